@@ -30,6 +30,7 @@ LIST(APPEND CPU_SOURCES "${SOURCES_DIR}/model/CPUParticleData.cpp")
 LIST(APPEND CPU_SOURCES "${SOURCES_DIR}/observables/CPUObservableFactory.cpp")
 LIST(APPEND CPU_SOURCES "${SOURCES_DIR}/observables/CPUObservables.cpp")
 LIST(APPEND CPU_SOURCES "${SOURCES_DIR}/model/topologies/CPUTopologyActionFactory.cpp")
+LIST(APPEND CPU_SOURCES "${SOURCES_DIR}/model/topologies/BondedInteractions.cpp")
 
 # --- neighbor list ---
 LIST(APPEND CPU_SOURCES "${SOURCES_DIR}/nl/CellContainer.cpp")
@@ -38,12 +38,14 @@ LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/Vec3.cpp")
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/Aggregators.cpp")
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/Actions.cpp")
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/Utils.cpp")
+LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/RandomProvider.cpp")
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/IOUtils.cpp")
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/Compartments.cpp")
 
 # potentials
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/potentials/Potentials.cpp")
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/potentials/PotentialRegistry.cpp")
+LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/potentials/TabulatedPotentialOrder2.cpp")
 
 # reactions
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/reactions/Reactions.cpp")
@@ -66,6 +68,7 @@ LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/topologies/reactions/TopologyRe
 
 # observables
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/observables/Trajectory.cpp")
+LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/observables/AsyncWriter.cpp")
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/observables/CenterOfMass.cpp")
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/observables/HistogramAlongAxis.cpp")
 LIST(APPEND READDY_MODEL_SOURCES "${SOURCES_DIR}/observables/Particles.cpp")
@@ -80,6 +80,19 @@ public:
      */
     void setKBT(double kBT);
 
+    /**
+     * Method to set the seed of the random number generators, which is applied at the start of the next run. Runs are
+     * only reproducible with a single threaded kernel, see KernelContext::setSeed.
+     * @param seed the seed.
+     */
+    void setSeed(std::uint64_t seed);
+
+    /**
+     * Method that returns the seed of the random number generators.
+     * @return the seed.
+     */
+    std::uint64_t getSeed() const;
+
     /**
      * Method to get the current box size.
      * @return the box size as Vec3 object.
@@ -357,6 +370,19 @@ public:
      */
     void registerPotentialOrder2(readdy::model::potentials::PotentialOrder2 *ptr);
 
+    /**
+     * If set, potentials of order 2 that are expensive to evaluate (Lennard-Jones, screened electrostatics and
+     * user defined ones) are sampled onto tables when the simulation is configured and evaluated by interpolation.
+     * @param autoTabulate whether to tabulate potentials
+     */
+    void setAutoTabulatePotentials(bool autoTabulate);
+
+    /**
+     * Method that returns whether expensive potentials of order 2 are tabulated.
+     * @return true if they are tabulated
+     */
+    bool getAutoTabulatePotentials() const;
+
 
     //void registerReactionByDescriptor(const std::string descriptor);
 
@@ -493,6 +519,14 @@ public:
 
     virtual void run(const time_step_type steps, const double timeStep);
 
+    /**
+     * The wall time of the simulation loop's actions and the selected kernel's counters, accumulated over all runs.
+     * @return the selected kernel's performance record
+     */
+    readdy::util::Performance &performance();
+
+    const readdy::util::Performance &performance() const;
+
     double getRecommendedTimeStep(unsigned int N) const;
 
     template<typename SchemeType=readdy::api::ReaDDyScheme>
@@ -41,6 +41,9 @@
  *  The configurator makes use of the builder pattern and either sets default values or not, depending on
  *  its constructor argument.
  *
+ *  The wall time of each action is recorded in the kernel's performance record (see Kernel::performance()), which can
+ *  be written to file at the end of a run.
+ *
  * @file SimulationScheme.h
  * @brief Header file containing the SchemeConfigurator<T> and a corresponding SimulationScheme superclass definition.
  * @author clonker
@@ -50,8 +53,10 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <type_traits>
 #include <readdy/common/common.h>
+#include <readdy/common/Performance.h>
 #include <readdy/model/Kernel.h>
 #include <readdy/io/Group.h>
 #include <readdy/model/IOUtils.h>
@@ -88,6 +93,30 @@ protected:
     friend
     class SchemeConfigurator;
 
+    /**
+     * Calls a function and records its wall time together with the current number of particles.
+     * @param timing the timing to record into
+     * @param function the function
+     */
+    template<typename Function>
+    void timed(util::Timing &timing, const Function &function) {
+        util::Timing::Scope scope(timing, kernel->getKernelStateModel().getNParticles());
+        function();
+    }
+
+    /**
+     * Writes what the kernel's performance record accumulated during a run into a new subgroup of performanceGroup, if
+     * set. The runs are numbered by the subgroups already present, so that several runs and schemes can write into the
+     * same file.
+     * @param before the performance record at the beginning of the run
+     */
+    void writePerformance(const util::Performance &before) {
+        if (performanceGroup) {
+            auto group = performanceGroup->createGroup("run_" + std::to_string(performanceGroup->subgroups().size()));
+            model::ioutils::writePerformance(group, kernel->performance().since(before));
+        }
+    }
+
     model::Kernel *const kernel;
     std::unique_ptr<model::actions::TimeStepDependentAction> integrator {nullptr};
     std::unique_ptr<model::actions::Action> forces {nullptr};
@@ -96,6 +125,7 @@ protected:
     std::unique_ptr<model::actions::UpdateNeighborList> clearNeighborList {nullptr};
     std::unique_ptr<evaluate_topology_reactions> evaluateTopologyReactions {nullptr};
     std::unique_ptr<io::Group> configGroup = nullptr;
+    std::unique_ptr<io::Group> performanceGroup = nullptr;
     bool evaluateObservables = true;
     time_step_type start = 0;
 };
@@ -107,30 +137,40 @@ public:
     using SimulationScheme::run;
 
     virtual void run(const continue_fun_t &continueFun) override {
+        const auto performanceBefore = kernel->performance();
         kernel->initialize();
         if(configGroup) {
             model::ioutils::writeSimulationSetup(*configGroup, kernel->getKernelContext());
         }
 
-        if (neighborList) neighborList->perform();
-        if (forces) forces->perform();
-        if (evaluateObservables) kernel->evaluateObservables(start);
+        auto &performance = kernel->performance();
+        auto &tIntegrator = performance.timing("integrator");
+        auto &tNeighborList = performance.timing("neighbor_list");
+        auto &tForces = performance.timing("forces");
+        auto &tReactions = performance.timing("reactions");
+        auto &tTopologyReactions = performance.timing("topology_reactions");
+        auto &tObservables = performance.timing("observables");
+
+        if (neighborList) timed(tNeighborList, [this] { neighborList->perform(); });
+        if (forces) timed(tForces, [this] { forces->perform(); });
+        if (evaluateObservables) timed(tObservables, [this] { kernel->evaluateObservables(start); });
         time_step_type t = start;
         while (continueFun(t)) {
-            if (integrator) integrator->perform();
-            if (neighborList) neighborList->perform();
+            if (integrator) timed(tIntegrator, [this] { integrator->perform(); });
+            if (neighborList) timed(tNeighborList, [this] { neighborList->perform(); });
             // if (forces) forces->perform();
 
-            if (reactionScheduler) reactionScheduler->perform();
-            if (evaluateTopologyReactions) evaluateTopologyReactions->perform();
-            if (neighborList) neighborList->perform();
-            if (forces) forces->perform();
-            if (evaluateObservables) kernel->evaluateObservables(t + 1);
+            if (reactionScheduler) timed(tReactions, [this] { reactionScheduler->perform(); });
+            if (evaluateTopologyReactions) timed(tTopologyReactions, [this] { evaluateTopologyReactions->perform(); });
+            if (neighborList) timed(tNeighborList, [this] { neighborList->perform(); });
+            if (forces) timed(tForces, [this] { forces->perform(); });
+            if (evaluateObservables) timed(tObservables, [this, t] { kernel->evaluateObservables(t + 1); });
             ++t;
         }
         if (clearNeighborList) clearNeighborList->perform();
         start = t;
         kernel->finalize();
+        writePerformance(performanceBefore);
         log::debug("Simulation completed");
     }
 };
@@ -201,6 +241,17 @@ public:
         return *this;
     }
 
+    /**
+     * At the end of each run, what the kernel's performance record accumulated during that run is written to the group
+     * readdy/performance/run_<n> of the file, where n counts the runs written to the file so far.
+     * @param file the file
+     * @return this configurator
+     */
+    SchemeConfigurator &writePerformanceToFile(io::File& file) {
+        scheme->performanceGroup = std::make_unique<io::Group>(file.createGroup("readdy/performance"));
+        return *this;
+    }
+
     SchemeConfigurator &withSkinSize(double skin = -1) {
         skinSize = skin;
         return *this;
@@ -258,33 +309,44 @@ public:
     using SimulationScheme::run;
 
     virtual void run(const continue_fun_t &fun) override {
+        const auto performanceBefore = kernel->performance();
         kernel->initialize();
         if(configGroup) {
             model::ioutils::writeSimulationSetup(*configGroup, kernel->getKernelContext());
         }
 
-        if (neighborList) neighborList->perform();
-        if (forces) forces->perform();
-        if (evaluateObservables) kernel->evaluateObservables(start);
+        auto &performance = kernel->performance();
+        auto &tIntegrator = performance.timing("integrator");
+        auto &tCompartments = performance.timing("compartments");
+        auto &tNeighborList = performance.timing("neighbor_list");
+        auto &tForces = performance.timing("forces");
+        auto &tReactions = performance.timing("reactions");
+        auto &tTopologyReactions = performance.timing("topology_reactions");
+        auto &tObservables = performance.timing("observables");
+
+        if (neighborList) timed(tNeighborList, [this] { neighborList->perform(); });
+        if (forces) timed(tForces, [this] { forces->perform(); });
+        if (evaluateObservables) timed(tObservables, [this] { kernel->evaluateObservables(start); });
         time_step_type t = start;
         while (fun(t)) {
-            if (integrator) integrator->perform();
-            if (compartments) compartments->perform();
-            if (neighborList) neighborList->perform();
+            if (integrator) timed(tIntegrator, [this] { integrator->perform(); });
+            if (compartments) timed(tCompartments, [this] { compartments->perform(); });
+            if (neighborList) timed(tNeighborList, [this] { neighborList->perform(); });
             // if (forces) forces->perform();
 
-            if (reactionScheduler) reactionScheduler->perform();
-            if (evaluateTopologyReactions) evaluateTopologyReactions->perform();
-            if (compartments) compartments->perform();
-            if (neighborList) neighborList->perform();
-            if (forces) forces->perform();
-            if (evaluateObservables) kernel->evaluateObservables(t + 1);
+            if (reactionScheduler) timed(tReactions, [this] { reactionScheduler->perform(); });
+            if (evaluateTopologyReactions) timed(tTopologyReactions, [this] { evaluateTopologyReactions->perform(); });
+            if (compartments) timed(tCompartments, [this] { compartments->perform(); });
+            if (neighborList) timed(tNeighborList, [this] { neighborList->perform(); });
+            if (forces) timed(tForces, [this] { forces->perform(); });
+            if (evaluateObservables) timed(tObservables, [this, t] { kernel->evaluateObservables(t + 1); });
             ++t;
         }
 
         if (clearNeighborList) clearNeighborList->perform();
         start = t;
         kernel->finalize();
+        writePerformance(performanceBefore);
         log::debug("Simulation completed");
     }
 
@@ -370,6 +432,11 @@ public:
         return *this;
     }
 
+    SchemeConfigurator &writePerformanceToFile(io::File& file) {
+        scheme->performanceGroup = std::make_unique<io::Group>(file.createGroup("readdy/performance"));
+        return *this;
+    }
+
     std::unique_ptr<AdvancedScheme> configure(double timeStep) {
         using default_integrator_t = readdy::model::actions::EulerBDIntegrator;
         using default_reactions_t = readdy::model::actions::reactions::Gillespie;
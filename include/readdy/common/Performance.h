@@ -0,0 +1,172 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * Low overhead instrumentation of the simulation loop. Wall times are taken from the steady clock and aggregated per
+ * action together with the number of calls and the number of particles the action was called on. Kernels can add
+ * named counters, e.g., how often the neighbor list was rebuilt.
+ *
+ * @file Performance.h
+ * @brief Header file containing the definitions of readdy::util::Performance and readdy::util::Timing.
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+
+#include "macros.h"
+
+NAMESPACE_BEGIN(readdy)
+NAMESPACE_BEGIN(util)
+
+/**
+ * aggregated measurements of one action
+ */
+struct Timing {
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * Measures the time until it runs out of scope and adds it to a timing, RAII style.
+     */
+    class Scope {
+    public:
+        /**
+         * starts the measurement
+         * @param timing the timing to record into
+         * @param nParticles the number of particles the action is called on
+         */
+        Scope(Timing &timing, std::size_t nParticles) : timing(timing), nParticles(nParticles) {}
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+        ~Scope() {
+            timing.seconds += std::chrono::duration<double>(clock::now() - begin).count();
+            ++timing.calls;
+            timing.particles += nParticles;
+        }
+
+    private:
+        Timing &timing;
+        std::size_t nParticles;
+        clock::time_point begin = clock::now();
+    };
+
+    /**
+     * total wall time in seconds
+     */
+    double seconds {0};
+    /**
+     * number of calls
+     */
+    std::size_t calls {0};
+    /**
+     * number of particles processed, summed over all calls
+     */
+    std::size_t particles {0};
+};
+
+/**
+ * Per-action timings and named counters. Entries are created on first access and references to them stay valid, so
+ * that they can be looked up once outside of the simulation loop.
+ */
+class Performance {
+public:
+    using timings_t = std::map<std::string, Timing>;
+    using counters_t = std::map<std::string, std::size_t>;
+
+    /**
+     * @param name the action's name
+     * @return the timing of that action
+     */
+    Timing &timing(const std::string &name) {
+        return _timings[name];
+    }
+
+    /**
+     * @param name the counter's name
+     * @return the counter
+     */
+    std::size_t &counter(const std::string &name) {
+        return _counters[name];
+    }
+
+    const timings_t &timings() const {
+        return _timings;
+    }
+
+    const counters_t &counters() const {
+        return _counters;
+    }
+
+    /**
+     * The measurements accumulated since an earlier state of this record, entries that were created in the meantime
+     * are taken as they are.
+     * @param earlier the earlier state
+     * @return the difference
+     */
+    Performance since(const Performance &earlier) const {
+        Performance result{*this};
+        for (auto &entry : result._timings) {
+            const auto it = earlier._timings.find(entry.first);
+            if (it != earlier._timings.end()) {
+                entry.second.seconds -= it->second.seconds;
+                entry.second.calls -= it->second.calls;
+                entry.second.particles -= it->second.particles;
+            }
+        }
+        for (auto &entry : result._counters) {
+            const auto it = earlier._counters.find(entry.first);
+            if (it != earlier._counters.end()) {
+                entry.second -= it->second;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * resets all timings and counters to zero, references to them stay valid
+     */
+    void clear() {
+        for (auto &entry : _timings) {
+            entry.second = {};
+        }
+        for (auto &entry : _counters) {
+            entry.second = 0;
+        }
+    }
+
+private:
+    timings_t _timings;
+    counters_t _counters;
+};
+
+NAMESPACE_END(util)
+NAMESPACE_END(readdy)
@@ -33,13 +33,14 @@
 
 #include <readdy/common/common.h>
 #include "executor.h"
+#include "work_stealing_pool.h"
 
 NAMESPACE_BEGIN(readdy)
 NAMESPACE_BEGIN(util)
 NAMESPACE_BEGIN(thread)
 
 enum class ThreadMode {
-    inactive, pool, std_thread, std_async
+    inactive, pool, std_thread, std_async, work_stealing
 };
 
 /**
@@ -79,6 +80,7 @@ private:
     ThreadMode _mode{ThreadMode::std_thread};
     std::unique_ptr<executor_base> _executor;
     std::unique_ptr<ctpl::thread_pool> pool;
+    std::unique_ptr<work_stealing_pool> wsPool;
 
     void update();
 };
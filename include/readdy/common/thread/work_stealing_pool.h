@@ -0,0 +1,357 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+/**
+ * A persistent pool of worker threads that executes batches of tasks. Tasks of a batch are distributed round-robin
+ * over per-thread deques, each thread works off its own deque from the bottom and steals from the top of the other
+ * deques once it ran dry. The calling thread takes part in the batch. Idle workers spin for a short while before they
+ * park on a condition variable, so that back-to-back batches of a simulation step do not pay for a wake-up while idle
+ * phases do not keep the cores busy.
+ *
+ * @file work_stealing_pool.h
+ * @brief Header file containing the work stealing thread pool and a corresponding executor
+ * @author clonker
+ * @date 17.10.17
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <readdy/common/macros.h>
+
+#if READDY_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "executor.h"
+
+NAMESPACE_BEGIN(readdy)
+NAMESPACE_BEGIN(util)
+NAMESPACE_BEGIN(thread)
+
+/**
+ * Fixed-capacity Chase-Lev deque of task indices. The owning thread pops from the bottom, other threads steal from
+ * the top. Pushing is only allowed while no other thread has access to the deque, i.e., before a batch is published.
+ */
+class task_deque {
+public:
+    using index_t = std::size_t;
+    using signed_index_t = std::ptrdiff_t;
+
+    /**
+     * removes all elements and makes sure that at least capacity elements fit
+     * @param capacity the capacity
+     */
+    void reset(std::size_t capacity) {
+        if (buffer.size() < capacity) {
+            buffer.resize(capacity);
+        }
+        top.store(0);
+        bottom.store(0);
+    }
+
+    /**
+     * pushes an element to the bottom, not thread safe
+     * @param idx the element
+     */
+    void push(index_t idx) {
+        const auto b = bottom.load(std::memory_order_relaxed);
+        buffer[b] = idx;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * pops an element from the bottom, may only be called by the owner
+     * @param idx the popped element
+     * @return true if an element could be popped
+     */
+    bool pop(index_t &idx) {
+        const auto b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b);
+        auto t = top.load();
+        if (t <= b) {
+            idx = buffer[b];
+            if (t == b) {
+                // last element, race against thieves
+                const bool won = top.compare_exchange_strong(t, t + 1);
+                bottom.store(b + 1);
+                return won;
+            }
+            return true;
+        }
+        bottom.store(b + 1);
+        return false;
+    }
+
+    /**
+     * steals an element from the top, may be called by any thread
+     * @param idx the stolen element
+     * @return true if an element could be stolen
+     */
+    bool steal(index_t &idx) {
+        auto t = top.load();
+        const auto b = bottom.load();
+        if (t < b) {
+            idx = buffer[t];
+            return top.compare_exchange_strong(t, t + 1);
+        }
+        return false;
+    }
+
+private:
+    std::vector<index_t> buffer;
+    std::atomic<signed_index_t> top{0};
+    std::atomic<signed_index_t> bottom{0};
+};
+
+/**
+ * Persistent work stealing thread pool. Its threads live as long as the pool does.
+ */
+class work_stealing_pool {
+public:
+    using task_t = std::function<void(std::size_t)>;
+
+    /**
+     * default number of iterations an idle worker waits for a new batch before it parks, the second half of which
+     * yields to other threads
+     */
+    static constexpr std::size_t default_n_spin_iterations = 1 << 8;
+
+    /**
+     * Creates a new pool. Since the calling thread participates in each batch, n-1 worker threads are spawned.
+     * @param n the number of threads executing a batch, including the calling thread
+     * @param pin whether the worker threads should be pinned to cores (only supported on linux). The i-th worker is
+     *            pinned to the i-th core of the process' affinity mask, hence pinning is only sensible if no other pool
+     *            is pinned within the same process.
+     * @param nSpinIterations number of iterations an idle worker waits for a new batch before it parks
+     */
+    explicit work_stealing_pool(std::size_t n, bool pin = false,
+                                std::size_t nSpinIterations = default_n_spin_iterations)
+            : deques(std::max(n, static_cast<std::size_t>(1))), nSpinIterations(nSpinIterations) {
+        workers.reserve(deques.size() - 1);
+        for (std::size_t i = 1; i < deques.size(); ++i) {
+            workers.emplace_back([this, i] { work(i); });
+        }
+        if (pin) {
+            pin_to_cores();
+        }
+    }
+
+    /**
+     * stops and joins all worker threads
+     */
+    ~work_stealing_pool() {
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            stopped.store(true);
+        }
+        sleepCV.notify_all();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool &) = delete;
+
+    work_stealing_pool &operator=(const work_stealing_pool &) = delete;
+
+    work_stealing_pool(work_stealing_pool &&) = delete;
+
+    work_stealing_pool &operator=(work_stealing_pool &&) = delete;
+
+    /**
+     * the number of threads that execute a batch, including the calling thread
+     * @return the number of threads
+     */
+    std::size_t size() const {
+        return deques.size();
+    }
+
+    /**
+     * Executes a batch of tasks and blocks until all of them are finished. Each task is invoked with its index in the
+     * batch. If a task throws, the first exception is rethrown after the whole batch has been processed.
+     * @param tasks the tasks
+     */
+    void run(std::vector<task_t> &tasks) {
+        if (tasks.empty()) return;
+        std::unique_lock<std::mutex> lock(submitMutex);
+
+        for (auto &deque : deques) {
+            deque.reset(tasks.size() / deques.size() + 1);
+        }
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            deques[i % deques.size()].push(i);
+        }
+        currentTasks = &tasks;
+        remaining.store(tasks.size());
+        accepting.store(true);
+
+        if (!workers.empty()) {
+            epoch.fetch_add(1);
+            if (sleeping.load() > 0) {
+                std::unique_lock<std::mutex> sleepLock(sleepMutex);
+                sleepCV.notify_all();
+            }
+        }
+
+        process(0);
+
+        // wait until all workers that joined this batch have left it again, only then the deques may be reused
+        accepting.store(false);
+        while (remaining.load() > 0 || active.load() > 0) {
+            std::this_thread::yield();
+        }
+        currentTasks = nullptr;
+
+        if (firstException) {
+            auto e = firstException;
+            firstException = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::vector<task_deque> deques;
+    std::size_t nSpinIterations;
+    std::vector<task_t> *currentTasks{nullptr};
+    std::exception_ptr firstException{nullptr};
+
+    std::atomic<std::size_t> remaining{0};
+    std::atomic<std::size_t> active{0};
+    std::atomic<std::size_t> epoch{0};
+    std::atomic<std::size_t> sleeping{0};
+    std::atomic<bool> accepting{false};
+    std::atomic<bool> stopped{false};
+
+    std::mutex submitMutex;
+    std::mutex exceptionMutex;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCV;
+
+    /**
+     * pins the i-th worker to the i-th core (modulo their number) that the process is allowed to run on, the calling
+     * thread is left alone
+     */
+    void pin_to_cores() {
+#if READDY_LINUX
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) != 0) return;
+        std::vector<int> cores;
+        for (int core = 0; core < CPU_SETSIZE; ++core) {
+            if (CPU_ISSET(core, &allowed)) cores.push_back(core);
+        }
+        if (cores.empty()) return;
+        for (std::size_t i = 0; i < workers.size(); ++i) {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(cores[(i + 1) % cores.size()], &cpuSet);
+            pthread_setaffinity_np(workers[i].native_handle(), sizeof(cpu_set_t), &cpuSet);
+        }
+#endif
+    }
+
+    void work(std::size_t self) {
+        std::size_t seenEpoch = 0;
+        while (true) {
+            // spin, then park
+            std::size_t spin = 0;
+            while (epoch.load() == seenEpoch && !stopped.load() && spin < nSpinIterations) {
+                if (++spin > nSpinIterations / 2) std::this_thread::yield();
+            }
+            if (epoch.load() == seenEpoch && !stopped.load()) {
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                sleeping.fetch_add(1);
+                sleepCV.wait(lock, [&] { return epoch.load() != seenEpoch || stopped.load(); });
+                sleeping.fetch_sub(1);
+            }
+            if (stopped.load()) return;
+            seenEpoch = epoch.load();
+
+            active.fetch_add(1);
+            if (accepting.load()) {
+                process(self);
+            }
+            active.fetch_sub(1);
+        }
+    }
+
+    void process(std::size_t self) {
+        auto &tasks = *currentTasks;
+        const auto n = deques.size();
+        std::size_t idx;
+        while (remaining.load() > 0) {
+            bool found = deques[self].pop(idx);
+            for (std::size_t k = 1; !found && k < n; ++k) {
+                found = deques[(self + k) % n].steal(idx);
+            }
+            if (found) {
+                try {
+                    tasks[idx](idx);
+                } catch (...) {
+                    std::unique_lock<std::mutex> lock(exceptionMutex);
+                    if (!firstException) firstException = std::current_exception();
+                }
+                remaining.fetch_sub(1);
+            }
+        }
+    }
+};
+
+/**
+ * executor that dispatches to a persistent work_stealing_pool
+ */
+class work_stealing_executor : public executor_base {
+public:
+    /**
+     * creates a new executor
+     * @param pool the pool, must outlive the executor
+     */
+    explicit work_stealing_executor(work_stealing_pool *pool) : pool(pool) {
+        if (pool == nullptr) {
+            throw std::invalid_argument("the work stealing executor requires a valid pool pointer!");
+        }
+    }
+
+    void execute_and_wait(std::vector<executable_t> &&executables) const override {
+        pool->run(executables);
+    }
+
+private:
+    work_stealing_pool *pool;
+};
+
+NAMESPACE_END(thread)
+NAMESPACE_END(util)
+NAMESPACE_END(readdy)
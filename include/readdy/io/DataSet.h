@@ -31,6 +31,10 @@
  */
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "H5Types.h"
 #include "DataSpace.h"
 #include "DataSetType.h"
@@ -38,6 +42,13 @@
 NAMESPACE_BEGIN(readdy)
 NAMESPACE_BEGIN(io)
 
+/**
+ * HDF5 is not necessarily built thread safe. Appending to and flushing data sets is serialized by this mutex, so that
+ * observables can be written from a background thread while others are written synchronously.
+ * @return the mutex
+ */
+READDY_API std::recursive_mutex &dataSetMutex();
+
 enum DataSetCompression {
     none = 0x0000, blosc = 0x0001
 };
@@ -61,6 +72,46 @@ public:
 
 };
 
+/**
+ * Bookkeeping of appends to a data set, shared between copies of the data set. The extent in the file is queried once
+ * and afterwards tracked on the fly. The memory space is shared as well, so that its tracked extent is the one of the
+ * memory space that every copy writes from.
+ */
+struct AppendState {
+    /**
+     * the file space, its extent is kept up to date with the data set's extent
+     */
+    DataSpace fileSpace{-1};
+    /**
+     * the extent of the data set in the file, empty as long as it was not queried
+     */
+    std::vector<h5::dims_t> extent;
+    /**
+     * the maximal extent of the data set in the file
+     */
+    std::vector<h5::dims_t> maxExtent;
+    /**
+     * the memory space, reshaped when data of a different shape is appended
+     */
+    DataSpace memorySpace{-1};
+    /**
+     * the current extent of the memory space
+     */
+    std::vector<h5::dims_t> memoryExtent;
+    /**
+     * in buffered mode, the number of frames along the extension dimension that are gathered before writing
+     */
+    h5::dims_t bufferedFrames{0};
+    /**
+     * the extent of the pending data
+     */
+    std::vector<h5::dims_t> pendingExtent;
+    /**
+     * the pending data, contiguous along the extension dimension
+     */
+    std::vector<char> pending;
+};
+
 class READDY_API DataSet : public Object {
 public:
 
@@ -82,6 +133,15 @@ public:
     template<typename T>
     void append(const std::vector<h5::dims_t> &dims, const T *const data);
 
+    /**
+     * Switches the buffered append mode on or off. In buffered mode, appended data is gathered in memory and written
+     * with a single extent change and write once it fills a chunk along the extension dimension. Pending data is
+     * written on flush() and when the last copy of the data set is destroyed. Only supported if the extension
+     * dimension is the first dimension.
+     * @param buffered whether appends should be buffered
+     */
+    void setBuffered(bool buffered);
+
     void flush();
 
     DataSpace getFileSpace() const;
@@ -95,10 +155,14 @@ public:
     }
 
 private:
+    void write(const std::vector<h5::dims_t> &dims, const void *data);
+
+    void writePending();
+
     h5::dims_t _extensionDim;
-    DataSpace memorySpace;
     DataSetType memoryType{-1};
     DataSetType fileType{-1};
+    std::shared_ptr<AppendState> state;
 };
 
 class VLENDataSet : public Object {
@@ -122,6 +186,7 @@ public:
     void append(const std::vector<h5::dims_t> &dims, std::vector<T> *const data);
 
     void flush() {
+        std::lock_guard<std::recursive_mutex> lock(dataSetMutex());
         if (hid() >= 0 && H5Fflush(hid(), H5F_SCOPE_LOCAL) < 0) {
             throw std::runtime_error("error when flushing HDF5 data set with handle " + std::to_string(hid()));
         }
@@ -147,9 +212,10 @@ public:
 
 private:
     h5::dims_t _extensionDim;
-    DataSpace memorySpace;
     DataSetType memoryType{-1};
     DataSetType fileType{-1};
+    std::shared_ptr<AppendState> state;
+    std::vector<hvl_t> vlenBuffer;
 };
 
 NAMESPACE_END(io)
@@ -33,6 +33,7 @@
 
 #include <sstream>
 #include <iterator>
+#include <algorithm>
 #include <atomic>
 
 #include <H5Ppublic.h>
@@ -54,11 +55,77 @@ inline DataSpace DataSet::getFileSpace() const {
     return DataSpace(_hid);
 }
 
-inline DataSet::~DataSet() = default;
+NAMESPACE_BEGIN(detail)
+/**
+ * makes sure that the append state knows the extent of the data set in the file
+ * @param hid the data set
+ * @param state the append state
+ */
+inline void prepareAppendState(h5::handle_t hid, AppendState &state) {
+    if (state.extent.empty()) {
+        auto _hid = H5Dget_space(hid);
+        if (_hid < 0) {
+            log::error("Failed to get data set space!");
+            H5Eprint(H5Eget_current_stack(), stderr);
+        }
+        state.fileSpace = DataSpace(_hid);
+        state.extent = state.fileSpace.dims();
+        state.maxExtent = state.fileSpace.max_dims();
+    }
+}
+
+/**
+ * Extends a data set along its extension dimension and selects the newly created region in the cached file space.
+ * @param hid the data set
+ * @param state the append state
+ * @param dims the dims of the data to be appended
+ * @param extensionDim the extension dimension
+ */
+inline void extendAndSelect(h5::handle_t hid, AppendState &state, const std::vector<h5::dims_t> &dims,
+                            h5::dims_t extensionDim) {
+    prepareAppendState(hid, state);
+    if (dims.size() != state.extent.size()) {
+        log::error("Tried to append data with ndims={} to set with ndims={}", dims.size(), state.extent.size());
+        throw std::runtime_error("tried to append data with wrong dimensionality!");
+    }
+    // the memory space is (re-)shaped to the dims
+    if (state.memorySpace.hid() < 0) {
+        state.memorySpace = DataSpace(dims);
+        state.memoryExtent = dims;
+    } else if (state.memoryExtent != dims) {
+        H5Sset_extent_simple(state.memorySpace.hid(), static_cast<int>(dims.size()), dims.data(), nullptr);
+        state.memoryExtent = dims;
+    }
+    std::vector<h5::dims_t> offset(dims.size(), 0);
+    offset[extensionDim] = state.extent[extensionDim];
+    state.extent[extensionDim] += dims[extensionDim];
+    H5Dset_extent(hid, state.extent.data());
+    H5Sset_extent_simple(state.fileSpace.hid(), static_cast<int>(state.extent.size()), state.extent.data(),
+                         state.maxExtent.data());
+    if (log::console()->should_log(spdlog::level::trace)) {
+        std::stringstream extentStream;
+        std::copy(state.extent.begin(), state.extent.end(), std::ostream_iterator<int>(extentStream, ", "));
+        std::stringstream offsetStream;
+        std::copy(offset.begin(), offset.end(), std::ostream_iterator<int>(offsetStream, ", "));
+        std::stringstream dimsStream;
+        std::copy(dims.begin(), dims.end(), std::ostream_iterator<int>(dimsStream, ", "));
+        log::trace("appending data of size ({}) at offset ({}), new extent ({})", dimsStream.str(),
+                   offsetStream.str(), extentStream.str());
+    }
+    H5Sselect_hyperslab(state.fileSpace.hid(), H5S_SELECT_SET, offset.data(), nullptr, dims.data(), nullptr);
+}
+NAMESPACE_END(detail)
+
+inline DataSet::~DataSet() {
+    if (state && state.use_count() == 1 && !state->pending.empty()) {
+        std::lock_guard<std::recursive_mutex> lock(dataSetMutex());
+        writePending();
+    }
+}
 
 inline DataSet::DataSet(h5::handle_t handle, const DataSetType &memoryType, const DataSetType &fileType)
         : Object(std::make_shared<DataSetHandle>(handle)), memoryType(memoryType), fileType(fileType),
-          memorySpace(-1) {}
+          state(std::make_shared<AppendState>()) {}
 
 template<typename T>
 inline void DataSet::append(std::vector<T> &data) {
@@ -72,123 +139,87 @@ inline void VLENDataSet::append(std::vector<std::vector<T>> &data) {
 
 template<typename T>
 inline void VLENDataSet::append(const std::vector<h5::dims_t> &dims, std::vector<T> *const data) {
-    {
-        std::stringstream result;
-        std::copy(dims.begin(), dims.end(), std::ostream_iterator<int>(result, ", "));
-        log::trace("appending to vlen data set with data size = ({})", result.str());
-    }
-    {
-        auto fs = getFileSpace();
-        if (dims.size() != fs.ndim()) {
-            log::error("Tried to append data with ndims={} to set with ndims={}", dims.size(), fs.ndim());
-            throw std::runtime_error("tried to append data with wrong dimensionality!");
-        }
-    }
-    if (memorySpace.hid() < 0) {
-        memorySpace = DataSpace(dims);
-    } else {
-        H5Sset_extent_simple(memorySpace.hid(), static_cast<int>(dims.size()), dims.data(), nullptr);
-    }
-    std::vector<h5::dims_t> currentExtent;
-    {
-        auto fs = getFileSpace();
-        currentExtent = fs.dims();
-    }
-    std::vector<h5::dims_t> offset;
-    {
-        offset.resize(dims.size());
-        offset[_extensionDim] = currentExtent[_extensionDim];
-    }
-    std::vector<h5::dims_t> newExtent(currentExtent.begin(), currentExtent.end());
-    {
-        newExtent[_extensionDim] += dims[_extensionDim];
-        H5Dset_extent(hid(), newExtent.data());
-        {
-            log::trace("setting new extent to:");
-            std::stringstream result;
-            std::copy(newExtent.begin(), newExtent.end(), std::ostream_iterator<int>(result, ", "));
-            log::trace("    size = {}", result.str());
-        }
-    }
-    log::trace("selecting hyperslab with:");
-    {
-        std::stringstream result;
-        std::copy(offset.begin(), offset.end(), std::ostream_iterator<int>(result, ", "));
-        log::trace("    current extent = {}", result.str());
-    }
-    {
-        std::stringstream result;
-        std::copy(dims.begin(), dims.end(), std::ostream_iterator<int>(result, ", "));
-        log::trace("    size = {}", result.str());
-    }
-    std::vector<hvl_t> traj;
+    std::lock_guard<std::recursive_mutex> lock(dataSetMutex());
+    detail::extendAndSelect(hid(), *state, dims, _extensionDim);
     {
         const auto n = dims[_extensionDim];
-        log::trace("appending n={} vlen entries", n);
-        traj.reserve(n);
-        for (auto i = 0; i < n; ++i) {
-            auto val = &data[i];
-            hvl_t entry;
-            entry.len = val->size();
-            entry.p = val->data();
-            traj.push_back(std::move(entry));
+        vlenBuffer.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            vlenBuffer[i].len = data[i].size();
+            vlenBuffer[i].p = data[i].data();
         }
     }
-    {
-        auto fileSpace = getFileSpace();
-        H5Sselect_hyperslab(fileSpace.hid(), H5S_SELECT_SET, offset.data(), nullptr, dims.data(), nullptr);
-        H5Dwrite(hid(), memoryType.hid(), memorySpace.hid(), fileSpace.hid(), H5P_DEFAULT, traj.data());
-    }
+    H5Dwrite(hid(), memoryType.hid(), state->memorySpace.hid(), state->fileSpace.hid(), H5P_DEFAULT, vlenBuffer.data());
 }
 
 template<typename T>
 inline void DataSet::append(const std::vector<h5::dims_t> &dims, const T *const data) {
-    {
-        std::stringstream result;
-        std::copy(dims.begin(), dims.end(), std::ostream_iterator<int>(result, ", "));
-        log::trace("appending to regular data set with data size = ({})", result.str());
-    }
-    if (dims.size() != getFileSpace().ndim()) {
-        log::error("Tried to append data with ndims={} to set with ndims={}", dims.size(), getFileSpace().ndim());
-        throw std::runtime_error("tried to append data with wrong dimensionality!");
-    }
-    if (memorySpace.hid() < 0) {
-        memorySpace = DataSpace(dims);
-    } else {
-        H5Sset_extent_simple(memorySpace.hid(), static_cast<int>(dims.size()), dims.data(), nullptr);
-    }
-    std::vector<h5::dims_t> currentExtent;
-    std::vector<h5::dims_t> offset;
-    offset.resize(dims.size());
-    {
-        currentExtent = getFileSpace().dims();
+    std::lock_guard<std::recursive_mutex> lock(dataSetMutex());
+    if (state->bufferedFrames == 0) {
+        write(dims, data);
+        return;
+    }
+    // gather the data, as long as its shape apart from the extension dimension does not change
+    if (!state->pending.empty() && (state->pendingExtent.size() != dims.size()
+                                    || !std::equal(dims.begin() + 1, dims.end(), state->pendingExtent.begin() + 1))) {
+        writePending();
+    }
+    if (state->pending.empty()) {
+        state->pendingExtent = dims;
+        state->pendingExtent[0] = 0;
+    }
+    std::size_t n = 1;
+    for (const auto dim : dims) n *= dim;
+    const auto bytes = reinterpret_cast<const char *>(data);
+    state->pending.insert(state->pending.end(), bytes, bytes + n * sizeof(T));
+    state->pendingExtent[0] += dims[0];
+    if (state->pendingExtent[0] >= state->bufferedFrames) {
+        writePending();
     }
-    offset[_extensionDim] = currentExtent[_extensionDim];
-    {
-        std::vector<h5::dims_t> newExtent(currentExtent);
-        newExtent[_extensionDim] += dims[_extensionDim];
-        H5Dset_extent(hid(), newExtent.data());
-    }
-    log::trace("selecting hyperslab with:");
-    {
-        std::stringstream result;
-        std::copy(offset.begin(), offset.end(), std::ostream_iterator<int>(result, ", "));
-        log::trace("    current extent = {}", result.str());
-    }
-    {
-        std::stringstream result;
-        std::copy(dims.begin(), dims.end(), std::ostream_iterator<int>(result, ", "));
-        log::trace("    size = {}", result.str());
-    }
-    auto fileSpace = getFileSpace();
-    H5Sselect_hyperslab(fileSpace.hid(), H5S_SELECT_SET, offset.data(), nullptr, dims.data(), nullptr);
-    if (H5Dwrite(hid(), memoryType.hid(), memorySpace.hid(), fileSpace.hid(), H5P_DEFAULT, data) < 0) {
+}
+
+inline void DataSet::write(const std::vector<h5::dims_t> &dims, const void *data) {
+    detail::extendAndSelect(hid(), *state, dims, _extensionDim);
+    if (H5Dwrite(hid(), memoryType.hid(), state->memorySpace.hid(), state->fileSpace.hid(), H5P_DEFAULT, data) < 0) {
         log::error("Error with data set {}", hid());
         H5Eprint(H5Eget_current_stack(), stderr);
     }
 }
 
+inline void DataSet::writePending() {
+    if (!state->pending.empty()) {
+        write(state->pendingExtent, state->pending.data());
+        state->pending.clear();
+    }
+}
+
+inline void DataSet::setBuffered(bool buffered) {
+    std::lock_guard<std::recursive_mutex> lock(dataSetMutex());
+    writePending();
+    state->bufferedFrames = 0;
+    if (buffered) {
+        if (_extensionDim != 0) {
+            log::warn("buffered appends are only supported along the first dimension, data set {} stays unbuffered",
+                      hid());
+            return;
+        }
+        // gather as many frames as fit into a chunk
+        auto plist = H5Dget_create_plist(hid());
+        const auto ndims = H5Pget_chunk(plist, 0, nullptr);
+        if (ndims > 0) {
+            std::vector<h5::dims_t> chunk(static_cast<std::size_t>(ndims));
+            H5Pget_chunk(plist, ndims, chunk.data());
+            state->bufferedFrames = std::max(chunk[0], static_cast<h5::dims_t>(1));
+        } else {
+            state->bufferedFrames = 1;
+        }
+        H5Pclose(plist);
+    }
+}
+
 inline void DataSet::flush() {
+    std::lock_guard<std::recursive_mutex> lock(dataSetMutex());
+    writePending();
     if (hid() >= 0 && H5Fflush(hid(), H5F_SCOPE_LOCAL) < 0) {
         throw std::runtime_error("error when flushing HDF5 data set with handle " + std::to_string(hid()));
     }
@@ -196,7 +227,7 @@ inline void DataSet::flush() {
 
 inline VLENDataSet::VLENDataSet(h5::handle_t handle, const DataSetType &memoryType, const DataSetType &fileType)
         : Object(std::make_shared<DataSetHandle>(handle)), memoryType(memoryType), fileType(fileType),
-          memorySpace(-1) {
+          state(std::make_shared<AppendState>()) {
     if(handle < 0) {
         log::critical("tried to create a data set with negative handle!");
     }
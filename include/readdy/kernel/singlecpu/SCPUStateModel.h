@@ -94,6 +94,8 @@ public:
 
     virtual const std::vector<readdy::model::Particle> getParticles() const override;
 
+    virtual std::size_t getNParticles() const override;
+
     std::vector<readdy::model::reactions::ReactionRecord>& reactionRecords();
 
     const std::vector<readdy::model::reactions::ReactionRecord>& reactionRecords() const;
@@ -275,7 +275,7 @@ public:
                             if (isInCollection(pTo, typeCountTo) && pFrom.getId() != pTo.getId()) {
                                 const auto dist = sqrt(distSquared(pFrom.getPos(), pTo.getPos()));
                                 auto upperBound = std::upper_bound(binBorders.begin(), binBorders.end(), dist);
-                                if (upperBound != binBorders.end()) {
+                                if (upperBound != binBorders.begin() && upperBound != binBorders.end()) {
                                     const auto binBordersIdx = upperBound - binBorders.begin();
                                     counts[binBordersIdx - 1]++;
                                 }
@@ -34,6 +34,7 @@
 
 #include <readdy/common/macros.h>
 #include <readdy/io/Group.h>
+#include <readdy/common/Performance.h>
 #include "KernelContext.h"
 
 NAMESPACE_BEGIN(readdy)
@@ -42,6 +43,14 @@ NAMESPACE_BEGIN(ioutils)
 
 void writeSimulationSetup(io::Group &group, const KernelContext &context);
 
+/**
+ * Writes timings and counters column-wise, i.e., the data sets timings/names, timings/seconds, timings/calls,
+ * timings/particles and counters/names, counters/values.
+ * @param group the group to write into
+ * @param performance the performance record
+ */
+void writePerformance(io::Group &group, const readdy::util::Performance &performance);
+
 struct ReactionInfo {
     const char* name;
     std::size_t index {0}; // identify reaction in map of vectors, e.g. for reaction records
@@ -37,11 +37,13 @@
 #include <map>
 #include <iostream>
 #include <readdy/common/signals.h>
+#include <readdy/common/Performance.h>
 #include <readdy/model/Plugin.h>
 #include <readdy/model/actions/Action.h>
 #include <readdy/model/KernelStateModel.h>
 #include <readdy/model/KernelContext.h>
 #include <readdy/model/observables/ObservableFactory.h>
+#include <readdy/model/observables/io/AsyncWriter.h>
 #include <readdy/model/_internal/ObservableWrapper.h>
 #include <readdy/model/potentials/PotentialFactory.h>
 #include <readdy/model/actions/ActionFactory.h>
@@ -119,6 +121,22 @@ public:
      */
     virtual void evaluateObservables(time_step_type t);
 
+    /**
+     * The writer thread that observables can hand their results to, so that writing to file does not stall the
+     * simulation loop. It is drained in finalize().
+     * @return the kernel's asynchronous writer
+     */
+    observables::util::AsyncWriter &asyncWriter();
+
+    /**
+     * The timings of the actions performed by the simulation schemes and the kernel's counters, accumulated over all
+     * runs until they are cleared.
+     * @return the kernel's performance record
+     */
+    readdy::util::Performance &performance();
+
+    const readdy::util::Performance &performance() const;
+
     /**
      * Registers an observable to the kernel signal.
      */
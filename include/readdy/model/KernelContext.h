@@ -44,6 +44,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <unordered_set>
@@ -83,6 +84,20 @@ public:
 
     void setKBT(double kBT);
 
+    /**
+     * Sets the seed of this context. It is handed to the random provider (see rnd::seed) the next time the context is
+     * configured, i.e., at the start of the next run. Since the random provider is shared by all kernels of a process,
+     * a seed only makes runs reproducible if no other kernel draws random numbers in between and if the kernel is
+     * single threaded, see rnd::seed.
+     * @param seed the seed
+     */
+    void setSeed(std::uint64_t seed);
+
+    /**
+     * @return the seed of this context or, if none was set, the current seed of the random provider
+     */
+    std::uint64_t getSeed() const;
+
     std::array<double, 3> &getBoxSize() const;
 
     std::tuple<readdy::model::Vec3, readdy::model::Vec3> getBoxBoundingVertices() const;
@@ -115,11 +130,18 @@ public:
     /**
      * Copy the reactions and potentials of the internal and external registries into the actual registries, which
      * is used during the run of the simulation. This step is necessary before the simulation can start. Otherwise the
-     * registered reactions and potentials will not take effect. The context is optionally logged in text format.
+     * registered reactions and potentials will not take effect. A seed that was set since the last configuration is
+     * handed to the random provider. The context is optionally logged in text format.
      * @param debugOutput decide if context information will be logged
      */
     void configure(bool debugOutput = false);
 
+    /**
+     * @return the number of times this context was configured, so that kernels can tell whether data derived from the
+     * registries is still up to date
+     */
+    std::size_t nConfigurations() const;
+
     /**
      * Returns whether reactions with positions shall be recorded in the state model, then obtainable by
      * the readdy::model::observables::Reactions observable.
@@ -33,6 +33,7 @@
 #pragma once
 #include <vector>
 #include <readdy/model/topologies/GraphTopology.h>
+#include <readdy/model/observables/io/TrajectoryEntry.h>
 #include "Particle.h"
 #include "Vec3.h"
 
@@ -48,6 +49,21 @@ public:
 
     virtual const std::vector<Particle> getParticles() const = 0;
 
+    /**
+     * The number of active particles. The default implementation goes through getParticles(), kernels should override
+     * it with something cheaper, as it is queried in every step for instrumentation purposes.
+     * @return the number of particles
+     */
+    virtual std::size_t getNParticles() const;
+
+    /**
+     * Writes all active particles into a trajectory frame. The frame's memory is reused, so that recording a
+     * trajectory does not allocate once the frame has reached its size. The default implementation goes through
+     * getParticles(), kernels can override it to write directly from their particle storage.
+     * @param frame the frame, its contents are replaced
+     */
+    virtual void toTrajectoryFrame(std::vector<observables::TrajectoryEntry> &frame) const;
+
     virtual Particle getParticleForIndex(const std::size_t index) const = 0;
 
     virtual particle_type_type getParticleType(const std::size_t index) const = 0;
@@ -21,8 +21,9 @@
 
 
 /**
- * The random provider can provide normal and uniform distributed random numbers. The choice of random generator
- * can be altered by template parameter. Current default: mt19937.
+ * The random provider can provide normal, uniform and exponentially distributed random numbers, either one at a time or
+ * as whole arrays. The choice of random generator can be altered by template parameter. Current default: philox4x32,
+ * a counter-based generator whose streams are derived from a process-wide seed (see rnd::seed).
  *
  * @file Random.h
  * @brief Header file containing the definitions for readdy::model::RandomProvider.
@@ -31,9 +32,12 @@
  */
 
 #pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <random>
-#include <time.h>
 #include <thread>
 #include "Vec3.h"
 
@@ -41,42 +45,282 @@ NAMESPACE_BEGIN(readdy)
 NAMESPACE_BEGIN(model)
 NAMESPACE_BEGIN(rnd)
 
-template<typename RealType=double, typename Generator = std::default_random_engine>
+/**
+ * Counter-based Philox4x32-10 generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", 2011). The n-th
+ * block of four outputs is a bijection of the counter (n, stream) under the key given by the seed, hence the state is
+ * tiny, streams are independent and skipping ahead is free. Satisfies the UniformRandomBitGenerator requirements.
+ */
+class philox4x32 {
+public:
+    using result_type = std::uint32_t;
+    using counter_type = std::array<std::uint32_t, 4>;
+    using key_type = std::array<std::uint32_t, 2>;
+
+    static constexpr result_type min() { return 0; }
+
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    /**
+     * creates a new generator
+     * @param seed the seed, used as key
+     * @param stream the stream, occupies the upper half of the counter
+     */
+    explicit philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0) {
+        this->seed(seed, stream);
+    }
+
+    /**
+     * reseeds the generator and resets its position within the stream
+     * @param seed the seed
+     * @param stream the stream
+     */
+    void seed(std::uint64_t seed, std::uint64_t stream = 0) {
+        key = {{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)}};
+        counter = {{0, 0, static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)}};
+        bufferPos = 4;
+    }
+
+    result_type operator()() {
+        if (bufferPos == 4) {
+            buffer = bijection(counter, key);
+            increment();
+            bufferPos = 0;
+        }
+        return buffer[bufferPos++];
+    }
+
+    /**
+     * advances the generator by z outputs
+     * @param z the number of outputs to skip
+     */
+    void discard(unsigned long long z) {
+        while (z > 0 && bufferPos < 4) {
+            ++bufferPos;
+            --z;
+        }
+        if (z > 0) {
+            const auto blocks = z / 4;
+            auto c = (static_cast<std::uint64_t>(counter[1]) << 32 | counter[0]) + blocks;
+            counter[0] = static_cast<std::uint32_t>(c);
+            counter[1] = static_cast<std::uint32_t>(c >> 32);
+            bufferPos = 4;
+            for (auto i = z % 4; i > 0; --i) operator()();
+        }
+    }
+
+    /**
+     * the ten rounds of philox, mapping a counter to a block of four random numbers
+     * @param ctr the counter
+     * @param key the key
+     * @return the random block
+     */
+    static counter_type bijection(counter_type ctr, key_type key) {
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                key[0] += 0x9E3779B9;
+                key[1] += 0xBB67AE85;
+            }
+            const auto p0 = static_cast<std::uint64_t>(0xD2511F53) * ctr[0];
+            const auto p1 = static_cast<std::uint64_t>(0xCD9E8D57) * ctr[2];
+            ctr = {{static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<std::uint32_t>(p1),
+                    static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<std::uint32_t>(p0)}};
+        }
+        return ctr;
+    }
+
+    friend bool operator==(const philox4x32 &lhs, const philox4x32 &rhs) {
+        return lhs.key == rhs.key && lhs.counter == rhs.counter && lhs.bufferPos == rhs.bufferPos;
+    }
+
+    friend bool operator!=(const philox4x32 &lhs, const philox4x32 &rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+    void increment() {
+        if (++counter[0] == 0) ++counter[1];
+    }
+
+    key_type key{};
+    counter_type counter{};
+    counter_type buffer{};
+    std::uint8_t bufferPos{4};
+};
+
+using default_generator = philox4x32;
+
+/**
+ * Sets the process-wide seed. All thread local generators obtained through engine() are rekeyed on their next use,
+ * where each thread gets its own stream. The streams are handed out in the order in which threads first draw numbers
+ * after seeding. Hence, the sequence of numbers is only reproducible if they are drawn by a single thread. With a
+ * thread pool, the assignment of work to threads and thereby of streams to particles varies from run to run.
+ * @param seed the seed
+ */
+READDY_API void seed(std::uint64_t seed);
+
+/**
+ * @return the current process-wide seed, initially chosen nondeterministically
+ */
+READDY_API std::uint64_t get_seed();
+
+NAMESPACE_BEGIN(detail)
+/**
+ * @return a counter that is incremented with every call to seed()
+ */
+READDY_API std::uint64_t seed_generation();
+
+/**
+ * @return the next unused stream index for the current seed
+ */
+READDY_API std::uint64_t next_stream();
+
+inline void seed_engine(philox4x32 &generator, std::uint64_t seed, std::uint64_t stream) {
+    generator.seed(seed, stream);
+}
+
+template<typename Generator>
+void seed_engine(Generator &generator, std::uint64_t seed, std::uint64_t stream) {
+    std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                      static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)};
+    generator.seed(seq);
+}
+
+/**
+ * draws a number uniformly distributed in [0, 1)
+ */
+template<typename RealType, typename Generator>
+RealType canonical(Generator &generator) {
+    const auto u = std::generate_canonical<RealType, std::numeric_limits<RealType>::digits>(generator);
+    // some standard library implementations can round up to 1
+    return u < 1 ? u : std::nextafter(static_cast<RealType>(1), static_cast<RealType>(0));
+}
+
+template<>
+inline double canonical<double, philox4x32>(philox4x32 &generator) {
+    const auto hi = static_cast<std::uint64_t>(generator() >> 5);
+    const auto lo = static_cast<std::uint64_t>(generator() >> 6);
+    return static_cast<double>(hi * 67108864 + lo) * (1. / 9007199254740992.);
+}
+
+template<>
+inline float canonical<float, philox4x32>(philox4x32 &generator) {
+    return static_cast<float>(generator() >> 8) * (1.f / 16777216.f);
+}
+NAMESPACE_END(detail)
+
+/**
+ * Yields the calling thread's generator of the given type. It is (re-)seeded lazily whenever the process-wide seed
+ * changed since its last use.
+ * @return the thread local generator
+ */
+template<typename Generator = default_generator>
+Generator &engine() {
+    static thread_local Generator generator;
+    static thread_local std::uint64_t generation = 0;
+    const auto currentGeneration = detail::seed_generation();
+    if (generation != currentGeneration) {
+        generation = currentGeneration;
+        detail::seed_engine(generator, get_seed(), detail::next_stream());
+    }
+    return generator;
+}
+
+template<typename RealType=double, typename Generator = default_generator>
 RealType normal(const RealType mean = 0.0, const RealType variance = 1.0) {
-    static thread_local Generator generator(clock() + std::hash<std::thread::id>()(std::this_thread::get_id()));
     std::normal_distribution<RealType> distribution(mean, variance);
-    return distribution(generator);
+    return distribution(engine<Generator>());
 }
 
-template<typename RealType=double, typename Generator = std::default_random_engine>
+template<typename RealType=double, typename Generator = default_generator>
 RealType uniform_real(const RealType a = 0.0, const RealType b = 1.0) {
-    static thread_local Generator generator(clock() + std::hash<std::thread::id>()(std::this_thread::get_id()));
     std::uniform_real_distribution<RealType> distribution(a, b);
-    return distribution(generator);
+    return distribution(engine<Generator>());
 }
 
-template<typename IntType=int, typename Generator = std::default_random_engine>
+template<typename IntType=int, typename Generator = default_generator>
 IntType uniform_int(const IntType a, const IntType b) {
-    static thread_local Generator generator(clock() + std::hash<std::thread::id>()(std::this_thread::get_id()));
     std::uniform_int_distribution<IntType> distribution(a, b);
-    return distribution(generator);
+    return distribution(engine<Generator>());
 }
 
-template<typename RealType=double, typename Generator = std::default_random_engine>
+template<typename RealType=double, typename Generator = default_generator>
 RealType exponential(RealType lambda = 1.0) {
-    static thread_local Generator generator(clock() + std::hash<std::thread::id>()(std::this_thread::get_id()));
     std::exponential_distribution<RealType> distribution(lambda);
-    return distribution(generator);
+    return distribution(engine<Generator>());
 }
 
-template<typename Generator = std::default_random_engine>
+template<typename Generator = default_generator>
 Vec3 normal3(const double mean = 0.0, const double variance = 1.0) {
     return {normal<double, Generator>(mean, variance),
             normal<double, Generator>(mean, variance),
             normal<double, Generator>(mean, variance)};
 }
 
-template<typename Iter, typename Gen = std::default_random_engine>
+/**
+ * Fills the range [first, last) with numbers uniformly distributed in [a, b). The generator is looked up once per
+ * call and the affine transformation is applied in a separate loop.
+ * @param first pointer to the first element of the range
+ * @param last pointer past the last element of the range
+ * @param a lower bound
+ * @param b upper bound
+ */
+template<typename RealType=double, typename Generator = default_generator>
+void fill_uniform(RealType *first, RealType *last, const RealType a = 0, const RealType b = 1) {
+    auto &generator = engine<Generator>();
+    const auto n = static_cast<std::size_t>(last - first);
+    for (std::size_t i = 0; i < n; ++i) {
+        first[i] = detail::canonical<RealType>(generator);
+    }
+    if (a != 0 || b != 1) {
+        const auto width = b - a;
+        for (std::size_t i = 0; i < n; ++i) {
+            first[i] = a + width * first[i];
+        }
+    }
+}
+
+/**
+ * Fills the range [first, last) with standard normally distributed numbers. The range is first filled with uniform
+ * numbers, which are then transformed pairwise by the Box-Muller method in a separate, branch free loop. This avoids
+ * constructing a distribution object per variate and keeps the transformation amenable to vectorization.
+ * @param first pointer to the first element of the range
+ * @param last pointer past the last element of the range
+ */
+template<typename RealType=double, typename Generator = default_generator>
+void fill_normal(RealType *first, RealType *last) {
+    static constexpr RealType two_pi = static_cast<RealType>(6.283185307179586476925286766559);
+    const auto n = static_cast<std::size_t>(last - first);
+    const auto nPairs = n / 2;
+    fill_uniform<RealType, Generator>(first, first + 2 * nPairs);
+    for (std::size_t i = 0; i < nPairs; ++i) {
+        // 1 - u lies in (0, 1], so that the logarithm is finite
+        const auto r = std::sqrt(-2 * std::log(1 - first[2 * i]));
+        const auto phi = two_pi * first[2 * i + 1];
+        first[2 * i] = r * std::cos(phi);
+        first[2 * i + 1] = r * std::sin(phi);
+    }
+    if (n % 2 == 1) {
+        first[n - 1] = normal<RealType, Generator>();
+    }
+}
+
+/**
+ * Fills the range [first, last) with exponentially distributed numbers by inversion of uniform numbers.
+ * @param first pointer to the first element of the range
+ * @param last pointer past the last element of the range
+ * @param lambda the rate
+ */
+template<typename RealType=double, typename Generator = default_generator>
+void fill_exponential(RealType *first, RealType *last, const RealType lambda = 1) {
+    const auto n = static_cast<std::size_t>(last - first);
+    fill_uniform<RealType, Generator>(first, last);
+    const auto scale = -1 / lambda;
+    for (std::size_t i = 0; i < n; ++i) {
+        first[i] = scale * std::log(1 - first[i]);
+    }
+}
+
+template<typename Iter, typename Gen = default_generator>
 Iter random_element(Iter start, const Iter end) {
     using IntType = typename std::iterator_traits<Iter>::difference_type;
     std::advance(start, uniform_int<IntType, Gen>(0, std::distance(start, end)));
@@ -33,6 +33,7 @@
 
 #include <readdy/model/Vec3.h>
 #include <readdy/model/Particle.h>
+#include <cstdint>
 #include <unordered_map>
 
 NAMESPACE_BEGIN(readdy)
@@ -49,6 +50,19 @@ public:
 
     virtual const bool isContained(const Vec3 &position) const = 0;
 
+    /**
+     * Evaluates the containment for a batch of positions given in structure of arrays layout. The default
+     * implementation calls isContained for each position, subclasses can provide a loop that is amenable to
+     * vectorization.
+     * @param x the x coordinates
+     * @param y the y coordinates
+     * @param z the z coordinates
+     * @param n the number of positions
+     * @param contained output, contained[i] is set to 1 if the i-th position is contained and to 0 otherwise
+     */
+    virtual void areContained(const double *x, const double *y, const double *z, std::size_t n,
+                              std::uint8_t *contained) const;
+
     const std::unordered_map<particleType_t, particleType_t> &getConversions() const {
         return conversions;
     }
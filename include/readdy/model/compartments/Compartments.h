@@ -45,6 +45,9 @@ public:
 
     virtual const bool isContained(const Vec3 &position) const override;
 
+    virtual void areContained(const double *x, const double *y, const double *z, std::size_t n,
+                              std::uint8_t *contained) const override;
+
 protected:
     const Vec3 origin;
     const double radius;
@@ -60,6 +63,9 @@ public:
 
     virtual const bool isContained(const Vec3 &position) const override;
 
+    virtual void areContained(const double *x, const double *y, const double *z, std::size_t n,
+                              std::uint8_t *contained) const override;
+
 protected:
     const Vec3 normalCoefficients;
     const double distanceFromOrigin;
@@ -62,6 +62,12 @@ protected:
 
     void setBinBorders(const std::vector<double> &binBorders);
 
+    /**
+     * turns the pair counts into the distribution, i.e., normalizes them by the bins' shell volumes
+     * @param nFromParticles the number of particles whose type is in typeCountFrom
+     */
+    void normalizeCounts(std::size_t nFromParticles);
+
     void initializeDataSet(io::File &file, const std::string &dataSetName, unsigned int flushStride) override;
 
     void append() override;
@@ -0,0 +1,103 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * The AsyncWriter owns a background thread that executes write tasks in the order in which they were enqueued. The
+ * number of pending tasks is bounded, enqueueing blocks while the queue is full, so that a simulation cannot run away
+ * from its I/O. Each kernel owns one writer, which is drained when the kernel is finalized.
+ *
+ * @file AsyncWriter.h
+ * @brief Header file containing the AsyncWriter, a bounded task queue that is processed by a dedicated writer thread
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <readdy/common/macros.h>
+
+NAMESPACE_BEGIN(readdy)
+NAMESPACE_BEGIN(model)
+NAMESPACE_BEGIN(observables)
+NAMESPACE_BEGIN(util)
+
+class AsyncWriter {
+public:
+    using task_t = std::function<void()>;
+
+    /**
+     * creates a new writer, the thread is started with the first task
+     * @param capacity the maximal number of pending tasks
+     */
+    explicit AsyncWriter(std::size_t capacity = 64);
+
+    /**
+     * processes all pending tasks and joins the writer thread
+     */
+    ~AsyncWriter();
+
+    AsyncWriter(const AsyncWriter &) = delete;
+
+    AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+    AsyncWriter(AsyncWriter &&) = delete;
+
+    AsyncWriter &operator=(AsyncWriter &&) = delete;
+
+    /**
+     * enqueues a task, blocks while the queue is full
+     * @param task the task
+     */
+    void enqueue(task_t task);
+
+    /**
+     * blocks until all tasks enqueued so far are processed. if a task threw, the first exception is rethrown.
+     */
+    void wait();
+
+private:
+    void work();
+
+    std::size_t capacity;
+    std::deque<task_t> tasks;
+    bool busy{false};
+    bool stopped{false};
+    std::exception_ptr firstException{nullptr};
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable taskDone;
+    std::thread thread;
+};
+
+NAMESPACE_END(util)
+NAMESPACE_END(observables)
+NAMESPACE_END(model)
+NAMESPACE_END(readdy)
@@ -44,7 +44,10 @@ NAMESPACE_BEGIN(util)
 class TimeSeriesWriter {
 public:
     TimeSeriesWriter(io::Group &group, unsigned int chunkSize, const std::string &dsName = "time") :
-            dataSet(group.createDataSet<time_step_type>(dsName, {chunkSize}, {io::h5::UNLIMITED_DIMS})) {}
+            dataSet(group.createDataSet<time_step_type>(dsName, {chunkSize}, {io::h5::UNLIMITED_DIMS})) {
+        // the time steps are gathered and written chunk-wise, pending ones on flush or destruction
+        dataSet.setBuffered(true);
+    }
 
     ~TimeSeriesWriter() = default;
 
@@ -60,6 +63,10 @@ public:
         dataSet.append({1}, &t);
     }
 
+    void append(const std::vector<time_step_type> &ts) {
+        if (!ts.empty()) dataSet.append({ts.size()}, ts.data());
+    }
+
     void flush() {
         dataSet.flush();
     }
@@ -95,6 +95,49 @@ protected:
     std::unique_ptr<Impl> pimpl;
 };
 
+/**
+ * Trajectory for simulations with a constant or bounded number of particles. Positions, ids and types are stored in
+ * separate data sets of fixed width (frames x particles x ...), which are chunked along frames and particles, so that
+ * single frames or particles can be read without touching the rest of the trajectory. Frames with fewer particles
+ * than the bound are padded with invalid ids and types, the number of particles per frame is stored alongside.
+ */
+class ColumnarTrajectory : public Observable<std::vector<TrajectoryEntry>> {
+    using super = Observable<std::vector<TrajectoryEntry>>;
+public:
+
+    /**
+     * maximal number of particles per chunk
+     */
+    static constexpr std::size_t particles_per_chunk = 1024;
+
+    /**
+     * Creates a new columnar trajectory.
+     * @param kernel the kernel
+     * @param stride the stride
+     * @param maxParticles upper bound of particles per frame, if 0 the number of particles in the first frame is used,
+     *        which then must not be empty
+     * @param singlePrecision whether positions should be stored as 32 bit floats
+     * @param precision if positive, positions are quantized to multiples of precision and stored as 32 bit integers,
+     *        half of the largest box edge divided by the precision must be smaller than the largest 32 bit integer
+     */
+    ColumnarTrajectory(Kernel *const kernel, unsigned int stride, std::size_t maxParticles = 0,
+                       bool singlePrecision = false, double precision = 0);
+
+    ~ColumnarTrajectory();
+
+    virtual void evaluate() override;
+
+    virtual void flush() override;
+
+protected:
+    void initializeDataSet(io::File &file, const std::string &dataSetName, unsigned int flushStride) override;
+
+    void append() override;
+
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
 NAMESPACE_END(observables)
 NAMESPACE_END(model)
 NAMESPACE_END(readdy)
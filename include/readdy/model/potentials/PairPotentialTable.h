@@ -0,0 +1,256 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          * 
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+/**
+ * The pair potential table is a flattened, compiled form of the order 2 potentials in the PotentialRegistry. For each
+ * pair of particle types it holds a contiguous range of plain parameter records that are tagged with the kind of
+ * potential, so that force loops can evaluate the built-in potentials inline instead of performing a hash map lookup
+ * and virtual calls per neighbor pair. Potentials of unknown kind are evaluated through their virtual interface.
+ *
+ * @file PairPotentialTable.h
+ * @brief Header file containing the dense type-pair table of order 2 potentials and their inline force kernels
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <readdy/common/macros.h>
+#include <readdy/model/Vec3.h>
+#include "PotentialOrder2.h"
+#include "TabulatedPotentialOrder2.h"
+
+NAMESPACE_BEGIN(readdy)
+NAMESPACE_BEGIN(model)
+NAMESPACE_BEGIN(potentials)
+
+enum class PairPotentialKind : std::uint8_t {
+    HARMONIC_REPULSION, WEAK_INTERACTION_PIECEWISE_HARMONIC, LENNARD_JONES, SCREENED_ELECTROSTATICS, TABULATED, GENERIC
+};
+
+/**
+ * Tagged parameters of a single order 2 potential. The meaning of the parameter array depends on the kind:
+ *  - HARMONIC_REPULSION: force constant, sum of radii
+ *  - WEAK_INTERACTION_PIECEWISE_HARMONIC: force constant, desired distance, depth, no interaction distance
+ *  - LENNARD_JONES: prefactor k, m, n, sigma, energy shift
+ *  - SCREENED_ELECTROSTATICS: electrostatic strength, inverse screening depth, repulsion strength, repulsion distance,
+ *    exponent
+ *  - TABULATED: unused, the table is interpolated through the pointer to the TabulatedPotentialOrder2
+ *  - GENERIC: unused, the potential is evaluated through the pointer
+ */
+struct PairPotentialEntry {
+    PairPotentialKind kind;
+    double cutoffSquared;
+    std::array<double, 5> params;
+    const PotentialOrder2 *potential;
+};
+
+NAMESPACE_BEGIN(pair_kernels)
+
+/**
+ * Adds force and energy of one potential evaluated at the separation vector x_ij to the accumulators, where the
+ * squared distance is known to be smaller than the cutoff squared. Specialized for each kind of potential.
+ */
+template<PairPotentialKind kind>
+inline void forceAndEnergy(const PairPotentialEntry &entry, const Vec3 &x_ij, double distSquared, Vec3 &force,
+                           double &energy);
+
+template<>
+inline void forceAndEnergy<PairPotentialKind::HARMONIC_REPULSION>(const PairPotentialEntry &entry, const Vec3 &x_ij,
+                                                                  double distSquared, Vec3 &force, double &energy) {
+    if (distSquared > 0) {
+        const auto forceConstant = entry.params[0];
+        const auto dist = std::sqrt(distSquared);
+        const auto delta = dist - entry.params[1];
+        energy += 0.5 * forceConstant * delta * delta;
+        force += (forceConstant * delta / dist) * x_ij;
+    }
+}
+
+template<>
+inline void forceAndEnergy<PairPotentialKind::WEAK_INTERACTION_PIECEWISE_HARMONIC>(
+        const PairPotentialEntry &entry, const Vec3 &x_ij, double distSquared, Vec3 &force, double &energy) {
+    const auto forceConstant = entry.params[0];
+    const auto desiredDistance = entry.params[1];
+    const auto depth = entry.params[2];
+    const auto noInteractionDistance = entry.params[3];
+    const auto dist = std::sqrt(distSquared);
+    const auto halfLen = .5 * (noInteractionDistance - desiredDistance);
+    const auto curvature = depth / (halfLen * halfLen);
+    double factor;
+    if (dist < desiredDistance) {
+        energy += .5 * forceConstant * (dist - desiredDistance) * (dist - desiredDistance) - depth;
+        factor = -1 * forceConstant * (desiredDistance - dist);
+    } else if (dist < desiredDistance + halfLen) {
+        energy += .5 * curvature * (dist - desiredDistance) * (dist - desiredDistance) - depth;
+        factor = -1 * curvature * (desiredDistance - dist);
+    } else {
+        energy += -.5 * curvature * (dist - noInteractionDistance) * (dist - noInteractionDistance);
+        factor = curvature * (noInteractionDistance - dist);
+    }
+    if (dist > 0) {
+        force += (factor / dist) * x_ij;
+    }
+}
+
+template<>
+inline void forceAndEnergy<PairPotentialKind::LENNARD_JONES>(const PairPotentialEntry &entry, const Vec3 &x_ij,
+                                                             double distSquared, Vec3 &force, double &energy) {
+    const auto k = entry.params[0];
+    const auto m = entry.params[1];
+    const auto n = entry.params[2];
+    const auto sigma = entry.params[3];
+    const auto ratio = sigma / std::sqrt(distSquared);
+    const auto ratioM = std::pow(ratio, m);
+    const auto ratioN = std::pow(ratio, n);
+    const auto ratioSquared = ratio * ratio;
+    energy += k * (ratioM - ratioN) - entry.params[4];
+    force -= (k / (sigma * sigma) * (m * ratioM * ratioSquared - n * ratioN * ratioSquared)) * x_ij;
+}
+
+template<>
+inline void forceAndEnergy<PairPotentialKind::SCREENED_ELECTROSTATICS>(
+        const PairPotentialEntry &entry, const Vec3 &x_ij, double distSquared, Vec3 &force, double &energy) {
+    const auto electrostaticStrength = entry.params[0];
+    const auto inverseScreeningDepth = entry.params[1];
+    const auto repulsionStrength = entry.params[2];
+    const auto repulsionDistance = entry.params[3];
+    const auto exponent = entry.params[4];
+    const auto dist = std::sqrt(distSquared);
+    const auto screened = electrostaticStrength * std::exp(-inverseScreeningDepth * dist);
+    const auto repulsion = std::pow(repulsionDistance / dist, exponent);
+    energy += screened / dist + repulsionStrength * repulsion;
+    const auto forceFactor = screened * (inverseScreeningDepth / dist + 1. / distSquared)
+                             + repulsionStrength * exponent / dist * repulsion;
+    force -= (forceFactor / dist) * x_ij;
+}
+
+template<>
+inline void forceAndEnergy<PairPotentialKind::TABULATED>(const PairPotentialEntry &entry, const Vec3 &x_ij,
+                                                         double distSquared, Vec3 &force, double &energy) {
+    static_cast<const TabulatedPotentialOrder2 *>(entry.potential)->evaluate(x_ij, distSquared, force, energy);
+}
+
+template<>
+inline void forceAndEnergy<PairPotentialKind::GENERIC>(const PairPotentialEntry &entry, const Vec3 &x_ij, double,
+                                                       Vec3 &force, double &energy) {
+    Vec3 update{0, 0, 0};
+    entry.potential->calculateForceAndEnergy(update, energy, x_ij);
+    force += update;
+}
+
+/**
+ * evaluates a potential of arbitrary kind by switching over its tag
+ */
+inline void forceAndEnergy(const PairPotentialEntry &entry, const Vec3 &x_ij, double distSquared, Vec3 &force,
+                           double &energy) {
+    switch (entry.kind) {
+        case PairPotentialKind::HARMONIC_REPULSION:
+            forceAndEnergy<PairPotentialKind::HARMONIC_REPULSION>(entry, x_ij, distSquared, force, energy);
+            break;
+        case PairPotentialKind::WEAK_INTERACTION_PIECEWISE_HARMONIC:
+            forceAndEnergy<PairPotentialKind::WEAK_INTERACTION_PIECEWISE_HARMONIC>(entry, x_ij, distSquared, force,
+                                                                                   energy);
+            break;
+        case PairPotentialKind::LENNARD_JONES:
+            forceAndEnergy<PairPotentialKind::LENNARD_JONES>(entry, x_ij, distSquared, force, energy);
+            break;
+        case PairPotentialKind::SCREENED_ELECTROSTATICS:
+            forceAndEnergy<PairPotentialKind::SCREENED_ELECTROSTATICS>(entry, x_ij, distSquared, force, energy);
+            break;
+        case PairPotentialKind::TABULATED:
+            forceAndEnergy<PairPotentialKind::TABULATED>(entry, x_ij, distSquared, force, energy);
+            break;
+        case PairPotentialKind::GENERIC:
+            forceAndEnergy<PairPotentialKind::GENERIC>(entry, x_ij, distSquared, force, energy);
+            break;
+    }
+}
+
+NAMESPACE_END(pair_kernels)
+
+class PairPotentialTable {
+public:
+    using particle_type_type = readdy::model::Particle::type_type;
+    using entries_t = std::vector<PairPotentialEntry>;
+    using const_iterator = entries_t::const_iterator;
+
+    /**
+     * Number of particle types spanned by the table, i.e., the largest type id plus one.
+     * @return the number of types
+     */
+    std::size_t nTypes() const {
+        return _nTypes;
+    }
+
+    bool empty() const {
+        return _entries.empty();
+    }
+
+    /**
+     * If all type pairs carry at most one potential and all potentials are of the same kind, this returns true and
+     * the kind is written into the argument. Force loops can then be specialized to that kind entirely.
+     * @param kind the common kind
+     * @return whether there is a common kind
+     */
+    bool uniform(PairPotentialKind &kind) const {
+        kind = _uniformKind;
+        return _uniform;
+    }
+
+    /**
+     * pointer to the first potential entry of a type pair
+     */
+    const PairPotentialEntry *begin(particle_type_type t1, particle_type_type t2) const {
+        return _entries.data() + _offsets[t1 * _nTypes + t2];
+    }
+
+    /**
+     * pointer past the last potential entry of a type pair
+     */
+    const PairPotentialEntry *end(particle_type_type t1, particle_type_type t2) const {
+        return _entries.data() + _offsets[t1 * _nTypes + t2 + 1];
+    }
+
+    const entries_t &entries() const {
+        return _entries;
+    }
+
+private:
+    friend class PotentialRegistry;
+
+    std::size_t _nTypes{0};
+    std::vector<std::size_t> _offsets{0};
+    entries_t _entries{};
+    bool _uniform{false};
+    PairPotentialKind _uniformKind{PairPotentialKind::GENERIC};
+};
+
+NAMESPACE_END(potentials)
+NAMESPACE_END(model)
+NAMESPACE_END(readdy)
@@ -38,6 +38,8 @@
 #include <readdy/model/ParticleTypeRegistry.h>
 #include "PotentialOrder1.h"
 #include "PotentialOrder2.h"
+#include "PairPotentialTable.h"
+#include "TabulatedPotentialOrder2.h"
 
 NAMESPACE_BEGIN(readdy)
 NAMESPACE_BEGIN(model)
@@ -86,12 +88,28 @@ public:
 
     const potential_o2_registry &potentials_order2() const;
 
+    /**
+     * The order 2 potentials flattened into a dense table over type pairs, only valid after configure().
+     * @return the table
+     */
+    const PairPotentialTable &pair_potential_table() const;
+
     const potentials_o1 &potentials_of(const std::string &type) const;
 
     const potentials_o2 &potentials_of(const std::string &t1, const std::string &t2) const;
 
     void configure();
 
+    /**
+     * If enabled, configure() replaces all order 2 potentials that are expensive to evaluate, i.e., everything but
+     * harmonic repulsion and weak interaction piecewise harmonic potentials, by TabulatedPotentialOrder2 instances.
+     * @param enabled whether potentials should be tabulated
+     * @param nSamples the number of grid points of each table
+     */
+    void setAutoTabulate(bool enabled, std::size_t nSamples = TabulatedPotentialOrder2::default_n_samples);
+
+    bool autoTabulate() const;
+
     void debug_output() const;
 
 private:
@@ -111,6 +129,17 @@ private:
     pot_ptr_vec1_external defaultPotentialsO1{};
     pot_ptr_vec2_external defaultPotentialsO2{};
 
+    PairPotentialTable pairPotentialTable{};
+
+    bool autoTabulateEnabled{false};
+    std::size_t nTabulationSamples{TabulatedPotentialOrder2::default_n_samples};
+    // tables are kept by the id of the tabulated potential, so that they survive reconfiguration
+    std::unordered_map<Potential::id_t, std::unique_ptr<TabulatedPotentialOrder2>> tabulatedPotentials{};
+
+    void tabulatePotentials();
+
+    void compilePairPotentialTable();
+
 };
 
 NAMESPACE_END(potentials)
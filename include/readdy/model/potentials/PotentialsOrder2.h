@@ -90,6 +90,7 @@ public:
 
     private:
         friend class WeakInteractionPiecewiseHarmonic;
+        friend class readdy::model::potentials::PotentialRegistry;
 
         const double desiredParticleDistance, depthAtDesiredDistance, noInteractionDistance, noInteractionDistanceSquared;
     };
@@ -0,0 +1,128 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          * 
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+/**
+ * A tabulated potential samples energy and force of another order 2 potential on an equidistant grid in the squared
+ * distance r^2 and evaluates them by cubic (Catmull-Rom) interpolation. Since all pair potentials are radially
+ * symmetric, the force is stored as scalar factor f(r^2) with F = f(r^2) * x_ij. Evaluation then costs a few
+ * multiplications regardless of whether the original potential involves transcendental functions or calls back into
+ * python.
+ *
+ * @file TabulatedPotentialOrder2.h
+ * @brief Header file containing the declaration of the tabulated order 2 potential
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "PotentialOrder2.h"
+
+NAMESPACE_BEGIN(readdy)
+NAMESPACE_BEGIN(model)
+NAMESPACE_BEGIN(potentials)
+
+class TabulatedPotentialOrder2 : public PotentialOrder2 {
+    using super = PotentialOrder2;
+public:
+    /**
+     * the default number of grid points
+     */
+    static constexpr std::size_t default_n_samples = 2048;
+
+    /**
+     * Creates a new tabulated potential. The table is filled when the potential is configured, the tabulated
+     * potential has to be configured already at that point.
+     * @param particleType1 the first particle type
+     * @param particleType2 the second particle type
+     * @param potential the tabulated potential, must outlive this object
+     * @param nSamples the number of grid points, at least 2
+     */
+    TabulatedPotentialOrder2(const std::string &particleType1, const std::string &particleType2,
+                             const PotentialOrder2 *potential, std::size_t nSamples = default_n_samples);
+
+    std::string describe() const override;
+
+    double getMaximalForce(double kbt) const noexcept override;
+
+    double calculateEnergy(const Vec3 &x_ij) const override;
+
+    void calculateForce(Vec3 &force, const Vec3 &x_ij) const override;
+
+    void calculateForceAndEnergy(Vec3 &force, double &energy, const Vec3 &x_ij) const override;
+
+    double getCutoffRadius() const override;
+
+    double getCutoffRadiusSquared() const override;
+
+    /**
+     * @return the potential this table was sampled from
+     */
+    const PotentialOrder2 *getTabulatedPotential() const;
+
+    /**
+     * Adds force and energy at x_ij to the accumulators by interpolating the table.
+     * @param x_ij the separation vector
+     * @param distSquared its squared norm
+     * @param force the force accumulator
+     * @param energy the energy accumulator
+     */
+    void evaluate(const Vec3 &x_ij, const double distSquared, Vec3 &force, double &energy) const {
+        const auto x = (std::max(distSquared, sMin) - sMin) * inverseSpacing;
+        const auto i = std::min(static_cast<std::size_t>(x), nSamples - 2);
+        const auto t = x - i;
+        const auto t2 = t * t;
+        const auto t3 = t2 * t;
+        // catmull-rom weights, the table is padded with one ghost sample on each side
+        const auto w0 = .5 * (-t3 + 2 * t2 - t);
+        const auto w1 = .5 * (3 * t3 - 5 * t2 + 2);
+        const auto w2 = .5 * (-3 * t3 + 4 * t2 + t);
+        const auto w3 = .5 * (t3 - t2);
+        const auto *s = &table[i];
+        energy += w0 * s[0].energy + w1 * s[1].energy + w2 * s[2].energy + w3 * s[3].energy;
+        force += (w0 * s[0].forceFactor + w1 * s[1].forceFactor + w2 * s[2].forceFactor + w3 * s[3].forceFactor)
+                 * x_ij;
+    }
+
+protected:
+    friend class readdy::model::potentials::PotentialRegistry;
+
+    void configureForTypes(const ParticleTypeRegistry *const context, particle_type_type type1,
+                           particle_type_type type2) override;
+
+    struct Sample {
+        double energy;
+        double forceFactor;
+    };
+
+    const PotentialOrder2 *const potential;
+    const std::size_t nSamples;
+    double sMin{0}, inverseSpacing{0}, cutoffSquared{0};
+    std::vector<Sample> table;
+};
+
+NAMESPACE_END(potentials)
+NAMESPACE_END(model)
+NAMESPACE_END(readdy)
@@ -32,7 +32,13 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <readdy/common/macros.h>
+#include <readdy/common/hash.h>
 
 #include "Topology.h"
 #include "graph/Graph.h"
@@ -42,6 +48,114 @@ NAMESPACE_BEGIN(readdy)
 NAMESPACE_BEGIN(model)
 NAMESPACE_BEGIN(top)
 
+NAMESPACE_BEGIN(detail)
+
+/**
+ * Index over the bonds, angles or dihedrals of a graph topology, each given as canonically ordered tuple of particle
+ * indices. It maps a tuple to the positions of its configurations in the potentials and a particle to the tuples that
+ * contain it, so that the tuples around a vertex can be replaced without enumerating the whole graph.
+ * @tparam N the number of particles per tuple
+ * @tparam Type the potential type enum
+ */
+template<std::size_t N, typename Type>
+class bonded_tuples {
+public:
+    using key_type = std::array<std::size_t, N>;
+    using entry = std::tuple<Type, std::size_t>;
+
+    struct key_hasher {
+        std::size_t operator()(const key_type &key) const {
+            std::size_t seed{0};
+            for (const auto idx : key) {
+                readdy::util::hash::combine(seed, idx);
+            }
+            return seed;
+        }
+    };
+
+    using key_set = std::unordered_set<key_type, key_hasher>;
+
+    /**
+     * removes all tuples
+     * @param nParticles the number of particles in the topology
+     */
+    void reset(std::size_t nParticles) {
+        _entries.clear();
+        _incident.clear();
+        _incident.resize(nParticles);
+    }
+
+    bool contains(const key_type &key) const {
+        return _entries.find(key) != _entries.end();
+    }
+
+    /**
+     * registers a configuration of a tuple
+     * @param key the tuple
+     * @param type the potential type
+     * @param position the configuration's position in the configurations of that type
+     */
+    void insert(const key_type &key, Type type, std::size_t position) {
+        auto &entries = _entries[key];
+        if (entries.empty()) {
+            for (const auto idx : key) {
+                _incident.at(idx).insert(key);
+            }
+        }
+        entries.emplace_back(type, position);
+    }
+
+    /**
+     * @param particleIndex the particle index
+     * @return the tuples containing that particle
+     */
+    const key_set &incident(std::size_t particleIndex) const {
+        return _incident.at(particleIndex);
+    }
+
+    /**
+     * Removes a tuple. Its configurations are swap-removed from configurations(type), the configuration that fills a
+     * gap is found again via its tuple keyOf(configuration).
+     * @param key the tuple
+     * @param configurations yields the vector of configurations for a type
+     * @param keyOf yields the tuple of a configuration
+     */
+    template<typename Configurations, typename KeyOf>
+    void erase(const key_type &key, const Configurations &configurations, const KeyOf &keyOf) {
+        auto it = _entries.find(key);
+        if (it == _entries.end()) return;
+        auto entries = std::move(it->second);
+        _entries.erase(it);
+        for (const auto idx : key) {
+            _incident.at(idx).erase(key);
+        }
+        // back to front, so that none of the tuple's own configurations is moved into a gap
+        std::sort(entries.begin(), entries.end(), [](const entry &e1, const entry &e2) {
+            return std::get<1>(e1) > std::get<1>(e2);
+        });
+        for (const auto &e : entries) {
+            auto &cfgs = configurations(std::get<0>(e));
+            const auto position = std::get<1>(e);
+            const auto last = cfgs.size() - 1;
+            if (position != last) {
+                cfgs[position] = std::move(cfgs[last]);
+                for (auto &moved : _entries.at(keyOf(cfgs[position]))) {
+                    if (moved == entry(std::get<0>(e), last)) {
+                        std::get<1>(moved) = position;
+                    }
+                }
+            }
+            cfgs.pop_back();
+        }
+    }
+
+private:
+    std::unordered_map<key_type, std::vector<entry>, key_hasher> _entries;
+    std::vector<key_set> _incident;
+};
+
+NAMESPACE_END(detail)
+
 class GraphTopology : public Topology {
 public:
 
@@ -87,8 +201,25 @@ public:
 
     const graph_t &graph() const;
 
+    /**
+     * Validates the graph and sets up the bonded potentials from scratch, enumerating all bonds, angles and dihedrals.
+     */
     void configure();
 
+    /**
+     * Updates the bonded potentials after vertices were marked by markChanged(). Only the bonds, angles and dihedrals
+     * containing a marked vertex are removed and enumerated again, which for a changed edge touches O(degree^2)
+     * tuples. Falls back to configure() if the topology was not configured before.
+     */
+    void updateBondedPotentials();
+
+    /**
+     * Marks a vertex whose edges or particle type change, see updateBondedPotentials(). The vertex must not be
+     * removed from the graph until the bonded potentials were updated.
+     * @param vertex the vertex
+     */
+    void markChanged(graph::Vertex::vertex_ptr vertex);
+
     void updateReactionRates();
 
     void validate();
@@ -116,6 +247,32 @@ protected:
     topology_reactions reactions_;
     rate_t _cumulativeRate;
     bool deactivated {false};
+
+private:
+    void insertBond(graph::Vertex::vertex_ptr v1, graph::Vertex::vertex_ptr v2);
+
+    void insertAngle(graph::Vertex::vertex_ptr v1, graph::Vertex::vertex_ptr center, graph::Vertex::vertex_ptr v2);
+
+    void insertDihedral(graph::Vertex::vertex_ptr v1, graph::Vertex::vertex_ptr v2, graph::Vertex::vertex_ptr v3,
+                        graph::Vertex::vertex_ptr v4);
+
+    pot::BondedPotential::bonds_t &bonds(api::BondType type);
+
+    pot::HarmonicAnglePotential::angles_t &angles(api::AngleType type);
+
+    pot::CosineDihedralPotential::dihedrals_t &dihedrals(api::TorsionType type);
+
+    detail::bonded_tuples<2, api::BondType> _bonds;
+    detail::bonded_tuples<3, api::AngleType> _angles;
+    detail::bonded_tuples<4, api::TorsionType> _dihedrals;
+    // the potentials holding the configurations of the indexed tuples, owned by the topology
+    template<typename Type, typename Potential>
+    using potentials_by_type = std::unordered_map<Type, Potential *, readdy::util::hash::EnumClassHash>;
+    potentials_by_type<api::BondType, pot::BondedPotential> _bondPotentials;
+    potentials_by_type<api::AngleType, pot::HarmonicAnglePotential> _anglePotentials;
+    potentials_by_type<api::TorsionType, pot::CosineDihedralPotential> _torsionPotentials;
+    std::vector<graph::Vertex::vertex_ptr> _changedVertices;
+    bool _configured {false};
 };
 
 NAMESPACE_END(top)
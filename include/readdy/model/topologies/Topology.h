@@ -91,6 +91,7 @@ public:
     template<typename T, typename... Args>
     typename std::enable_if<std::is_base_of<bonded_potential, T>::value>::type addBondedPotential(Args &&...args) {
         bondedPotentials.push_back(std::make_unique<T>(this, std::forward<Args>(args)...));
+        touch();
     }
 
     void addBondedPotential(std::unique_ptr<bonded_potential> &&);
@@ -98,6 +99,7 @@ public:
     template<typename T, typename... Args>
     typename std::enable_if<std::is_base_of<angle_potential, T>::value>::type addAnglePotential(Args &&...args) {
         anglePotentials.push_back(std::make_unique<T>(this, std::forward<Args>(args)...));
+        touch();
     }
 
     void addAnglePotential(std::unique_ptr<angle_potential> &&);
@@ -105,13 +107,28 @@ public:
     template<typename T, typename... Args>
     typename std::enable_if<std::is_base_of<torsion_potential, T>::value>::type addTorsionPotential(Args &&...args) {
         torsionPotentials.push_back(std::make_unique<T>(this, std::forward<Args>(args)...));
+        touch();
     }
 
     void addTorsionPotential(std::unique_ptr<torsion_potential> &&);
 
     virtual void permuteIndices(const std::vector<std::size_t> &permutation);
 
+    /**
+     * The version changes whenever the particles, the potentials or the reaction rates of the topology might have
+     * changed, including non-const access to the particles. Versions are unique among all topologies, so that kernels
+     * can cache information derived from a topology and recognize when it became stale.
+     * @return the version
+     */
+    std::size_t version() const;
+
 protected:
+    /**
+     * assigns a new version
+     */
+    void touch();
+
+    std::size_t _version;
     particles_t particles;
     std::vector<std::unique_ptr<bonded_potential>> bondedPotentials;
     std::vector<std::unique_ptr<angle_potential>> anglePotentials;
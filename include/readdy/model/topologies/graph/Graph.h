@@ -68,6 +68,17 @@ public:
 
     using vertex_label_mapping = std::unordered_map<std::string, vertex_ref>;
 
+    /**
+     * Compact snapshot of the adjacency in CSR layout with integer vertex handles. The handle of a vertex is its
+     * position in the vertex list, the neighbors of the vertex with handle h are
+     * neighbors[offsets[h]], ..., neighbors[offsets[h + 1] - 1], in the order of Vertex::neighbors().
+     */
+    struct Adjacency {
+        std::vector<Vertex::vertex_ptr> vertices;
+        std::vector<std::size_t> offsets;
+        std::vector<std::size_t> neighbors;
+    };
+
     Graph() = default;
 
     Graph(vertex_list vertexList, vertex_label_mapping vertexLabelMapping);
@@ -140,12 +151,28 @@ public:
 
     void removeParticle(std::size_t particleIndex);
 
+    /**
+     * The compact adjacency. It is cached and only rebuilt in O(V + E) if vertices or edges were added or removed
+     * through this graph since the last call.
+     * @return the adjacency
+     */
+    const Adjacency &adjacency();
+
     bool isConnected();
 
     const vertex_label_mapping& vertexLabelMapping() const;
 
     vertex_label_mapping& vertexLabelMapping();
 
+    /**
+     * Reports each edge, each path of length 2 and each path of length 3 once. A path (x, u, v, y) of length 3 is only
+     * reported if neither x is adjacent to v nor y is adjacent to u, so that whether it is a path is independent of the
+     * order in which vertices are visited. The traversal runs on the cached adjacency, so the callbacks must not add or
+     * remove vertices or edges.
+     * @param tuple_callback called for the edges
+     * @param triple_callback called for the paths of length 2, the middle vertex being the center
+     * @param quadruple_callback called for the paths of length 3
+     */
     void findNTuples(const edge_callback &tuple_callback,
                      const path_len_2_callback &triple_callback,
                      const path_len_3_callback &quadruple_callback);
@@ -154,7 +181,8 @@ public:
     findNTuples();
 
     /**
-     * Returns the connected components, invalidates this graph
+     * Returns the connected components, invalidates this graph. The vertices are spliced into the components, so that
+     * this takes O(V + E) and references to vertices stay valid.
      * @return connected components
      */
     std::vector<Graph> connectedComponentsDestructive();
@@ -162,6 +190,8 @@ public:
 private:
     vertex_list _vertices;
     vertex_label_mapping _vertex_label_mapping{};
+    Adjacency _adjacency{};
+    bool _adjacencyValid{false};
 
     void removeNeighborsEdges(vertex_ref vertex);
 
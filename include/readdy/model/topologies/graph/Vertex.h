@@ -69,7 +69,7 @@ public:
      * @param particleIndex the particle index this vertex belongs to
      */
     Vertex(std::size_t particleIndex, particle_type_type particleType, const std::string &label = "")
-            : particleIndex(particleIndex), _label(label), visited(false), particleType_(particleType) {}
+            : particleIndex(particleIndex), _label(label), particleType_(particleType) {}
 
     Vertex(const Vertex &) = delete;
 
@@ -143,11 +143,6 @@ public:
         particleType_ = type;
     }
 
-    /**
-     * flag if this vertex has been visited (for BFS/DFS)
-     */
-    bool visited;
-
 private:
     friend class readdy::model::top::graph::Graph;
 
@@ -158,6 +153,10 @@ private:
 
     particle_type_type particleType_;
     label_t _label{""};
+    /**
+     * position in the vertex list, assigned by Graph::adjacency()
+     */
+    std::size_t _handle{0};
 };
 
 class VertexRef;
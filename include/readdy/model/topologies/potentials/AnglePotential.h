@@ -55,8 +55,8 @@ struct AngleConfiguration {
 
     AngleConfiguration(size_t idx1, size_t idx2, size_t idx3, double forceConstant, double equilibriumAngle);
 
-    const std::size_t idx1, idx2, idx3;
-    const double equilibriumAngle, forceConstant;
+    std::size_t idx1, idx2, idx3;
+    double equilibriumAngle, forceConstant;
 };
 
 
@@ -80,6 +80,8 @@ public:
     calculateForce(Vec3 &f_i, Vec3 &f_j, Vec3 &f_k, const Vec3 &x_ji, const Vec3 &x_jk, const angle_t &angle) const;
 
 protected:
+    friend class readdy::model::top::GraphTopology;
+
     angles_t angles;
 };
 
@@ -61,6 +61,8 @@ public:
 
     const bonds_t &getBonds() const;
 protected:
+    friend class readdy::model::top::GraphTopology;
+
     bonds_t bonds;
 };
 
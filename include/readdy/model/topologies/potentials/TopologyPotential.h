@@ -38,6 +38,7 @@ NAMESPACE_BEGIN(readdy)
 NAMESPACE_BEGIN(model)
 NAMESPACE_BEGIN(top)
 class Topology;
+class GraphTopology;
 class TopologyActionFactory;
 NAMESPACE_BEGIN(pot)
 
@@ -74,6 +74,8 @@ public:
     createForceAndEnergyAction(const TopologyActionFactory *const factory) override;
 
 protected:
+    friend class readdy::model::top::GraphTopology;
+
     dihedrals_t dihedrals;
 };
 
@@ -49,6 +49,12 @@ public:
 
     CPUKernel();
 
+    /**
+     * Creates a kernel whose particle data is stored in the given layout.
+     * @param layout the memory layout of the particle data
+     */
+    explicit CPUKernel(model::CPUParticleData::Layout layout);
+
     ~CPUKernel();
 
     // factory method
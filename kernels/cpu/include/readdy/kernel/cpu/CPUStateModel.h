@@ -56,7 +56,8 @@ public:
     using topologies_t = readdy::util::index_persistent_vector<std::unique_ptr<readdy::model::top::GraphTopology>>;
 
     CPUStateModel(readdy::model::KernelContext *const context, readdy::util::thread::Config const *const config,
-                  readdy::model::top::TopologyActionFactory const *const taf);
+                  readdy::model::top::TopologyActionFactory const *const taf,
+                  data_t::Layout layout = data_t::Layout::aos);
 
     ~CPUStateModel();
 
@@ -64,6 +65,10 @@ public:
 
     virtual const std::vector<particle_t> getParticles() const override;
 
+    virtual std::size_t getNParticles() const override;
+
+    virtual void toTrajectoryFrame(std::vector<readdy::model::observables::TrajectoryEntry> &frame) const override;
+
     virtual void updateNeighborList() override;
 
     virtual void calculateForces() override;
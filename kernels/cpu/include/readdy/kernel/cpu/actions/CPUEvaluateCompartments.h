@@ -36,6 +36,10 @@ namespace kernel {
 namespace cpu {
 namespace actions {
 
+/**
+ * Evaluates the compartments in parallel. Only particles of types that are converted by at least one compartment are
+ * considered, their positions are tested in blocks against each compartment.
+ */
 class CPUEvaluateCompartments : public readdy::model::actions::EvaluateCompartments {
 public:
     CPUEvaluateCompartments(CPUKernel *const kernel);
@@ -35,6 +35,7 @@
 
 #include <readdy/model/actions/Actions.h>
 #include "../CPUKernel.h"
+#include "../util/fenwick_tree.h"
 
 namespace readdy {
 namespace kernel {
@@ -42,14 +43,51 @@ namespace cpu {
 namespace actions {
 namespace top {
 
+/**
+ * Evaluates the topology reactions. The reaction rates of all topologies are kept in a Fenwick tree that persists
+ * between time steps, where topology slot s occupies the leaves [s * stride, (s+1) * stride). Only the leaves of
+ * topologies whose version changed since the last call are updated. Within a time step, the events are drawn without
+ * replacement and proportionally to their rates. Each event is performed with probability rate * timeStep, after which
+ * the other events of its topology are discarded, otherwise it is discarded itself.
+ */
 class CPUEvaluateTopologyReactions : public readdy::model::actions::top::EvaluateTopologyReactions {
 public:
+    using rate_t = readdy::model::top::GraphTopology::rate_t;
+
     CPUEvaluateTopologyReactions(CPUKernel *const kernel, double timeStep);
 
     virtual void perform() override;
 
+    /**
+     * brings the rate tree up to date with the topologies of the kernel
+     */
+    void updateRates();
+
+    /**
+     * the rates of the topologies' reactions, see updateRates()
+     * @return the rate tree
+     */
+    const util::fenwick_tree<rate_t> &rates() const;
+
+    /**
+     * the number of leaves of the rate tree reserved for each topology
+     * @return the stride
+     */
+    std::size_t stride() const;
+
 private:
+    /**
+     * the version of a topology slot that has not been seen yet
+     */
+    static constexpr std::size_t unknown_version = static_cast<std::size_t>(-1);
+
     CPUKernel *const kernel;
+    util::fenwick_tree<rate_t> _rates;
+    // per topology slot the version whose rates are in the tree, zero for deactivated topologies
+    std::vector<std::size_t> _versions;
+    // the number of leaves with positive rate
+    std::size_t _nEvents{0};
+    std::size_t _stride{0};
 };
 
 
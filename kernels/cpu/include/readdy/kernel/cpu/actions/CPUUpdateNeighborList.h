@@ -52,9 +52,20 @@ public:
             firstRun = false;
         }
         switch (operation) {
-            case create:
+            case create: {
+                const auto &neighborList = *kernel->getCPUKernelStateModel().getNeighborList();
+                const auto before = neighborList.stats();
                 kernel->getKernelStateModel().updateNeighborList();
+                const auto &after = neighborList.stats();
+                auto &performance = kernel->performance();
+                performance.counter("neighbor_list.updates") += after.n_updates - before.n_updates;
+                performance.counter("neighbor_list.rebuilds") += after.n_rebuilds - before.n_rebuilds;
+                performance.counter("neighbor_list.adaptive_updates") +=
+                        after.n_adaptive_updates - before.n_adaptive_updates;
+                performance.counter("neighbor_list.dirty_cells") += after.n_dirty_cells - before.n_dirty_cells;
+                performance.counter("neighbor_list.hilbert_sorts") += after.n_hilbert_sorts - before.n_hilbert_sorts;
                 break;
+            }
             case clear:
                 kernel->getKernelStateModel().clearNeighborList();
                 break;
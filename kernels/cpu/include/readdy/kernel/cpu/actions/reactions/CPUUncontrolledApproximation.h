@@ -38,11 +38,15 @@ namespace cpu {
 namespace actions {
 namespace reactions {
 
+class ReactionTable;
+
 class CPUUncontrolledApproximation : public readdy::model::actions::reactions::UncontrolledApproximation {
     using super = readdy::model::actions::reactions::UncontrolledApproximation;
 public:
     CPUUncontrolledApproximation(CPUKernel *const kernel, double timeStep);
 
+    ~CPUUncontrolledApproximation();
+
     virtual void perform() override;
 
     virtual void registerReactionScheme_11(const std::string &reactionName, reaction_11 fun) override {
@@ -64,6 +68,10 @@ public:
 
 protected:
     CPUKernel *const kernel;
+    // the reaction table is only rebuilt if the context was reconfigured or the time step changed
+    std::unique_ptr<ReactionTable> table;
+    std::size_t tableConfiguration {0};
+    double tableTimeStep {0};
 };
 }
 }
@@ -21,17 +21,28 @@
 
 
 /**
- * << detailed description >>
+ * Reaction scheduler implementing the next subvolume method (Elf and Ehrenberg, 2004) on top of the particle
+ * positions. Space is divided into a grid of subvolumes, each of which carries its possible events, its propensity and
+ * the time of its next event. The subvolumes are kept in an indexed priority queue that is ordered by these times.
+ * Reaction partners are taken from the neighbor list, where a pair belongs to the subvolume of the particle with the
+ * smaller index. Within a time step the earliest event is executed and its educts are consumed. Then only the
+ * subvolumes that held an event with one of the educts are reevaluated and repositioned in the queue. As in the other
+ * schedulers, products do not react before the next time step.
  *
- * @file SingleCPUNextSubvolumesReactionScheduler.h
- * @brief << brief description >>
+ * @file NextSubvolumesReactionScheduler.h
+ * @brief Header file containing the CPU implementation of the next subvolume method
  * @author clonker
  * @date 09.09.16
  */
 
 #pragma once
+
+#include <array>
+#include <limits>
+
 #include <readdy/model/actions/Actions.h>
-#include "readdy/kernel/cpu/CPUKernel.h"
+#include <readdy/kernel/cpu/CPUKernel.h>
+#include <readdy/kernel/cpu/actions/reactions/Event.h>
 
 namespace readdy {
 namespace kernel {
@@ -40,45 +51,71 @@ namespace actions {
 namespace reactions {
 
 class CPUNextSubvolumes : public readdy::model::actions::reactions::NextSubvolumes {
-using cell_index_t = unsigned int;
-using signed_cell_index_t = typename std::make_signed<cell_index_t>::type;
+    using cell_index_t = unsigned int;
+    using signed_cell_index_t = typename std::make_signed<cell_index_t>::type;
     using super = readdy::model::actions::reactions::NextSubvolumes;
 public:
-    CPUNextSubvolumes(const CPUKernel *const kernel, double timeStep);
+    CPUNextSubvolumes(CPUKernel *const kernel, double timeStep);
+
     ~CPUNextSubvolumes();
 
     virtual void perform() override;
 
     double getMaxReactionRadius() const;
+
+    /**
+     * @return the number of subvolumes in each spatial direction, only valid after perform() was called
+     */
+    const std::array<cell_index_t, 3> &getNCells() const;
+
 private:
-    struct ReactionEvent;
     struct GridCell;
 
-    CPUKernel const* const kernel;
+    static constexpr double no_event = std::numeric_limits<double>::infinity();
+    static constexpr std::size_t not_queued = std::numeric_limits<std::size_t>::max();
+
+    CPUKernel *const kernel;
 
-    // sets up a grid cell (rate, timestamp, next event)
-    void setUpCell(GridCell& cell);
-    // sets up the computational grid with spacing >= max(reaction radii)
+    // sets up the computational grid with spacing >= max(reaction radii), if the box or the radii changed
     void setUpGrid();
+
     // assigns particles to the computational grid
     void assignParticles();
-    // schedules the reactions
+
+    // gathers the events of all cells and schedules them
     void setUpEventQueue();
-    // evaluates the collected events
+
+    // executes events until the time step is exhausted
     void evaluateReactions();
-    // sets up the neighbor-linked-list structure
-    void setUpNeighbors(GridCell& cell);
-    GridCell * getCell(const readdy::model::Vec3& particlePosition);
-    // fetches a cell at (i,j,k)
-    GridCell * getCell(signed_cell_index_t i, signed_cell_index_t j, signed_cell_index_t k);
+
+    // collects the possible events of a cell
+    void setUpCell(GridCell &cell);
+
+    // draws the time of the next event of a cell, which cannot happen before now
+    void scheduleCell(GridCell &cell, double now);
+
+    // restores the heap property after the timestamp of the cell at position pos in the event queue changed
+    void updateQueue(std::size_t pos);
+
+    GridCell *getCell(const readdy::model::Vec3 &particlePosition);
 
     // array holding the number of cells in each spatial direction
-    std::array<unsigned int, 3> nCells;
+    std::array<cell_index_t, 3> nCells{{0, 0, 0}};
     // size of each box
     readdy::model::Vec3 cellSize;
+    // the configuration the grid was set up for
+    std::array<double, 3> gridBoxSize{{0, 0, 0}};
+    double gridCellWidth{-1};
 
     std::vector<GridCell> cells;
-    std::vector<GridCell*> eventQueue;
+    // the cell each particle belongs to
+    std::vector<cell_index_t> particleCells;
+    // flags for the particles that were consumed by an event in the current time step
+    std::vector<char> consumed;
+    // the cells that contain at least one particle
+    std::vector<cell_index_t> occupiedCells;
+    // binary min-heap of cell indices, ordered by the time of the next event
+    std::vector<cell_index_t> eventQueue;
 };
 
 }
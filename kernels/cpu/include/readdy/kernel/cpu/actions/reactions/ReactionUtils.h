@@ -30,7 +30,9 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <readdy/model/RandomProvider.h>
 #include <readdy/kernel/cpu/CPUKernel.h>
 #include <readdy/kernel/cpu/nl/NeighborList.h>
@@ -68,6 +70,129 @@ inline bool shouldPerformEvent(const double rate, const double timestep, bool ap
     return approximated ? performReactionEvent<true>(rate, timestep) : performReactionEvent<false>(rate, timestep);
 }
 
+/**
+ * the probability of an event with the given rate to happen within one time step, see performReactionEvent
+ */
+inline double eventProbability(const double rate, const double timeStep, bool approximated) {
+    return approximated ? rate * timeStep : 1 - std::exp(-rate * timeStep);
+}
+
+/**
+ * Dense lookup of the reactions by educt type (pair), built once per reaction step. Besides the reactions it holds a
+ * mask of the reactive type pairs, the maximal educt distance per type pair and a consecutive id and the event
+ * probability of each reaction with positive rate, so that candidate events can be grouped by reaction.
+ */
+class ReactionTable {
+public:
+    using type_t = readdy::particle_type_type;
+    using order1_t = std::vector<readdy::model::reactions::Reaction<1> *>;
+    using order2_t = std::vector<readdy::model::reactions::Reaction<2> *>;
+
+    ReactionTable(const readdy::model::KernelContext &ctx, double timeStep, bool approximated) {
+        const auto types = ctx.particle_types().types_flat();
+        nTypes = types.empty() ? 0 : static_cast<std::size_t>(*std::max_element(types.begin(), types.end())) + 1;
+        order1Reactions.resize(nTypes, &noOrder1);
+        order1Offsets.resize(nTypes, 0);
+        order2Reactions.resize(nTypes * nTypes, &noOrder2);
+        order2Offsets.resize(nTypes * nTypes, 0);
+        reactivePairs.resize(nTypes * nTypes, false);
+        maxDistancesSquared.resize(nTypes * nTypes, 0);
+        const auto &registry = ctx.reactions();
+        for (const auto t : types) {
+            order1Reactions[t] = &registry.order1_by_type(t);
+            order1Offsets[t] = probabilities.size();
+            for (const auto reaction : *order1Reactions[t]) {
+                probabilities.push_back(eventProbability(reaction->getRate(), timeStep, approximated));
+            }
+        }
+        for (const auto t1 : types) {
+            for (const auto t2 : types) {
+                const auto pair = t1 * nTypes + t2;
+                order2Reactions[pair] = &registry.order2_by_type(t1, t2);
+                order2Offsets[pair] = probabilities.size();
+                for (const auto reaction : *order2Reactions[pair]) {
+                    probabilities.push_back(eventProbability(reaction->getRate(), timeStep, approximated));
+                    if (reaction->getRate() > 0) {
+                        reactivePairs[pair] = true;
+                        maxDistancesSquared[pair] = std::max(maxDistancesSquared[pair],
+                                                             reaction->getEductDistanceSquared());
+                    }
+                }
+            }
+        }
+    }
+
+    const order1_t &order1(type_t type) const {
+        return type < nTypes ? *order1Reactions[type] : noOrder1;
+    }
+
+    const order2_t &order2(type_t type1, type_t type2) const {
+        return type1 < nTypes && type2 < nTypes ? *order2Reactions[type1 * nTypes + type2] : noOrder2;
+    }
+
+    /**
+     * @return true if there is an order 2 reaction with positive rate for the type pair
+     */
+    bool reactive(type_t type1, type_t type2) const {
+        return type1 < nTypes && type2 < nTypes && reactivePairs[type1 * nTypes + type2];
+    }
+
+    /**
+     * @return the maximal squared educt distance of the order 2 reactions with positive rate for the type pair
+     */
+    double maxEductDistanceSquared(type_t type1, type_t type2) const {
+        return maxDistancesSquared[type1 * nTypes + type2];
+    }
+
+    std::size_t order1Id(type_t type, std::size_t reactionIndex) const {
+        return order1Offsets[type] + reactionIndex;
+    }
+
+    std::size_t order2Id(type_t type1, type_t type2, std::size_t reactionIndex) const {
+        return order2Offsets[type1 * nTypes + type2] + reactionIndex;
+    }
+
+    /**
+     * @return the total number of reaction ids
+     */
+    std::size_t nReactionIds() const {
+        return probabilities.size();
+    }
+
+    /**
+     * @return the probability of the reaction with the given id to happen within one time step
+     */
+    double probability(std::size_t id) const {
+        return probabilities[id];
+    }
+
+private:
+    std::size_t nTypes;
+    order1_t noOrder1;
+    order2_t noOrder2;
+    std::vector<const order1_t *> order1Reactions;
+    std::vector<std::size_t> order1Offsets;
+    std::vector<const order2_t *> order2Reactions;
+    std::vector<std::size_t> order2Offsets;
+    std::vector<bool> reactivePairs;
+    std::vector<double> maxDistancesSquared;
+    std::vector<double> probabilities;
+};
+
+/**
+ * Number of failures before the first success in a sequence of Bernoulli trials with success probability p, i.e.,
+ * the number of candidates that can be skipped before the next accepted one.
+ * @param p the success probability, in (0, 1)
+ * @return the geometrically distributed number of failures
+ */
+inline std::size_t geometricSkip(const double p) {
+    // 1 - u lies in (0, 1], so that the logarithm is finite
+    const auto u = 1. - readdy::model::rnd::uniform_real();
+    const auto skip = std::floor(std::log(u) / std::log1p(-p));
+    return skip < static_cast<double>(std::numeric_limits<std::size_t>::max() / 2)
+           ? static_cast<std::size_t>(skip) : std::numeric_limits<std::size_t>::max() / 2;
+}
+
 data_t::update_t handleEventsGillespie(
         CPUKernel *const kernel, double timeStep,
         bool filterEventsInAdvance, bool approximateRate,
@@ -78,7 +203,7 @@ void gatherEvents(CPUKernel *const kernel, const ParticleIndexCollection &partic
                   const data_t &data, double &alpha, std::vector<event_t> &events,
                   const readdy::model::KernelContext::dist_squared_fun& d2) {
     for (const auto index : particles) {
-        auto& entry = data.entry_at(index);
+        const auto entry = data.entry_at(index);
         // this being false should really not happen, though
         if (!entry.is_deactivated()) {
             // order 1
@@ -130,8 +255,8 @@ void performReaction(data_t& data, const readdy::model::KernelContext& context,
                      data_t::entries_update_t& newEntries, std::vector<data_t::index_t>& decayedEntries,
                      Reaction* reaction, record_t* record) {
     const auto& pbc = context.getPBCFun();
-    auto& entry1 = data.entry_at(idx1);
-    auto& entry2 = data.entry_at(idx2);
+    auto entry1 = data.entry_at(idx1);
+    auto entry2 = data.entry_at(idx2);
     if(record) {
         record->type = static_cast<int>(reaction->getType());
         record->where = (entry1.position() + entry2.position()) / 2.;
@@ -176,7 +301,7 @@ void performReaction(data_t& data, const readdy::model::KernelContext& context,
 
             entry1.type = reaction->getProducts()[0];
             entry1.id = readdy::model::Particle::nextId();
-            data.displace(entry1, reaction->getWeight1() * reaction->getProductDistance() * n3);
+            data.displace(idx1, reaction->getWeight1() * reaction->getProductDistance() * n3);
             if(record) {
                 record->products[0] = entry1.id;
                 record->products[1] = p.getId();
@@ -32,6 +32,8 @@
 #pragma once
 #include <cstddef>
 #include <atomic>
+#include <iterator>
+#include <type_traits>
 #include <vector>
 #include <memory>
 #include <stack>
@@ -40,6 +42,8 @@
 #include <readdy/common/thread/Config.h>
 #include <readdy/model/Particle.h>
 #include <readdy/model/KernelContext.h>
+#include <readdy/kernel/cpu/util/aligned_allocator.h>
+#include "CompactNeighborList.h"
 
 namespace readdy {
 namespace kernel {
@@ -54,30 +58,52 @@ class CPUParticleData {
     friend class readdy::kernel::cpu::nl::NeighborList;
 public:
 
+    /**
+     * The memory layout of the particle data, which is fixed at construction. In the array-of-structures layout each
+     * particle is stored as one Entry. In the structure-of-arrays layout the coordinates, forces, types and
+     * deactivation flags live in separate, cache line aligned columns, so that the integrator and the force loop can
+     * stream through them.
+     */
+    enum class Layout {
+        aos, soa
+    };
+
     struct Entry;
-    using Neighbor = std::size_t;
+    template<bool Const>
+    class BasicEntryRef;
+    template<bool Const>
+    class BasicIterator;
+    class AoSView;
+    class SoAView;
+
+    using Neighbor = CompactNeighborList::value_type;
     using ctx_t = readdy::model::KernelContext;
     using particle_type = readdy::model::Particle;
     using entries_t = std::vector<Entry>;
     using entries_update_t = std::vector<Entry>;
     using top_particle_type = readdy::model::TopologyParticle;
-    using neighbors_t = std::vector<Neighbor>;
-    using neighbor_list_t = std::vector<neighbors_t>;
+    using neighbors_t = CompactNeighborList::range;
+    using neighbor_list_t = CompactNeighborList;
     using index_t = entries_t::size_type;
     using update_t = std::pair<entries_update_t, std::vector<index_t>>;
     using vec3 = readdy::model::Vec3;
     using force_t = vec3;
     using displacement_t = double;
     using reorder_signal_t = readdy::signals::signal<void(const std::vector<std::size_t>)>;
+    template<typename T>
+    using column_t = std::vector<T, util::aligned_allocator<T>>;
 
-    using iterator = decltype(std::declval<entries_t>().begin());
-    using const_iterator = decltype(std::declval<entries_t>().cbegin());
+    using EntryRef = BasicEntryRef<false>;
+    using ConstEntryRef = BasicEntryRef<true>;
+    using iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true>;
 
-    using neighbors_list_iterator = neighbor_list_t::iterator;
+    using neighbors_list_iterator = neighbor_list_t::const_iterator;
     using neighbors_list_const_iterator = neighbor_list_t::const_iterator;
 
     /**
-     * Particle data entry with padding such that it fits exactly into 64 bytes.
+     * Particle data entry, which is how particles are stored in the array-of-structures layout and how new particles
+     * are handed to the particle data in both layouts.
      */
     struct Entry {
         Entry(const particle_type &particle) : pos(particle.getPos()), force(force_t()), type(particle.getType()),
@@ -110,8 +136,232 @@ public:
         bool deactivated; // 60 + 1 = 61 bytes
         char padding[3] {0,0,0}; // 61 + 3 = 64 bytes
     };
+
+    /**
+     * Reference to the particle stored at an index, independent of the layout. The force, displacement, id and type
+     * can be accessed as with an Entry, the position is assembled from the coordinates.
+     */
+    template<bool Const>
+    class BasicEntryRef {
+        using data_type = typename std::conditional<Const, const CPUParticleData, CPUParticleData>::type;
+        template<typename T>
+        using ref = typename std::conditional<Const, const T &, T &>::type;
+    public:
+        BasicEntryRef(data_type &data, index_t index)
+                : force(data._layout == Layout::aos ? data.entries[index].force : data.columns.force[index]),
+                  displacement(data._layout == Layout::aos ? data.entries[index].displacement
+                                                           : data.columns.displacement[index]),
+                  id(data._layout == Layout::aos ? data.entries[index].id : data.columns.id[index]),
+                  type(data._layout == Layout::aos ? data.entries[index].type : data.columns.type[index]),
+                  _data(&data), _index(index) {}
+
+        template<bool C = Const, typename = typename std::enable_if<C>::type>
+        BasicEntryRef(const BasicEntryRef<false> &other) : BasicEntryRef(*other._data, other._index) {}
+
+        bool is_deactivated() const {
+            return _data->_layout == Layout::aos ? _data->entries[_index].deactivated
+                                                 : _data->columns.deactivated[_index] != 0;
+        }
+
+        particle_type::pos_type position() const {
+            return _data->pos(_index);
+        }
+
+        index_t index() const {
+            return _index;
+        }
+
+        ref<force_t> force;
+        ref<displacement_t> displacement;
+        ref<particle_type::id_type> id;
+        ref<particle_type::type_type> type;
+
+    private:
+        friend class BasicEntryRef<true>;
+
+        data_type *_data;
+        index_t _index;
+    };
+
+    /**
+     * Random access iterator over the particles, dereferencing to entry references.
+     */
+    template<bool Const>
+    class BasicIterator {
+        using data_type = typename std::conditional<Const, const CPUParticleData, CPUParticleData>::type;
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = BasicEntryRef<Const>;
+        using difference_type = std::ptrdiff_t;
+        using reference = BasicEntryRef<Const>;
+
+        struct pointer {
+            reference ref;
+
+            const reference *operator->() const {
+                return &ref;
+            }
+        };
+
+        BasicIterator() = default;
+
+        BasicIterator(data_type *data, index_t index) : _data(data), _index(index) {}
+
+        template<bool C = Const, typename = typename std::enable_if<C>::type>
+        BasicIterator(const BasicIterator<false> &other) : _data(other._data), _index(other._index) {}
+
+        reference operator*() const {
+            return {*_data, _index};
+        }
+
+        pointer operator->() const {
+            return {**this};
+        }
+
+        reference operator[](difference_type n) const {
+            return {*_data, _index + n};
+        }
+
+        BasicIterator &operator++() {
+            ++_index;
+            return *this;
+        }
+
+        BasicIterator operator++(int) {
+            auto copy = *this;
+            ++_index;
+            return copy;
+        }
+
+        BasicIterator &operator--() {
+            --_index;
+            return *this;
+        }
+
+        BasicIterator operator--(int) {
+            auto copy = *this;
+            --_index;
+            return copy;
+        }
+
+        BasicIterator &operator+=(difference_type n) {
+            _index += n;
+            return *this;
+        }
+
+        BasicIterator &operator-=(difference_type n) {
+            _index -= n;
+            return *this;
+        }
+
+        friend BasicIterator operator+(BasicIterator it, difference_type n) {
+            return it += n;
+        }
+
+        friend BasicIterator operator+(difference_type n, BasicIterator it) {
+            return it += n;
+        }
+
+        friend BasicIterator operator-(BasicIterator it, difference_type n) {
+            return it -= n;
+        }
+
+        friend difference_type operator-(const BasicIterator &lhs, const BasicIterator &rhs) {
+            return static_cast<difference_type>(lhs._index) - static_cast<difference_type>(rhs._index);
+        }
+
+        friend bool operator==(const BasicIterator &lhs, const BasicIterator &rhs) {
+            return lhs._index == rhs._index;
+        }
+
+        friend bool operator!=(const BasicIterator &lhs, const BasicIterator &rhs) {
+            return lhs._index != rhs._index;
+        }
+
+        friend bool operator<(const BasicIterator &lhs, const BasicIterator &rhs) {
+            return lhs._index < rhs._index;
+        }
+
+        friend bool operator>(const BasicIterator &lhs, const BasicIterator &rhs) {
+            return lhs._index > rhs._index;
+        }
+
+        friend bool operator<=(const BasicIterator &lhs, const BasicIterator &rhs) {
+            return lhs._index <= rhs._index;
+        }
+
+        friend bool operator>=(const BasicIterator &lhs, const BasicIterator &rhs) {
+            return lhs._index >= rhs._index;
+        }
+
+    private:
+        friend class BasicIterator<true>;
+
+        data_type *_data{nullptr};
+        index_t _index{0};
+    };
+
+    /**
+     * Index based access to the entries of the array-of-structures layout, for loops that are compiled per layout.
+     */
+    class AoSView {
+    public:
+        explicit AoSView(Entry *entries) : entries(entries) {}
+
+        bool is_deactivated(index_t i) const {
+            return entries[i].deactivated;
+        }
+
+        const vec3 &position(index_t i) const {
+            return entries[i].pos;
+        }
+
+        particle_type::type_type type(index_t i) const {
+            return entries[i].type;
+        }
+
+        force_t &force(index_t i) const {
+            return entries[i].force;
+        }
+
+    private:
+        Entry *entries;
+    };
+
+    /**
+     * Index based access to the columns of the structure-of-arrays layout, for loops that are compiled per layout.
+     * The columns are exposed, so that loops over ranges of particles can be vectorized.
+     */
+    class SoAView {
+    public:
+        bool is_deactivated(index_t i) const {
+            return deactivated[i] != 0;
+        }
+
+        vec3 position(index_t i) const {
+            return {x[i], y[i], z[i]};
+        }
+
+        particle_type::type_type type(index_t i) const {
+            return types[i];
+        }
+
+        force_t &force(index_t i) const {
+            return forces[i];
+        }
+
+        vec3::value_t *x;
+        vec3::value_t *y;
+        vec3::value_t *z;
+        force_t *forces;
+        particle_type::type_type *types;
+        char *deactivated;
+        displacement_t *displacements;
+    };
+
     // ctor / dtor
-    CPUParticleData(readdy::model::KernelContext *const context, const readdy::util::thread::Config &_config);
+    CPUParticleData(readdy::model::KernelContext *const context, const readdy::util::thread::Config &_config,
+                    Layout layout = Layout::aos);
 
     ~CPUParticleData();
 
@@ -124,6 +374,8 @@ public:
 
     CPUParticleData &operator=(const CPUParticleData &rhs) = delete;
 
+    Layout layout() const;
+
     std::size_t size() const;
 
     void reserve(std::size_t n);
@@ -152,7 +404,7 @@ public:
 
     readdy::model::Particle getParticle(const index_t index) const;
 
-    readdy::model::Particle toParticle(const Entry& e) const;
+    readdy::model::Particle toParticle(const ConstEntryRef &e) const;
 
     void removeParticle(const particle_type &particle);
 
@@ -169,15 +421,24 @@ public:
     const_iterator begin() const;
     const_iterator end() const;
 
-    Entry& entry_at(index_t);
-    const Entry& entry_at(index_t) const;
-    const Entry& centry_at(index_t) const;
+    EntryRef entry_at(index_t);
+    ConstEntryRef entry_at(index_t) const;
+    ConstEntryRef centry_at(index_t) const;
 
-    neighbors_t& neighbors_at(index_t);
-    const neighbors_t& neighbors_at(index_t) const;
-    const neighbors_t& cneighbors_at(index_t) const;
+    /**
+     * @return the view on the entries, only valid in the array-of-structures layout and until particles are added
+     */
+    AoSView aos_view();
+
+    /**
+     * @return the view on the columns, only valid in the structure-of-arrays layout and until particles are added
+     */
+    SoAView soa_view();
 
-    const particle_type::pos_type& pos(index_t) const;
+    neighbors_t neighbors_at(index_t) const;
+    neighbors_t cneighbors_at(index_t) const;
+
+    particle_type::pos_type pos(index_t) const;
 
     index_t getNDeactivated() const;
 
@@ -188,7 +449,24 @@ public:
      * @return vector of new entries
      */
     std::vector<index_t> update(update_t&&);
-    void displace(Entry&, const particle_type::pos_type& delta);
+    void displace(index_t index, const particle_type::pos_type& delta);
+
+    /**
+     * Displaces a particle and applies the periodic boundary conditions that are given by the template arguments,
+     * i.e., without going through the context's fix position function.
+     * @param index the index of the particle
+     * @param delta the displacement
+     * @param box the box size
+     */
+    template<bool PX, bool PY, bool PZ>
+    void displace(index_t index, const particle_type::pos_type &delta, const std::array<scalar, 3> &box) {
+        auto position = pos(index) + delta;
+        readdy::model::fixPosition<PX, PY, PZ>(position, box[0], box[1], box[2]);
+        setPosition(index, position);
+        if (_trackDisplacement) {
+            entry_at(index).displacement += std::sqrt(delta * delta);
+        }
+    }
     void blanks_moved_to_end();
     void blanks_moved_to_front();
 
@@ -198,9 +476,40 @@ public:
 
 protected:
 
+    /**
+     * The columns of the structure-of-arrays layout.
+     */
+    struct Columns {
+        column_t<vec3::value_t> x;
+        column_t<vec3::value_t> y;
+        column_t<vec3::value_t> z;
+        column_t<force_t> force;
+        column_t<particle_type::type_type> type;
+        column_t<char> deactivated;
+        std::vector<particle_type::id_type> id;
+        std::vector<displacement_t> displacement;
+    };
+
+    void setPosition(index_t index, const particle_type::pos_type &position);
+
+    void setDeactivated(index_t index, bool deactivated);
+
+    /**
+     * stores an entry at an index that is smaller than the size
+     */
+    void assign(index_t index, Entry &&entry);
+
+    /**
+     * stores an entry behind the last one
+     */
+    void append(Entry &&entry);
+
+    const Layout _layout;
+
     std::vector<index_t> blanks;
     neighbor_list_t neighbors;
     entries_t entries;
+    Columns columns;
 
     bool _trackDisplacement {true};
 
@@ -0,0 +1,229 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * Neighbor list storage in compressed sparse row format: the neighbors of all particles live in one flat array of
+ * 32 bit indices, the neighbors of particle i are found in [offsets[i], offsets[i] + counts[i]). Rows may have more
+ * capacity (offsets[i+1] - offsets[i]) than they currently use, so that they can be refilled in place as long as
+ * the number of neighbors does not grow beyond it. The arrays are only grown, never shrunk, so that repeated
+ * rebuilds do not reallocate.
+ *
+ * @file CompactNeighborList.h
+ * @brief Header file containing the CSR storage of the CPU kernel's neighbor list
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace readdy {
+namespace kernel {
+namespace cpu {
+namespace nl {
+class NeighborList;
+}
+namespace model {
+
+class CompactNeighborList {
+    friend class readdy::kernel::cpu::nl::NeighborList;
+public:
+    using value_type = std::uint32_t;
+    using offset_type = std::size_t;
+    using count_type = std::uint32_t;
+    using row_index = std::size_t;
+
+    /**
+     * read-only view on the neighbors of one particle
+     */
+    class range {
+    public:
+        using value_type = CompactNeighborList::value_type;
+        using const_iterator = const value_type *;
+        using iterator = const_iterator;
+
+        range(const value_type *begin, const value_type *end) : _begin(begin), _end(end) {}
+
+        const_iterator begin() const { return _begin; }
+
+        const_iterator end() const { return _end; }
+
+        const_iterator cbegin() const { return _begin; }
+
+        const_iterator cend() const { return _end; }
+
+        std::size_t size() const { return static_cast<std::size_t>(_end - _begin); }
+
+        bool empty() const { return _begin == _end; }
+
+        value_type operator[](std::size_t i) const { return _begin[i]; }
+
+    private:
+        const value_type *_begin;
+        const value_type *_end;
+    };
+
+    /**
+     * random access iterator over the rows, dereferencing yields the neighbors of the respective particle
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = range;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = range;
+
+        const_iterator(const CompactNeighborList *list, row_index row) : list(list), row(row) {}
+
+        range operator*() const { return list->at(row); }
+
+        range operator[](difference_type n) const { return list->at(row + n); }
+
+        const_iterator &operator++() {
+            ++row;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto copy = *this;
+            ++row;
+            return copy;
+        }
+
+        const_iterator &operator--() {
+            --row;
+            return *this;
+        }
+
+        const_iterator &operator+=(difference_type n) {
+            row += n;
+            return *this;
+        }
+
+        const_iterator &operator-=(difference_type n) {
+            row -= n;
+            return *this;
+        }
+
+        const_iterator operator+(difference_type n) const { return {list, row + n}; }
+
+        const_iterator operator-(difference_type n) const { return {list, row - n}; }
+
+        difference_type operator-(const const_iterator &rhs) const {
+            return static_cast<difference_type>(row) - static_cast<difference_type>(rhs.row);
+        }
+
+        bool operator==(const const_iterator &rhs) const { return row == rhs.row && list == rhs.list; }
+
+        bool operator!=(const const_iterator &rhs) const { return !(*this == rhs); }
+
+    private:
+        const CompactNeighborList *list;
+        row_index row;
+    };
+
+    using iterator = const_iterator;
+
+    /**
+     * the number of rows, i.e., particles
+     */
+    std::size_t size() const { return counts.size(); }
+
+    range at(row_index row) const {
+        const auto first = indices.data() + offsets[row];
+        return {first, first + counts[row]};
+    }
+
+    range operator[](row_index row) const { return at(row); }
+
+    const_iterator begin() const { return {this, 0}; }
+
+    const_iterator end() const { return {this, size()}; }
+
+    const_iterator cbegin() const { return begin(); }
+
+    const_iterator cend() const { return end(); }
+
+    /**
+     * the number of neighbors that fit into a row without rebuilding the offsets
+     */
+    offset_type capacity(row_index row) const { return offsets[row + 1] - offsets[row]; }
+
+    /**
+     * the total number of stored neighbor indices, including unused capacity
+     */
+    offset_type n_entries() const { return offsets.back(); }
+
+    /**
+     * appends an empty row without capacity
+     */
+    void append_row() {
+        offsets.push_back(offsets.back());
+        counts.push_back(0);
+    }
+
+    /**
+     * empties a row, keeping its capacity
+     */
+    void clear_row(row_index row) { counts[row] = 0; }
+
+    /**
+     * resizes to n rows, rows that are added have no capacity
+     */
+    void resize_rows(std::size_t n) {
+        offsets.resize(n + 1, offsets.back());
+        counts.resize(n, 0);
+    }
+
+    /**
+     * removes all rows
+     */
+    void clear() {
+        offsets.resize(1);
+        offsets.front() = 0;
+        counts.clear();
+    }
+
+    void reserve(std::size_t n) {
+        offsets.reserve(n + 1);
+        counts.reserve(n);
+    }
+
+private:
+    // the neighbor list (re-)builds the arrays, after the offsets were changed the indices have to be resized to
+    // n_entries(), which keeps their capacity
+    std::vector<offset_type> offsets{0};
+    std::vector<count_type> counts{};
+    std::vector<value_type> indices{};
+};
+
+}
+}
+}
+}
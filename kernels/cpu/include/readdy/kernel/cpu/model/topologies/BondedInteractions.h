@@ -0,0 +1,144 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * Kernel wide, flattened table of the bonds, angles and dihedrals of all active topologies. The topologies' particle
+ * indices are resolved to indices into the particle data, so that the evaluation neither goes through the topologies
+ * nor allocates actions. The table is rebuilt only if a topology was added, removed or changed (see
+ * Topology::version()). The particles of the topologies are numbered densely by slots, topology after topology. The
+ * table is evaluated in parallel, where each thread scatters its forces into a buffer covering the slots that its
+ * share of the table touches, and the buffers are reduced into the particle data afterwards. Hence, the buffers scale
+ * with the number of topology particles rather than with the number of particles, no matter where the topology
+ * particles are located in the particle data.
+ *
+ * @file BondedInteractions.h
+ * @brief Header file containing the flattened table of bonded topology interactions
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <readdy/common/macros.h>
+#include <readdy/common/index_persistent_vector.h>
+#include <readdy/common/thread/Config.h>
+#include <readdy/model/KernelContext.h>
+#include <readdy/model/topologies/GraphTopology.h>
+#include <readdy/kernel/cpu/model/CPUParticleData.h>
+
+NAMESPACE_BEGIN(readdy)
+NAMESPACE_BEGIN(kernel)
+NAMESPACE_BEGIN(cpu)
+NAMESPACE_BEGIN(model)
+NAMESPACE_BEGIN(top)
+
+class BondedInteractions {
+public:
+    using topologies_t = readdy::util::index_persistent_vector<std::unique_ptr<readdy::model::top::GraphTopology>>;
+    using topology_action_factory = readdy::model::top::TopologyActionFactory;
+    using harmonic_bond = readdy::model::top::pot::HarmonicBondPotential;
+    using harmonic_angle = readdy::model::top::pot::HarmonicAnglePotential;
+    using cos_dihedral = readdy::model::top::pot::CosineDihedralPotential;
+
+    /**
+     * the configurations refer to indices into the particle data, the slots to the same particles in slot numbering
+     */
+    struct bond {
+        const harmonic_bond *potential;
+        harmonic_bond::bond_t configuration;
+        std::array<std::size_t, 2> slots;
+    };
+
+    struct angle {
+        const harmonic_angle *potential;
+        harmonic_angle::angle_t configuration;
+        std::array<std::size_t, 3> slots;
+    };
+
+    struct dihedral {
+        const cos_dihedral *potential;
+        cos_dihedral::dihedral_t configuration;
+        std::array<std::size_t, 4> slots;
+    };
+
+    /**
+     * Rebuilds the table if the set of active topologies or any of their versions changed since the last call, or if
+     * the number of threads changed.
+     * @param topologies the topologies
+     * @param nThreads the number of threads that evaluate the table
+     * @return true if the table was rebuilt
+     */
+    bool update(const topologies_t &topologies, std::size_t nThreads);
+
+    /**
+     * Adds the forces of the bonded interactions to the particles. Potentials of kinds that are not contained in the
+     * table are evaluated through their actions.
+     * @param data the particle data
+     * @param context the kernel context
+     * @param config the thread config, must match the number of threads given to update()
+     * @param factory the topology action factory
+     * @return the energy of the bonded interactions
+     */
+    double evaluate(CPUParticleData &data, const readdy::model::KernelContext &context,
+                    const readdy::util::thread::Config &config, const topology_action_factory *factory);
+
+    const std::vector<bond> &bonds() const;
+
+    const std::vector<angle> &angles() const;
+
+    const std::vector<dihedral> &dihedrals() const;
+
+    /**
+     * @return the index into the particle data for each slot
+     */
+    const std::vector<std::size_t> &slots() const;
+
+private:
+    /**
+     * forces of one thread, indexed by slot relative to offset
+     */
+    struct force_buffer {
+        std::vector<readdy::model::Vec3> forces;
+        std::size_t offset{0};
+    };
+
+    std::vector<std::size_t> _signature;
+    std::size_t _nThreads{0};
+    std::vector<bond> _bonds;
+    std::vector<angle> _angles;
+    std::vector<dihedral> _dihedrals;
+    std::vector<std::size_t> _slots;
+    std::vector<readdy::model::top::pot::TopologyPotential *> _others;
+    std::vector<force_buffer> _buffers;
+};
+
+NAMESPACE_END(top)
+NAMESPACE_END(model)
+NAMESPACE_END(cpu)
+NAMESPACE_END(kernel)
+NAMESPACE_END(readdy)
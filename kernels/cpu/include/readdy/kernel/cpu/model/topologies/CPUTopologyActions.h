@@ -60,8 +60,8 @@ public:
         const auto &d = context->getShortestDifferenceFun();
         for (const auto &bond : potential->getBonds()) {
             readdy::model::Vec3 forceUpdate{0, 0, 0};
-            auto &e1 = data->entry_at(particleIndices.at(bond.idx1));
-            auto &e2 = data->entry_at(particleIndices.at(bond.idx2));
+            auto e1 = data->entry_at(particleIndices.at(bond.idx1));
+            auto e2 = data->entry_at(particleIndices.at(bond.idx2));
             const auto x_ij = d(e1.position(), e2.position());
             potential->calculateForce(forceUpdate, x_ij, bond);
             e1.force += forceUpdate;
@@ -89,9 +89,9 @@ public:
 
 
         for (const auto &angle : potential->getAngles()) {
-            auto &e1 = data->entry_at(particleIndices.at(angle.idx1));
-            auto &e2 = data->entry_at(particleIndices.at(angle.idx2));
-            auto &e3 = data->entry_at(particleIndices.at(angle.idx3));
+            auto e1 = data->entry_at(particleIndices.at(angle.idx1));
+            auto e2 = data->entry_at(particleIndices.at(angle.idx2));
+            auto e3 = data->entry_at(particleIndices.at(angle.idx3));
             const auto x_ji = d(e2.position(), e1.position());
             const auto x_jk = d(e2.position(), e3.position());
             energy += potential->calculateEnergy(x_ji, x_jk, angle);
@@ -117,10 +117,10 @@ public:
         const auto &d = context->getShortestDifferenceFun();
 
         for (const auto &dih : potential->getDihedrals()) {
-            auto &e_i = data->entry_at(particleIndices.at(dih.idx1));
-            auto &e_j = data->entry_at(particleIndices.at(dih.idx2));
-            auto &e_k = data->entry_at(particleIndices.at(dih.idx3));
-            auto &e_l = data->entry_at(particleIndices.at(dih.idx4));
+            auto e_i = data->entry_at(particleIndices.at(dih.idx1));
+            auto e_j = data->entry_at(particleIndices.at(dih.idx2));
+            auto e_k = data->entry_at(particleIndices.at(dih.idx3));
+            auto e_l = data->entry_at(particleIndices.at(dih.idx4));
             const auto x_ji = d(e_j.position(), e_i.position());
             const auto x_kj = d(e_k.position(), e_j.position());
             const auto x_kl = d(e_k.position(), e_l.position());
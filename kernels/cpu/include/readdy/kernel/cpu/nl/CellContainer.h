@@ -32,6 +32,8 @@
 
 #include <vector>
 #include <array>
+#include <functional>
+#include <limits>
 
 #include <readdy/common/thread/Config.h>
 #include <readdy/common/common.h>
@@ -103,10 +105,41 @@ public:
 
     const cell_index &contiguous_index() const;
 
-    virtual void insert_particle(const particle_index index, bool mark_dirty=false) const;
-
     virtual void insert_particle(const particle_index index, bool mark_dirty=false);
 
+    /**
+     * Sorts the active particles into the leaf cells by a parallel counting sort without any locking: first the leaf
+     * of each particle is determined and counted, then each leaf's list is grown by its count and finally the
+     * particles are scattered into the reserved slots. Within a leaf, the inserted particles are ordered by index.
+     * @param filter if given, only particles for which it yields true are inserted
+     * @return the number of particles that lie outside of all cells
+     */
+    std::size_t insert_particles(const std::function<bool(particle_index)> &filter = nullptr);
+
+    /**
+     * Removes particles from the leaves they were inserted into, each leaf is compacted once. The super cells of the
+     * affected leaves are marked dirty. Particles that are not contained in any leaf are ignored.
+     * @param particles the particles
+     */
+    void remove_particles(const std::vector<particle_index> &particles);
+
+    /**
+     * the leaf cells in depth first order, only populated for the root container
+     * @return the leaves
+     */
+    const std::vector<sub_cell *> &leaves() const;
+
+    /**
+     * the leaves of this cell are leaves()[first_leaf(), first_leaf() + n_leaves()) of the root container
+     * @return the index of the first leaf
+     */
+    const cell_index &first_leaf() const;
+
+    /**
+     * @return the number of leaves contained in this cell, 1 for a leaf
+     */
+    const cell_index &n_leaves() const;
+
     virtual void clear();
 
     /**
@@ -215,8 +248,29 @@ public:
 
     void execute_for_each_sub_cell(const std::function<void(const sub_cell &)> &function) const;
 
+    /**
+     * value of leaf_of_particle for particles that are not contained in any leaf
+     */
+    static constexpr cell_index no_leaf = std::numeric_limits<cell_index>::max();
+
+    /**
+     * only meaningful on the root container
+     * @param index the particle
+     * @return index of the leaf that the particle was inserted into or no_leaf
+     */
+    cell_index leaf_of_particle(particle_index index) const;
+
+    void set_leaf_of_particle(particle_index index, cell_index leaf);
+
 protected:
 
+    /**
+     * (re-)builds the list of leaves and their ranges, invoked on the root after its cells were (re-)created
+     */
+    void index_leaves();
+
+    void collect_leaves(std::vector<sub_cell *> &leaves);
+
     CellContainer *_super_cell{nullptr};
 
     template<typename T, typename Dims>
@@ -241,6 +295,11 @@ protected:
 
     std::size_t _n_dirty_macro_cells {0};
 
+    cell_index _first_leaf {0};
+    cell_index _n_leaves {0};
+    std::vector<sub_cell *> _leaves {};
+    std::vector<cell_index> _particle_leaves {};
+
     model::CPUParticleData &_data;
     const readdy::model::KernelContext &_context;
     const readdy::util::thread::Config& _config;
@@ -46,7 +46,6 @@ public:
     using skin_size_t = scalar;
     using data_t = readdy::kernel::cpu::model::CPUParticleData;
     using neighbors_t = data_t::neighbors_t;
-    using iterator = data_t::neighbors_list_iterator;
     using const_iterator = data_t::neighbors_list_const_iterator;
 
     NeighborList(model::CPUParticleData &data, const readdy::model::KernelContext &context,
@@ -75,53 +74,158 @@ public:
 
     const bool& performs_hilbert_sort() const;
 
+    /**
+     * Sorts the particle data along a hilbert curve and rebuilds the neighbor list. Listeners of the particle data's
+     * reorder signal (e.g., the topologies) are notified about the permutation.
+     */
     void sort_by_hilbert_curve();
 
+    /**
+     * The particles are re-sorted every that many updates, 0 disables the re-sorting by update count.
+     * @return the interval
+     */
+    std::size_t &hilbert_sort_interval();
+
+    const std::size_t &hilbert_sort_interval() const;
+
+    /**
+     * The particles are re-sorted once the locality() grew by this factor since the last sort, which is checked every
+     * locality_check_interval updates. A value <= 1 disables the re-sorting by locality.
+     * @return the factor
+     */
+    scalar &hilbert_sort_locality_factor();
+
+    const scalar &hilbert_sort_locality_factor() const;
+
+    /**
+     * the mean distance in memory (i.e., difference of indices) between neighboring particles
+     * @return the locality metric, smaller is better
+     */
+    scalar locality() const;
+
+    /**
+     * number of updates between two evaluations of the locality metric
+     */
+    static constexpr std::size_t locality_check_interval = 100;
+
     void updateData(data_t::update_t &&update);
 
     void displace(data_t::iterator iter, const readdy::model::Vec3 &vec);
 
-    void displace(data_t::Entry &entry, const readdy::model::Vec3 &delta);
+    void displace(const data_t::EntryRef &entry, const readdy::model::Vec3 &delta);
 
     void displace(data_t::index_t entry, const readdy::model::Vec3 &delta);
 
-    iterator begin();
+    const_iterator begin() const;
 
-    iterator end();
+    const_iterator end() const;
 
     const_iterator cbegin() const;
 
     const_iterator cend() const;
 
-    const neighbors_t &neighbors_of(const data_t::index_t entry) const;
+    neighbors_t neighbors_of(const data_t::index_t entry) const;
 
     skin_size_t &skin();
 
     const skin_size_t &skin() const;
 
+    /**
+     * The cutoff of a type pair is the largest radius among the order 2 potentials and reactions between the two
+     * types. Valid after set_up().
+     * @return the cutoff of the type pair, 0 if the types neither interact nor react
+     */
+    scalar pair_cutoff(particle_type_type type1, particle_type_type type2) const;
+
+    /**
+     * The cutoff by which the stored pairs are filtered: only pairs closer than their candidate cutoff plus skin are
+     * stored. Since conversion, enzymatic and fission reactions, compartments and topology reactions change particle
+     * types in place, without the list being rebuilt, this is the largest pair cutoff over all types that the two
+     * particles can be converted into. Topology particles are assumed to be convertible into any type. Valid after
+     * set_up().
+     * @return the candidate cutoff of the type pair, 0 if pairs of these types are never needed
+     */
+    scalar candidate_cutoff(particle_type_type type1, particle_type_type type2) const;
+
+    /**
+     * counts of what the updates of the neighbor list amounted to, accumulated over its lifetime
+     */
+    struct statistics {
+        /**
+         * number of calls to set_up() and update()
+         */
+        std::size_t n_updates {0};
+        /**
+         * number of times the whole list was built from scratch
+         */
+        std::size_t n_rebuilds {0};
+        /**
+         * number of times the list was updated adaptively, i.e., only for dirty cells
+         */
+        std::size_t n_adaptive_updates {0};
+        /**
+         * number of dirty macro cells, summed over the adaptive updates
+         */
+        std::size_t n_dirty_cells {0};
+        /**
+         * number of times the particles were sorted along the hilbert curve
+         */
+        std::size_t n_hilbert_sorts {0};
+    };
+
+    const statistics &stats() const;
+
 private:
 
+    /**
+     * determines the cutoff of each type pair
+     * @return the largest cutoff, determining the size of the cells
+     */
     scalar calculate_max_cutoff();
 
     void fill_container();
 
     /**
-     * should be called once containers are all valid / filled
+     * should be called once containers are all valid / filled, counts the neighbors of each particle, lays out the
+     * rows of the CSR storage accordingly and fills them
      */
     void fill_verlet_list();
 
-    void fill_cell_verlet_list(const CellContainer::sub_cell &sub_cell, const bool reset_displacement);
+    void count_cell_neighbors(const CellContainer::sub_cell &sub_cell);
+
+    /**
+     * parallel prefix sum over the rows' capacities, yielding their offsets
+     */
+    void update_offsets();
+
+    /**
+     * fills the rows of the cell's particles in place
+     * @return false if a row did not have enough capacity, in which case it is truncated
+     */
+    bool fill_cell_verlet_list(const CellContainer::sub_cell &sub_cell, const bool reset_displacement);
 
     void handle_dirty_cells();
 
+    bool resort_due() const;
+
+    void update_candidate_cutoffs();
+
     CellContainer _cell_container;
 
     skin_size_t _skin;
     scalar _max_cutoff;
-    scalar _max_cutoff_skin_squared {0};
+    std::size_t _n_types {0};
+    std::vector<scalar> _pair_cutoffs {};
+    std::vector<scalar> _candidate_cutoffs {};
+    std::vector<scalar> _candidate_cutoffs_skin_squared {};
     bool _hilbert_sort {true};
     bool _adaptive {true};
     bool _is_set_up {false};
+    std::size_t _hilbert_sort_interval {0};
+    scalar _hilbert_sort_locality_factor {2};
+    std::size_t _n_updates_since_sort {0};
+    scalar _locality_after_sort {0};
+    statistics _stats {};
     model::CPUParticleData &_data;
     const readdy::model::KernelContext &_context;
     const readdy::util::thread::Config &_config;
@@ -40,24 +40,23 @@ namespace kernel {
 namespace cpu {
 namespace nl {
 
+/**
+ * The particles of a leaf cell. The lists are not synchronized, they are filled by CellContainer::insert_particles()
+ * and updated through move lists, in both cases each list is written to by one thread only.
+ */
 class ParticlesList {
 public:
     using particle_index = model::CPUParticleData::index_t;
     using particle_indices = std::vector<particle_index>;
-    using mutex_type = std::mutex;
-    using particles_lock = std::unique_lock<mutex_type>;
 
     using iterator = particle_indices::iterator;
     using const_iterator = particle_indices::const_iterator;
 
     ParticlesList() = default;
 
-    ParticlesList(ParticlesList &&rhs) : _particles_mutex() {
-        particles_lock rhs_lock(rhs._particles_mutex);
-        _particles = std::move(rhs._particles);
-    }
+    ParticlesList(ParticlesList &&) = default;
 
-    ParticlesList &operator=(ParticlesList &&) = delete;
+    ParticlesList &operator=(ParticlesList &&) = default;
 
     ParticlesList(const ParticlesList &) = delete;
 
@@ -65,11 +64,6 @@ public:
 
     virtual ~ParticlesList() = default;
 
-    void add(const particle_index index) const {
-        particles_lock lock(_particles_mutex);
-        _particles.push_back(index);
-    }
-
     void add(const particle_index index) {
         _particles.push_back(index);
     }
@@ -82,30 +76,6 @@ public:
         return _particles.erase(it);
     }
 
-    bool erase_if_found(particle_index index) {
-        auto it = std::find(begin(), end(), index);
-        if(it != end()) {
-            _particles.erase(it);
-            return true;
-        }
-        return false;
-    }
-
-    bool erase_if_found(particle_index index) const {
-        particles_lock lock(_particles_mutex);
-        auto it = std::find(begin(), end(), index);
-        if(it != end()) {
-            _particles.erase(it);
-            return true;
-        }
-        return false;
-    }
-
-    const_iterator erase(const_iterator it) const {
-        particles_lock lock(_particles_mutex);
-        return _particles.erase(it);
-    }
-
     particle_indices  &data() {
         return _particles;
     }
@@ -139,8 +109,7 @@ public:
     }
 
 private:
-    mutable std::mutex _particles_mutex{};
-    mutable particle_indices _particles{};
+    particle_indices _particles{};
 };
 
 }
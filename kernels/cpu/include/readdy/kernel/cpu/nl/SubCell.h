@@ -80,14 +80,14 @@ public:
 
     void setup_uniform_neighbors(const std::uint8_t radius);
 
-    virtual void insert_particle(const particle_index index, bool mark_dirty=false) const override;
-
     virtual void insert_particle(const particle_index index, bool mark_dirty=false) override;
 
     virtual void clear() override;
 
     const ParticlesList& particles() const;
 
+    ParticlesList& particles();
+
     const bool is_dirty() const;
 
     virtual void set_dirty() const override;
@@ -30,12 +30,17 @@
  */
 
 #pragma once
+#include <array>
+#include <memory>
 #include <readdy/model/observables/Observables.h>
 
 namespace readdy {
 namespace kernel {
 namespace cpu {
 class CPUKernel;
+namespace nl {
+class CellContainer;
+}
 
 namespace observables {
 
@@ -99,6 +104,36 @@ protected:
     CPUKernel *const kernel;
 };
 
+/**
+ * Radial distribution that only looks at pairs within the largest bin border. The particles of interest are sorted
+ * into a cell list with cells at least as wide as the largest border, the cells are processed in parallel with one
+ * histogram per task. Types are looked up in precomputed masks and equidistant bins are indexed directly.
+ */
+class CPURadialDistribution : public readdy::model::observables::RadialDistribution {
+public:
+    CPURadialDistribution(CPUKernel *const kernel, unsigned int stride, const std::vector<double> &binBorders,
+                          const std::vector<std::string> &typeCountFrom, const std::vector<std::string> &typeCountTo,
+                          double particleToDensity);
+
+    virtual ~CPURadialDistribution();
+
+    virtual void evaluate() override;
+
+protected:
+    /**
+     * the bin a distance falls into, or -1 if it is not covered by the bin borders
+     */
+    std::ptrdiff_t binIndex(double dist) const;
+
+    CPUKernel *const kernel;
+    std::vector<char> fromMask, toMask;
+    bool uniformBins{false};
+    double binWidth{0};
+    std::unique_ptr<nl::CellContainer> cells;
+    std::array<double, 3> cellsBoxSize{{0, 0, 0}};
+    std::array<bool, 3> cellsPeriodicity{{false, false, false}};
+};
+
 class CPUReactions : public readdy::model::observables::Reactions {
 public:
     CPUReactions(CPUKernel *const kernel, unsigned int stride);
@@ -0,0 +1,117 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+/**
+ * Allocator handing out memory with a given alignment, so that the columns of the structure-of-arrays particle data
+ * start at cache line boundaries without relying on c++17's aligned new.
+ *
+ * @file aligned_allocator.h
+ * @brief Header file containing an allocator with configurable alignment
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#include <readdy/common/macros.h>
+
+#if READDY_WINDOWS
+#include <malloc.h>
+#endif
+
+namespace readdy {
+namespace kernel {
+namespace cpu {
+namespace util {
+
+/**
+ * the size of a cache line in bytes
+ */
+constexpr std::size_t cache_line_size = 64;
+
+template<typename T, std::size_t Alignment = cache_line_size>
+class aligned_allocator {
+    static_assert(Alignment >= alignof(void *) && (Alignment & (Alignment - 1)) == 0,
+                  "the alignment must be a power of two and at least the alignment of a pointer");
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    template<typename U>
+    struct rebind {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() noexcept = default;
+
+    template<typename U>
+    aligned_allocator(const aligned_allocator<U, Alignment> &) noexcept {}
+
+    T *allocate(size_type n) {
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+#if READDY_WINDOWS
+        void *ptr = _aligned_malloc(n * sizeof(T), Alignment);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+#else
+        void *ptr = nullptr;
+        if (posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0) {
+            throw std::bad_alloc();
+        }
+#endif
+        return static_cast<T *>(ptr);
+    }
+
+    void deallocate(T *ptr, size_type) noexcept {
+#if READDY_WINDOWS
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+};
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator==(const aligned_allocator<T, Alignment> &, const aligned_allocator<U, Alignment> &) noexcept {
+    return true;
+}
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator!=(const aligned_allocator<T, Alignment> &, const aligned_allocator<U, Alignment> &) noexcept {
+    return false;
+}
+
+}
+}
+}
+}
@@ -0,0 +1,175 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * Fenwick tree (binary indexed tree) over non-negative weights. Setting a weight, querying prefix sums and finding the
+ * element that a cumulative weight falls into all take O(log n), which makes it suitable for sampling from a discrete
+ * distribution whose weights change only locally.
+ *
+ * @file fenwick_tree.h
+ * @brief Header file containing a Fenwick tree for sampling from weights that change locally
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace readdy {
+namespace kernel {
+namespace cpu {
+namespace util {
+
+template<typename T>
+class fenwick_tree {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    /**
+     * the number of weights
+     * @return the size
+     */
+    size_type size() const {
+        return _values.size();
+    }
+
+    /**
+     * Resizes the tree, keeping the weights of the first min(size(), n) elements. Added elements have weight zero.
+     * Takes O(n).
+     * @param n the new size
+     */
+    void resize(size_type n) {
+        _values.resize(n, 0);
+        rebuild();
+    }
+
+    /**
+     * sets all weights to zero, O(n)
+     */
+    void reset() {
+        std::fill(_values.begin(), _values.end(), 0);
+        std::fill(_tree.begin(), _tree.end(), 0);
+        _nUpdates = 0;
+    }
+
+    /**
+     * the weight of an element
+     * @param i the element
+     * @return its weight
+     */
+    const value_type &operator[](size_type i) const {
+        return _values[i];
+    }
+
+    /**
+     * Sets the weight of an element. Since the update is applied as a difference, the inner nodes are recomputed from
+     * scratch every size() updates, so that rounding errors do not accumulate.
+     * @param i the element
+     * @param value its new weight
+     */
+    void set(size_type i, value_type value) {
+        const auto delta = value - _values[i];
+        _values[i] = value;
+        if (delta == 0) return;
+        if (++_nUpdates > _values.size()) {
+            rebuild();
+        } else {
+            for (auto k = i + 1; k <= _values.size(); k += k & (~k + 1)) {
+                _tree[k] += delta;
+            }
+        }
+    }
+
+    /**
+     * the sum of the weights of the first n elements
+     * @param n the number of elements
+     * @return the prefix sum
+     */
+    value_type prefix_sum(size_type n) const {
+        value_type result = 0;
+        for (auto k = n; k > 0; k -= k & (~k + 1)) {
+            result += _tree[k];
+        }
+        return result;
+    }
+
+    /**
+     * the sum of all weights
+     * @return the total weight
+     */
+    value_type total() const {
+        return prefix_sum(_values.size());
+    }
+
+    /**
+     * Finds the element i with prefix_sum(i) <= x < prefix_sum(i+1). If x exceeds the total weight due to rounding,
+     * the last element is returned.
+     * @param x the cumulative weight, in [0, total())
+     * @return the element
+     */
+    size_type find(value_type x) const {
+        size_type pos = 0;
+        auto step = highest_power_of_two(_values.size());
+        for (; step > 0; step >>= 1) {
+            if (pos + step <= _values.size() && _tree[pos + step] <= x) {
+                pos += step;
+                x -= _tree[pos];
+            }
+        }
+        return pos < _values.size() ? pos : _values.size() - 1;
+    }
+
+private:
+    static size_type highest_power_of_two(size_type n) {
+        size_type result = n > 0 ? 1 : 0;
+        while (result > 0 && (result << 1) <= n) result <<= 1;
+        return result;
+    }
+
+    void rebuild() {
+        _tree.assign(_values.size() + 1, 0);
+        for (size_type k = 1; k <= _values.size(); ++k) {
+            _tree[k] += _values[k - 1];
+            const auto parent = k + (k & (~k + 1));
+            if (parent <= _values.size()) {
+                _tree[parent] += _tree[k];
+            }
+        }
+        _nUpdates = 0;
+    }
+
+    std::vector<value_type> _values;
+    // one based, node k covers the elements (k - lowbit(k), k]
+    std::vector<value_type> _tree{0};
+    size_type _nUpdates{0};
+};
+
+}
+}
+}
+}
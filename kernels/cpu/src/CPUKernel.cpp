@@ -55,15 +55,19 @@ readdy::model::Kernel* CPUKernel::create() {
     return new CPUKernel();
 }
 
-CPUKernel::CPUKernel() : readdy::model::Kernel(name), pimpl(std::make_unique<Impl>()) {
+CPUKernel::CPUKernel() : CPUKernel(model::CPUParticleData::Layout::aos) {}
+
+CPUKernel::CPUKernel(model::CPUParticleData::Layout layout)
+        : readdy::model::Kernel(name), pimpl(std::make_unique<Impl>()) {
     pimpl->config = std::make_unique<readdy::util::thread::Config>();
-    pimpl->config->setMode(readdy::util::thread::ThreadMode::pool);
+    pimpl->config->setMode(readdy::util::thread::ThreadMode::work_stealing);
 
     pimpl->reactionFactory = std::make_unique<readdy::model::reactions::ReactionFactory>();
     pimpl->context = std::make_unique<readdy::model::KernelContext>();
     pimpl->actionFactory = std::make_unique<actions::CPUActionFactory>(this);
     pimpl->topologyActionFactory = std::make_unique<readdy::kernel::cpu::model::top::CPUTopologyActionFactory>(this);
-    pimpl->stateModel = std::make_unique<CPUStateModel>(pimpl->context.get(), pimpl->config.get(), pimpl->topologyActionFactory.get());
+    pimpl->stateModel = std::make_unique<CPUStateModel>(pimpl->context.get(), pimpl->config.get(),
+                                                        pimpl->topologyActionFactory.get(), layout);
     pimpl->potentialFactory = std::make_unique<readdy::model::potentials::PotentialFactory>();
     pimpl->observableFactory = std::make_unique<observables::CPUObservableFactory>(this);
     pimpl->compartmentFactory = std::make_unique<readdy::model::compartments::CompartmentFactory>();
@@ -127,7 +131,6 @@ readdy::util::thread::Config &CPUKernel::threadConfig() {
 
 void CPUKernel::initialize() {
     readdy::model::Kernel::initialize();
-    threadConfig().setMode(readdy::util::thread::ThreadMode::pool);
     for(auto& top : getCPUKernelStateModel().topologies()) {
         top->configure();
         top->updateReactionRates();
@@ -135,8 +138,8 @@ void CPUKernel::initialize() {
 }
 
 void CPUKernel::finalize() {
+    // the thread pool is kept alive for the lifetime of the kernel
     readdy::model::Kernel::finalize();
-    threadConfig().setMode(readdy::util::thread::ThreadMode::inactive);
 }
 
 const readdy::util::thread::executor_base &CPUKernel::executor() const {
@@ -29,10 +29,13 @@
  * @date 13.07.16
  */
 
+#include <algorithm>
 #include <future>
+#include <numeric>
 #include <readdy/kernel/cpu/CPUStateModel.h>
 #include <readdy/common/thread/barrier.h>
 #include <readdy/kernel/cpu/nl/NeighborList.h>
+#include <readdy/kernel/cpu/model/topologies/BondedInteractions.h>
 #include <readdy/common/index_persistent_vector.h>
 
 namespace readdy {
@@ -41,26 +44,98 @@ namespace cpu {
 
 namespace thd = readdy::util::thread;
 
-using entries_it = CPUStateModel::data_t::entries_t::iterator;
+using data_t = CPUStateModel::data_t;
 using topologies_it = std::vector<std::unique_ptr<readdy::model::top::GraphTopology>>::const_iterator;
 using pot1Map = readdy::model::potentials::PotentialRegistry::potential_o1_registry;
-using pot2Map = readdy::model::potentials::PotentialRegistry::potential_o2_registry;
-using dist_fun = readdy::model::KernelContext::shortest_dist_fun;
+using pair_table = readdy::model::potentials::PairPotentialTable;
+using pair_kind = readdy::model::potentials::PairPotentialKind;
+using pair_entry = readdy::model::potentials::PairPotentialEntry;
+using box_t = std::array<double, 3>;
 using top_action_factory = readdy::model::top::TopologyActionFactory;
 
-void calculateForcesThread(std::size_t, entries_it begin, entries_it end, neighbor_list::const_iterator neighbors_it,
-                           std::promise<double>& energyPromise, const CPUStateModel::data_t& data, const pot1Map& pot1,
-                           const pot2Map& pot2, const dist_fun& d) {
+/**
+ * evaluates the pair potentials of one fixed kind
+ */
+template<pair_kind kind>
+struct specialized_pair_kernel {
+    static void apply(const pair_entry &entry, const readdy::model::Vec3 &x_ij, double distSquared,
+                      readdy::model::Vec3 &force, double &energy) {
+        readdy::model::potentials::pair_kernels::forceAndEnergy<kind>(entry, x_ij, distSquared, force, energy);
+    }
+};
+
+/**
+ * evaluates pair potentials of mixed kinds by switching over their tags
+ */
+struct dispatching_pair_kernel {
+    static void apply(const pair_entry &entry, const readdy::model::Vec3 &x_ij, double distSquared,
+                      readdy::model::Vec3 &force, double &energy) {
+        readdy::model::potentials::pair_kernels::forceAndEnergy(entry, x_ij, distSquared, force, energy);
+    }
+};
+
+/**
+ * Forces that one thread exerts on particles beyond its own range of particles. Since pairs are only evaluated from
+ * the side of the smaller index, these can only be particles with larger indices. The buffer covers the indices from
+ * the smallest to the largest such neighbor, it is indexed relative to offset and only [touchedBegin, touchedEnd) may
+ * contain non-zero values.
+ */
+struct force_buffer {
+    std::vector<readdy::model::Vec3> forces;
+    std::size_t offset{0};
+    std::size_t touchedBegin{0};
+    std::size_t touchedEnd{0};
+};
+
+/**
+ * Force loop over the particles [beginIndex, endIndex), compiled per pair kernel, periodicity and layout of the
+ * particle data, which is accessed through View (see CPUParticleData::AoSView and CPUParticleData::SoAView).
+ */
+template<typename PairKernel, bool PX, bool PY, bool PZ, typename View>
+void calculateForcesThread(std::size_t, std::size_t beginIndex, std::size_t endIndex,
+                           neighbor_list::const_iterator neighbors_it, std::promise<double>& energyPromise,
+                           const View &view, std::size_t nParticles, const pot1Map& pot1, const pair_table& pot2,
+                           const box_t& box, force_buffer &buffer) {
     double energyUpdate = 0.0;
-    for (auto it = begin; it != end; ++it) {
-        if (!it->is_deactivated()) {
+    // the table is empty as long as the context has not been configured
+    const bool hasPairPotentials = !pot2.empty();
+
+    // particles of this range receive forces from pairs that were evaluated earlier in the loop, so reset them first
+    for (auto index = beginIndex; index < endIndex; ++index) {
+        view.force(index) = {0, 0, 0};
+    }
+    // the neighbors outside of this range, as the particles are sorted spatially these are usually close to endIndex
+    {
+        auto lo = nParticles;
+        std::size_t hi = 0;
+        auto nIt = neighbors_it;
+        for (auto index = beginIndex; index < endIndex; ++index, ++nIt) {
+            for (const std::size_t neighbor : *nIt) {
+                if (neighbor >= endIndex) {
+                    lo = std::min(lo, neighbor);
+                    hi = std::max(hi, neighbor + 1);
+                }
+            }
+        }
+        const auto span = hi > lo ? hi - lo : 0;
+        buffer.offset = lo;
+        if (buffer.forces.size() < span || buffer.forces.size() > 2 * span) {
+            buffer.forces.assign(span, {0, 0, 0});
+        }
+    }
+    buffer.touchedBegin = nParticles;
+    buffer.touchedEnd = 0;
+
+    for (auto index = beginIndex; index < endIndex; ++index) {
+        if (!view.is_deactivated(index)) {
             readdy::model::Vec3 force{0, 0, 0};
-            const auto &myPos = it->position();
+            const auto &myPos = view.position(index);
+            const auto myType = view.type(index);
 
             //
             // 1st order potentials
             //
-            auto find_it = pot1.find(it->type);
+            auto find_it = pot1.find(myType);
             if (find_it != pot1.end()) {
                 for (const auto &potential : find_it->second) {
                     potential->calculateForceAndEnergy(force, energyUpdate, myPos);
@@ -68,29 +143,38 @@ void calculateForcesThread(std::size_t, entries_it begin, entries_it end, neighb
             }
 
             //
-            // 2nd order potentials
+            // 2nd order potentials, each pair is evaluated once from the side of the smaller index and the
+            // counter force is applied to the neighbor
             //
-            double mySecondOrderEnergy = 0.;
-            for (const auto neighbor : *neighbors_it) {
-                auto &neighborEntry = data.entry_at(neighbor);
-                auto potit = pot2.find(std::tie(it->type, neighborEntry.type));
-                if (potit != pot2.end()) {
-                    auto x_ij = d(myPos, neighborEntry.position());
-                    auto distSquared = x_ij * x_ij;
-                    for (const auto &potential : potit->second) {
-                        if (distSquared < potential->getCutoffRadiusSquared()) {
-                            readdy::model::Vec3 updateVec{0, 0, 0};
-                            potential->calculateForceAndEnergy(updateVec, mySecondOrderEnergy, x_ij);
-                            force += updateVec;
+            if (hasPairPotentials) {
+                for (const std::size_t neighbor : *neighbors_it) {
+                    if (neighbor <= index) continue;
+                    const auto neighborType = view.type(neighbor);
+                    auto potIt = pot2.begin(myType, neighborType);
+                    const auto potEnd = pot2.end(myType, neighborType);
+                    if (potIt != potEnd) {
+                        const auto x_ij = readdy::model::shortestDifference<PX, PY, PZ>(
+                                myPos, view.position(neighbor), box[0], box[1], box[2]);
+                        const auto distSquared = x_ij * x_ij;
+                        readdy::model::Vec3 pairForce{0, 0, 0};
+                        for (; potIt != potEnd; ++potIt) {
+                            if (distSquared < potIt->cutoffSquared) {
+                                PairKernel::apply(*potIt, x_ij, distSquared, pairForce, energyUpdate);
+                            }
+                        }
+                        force += pairForce;
+                        if (neighbor < endIndex) {
+                            view.force(neighbor) -= pairForce;
+                        } else {
+                            buffer.forces[neighbor - buffer.offset] -= pairForce;
+                            buffer.touchedBegin = std::min(buffer.touchedBegin, neighbor);
+                            buffer.touchedEnd = std::max(buffer.touchedEnd, neighbor + 1);
                         }
                     }
                 }
             }
-            // The contribution of second order potentials must be halved since we parallelise over particles.
-            // Thus every particle pair potential is seen twice
-            energyUpdate += 0.5 * mySecondOrderEnergy;
 
-            it->force = force;
+            view.force(index) += force;
         }
         ++neighbors_it;
     }
@@ -116,6 +200,78 @@ void calculateForcesThread(std::size_t, entries_it begin, entries_it end, neighb
     energyPromise.set_value(energyUpdate);
 }
 
+template<typename View>
+using forces_fun = decltype(&calculateForcesThread<dispatching_pair_kernel, true, true, true, View>);
+
+template<typename PairKernel, typename View>
+forces_fun<View> selectPeriodicity(const std::array<bool, 3> &pbc) {
+    static const forces_fun<View> dispatch[8] = {
+            calculateForcesThread<PairKernel, false, false, false, View>,
+            calculateForcesThread<PairKernel, false, false, true, View>,
+            calculateForcesThread<PairKernel, false, true, false, View>,
+            calculateForcesThread<PairKernel, false, true, true, View>,
+            calculateForcesThread<PairKernel, true, false, false, View>,
+            calculateForcesThread<PairKernel, true, false, true, View>,
+            calculateForcesThread<PairKernel, true, true, false, View>,
+            calculateForcesThread<PairKernel, true, true, true, View>
+    };
+    return dispatch[4 * pbc[0] + 2 * pbc[1] + pbc[2]];
+}
+
+/**
+ * Selects the force loop for the current configuration. If all type pairs interact through at most one potential of
+ * the same kind, the loop is specialized to that kind, otherwise the kind is switched over per pair.
+ */
+template<typename View>
+forces_fun<View> selectForcesFun(const pair_table &table, const std::array<bool, 3> &pbc) {
+    pair_kind kind;
+    if (table.uniform(kind)) {
+        switch (kind) {
+            case pair_kind::HARMONIC_REPULSION:
+                return selectPeriodicity<specialized_pair_kernel<pair_kind::HARMONIC_REPULSION>, View>(pbc);
+            case pair_kind::WEAK_INTERACTION_PIECEWISE_HARMONIC:
+                return selectPeriodicity<specialized_pair_kernel<pair_kind::WEAK_INTERACTION_PIECEWISE_HARMONIC>, View>(pbc);
+            case pair_kind::LENNARD_JONES:
+                return selectPeriodicity<specialized_pair_kernel<pair_kind::LENNARD_JONES>, View>(pbc);
+            case pair_kind::SCREENED_ELECTROSTATICS:
+                return selectPeriodicity<specialized_pair_kernel<pair_kind::SCREENED_ELECTROSTATICS>, View>(pbc);
+            case pair_kind::TABULATED:
+                return selectPeriodicity<specialized_pair_kernel<pair_kind::TABULATED>, View>(pbc);
+            case pair_kind::GENERIC:
+                return selectPeriodicity<specialized_pair_kernel<pair_kind::GENERIC>, View>(pbc);
+        }
+    }
+    return selectPeriodicity<dispatching_pair_kernel, View>(pbc);
+}
+
+/**
+ * Evaluates the first order and pair potentials, each thread takes a range of particles.
+ */
+template<typename View>
+void calculatePairForces(const View &view, std::size_t nParticles, neighbor_list::const_iterator it_nl,
+                         const pot1Map &pot1, const pair_table &pot2, const box_t &box, const std::array<bool, 3> &pbc,
+                         const readdy::util::thread::Config &config, std::vector<std::promise<double>> &promises,
+                         std::vector<force_buffer> &buffers) {
+    const auto calculateForcesFun = selectForcesFun<View>(pot2, pbc);
+    const std::size_t grainSize = nParticles / config.nThreads();
+    const auto& executor = *config.executor();
+    std::vector<std::function<void(std::size_t)>> executables;
+    executables.reserve(config.nThreads());
+
+    std::size_t beginIndex = 0;
+    for (std::size_t i = 0; i < config.nThreads() - 1; ++i) {
+        executables.push_back(executor.pack(calculateForcesFun, beginIndex, beginIndex + grainSize, it_nl,
+                                            std::ref(promises.at(i)), std::cref(view), nParticles, std::cref(pot1),
+                                            std::cref(pot2), std::cref(box), std::ref(buffers.at(i))));
+        it_nl += grainSize;
+        beginIndex += grainSize;
+    }
+    executables.push_back(executor.pack(calculateForcesFun, beginIndex, nParticles, it_nl, std::ref(promises.back()),
+                                        std::cref(view), nParticles, std::cref(pot1), std::cref(pot2),
+                                        std::cref(box), std::ref(buffers.back())));
+    executor.execute_and_wait(std::move(executables));
+}
+
 struct CPUStateModel::Impl {
     using reaction_counts_order1_map = CPUStateModel::reaction_counts_order1_map;
     using reaction_counts_order2_map = CPUStateModel::reaction_counts_order2_map;
@@ -128,6 +284,8 @@ struct CPUStateModel::Impl {
     top_action_factory const *const topologyActionFactory;
     std::vector<readdy::model::reactions::ReactionRecord> reactionRecords{};
     std::pair<reaction_counts_order1_map, reaction_counts_order2_map> reactionCounts;
+    std::vector<force_buffer> forceBuffers;
+    model::top::BondedInteractions bondedInteractions;
 
     const model::CPUParticleData &cdata() const {
         return *particleData;
@@ -138,8 +296,9 @@ struct CPUStateModel::Impl {
     }
 
     Impl(readdy::model::KernelContext *context, top_action_factory const *const taf,
-         readdy::util::thread::Config const *const config)
-            : particleData(std::make_unique<CPUStateModel::data_t>(context, *config)), topologyActionFactory(taf) {
+         readdy::util::thread::Config const *const config, data_t::Layout layout)
+            : particleData(std::make_unique<CPUStateModel::data_t>(context, *config, layout)),
+              topologyActionFactory(taf) {
         Impl::context = context;
     }
 
@@ -149,46 +308,45 @@ private:
 
 void CPUStateModel::calculateForces() {
     pimpl->currentEnergy = 0;
-    const auto &particleData = pimpl->cdata();
+    auto &particleData = pimpl->data();
     const auto &potOrder1 = pimpl->context->potentials().potentials_order1();
-    const auto &potOrder2 = pimpl->context->potentials().potentials_order2();
-    const auto &d = pimpl->context->getShortestDifferenceFun();
+    const auto &potOrder2 = pimpl->context->potentials().pair_potential_table();
+    const auto &box = pimpl->context->getBoxSize();
+    const auto &pbc = pimpl->context->getPeriodicBoundary();
     {
         //std::vector<std::future<double>> energyFutures;
         //energyFutures.reserve(config->nThreads());
         std::vector<std::promise<double>> promises (config->nThreads());
+        auto &buffers = pimpl->forceBuffers;
+        buffers.resize(config->nThreads());
+        if (particleData.layout() == data_t::Layout::aos) {
+            calculatePairForces(particleData.aos_view(), particleData.size(), pimpl->neighborList->begin(), potOrder1,
+                                potOrder2, box, pbc, *config, promises, buffers);
+        } else {
+            calculatePairForces(particleData.soa_view(), particleData.size(), pimpl->neighborList->begin(), potOrder1,
+                                potOrder2, box, pbc, *config, promises, buffers);
+        }
         {
-            const std::size_t grainSize = (pimpl->cdata().size()) / config->nThreads();
-            const std::size_t grainSizeTopologies = pimpl->topologies.size() / config->nThreads();
-            entries_it it_data_end = pimpl->data().end();
-            entries_it it_data = pimpl->data().begin();
-            auto it_nl = pimpl->neighborList->begin();
-            auto it_tops = pimpl->topologies.cbegin();
-            const thd::barrier barrier{config->nThreads()};
-
+            // add the forces that threads exerted on particles of other threads, resetting the buffers on the way
             const auto& executor = *config->executor();
             std::vector<std::function<void(std::size_t)>> executables;
             executables.reserve(config->nThreads());
-
+            const std::size_t grainSize = particleData.size() / config->nThreads();
+            auto reduce = [&buffers, &particleData](std::size_t, std::size_t begin, std::size_t end) {
+                for (auto &buffer : buffers) {
+                    const auto from = std::max(begin, buffer.touchedBegin);
+                    const auto to = std::min(end, buffer.touchedEnd);
+                    for (auto idx = from; idx < to; ++idx) {
+                        auto &f = buffer.forces[idx - buffer.offset];
+                        particleData.entry_at(idx).force += f;
+                        f = {0, 0, 0};
+                    }
+                }
+            };
             for (std::size_t i = 0; i < config->nThreads() - 1; ++i) {
-                //energyFutures.push_back(promises[i].get_future());
-                //ForcesThreadArgs args (, std::cref(barrier));
-                executables.push_back(executor.pack(calculateForcesThread, it_data, it_data + grainSize, it_nl, std::ref(promises.at(i)),
-                                                    std::cref(particleData), std::cref(potOrder1), std::cref(potOrder2),
-                                                    std::cref(d)));
-                it_nl += grainSize;
-                it_data += grainSize;
-                it_tops += grainSizeTopologies;
-            }
-            {
-                std::promise<double> &lastPromise = promises.back();
-                //energyFutures.push_back(lastPromise.get_future());
-                //ForcesThreadArgs args (, std::cref(barrier));
-                executables.push_back(
-                        executor.pack(calculateForcesThread, it_data, it_data_end, it_nl, std::ref(lastPromise),
-                                      std::cref(particleData), std::cref(potOrder1), std::cref(potOrder2),
-                                      std::cref(d)));
+                executables.push_back(executor.pack(reduce, i * grainSize, (i + 1) * grainSize));
             }
+            executables.push_back(executor.pack(reduce, (config->nThreads() - 1) * grainSize, particleData.size()));
             executor.execute_and_wait(std::move(executables));
 
         }
@@ -197,24 +355,9 @@ void CPUStateModel::calculateForces() {
         }
     }
 
-    for (auto t_it = pimpl->topologies.cbegin(); t_it != pimpl->topologies.cend(); ++t_it) {
-        const auto &top = *t_it;
-        if (!top->isDeactivated()) {
-            for (const auto &bondedPot : top->getBondedPotentials()) {
-                auto action = bondedPot->createForceAndEnergyAction(pimpl->topologyActionFactory);
-                auto energy = action->perform();
-                pimpl->currentEnergy += energy;
-            }
-            for (const auto &anglePot : top->getAnglePotentials()) {
-                auto energy = anglePot->createForceAndEnergyAction(pimpl->topologyActionFactory)->perform();
-                pimpl->currentEnergy += energy;
-            }
-            for (const auto &torsionPot : top->getTorsionPotentials()) {
-                auto energy = torsionPot->createForceAndEnergyAction(pimpl->topologyActionFactory)->perform();
-                pimpl->currentEnergy += energy;
-            }
-        }
-    }
+    pimpl->bondedInteractions.update(pimpl->topologies, config->nThreads());
+    pimpl->currentEnergy += pimpl->bondedInteractions.evaluate(particleData, *pimpl->context, *config,
+                                                               pimpl->topologyActionFactory);
 }
 
 const std::vector<readdy::model::Vec3> CPUStateModel::getParticlePositions() const {
@@ -239,6 +382,59 @@ const std::vector<readdy::model::Particle> CPUStateModel::getParticles() const {
     return result;
 }
 
+std::size_t CPUStateModel::getNParticles() const {
+    const auto &data = pimpl->cdata();
+    return data.size() - data.getNDeactivated();
+}
+
+void CPUStateModel::toTrajectoryFrame(std::vector<readdy::model::observables::TrajectoryEntry> &frame) const {
+    const auto &data = pimpl->cdata();
+    const std::size_t nChunks = config->nThreads();
+    const std::size_t grainSize = data.size() / nChunks;
+    const auto chunkBegin = [&](std::size_t chunk) { return data.cbegin() + chunk * grainSize; };
+    const auto chunkEnd = [&](std::size_t chunk) {
+        return chunk == nChunks - 1 ? data.cend() : data.cbegin() + (chunk + 1) * grainSize;
+    };
+    const auto &executor = *config->executor();
+
+    // count the active particles per chunk to obtain the chunks' offsets within the frame
+    std::vector<std::size_t> offsets(nChunks + 1, 0);
+    {
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nChunks);
+        for (std::size_t chunk = 0; chunk < nChunks; ++chunk) {
+            executables.push_back(executor.pack([&](std::size_t, std::size_t chunk) {
+                offsets[chunk + 1] = static_cast<std::size_t>(std::count_if(
+                        chunkBegin(chunk), chunkEnd(chunk), [](const data_t::ConstEntryRef &e) { return !e.is_deactivated(); }));
+            }, chunk));
+        }
+        executor.execute_and_wait(std::move(executables));
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    frame.resize(offsets.back());
+
+    // write the active particles directly into the frame
+    {
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nChunks);
+        for (std::size_t chunk = 0; chunk < nChunks; ++chunk) {
+            executables.push_back(executor.pack([&](std::size_t, std::size_t chunk) {
+                auto out = frame.begin() + offsets[chunk];
+                for (auto it = chunkBegin(chunk); it != chunkEnd(chunk); ++it) {
+                    if (!it->is_deactivated()) {
+                        out->typeId = it->type;
+                        out->id = it->id;
+                        out->flavor = particle_t::FLAVOR_NORMAL;
+                        out->pos = it->position();
+                        ++out;
+                    }
+                }
+            }, chunk));
+        }
+        executor.execute_and_wait(std::move(executables));
+    }
+}
+
 void CPUStateModel::updateNeighborList() {
     if(pimpl->initial_neighbor_list_setup) {
         pimpl->neighborList->set_up();
@@ -266,8 +462,9 @@ double CPUStateModel::getEnergy() const {
 
 CPUStateModel::CPUStateModel(readdy::model::KernelContext *const context,
                              readdy::util::thread::Config const *const config,
-                             readdy::model::top::TopologyActionFactory const *const taf)
-        : pimpl(std::make_unique<Impl>(context, taf, config)), config(config) {
+                             readdy::model::top::TopologyActionFactory const *const taf,
+                             data_t::Layout layout)
+        : pimpl(std::make_unique<Impl>(context, taf, config, layout)), config(config) {
     pimpl->neighborList = std::make_unique<neighbor_list>(*getParticleData(), *context, *config);
     pimpl->reorderConnection = std::make_unique<readdy::signals::scoped_connection>(
             pimpl->data().registerReorderEventListener([this](const std::vector<std::size_t> &indices) -> void {
@@ -29,6 +29,10 @@
  * @date 07.07.16
  */
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 #include <readdy/kernel/cpu/actions/CPUEulerBDIntegrator.h>
 
 namespace readdy {
@@ -39,29 +43,140 @@ namespace actions {
 namespace rnd = readdy::model::rnd;
 namespace thd = readdy::util::thread;
 
+using data_t = readdy::kernel::cpu::model::CPUParticleData;
+using index_t = data_t::index_t;
+
+/**
+ * number of particles for which the normally distributed random numbers are drawn in one go
+ */
+static constexpr std::size_t block_size = 256;
+
+/**
+ * Integrates the particles [begin, end) of the array-of-structures layout.
+ */
+template<bool PX, bool PY, bool PZ>
+void integrate(index_t begin, index_t end, data_t &pd, const std::vector<double> &randomFactors,
+               const std::vector<double> &forceFactors, const std::array<double, 3> &box) {
+    std::array<double, 3 * block_size> noise;
+    const auto view = pd.aos_view();
+    for (auto blockBegin = begin; blockBegin != end;) {
+        const auto n = std::min(block_size, end - blockBegin);
+        rnd::fill_normal(noise.data(), noise.data() + 3 * n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto index = blockBegin + i;
+            if (!view.is_deactivated(index)) {
+                const auto type = view.type(index);
+                const auto &force = view.force(index);
+                const auto randomFactor = randomFactors[type];
+                const auto forceFactor = forceFactors[type];
+                const readdy::model::Vec3 delta{randomFactor * noise[3 * i] + forceFactor * force[0],
+                                                randomFactor * noise[3 * i + 1] + forceFactor * force[1],
+                                                randomFactor * noise[3 * i + 2] + forceFactor * force[2]};
+                pd.displace<PX, PY, PZ>(index, delta, box);
+            }
+        }
+        blockBegin += n;
+    }
+}
+
+/**
+ * Integrates the particles [begin, end) of the structure-of-arrays layout. The loop body is free of branches and
+ * works on the columns directly, deactivated particles are masked out by vanishing prefactors. The noise is consumed
+ * in the same order as in the array-of-structures loop, so that both layouts produce the same trajectories.
+ */
+template<bool PX, bool PY, bool PZ>
+void integrateColumns(index_t begin, index_t end, data_t &pd, const std::vector<double> &randomFactors,
+                      const std::vector<double> &forceFactors, const std::array<double, 3> &box) {
+    std::array<double, 3 * block_size> noise;
+    const auto view = pd.soa_view();
+    const bool trackDisplacement = pd.trackDisplacement();
+    const auto *const rf = randomFactors.data();
+    const auto *const ff = forceFactors.data();
+    const auto dx = box[0], dy = box[1], dz = box[2];
+    for (auto blockBegin = begin; blockBegin != end;) {
+        const auto n = std::min(block_size, end - blockBegin);
+        rnd::fill_normal(noise.data(), noise.data() + 3 * n);
+        auto *const x = view.x + blockBegin;
+        auto *const y = view.y + blockBegin;
+        auto *const z = view.z + blockBegin;
+        const auto *const forces = view.forces + blockBegin;
+        const auto *const types = view.types + blockBegin;
+        const auto *const deactivated = view.deactivated + blockBegin;
+        auto *const displacements = view.displacements + blockBegin;
+        for (std::size_t i = 0; i < n; ++i) {
+            const double active = deactivated[i] == 0 ? 1. : 0.;
+            const auto randomFactor = rf[types[i]] * active;
+            const auto forceFactor = ff[types[i]] * active;
+            const auto deltaX = randomFactor * noise[3 * i] + forceFactor * forces[i][0];
+            const auto deltaY = randomFactor * noise[3 * i + 1] + forceFactor * forces[i][1];
+            const auto deltaZ = randomFactor * noise[3 * i + 2] + forceFactor * forces[i][2];
+            auto posX = x[i] + deltaX;
+            auto posY = y[i] + deltaY;
+            auto posZ = z[i] + deltaZ;
+            if (PX) posX -= std::floor((posX + .5 * dx) / dx) * dx;
+            if (PY) posY -= std::floor((posY + .5 * dy) / dy) * dy;
+            if (PZ) posZ -= std::floor((posZ + .5 * dz) / dz) * dz;
+            x[i] = posX;
+            y[i] = posY;
+            z[i] = posZ;
+            if (trackDisplacement) {
+                displacements[i] += std::sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+            }
+        }
+        blockBegin += n;
+    }
+}
+
 void CPUEulerBDIntegrator::perform() {
     auto& pd = *kernel->getCPUKernelStateModel().getParticleData();
     const auto size = pd.size();
 
     const auto &context = kernel->getKernelContext();
-    using iter_t = decltype(pd.begin());
 
     const auto dt = timeStep;
 
-    auto worker = [&context, &pd, dt](std::size_t id, iter_t entry_begin, iter_t entry_end)  {
-        const auto &fixPos = context.getFixPositionFun();
+    // per-type prefactors of the random and the deterministic displacement
+    std::vector<double> randomFactors;
+    std::vector<double> forceFactors;
+    {
+        const auto types = context.particle_types().types_flat();
+        const auto maxType = types.empty() ? 0 : *std::max_element(types.begin(), types.end());
+        randomFactors.resize(maxType + 1u, 0.);
+        forceFactors.resize(maxType + 1u, 0.);
         const auto kbt = context.getKBT();
-        for (iter_t it = entry_begin; it != entry_end; ++it) {
-            if(!it->is_deactivated()) {
-                const double D = context.particle_types().diffusion_constant_of(it->type);
-                const auto randomDisplacement = std::sqrt(2. * D * dt) * rnd::normal3(0, 1);
-                const auto deterministicDisplacement = it->force * dt * D / kbt;
-                pd.displace(*it, randomDisplacement + deterministicDisplacement);
-            }
+        for (const auto type : types) {
+            const double D = context.particle_types().diffusion_constant_of(type);
+            randomFactors[type] = std::sqrt(2. * D * dt);
+            forceFactors[type] = D * dt / kbt;
         }
+    }
+
+    using integrate_fun = void (*)(index_t, index_t, data_t &, const std::vector<double> &,
+                                   const std::vector<double> &, const std::array<double, 3> &);
+    integrate_fun integrateFun;
+    {
+        const auto &pbc = context.getPeriodicBoundary();
+        static const integrate_fun dispatch[8] = {
+                integrate<false, false, false>, integrate<false, false, true>,
+                integrate<false, true, false>, integrate<false, true, true>,
+                integrate<true, false, false>, integrate<true, false, true>,
+                integrate<true, true, false>, integrate<true, true, true>
+        };
+        static const integrate_fun dispatchColumns[8] = {
+                integrateColumns<false, false, false>, integrateColumns<false, false, true>,
+                integrateColumns<false, true, false>, integrateColumns<false, true, true>,
+                integrateColumns<true, false, false>, integrateColumns<true, false, true>,
+                integrateColumns<true, true, false>, integrateColumns<true, true, true>
+        };
+        const auto idx = 4 * pbc[0] + 2 * pbc[1] + pbc[2];
+        integrateFun = pd.layout() == data_t::Layout::aos ? dispatch[idx] : dispatchColumns[idx];
+    }
+    const auto &box = context.getBoxSize();
+
+    auto worker = [&](std::size_t, index_t begin, index_t end) {
+        integrateFun(begin, end, pd, randomFactors, forceFactors, box);
     };
 
-    auto work_iter = pd.begin();
     {
         auto& executor = kernel->executor();
         std::vector<std::function<void(std::size_t)>> executables;
@@ -70,11 +185,12 @@ void CPUEulerBDIntegrator::perform() {
         auto granularity = kernel->getNThreads();
         const std::size_t grainSize = size / granularity;
 
+        index_t work_begin = 0;
         for (unsigned int i = 0; i < granularity - 1; ++i) {
-            executables.push_back(executor.pack(worker, work_iter, work_iter+grainSize));
-            work_iter += grainSize;
+            executables.push_back(executor.pack(worker, work_begin, work_begin + grainSize));
+            work_begin += grainSize;
         }
-        executables.push_back(executor.pack(worker, work_iter, pd.end()));
+        executables.push_back(executor.pack(worker, work_begin, size));
         executor.execute_and_wait(std::move(executables));
     }
 
@@ -27,6 +27,10 @@
  * @date 18.10.16
  */
 
+#include <algorithm>
+#include <array>
+#include <numeric>
+
 #include <readdy/kernel/cpu/actions/CPUEvaluateCompartments.h>
 
 namespace readdy {
@@ -34,24 +38,94 @@ namespace kernel {
 namespace cpu {
 namespace actions {
 
+using data_t = readdy::kernel::cpu::model::CPUParticleData;
+using iter_t = data_t::iterator;
+using particle_type = readdy::model::Particle::type_type;
+
+/**
+ * number of particles whose positions are gathered and tested against the compartments in one go
+ */
+static constexpr std::size_t block_size = 256;
+
 CPUEvaluateCompartments::CPUEvaluateCompartments(CPUKernel *const kernel) : kernel(kernel) {}
 
 void CPUEvaluateCompartments::perform() {
     const auto &ctx = kernel->getKernelContext();
     const auto &compartments = ctx.getCompartments();
-    for(auto& e : *kernel->getCPUKernelStateModel().getParticleData()) {
-        if(!e.is_deactivated()) {
-            for (auto i = 0; i < compartments.size(); ++i) {
-                if (compartments[i]->isContained(e.position())) {
-                    const auto &conversions = compartments[i]->getConversions();
-                    const auto convIt = conversions.find(e.type);
-                    if (convIt != conversions.end()) {
-                        e.type = (*convIt).second;
+    if (compartments.empty()) return;
+
+    auto &data = *kernel->getCPUKernelStateModel().getParticleData();
+
+    // dense per-compartment conversion tables (identity for types that are not converted) and a mask of the types
+    // that are converted by any compartment, particles of all other types are never touched
+    std::vector<std::vector<particle_type>> conversionTables;
+    std::vector<char> relevant;
+    {
+        const auto types = ctx.particle_types().types_flat();
+        std::size_t nTypes = types.empty() ? 0 : *std::max_element(types.begin(), types.end()) + 1u;
+        for (const auto &compartment : compartments) {
+            for (const auto &conversion : compartment->getConversions()) {
+                nTypes = std::max(nTypes, static_cast<std::size_t>(std::max(conversion.first, conversion.second)) + 1);
+            }
+        }
+        relevant.resize(nTypes, false);
+        conversionTables.reserve(compartments.size());
+        for (const auto &compartment : compartments) {
+            std::vector<particle_type> table(nTypes);
+            std::iota(table.begin(), table.end(), static_cast<particle_type>(0));
+            for (const auto &conversion : compartment->getConversions()) {
+                table[conversion.first] = conversion.second;
+                relevant[conversion.first] = true;
+            }
+            conversionTables.push_back(std::move(table));
+        }
+    }
+
+    auto worker = [&](std::size_t, iter_t begin, iter_t end) {
+        std::array<double, block_size> x, y, z;
+        std::array<std::uint8_t, block_size> contained;
+        std::array<data_t::index_t, block_size> indices;
+        auto it = begin;
+        while (it != end) {
+            // gather the positions of the next block of relevant particles
+            std::size_t n = 0;
+            for (; it != end && n < block_size; ++it) {
+                if (!it->is_deactivated() && it->type < relevant.size() && relevant[it->type]) {
+                    const auto &pos = it->position();
+                    x[n] = pos[0];
+                    y[n] = pos[1];
+                    z[n] = pos[2];
+                    indices[n] = it->index();
+                    ++n;
+                }
+            }
+            // apply the compartments in order, so that a particle converted by one compartment can be converted
+            // again by a subsequent one
+            for (std::size_t c = 0; c < compartments.size(); ++c) {
+                compartments[c]->areContained(x.data(), y.data(), z.data(), n, contained.data());
+                const auto &table = conversionTables[c];
+                for (std::size_t i = 0; i < n; ++i) {
+                    if (contained[i]) {
+                        auto entry = data.entry_at(indices[i]);
+                        entry.type = table[entry.type];
                     }
                 }
             }
         }
+    };
+
+    const auto &executor = kernel->executor();
+    const std::size_t nThreads = kernel->getNThreads();
+    const std::size_t grainSize = data.size() / nThreads;
+    std::vector<std::function<void(std::size_t)>> executables;
+    executables.reserve(nThreads);
+    auto workIter = data.begin();
+    for (std::size_t i = 0; i < nThreads - 1; ++i) {
+        executables.push_back(executor.pack(worker, workIter, workIter + grainSize));
+        workIter += grainSize;
     }
+    executables.push_back(executor.pack(worker, workIter, data.end()));
+    executor.execute_and_wait(std::move(executables));
 }
 
 }
@@ -30,6 +30,8 @@
  * @copyright GNU Lesser General Public License v3.0
  */
 
+#include <algorithm>
+
 #include <readdy/kernel/cpu/actions/CPUEvaluateTopologyReactions.h>
 
 namespace readdy {
@@ -42,180 +44,131 @@ namespace top {
 CPUEvaluateTopologyReactions::CPUEvaluateTopologyReactions(CPUKernel *const kernel, double timeStep)
         : EvaluateTopologyReactions(timeStep), kernel(kernel) {}
 
-template<bool approximated>
-bool performReactionEvent(const double rate, const double timeStep) {
-    if (approximated) {
-        return readdy::model::rnd::uniform_real() < rate * timeStep;
-    } else {
-        return readdy::model::rnd::uniform_real() < 1 - std::exp(-rate * timeStep);
+constexpr std::size_t CPUEvaluateTopologyReactions::unknown_version;
+
+void CPUEvaluateTopologyReactions::updateRates() {
+    const auto &topologies = kernel->getCPUKernelStateModel().topologies();
+    const auto versionOf = [](const std::unique_ptr<readdy::model::top::GraphTopology> &top) -> std::size_t {
+        return top->isDeactivated() ? 0 : top->version();
+    };
+
+    // if a changed topology has more reactions than there are leaves per slot, the tree is laid out anew
+    bool relayout = _versions.size() > topologies.size();
+    for (std::size_t slot = 0; slot < topologies.size() && !relayout; ++slot) {
+        const auto &top = topologies.at(slot);
+        if ((slot >= _versions.size() || versionOf(top) != _versions[slot]) && !top->isDeactivated()) {
+            relayout = top->registeredReactions().size() > _stride;
+        }
+    }
+    if (relayout) {
+        _stride = 0;
+        for (const auto &top : topologies) {
+            if (!top->isDeactivated()) {
+                _stride = std::max(_stride, top->registeredReactions().size());
+            }
+        }
+        _versions.assign(topologies.size(), unknown_version);
+        _nEvents = 0;
+        _rates.reset();
+        _rates.resize(topologies.size() * _stride);
+    } else if (_versions.size() < topologies.size()) {
+        _versions.resize(topologies.size(), unknown_version);
+        _rates.resize(topologies.size() * _stride);
+    }
+
+    for (std::size_t slot = 0; slot < topologies.size(); ++slot) {
+        const auto &top = topologies.at(slot);
+        const auto version = versionOf(top);
+        if (version != _versions[slot]) {
+            _versions[slot] = version;
+            const auto &reactions = top->registeredReactions();
+            for (std::size_t r = 0; r < _stride; ++r) {
+                const rate_t rate = !top->isDeactivated() && r < reactions.size() ? std::get<1>(reactions[r]) : 0;
+                const auto leaf = slot * _stride + r;
+                if (_rates[leaf] > 0) --_nEvents;
+                if (rate > 0) ++_nEvents;
+                _rates.set(leaf, rate);
+            }
+        }
     }
 }
 
-bool shouldPerformEvent(const double rate, const double timestep, bool approximated) {
-    return approximated ? performReactionEvent<true>(rate, timestep) : performReactionEvent<false>(rate, timestep);
+const util::fenwick_tree<CPUEvaluateTopologyReactions::rate_t> &CPUEvaluateTopologyReactions::rates() const {
+    return _rates;
+}
+
+std::size_t CPUEvaluateTopologyReactions::stride() const {
+    return _stride;
 }
 
 void CPUEvaluateTopologyReactions::perform() {
-    using rate_t = readdy::model::top::GraphTopology::rate_t;
     auto &topologies = kernel->getCPUKernelStateModel().topologies();
-
-    if(!topologies.empty()) {
-        std::stringstream ss;
-        for(const auto& top : topologies) {
-            if(!top->isDeactivated()) {
-                const void * address = static_cast<const void*>(top.get());
-                std::stringstream ss2;
-                ss2 << address;
-                std::string name = ss2.str();
-                ss << ", " << name << "(" << top->getNParticles() <<")";
-            }
+    if (topologies.empty()) {
+        return;
+    }
+    updateRates();
+
+    std::vector<readdy::model::top::GraphTopology> new_topologies;
+    // the leaves that were set to zero during this time step together with their rates
+    std::vector<std::pair<std::size_t, rate_t>> removed;
+    auto remove = [this, &removed](std::size_t leaf) {
+        removed.emplace_back(leaf, _rates[leaf]);
+        _rates.set(leaf, 0);
+    };
+    // the events are visited in an order that is drawn proportionally to their rates, each one is performed with
+    // probability rate * timeStep, unless its topology already reacted in this time step
+    for (auto nRemaining = _nEvents; nRemaining > 0;) {
+        auto leaf = _rates.find(readdy::model::rnd::uniform_real(0., _rates.total()));
+        while (_rates[leaf] <= 0) {
+            // can only be hit due to rounding, fall back to the next remaining event
+            leaf = (leaf + 1) % _rates.size();
+        }
+        const auto rate = _rates[leaf];
+        const auto topology_idx = leaf / _stride;
+        const auto reaction_idx = leaf % _stride;
+        if (readdy::model::rnd::uniform_real() >= rate * timeStep) {
+            remove(leaf);
+            --nRemaining;
+            continue;
         }
-        struct TREvent {
-            rate_t cumulative_rate;
-            rate_t own_rate;
-            std::size_t topology_idx;
-            std::size_t reaction_idx;
-        };
-
-        std::vector<TREvent> events;
-
-        {
-            rate_t current_cumulative_rate = 0;
-            std::size_t topology_idx = 0;
-            for (auto &topRef : topologies) {
-
-                if (!topRef->isDeactivated()) {
-
-                    std::size_t reaction_idx = 0;
-                    for (const auto &reaction : topRef->registeredReactions()) {
-
-                        TREvent event;
-                        event.own_rate = std::get<1>(reaction);
-                        event.cumulative_rate = event.own_rate + current_cumulative_rate;
-                        current_cumulative_rate = event.cumulative_rate;
-                        event.topology_idx = topology_idx;
-                        event.reaction_idx = reaction_idx;
-
-                        events.push_back(std::move(event));
-
-                        ++reaction_idx;
-                    }
-                }
-                ++topology_idx;
+        // each topology reacts at most once per time step
+        for (auto other = topology_idx * _stride; other < (topology_idx + 1) * _stride; ++other) {
+            if (_rates[other] > 0) {
+                remove(other);
+                --nRemaining;
             }
         }
-
-        if (!events.empty()) {
-
-            auto end = events.end();
-
-            std::vector<readdy::model::top::GraphTopology> new_topologies;
-            while (end != events.begin()) {
-                const auto cumulative_rate = (end - 1)->cumulative_rate;
-
-                const auto x = readdy::model::rnd::uniform_real(0., cumulative_rate);
-
-                const auto eventIt = std::lower_bound(
-                        events.begin(), end, x, [](const TREvent &elem1, const rate_t elem2) {
-                            return elem1.cumulative_rate < elem2;
-                        }
-                );
-
-                if (eventIt != events.end()) {
-                    const auto &event = *eventIt;
-
-                    if (shouldPerformEvent(event.own_rate, timeStep, true)) {
-                        log::trace("picked event {} / {} with rate {}", std::distance(events.begin(), eventIt)+1, events.size(), eventIt->own_rate);
-                        // perform the event!
-                        auto &topology = topologies.at(event.topology_idx);
-                        if (topology->isDeactivated()) {
-                            log::critical("deactivated topology with idx {}", event.topology_idx);
-                            for (auto it = events.begin(); it != end; ++it) {
-                                log::warn(" -> event {}, {}, {}, {}", it->topology_idx, it->reaction_idx, it->own_rate,
-                                          it->cumulative_rate);
-                            }
-                            for (auto it = end; it != events.end(); ++it) {
-                                log::warn(" -> deactivated event {}, {}, {}, {}", it->topology_idx, it->reaction_idx,
-                                          it->own_rate, it->cumulative_rate);
-                            }
-                        }
-                        assert(!topology->isDeactivated());
-                        auto &reaction = topology->registeredReactions().at(event.reaction_idx);
-                        auto result = std::get<0>(reaction).execute(*topology, kernel);
-                        if (!result.empty()) {
-                            // we had a topology fission, so we need to actually remove the current topology from the
-                            // data structure
-                            topologies.erase(topologies.begin() + event.topology_idx);
-                            //log::error("erased topology with index {}", event.topology_idx);
-                            assert(topology->isDeactivated());
-                            std::move(result.begin(), result.end(), std::back_inserter(new_topologies));
-                        } else {
-                            if (topology->isNormalParticle(*kernel)) {
-                                topologies.erase(topologies.begin() + event.topology_idx);
-                                //log::error("erased topology with index {}", event.topology_idx);
-                                assert(topology->isDeactivated());
-                            }
-                        }
-
-                        // loop over all other events, swap events considering this particular topology to the end
-                        rate_t cumsum = 0;
-                        //log::warn("------");
-                        for (auto it = events.begin();;) {
-                            if (it->topology_idx == event.topology_idx) {
-                                --end;
-                                //log::warn("swapping event with topology idx {}", it->topology_idx);
-                                std::iter_swap(it, end);
-                            }
-                            cumsum += it->own_rate;
-                            it->cumulative_rate = cumsum;
-                            if (it >= end) {
-                                break;
-                            }
-                            if (it->topology_idx != event.topology_idx) {
-                                ++it;
-                            }
-                        }
-
-                    } else {
-
-                        // remove event from the list (ie shift it to the end)
-                        --end;
-
-                        // swap with last element that is not yet deactivated
-                        std::iter_swap(eventIt, end);
-
-                        // this element's cumulative rate gets initialized with its own rate
-                        eventIt->cumulative_rate = eventIt->own_rate;
-                        if (eventIt > events.begin()) {
-                            // and then increased by the cumulative rate of its predecessor
-                            eventIt->cumulative_rate += (eventIt - 1)->cumulative_rate;
-                        }
-                        // now update the cumulative rates of all following elements...
-                        auto cumsum = (*eventIt).cumulative_rate;
-                        for (auto _it = eventIt + 1; _it < end; ++_it) {
-                            cumsum += (*_it).own_rate;
-                            (*_it).cumulative_rate = cumsum;
-                        }
-
-                    }
-
-                } else {
-                    log::critical("this should not happen (event not found by drawn rate)");
-                    throw std::logic_error("this should not happen (event not found by drawn rate)");
-                }
+        auto &topology = topologies.at(topology_idx);
+        assert(!topology->isDeactivated());
+        log::trace("picked reaction {} of topology {} with rate {}", reaction_idx, topology_idx, rate);
+
+        auto &reaction = topology->registeredReactions().at(reaction_idx);
+        auto result = std::get<0>(reaction).execute(*topology, kernel);
+        if (!result.empty()) {
+            // we had a topology fission, so we need to actually remove the current topology from the
+            // data structure
+            topologies.erase(topologies.begin() + topology_idx);
+            assert(topology->isDeactivated());
+            std::move(result.begin(), result.end(), std::back_inserter(new_topologies));
+        } else {
+            if (topology->isNormalParticle(*kernel)) {
+                topologies.erase(topologies.begin() + topology_idx);
+                assert(topology->isDeactivated());
             }
+        }
+    }
+    // the tree keeps the rates at the beginning of the time step, topologies that reacted are updated by their version
+    for (const auto &leaf : removed) {
+        _rates.set(leaf.first, leaf.second);
+    }
 
-            if (!new_topologies.empty()) {
-                for (auto &&top : new_topologies) {
-                    // if we have a single particle that is not of flavor topology, ignore!
-                    if (!top.isNormalParticle(*kernel)) {
-                        auto new_top = std::make_unique<readdy::model::top::GraphTopology>(std::move(top));
-                        auto it = topologies.push_back(std::move(new_top));
-                        (*it)->updateReactionRates();
-                        (*it)->configure();
-                    }
-                }
-            }
+    for (auto &&top : new_topologies) {
+        // if we have a single particle that is not of flavor topology, ignore!
+        if (!top.isNormalParticle(*kernel)) {
+            auto new_top = std::make_unique<readdy::model::top::GraphTopology>(std::move(top));
+            auto it = topologies.push_back(std::move(new_top));
+            (*it)->updateReactionRates();
+            (*it)->configure();
         }
     }
 }
@@ -224,4 +177,4 @@ void CPUEvaluateTopologyReactions::perform() {
 }
 }
 }
-}
\ No newline at end of file
+}
@@ -290,6 +290,8 @@ void CPUGillespieParallel::handleBoxReactions() {
             n_local_problematic += local_problematic.size();
             gatherEvents(kernel, std::move(local_problematic), neighbor_list, data, alpha, evilEvents, d2);
         }
+        // the particles whose reactions might reach into another box cannot be handled by the boxes concurrently
+        kernel->performance().counter("reactions.conflicts") += n_local_problematic;
         auto countsPtr = &stateModel.reactionCounts();
         if (!ctx.recordReactionCounts()) {
             countsPtr = nullptr;
@@ -29,6 +29,7 @@
  * @date 20.10.16
  */
 
+#include <algorithm>
 #include <future>
 
 #include <readdy/kernel/cpu/actions/reactions/CPUUncontrolledApproximation.h>
@@ -57,9 +58,28 @@ CPUUncontrolledApproximation::CPUUncontrolledApproximation(CPUKernel *const kern
 
 }
 
+CPUUncontrolledApproximation::~CPUUncontrolledApproximation() = default;
+
 void findEvents(std::size_t, data_iter_t begin, data_iter_t end, neighbor_list_iter_t nl_begin,
-                const CPUKernel *const kernel, double dt, bool approximateRate, event_promise_t &events,
+                const CPUKernel *const kernel, const ReactionTable &table, event_promise_t &events,
                 std::promise<std::size_t> &n_events) {
+    // instead of drawing one uniform per candidate, each reaction counts down the geometrically distributed number of
+    // candidates that are rejected before the next one is accepted
+    std::vector<std::size_t> countdowns(table.nReactionIds());
+    for (std::size_t id = 0; id < countdowns.size(); ++id) {
+        const auto p = table.probability(id);
+        countdowns[id] = p > 0 && p < 1 ? geometricSkip(p) : 0;
+    }
+    const auto accept = [&](std::size_t id) {
+        auto &countdown = countdowns[id];
+        if (countdown > 0) {
+            --countdown;
+            return false;
+        }
+        const auto p = table.probability(id);
+        if (p < 1) countdown = geometricSkip(p);
+        return true;
+    };
     std::vector<event_t> eventsUpdate;
     const auto &data = *kernel->getCPUKernelStateModel().getParticleData();
     const auto &d2 = kernel->getKernelContext().getDistSquaredFun();
@@ -72,14 +92,16 @@ void findEvents(std::size_t, data_iter_t begin, data_iter_t end, neighbor_list_i
         if (!entry.is_deactivated()) {
             // order 1
             {
-                const auto &reactions = kernel->getKernelContext().reactions().order1_by_type(entry.type);
+                const auto &reactions = table.order1(entry.type);
                 for (auto it_reactions = reactions.begin(); it_reactions != reactions.end(); ++it_reactions) {
                     const auto rate = (*it_reactions)->getRate();
-                    if (rate > 0 && shouldPerformEvent(rate, dt, approximateRate)) {
-                        eventsUpdate.push_back(
-                                {1, (*it_reactions)->getNProducts(), index, index, rate, 0,
-                                 static_cast<event_t::reaction_index_type>(it_reactions - reactions.begin()),
-                                 entry.type, 0});
+                    if (rate > 0) {
+                        const auto reaction_index = static_cast<std::size_t>(it_reactions - reactions.begin());
+                        if (accept(table.order1Id(entry.type, reaction_index))) {
+                            eventsUpdate.push_back({1, (*it_reactions)->getNProducts(), index, index, rate, 0,
+                                                    static_cast<event_t::reaction_index_type>(reaction_index),
+                                                    entry.type, 0});
+                        }
                     }
                 }
             }
@@ -87,20 +109,19 @@ void findEvents(std::size_t, data_iter_t begin, data_iter_t end, neighbor_list_i
             for (const auto idx_neighbor : *it_nl) {
                 if (index > idx_neighbor) continue;
                 const auto &neighbor = data.entry_at(idx_neighbor);
-                const auto &reactions = kernel->getKernelContext().reactions().order2_by_type(entry.type,
-                                                                                              neighbor.type);
-                if (!reactions.empty()) {
-                    const auto distSquared = d2(neighbor.position(), entry.position());
-                    for (auto it_reactions = reactions.begin(); it_reactions < reactions.end(); ++it_reactions) {
-                        const auto &react = *it_reactions;
-                        const auto rate = react->getRate();
-                        if (rate > 0 && distSquared < react->getEductDistanceSquared()
-                            && shouldPerformEvent(rate, dt, approximateRate)) {
-                            const auto reaction_index = static_cast<event_t::reaction_index_type>(it_reactions -
-                                                                                                  reactions.begin());
-                            eventsUpdate.push_back(
-                                    {2, react->getNProducts(), index, idx_neighbor, rate, 0, reaction_index,
-                                     entry.type, neighbor.type});
+                if (!table.reactive(entry.type, neighbor.type)) continue;
+                const auto distSquared = d2(neighbor.position(), entry.position());
+                if (distSquared >= table.maxEductDistanceSquared(entry.type, neighbor.type)) continue;
+                const auto &reactions = table.order2(entry.type, neighbor.type);
+                for (auto it_reactions = reactions.begin(); it_reactions < reactions.end(); ++it_reactions) {
+                    const auto &react = *it_reactions;
+                    const auto rate = react->getRate();
+                    if (rate > 0 && distSquared < react->getEductDistanceSquared()) {
+                        const auto reaction_index = static_cast<std::size_t>(it_reactions - reactions.begin());
+                        if (accept(table.order2Id(entry.type, neighbor.type, reaction_index))) {
+                            eventsUpdate.push_back({2, react->getNProducts(), index, idx_neighbor, rate, 0,
+                                                    static_cast<event_t::reaction_index_type>(reaction_index),
+                                                    entry.type, neighbor.type});
                         }
                     }
                 }
@@ -126,6 +147,12 @@ void CPUUncontrolledApproximation::perform() {
         readdy::model::observables::ReactionCounts::initializeCounts(stateModel.reactionCounts(), ctx);
     }
 
+    if (!table || tableConfiguration != ctx.nConfigurations() || tableTimeStep != timeStep) {
+        table = std::make_unique<ReactionTable>(ctx, timeStep, true);
+        tableConfiguration = ctx.nConfigurations();
+        tableTimeStep = timeStep;
+    }
+
     // gather events
     std::vector<std::future<std::size_t>> n_eventsFutures;
     std::vector<std::promise<std::size_t>> n_events_promises(kernel->getNThreads());
@@ -146,7 +173,7 @@ void CPUUncontrolledApproximation::perform() {
             eventFutures.push_back(promises.at(i).get_future());
             n_eventsFutures.push_back(n_events_promises.at(i).get_future());
 
-            executables.push_back(executor.pack(findEvents, it, it + grainSize, it_nl, kernel, timeStep, true,
+            executables.push_back(executor.pack(findEvents, it, it + grainSize, it_nl, kernel, std::cref(*table),
                                                 std::ref(promises.at(i)), std::ref(n_events_promises.at(i))));
             it += grainSize;
             it_nl += grainSize;
@@ -158,7 +185,7 @@ void CPUUncontrolledApproximation::perform() {
             n_eventsFutures.push_back(n_events.get_future());
 
 
-            executables.push_back(executor.pack(findEvents, it, data.cend(), it_nl, kernel, timeStep, true,
+            executables.push_back(executor.pack(findEvents, it, data.cend(), it_nl, kernel, std::cref(*table),
                                                 std::ref(eventPromise), std::ref(n_events)));
         }
         executor.execute_and_wait(std::move(executables));
@@ -181,64 +208,98 @@ void CPUUncontrolledApproximation::perform() {
     }
 
     // shuffle reactions
-    std::random_shuffle(events.begin(), events.end());
+    std::shuffle(events.begin(), events.end(), readdy::model::rnd::engine());
+
+    // resolve conflicts: going through the events in shuffled order, an event is discarded if one of its educts was
+    // already consumed by an earlier event. the accepted events are pairwise disjoint in their educts.
+    {
+        std::vector<char> consumed(data.size(), 0);
+        std::size_t nAccepted = 0;
+        for (const auto &event : events) {
+            if (!consumed[event.idx1] && (event.nEducts == 1 || !consumed[event.idx2])) {
+                consumed[event.idx1] = 1;
+                if (event.nEducts == 2) consumed[event.idx2] = 1;
+                events[nAccepted++] = event;
+            }
+        }
+        kernel->performance().counter("reactions.conflicts") += events.size() - nAccepted;
+        events.erase(events.begin() + nAccepted, events.end());
+    }
 
     // execute reactions
     {
-        data_t::entries_update_t newParticles{};
-        std::vector<data_t::index_t> decayedEntries{};
-
-        // todo better conflict detection?
-        for (auto it = events.begin(); it != events.end(); ++it) {
-            auto &event = *it;
-            if (event.cumulativeRate == 0) {
-                auto entry1 = event.idx1;
+        const auto &executor = kernel->executor();
+        const auto nThreads = kernel->getNThreads();
+        const bool recordReactions = ctx.recordReactionsWithPositions();
+
+        std::vector<data_t::entries_update_t> newParticles(nThreads);
+        std::vector<std::vector<data_t::index_t>> decayedEntries(nThreads);
+        std::vector<std::vector<record_t>> records(nThreads);
+
+        // since the accepted events do not share any particles, they can be performed concurrently
+        auto worker = [&](std::size_t, std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto &chunkNewParticles = newParticles[chunk];
+            auto &chunkDecayedEntries = decayedEntries[chunk];
+            auto &chunkRecords = records[chunk];
+            for (auto i = begin; i < end; ++i) {
+                const auto &event = events[i];
+                record_t record;
+                record.reactionIndex = event.reactionIdx;
+                auto recordPtr = recordReactions ? &record : nullptr;
                 if (event.nEducts == 1) {
                     auto reaction = ctx.reactions().order1_by_type(event.t1)[event.reactionIdx];
-                    if (ctx.recordReactionsWithPositions()) {
-                        record_t record;
-                        record.reactionIndex = event.reactionIdx;
-                        performReaction(data, ctx, entry1, entry1, newParticles, decayedEntries, reaction, &record);
-                        fixPos(record.where);
-                        kernel->getCPUKernelStateModel().reactionRecords().push_back(std::move(record));
-                    } else {
-                        performReaction(data, ctx, entry1, entry1, newParticles, decayedEntries, reaction, nullptr);
-                    }
-                    if (ctx.recordReactionCounts()) {
-                        auto &countsOrder1 = std::get<0>(stateModel.reactionCounts());
-                        countsOrder1.at(event.t1).at(event.reactionIdx)++;
-                    }
-                    for (auto _it2 = it + 1; _it2 != events.end(); ++_it2) {
-                        if (_it2->idx1 == entry1 || _it2->idx2 == entry1) {
-                            _it2->cumulativeRate = 1;
-                        }
-                    }
+                    performReaction(data, ctx, event.idx1, event.idx1, chunkNewParticles, chunkDecayedEntries,
+                                    reaction, recordPtr);
                 } else {
                     auto reaction = ctx.reactions().order2_by_type(event.t1, event.t2)[event.reactionIdx];
-                    if (ctx.recordReactionsWithPositions()) {
-                        record_t record;
-                        record.reactionIndex = event.reactionIdx;
-                        performReaction(data, ctx, entry1, event.idx2, newParticles, decayedEntries, reaction, &record);
-                        fixPos(record.where);
-                        kernel->getCPUKernelStateModel().reactionRecords().push_back(std::move(record));
-                    } else {
-                        performReaction(data, ctx, entry1, event.idx2, newParticles, decayedEntries, reaction, nullptr);
-                    }
-                    if (ctx.recordReactionCounts()) {
-                        auto &countsOrder2 = std::get<1>(stateModel.reactionCounts());
-                        countsOrder2.at(std::tie(event.t1, event.t2)).at(event.reactionIdx)++;
-                    }
-                    for (auto _it2 = it + 1; _it2 != events.end(); ++_it2) {
-                        if (_it2->idx1 == entry1 || _it2->idx2 == entry1 ||
-                            _it2->idx1 == event.idx2 || _it2->idx2 == event.idx2) {
-                            _it2->cumulativeRate = 1;
-                        }
-                    }
+                    performReaction(data, ctx, event.idx1, event.idx2, chunkNewParticles, chunkDecayedEntries,
+                                    reaction, recordPtr);
                 }
+                if (recordReactions) {
+                    fixPos(record.where);
+                    chunkRecords.push_back(std::move(record));
+                }
+            }
+        };
+        {
+            const std::size_t grainSize = events.size() / nThreads;
+            std::vector<std::function<void(std::size_t)>> executables;
+            executables.reserve(nThreads);
+            for (std::size_t i = 0; i < nThreads - 1; ++i) {
+                executables.push_back(executor.pack(worker, i, i * grainSize, (i + 1) * grainSize));
+            }
+            executables.push_back(executor.pack(worker, nThreads - 1, (nThreads - 1) * grainSize, events.size()));
+            executor.execute_and_wait(std::move(executables));
+        }
+
+        if (ctx.recordReactionCounts()) {
+            auto &countsOrder1 = std::get<0>(stateModel.reactionCounts());
+            auto &countsOrder2 = std::get<1>(stateModel.reactionCounts());
+            for (const auto &event : events) {
+                if (event.nEducts == 1) {
+                    countsOrder1.at(event.t1).at(event.reactionIdx)++;
+                } else {
+                    countsOrder2.at(std::tie(event.t1, event.t2)).at(event.reactionIdx)++;
+                }
+            }
+        }
+
+        // merge the per-thread results in the order of the events
+        data_t::entries_update_t mergedNewParticles{};
+        std::vector<data_t::index_t> mergedDecayedEntries{};
+        for (std::size_t i = 0; i < nThreads; ++i) {
+            mergedNewParticles.insert(mergedNewParticles.end(), std::make_move_iterator(newParticles[i].begin()),
+                                      std::make_move_iterator(newParticles[i].end()));
+            mergedDecayedEntries.insert(mergedDecayedEntries.end(), decayedEntries[i].begin(),
+                                        decayedEntries[i].end());
+            if (recordReactions) {
+                auto &reactionRecords = stateModel.reactionRecords();
+                reactionRecords.insert(reactionRecords.end(), std::make_move_iterator(records[i].begin()),
+                                       std::make_move_iterator(records[i].end()));
             }
         }
 
-        nl.updateData(std::make_pair(std::move(newParticles), std::move(decayedEntries)));
+        nl.updateData(std::make_pair(std::move(mergedNewParticles), std::move(mergedDecayedEntries)));
     }
 }
 }
@@ -21,19 +21,18 @@
 
 
 /**
- * << detailed description >>
- *
- * @file SingleCPUNextSubvolumes.cpp
- * @brief << brief description >>
+ * @file NextSubvolumesReactionScheduler.cpp
+ * @brief Implementation of the CPU next subvolume method
  * @author clonker
  * @date 09.09.16
  */
 
+#include <algorithm>
+#include <cmath>
+
 #include <readdy/kernel/cpu/actions/reactions/ReactionUtils.h>
-#include <readdy/common/numeric.h>
-#include "readdy/kernel/cpu/actions/reactions/NextSubvolumesReactionScheduler.h"
+#include <readdy/kernel/cpu/actions/reactions/NextSubvolumesReactionScheduler.h>
 
-using particle_type = readdy::model::Particle;
 namespace rnd = readdy::model::rnd;
 
 namespace readdy {
@@ -42,343 +41,302 @@ namespace cpu {
 namespace actions {
 namespace reactions {
 
-struct CPUNextSubvolumes::ReactionEvent {
-    int order;
-    unsigned int type1, type2;
-    std::size_t reactionIndex;
-    double reactionRate;
-    double cumulativeRate;
-
-    explicit ReactionEvent(const int order, const size_t reactionIndex, const double reactionRate, unsigned int t1,
-                           unsigned int t2)
-            : order(order), reactionIndex(reactionIndex), reactionRate(reactionRate), type1(t1), type2(t2) {}
-
-    ReactionEvent() : ReactionEvent(-1, 0, 0, 0, 0) {}
-
-    bool isValid() const {
-        return order >= 0;
-    }
-};
+constexpr double CPUNextSubvolumes::no_event;
+constexpr std::size_t CPUNextSubvolumes::not_queued;
 
 struct CPUNextSubvolumes::GridCell {
     using particle_index = data_t::index_t;
 
-    cell_index_t i, j, k, id;
-    std::vector<const GridCell *> neighbors;
-    std::unordered_map<particle_type::type_type, std::vector<particle_index>> particles;
-    std::vector<unsigned long> typeCounts;
+    cell_index_t id;
+    std::vector<particle_index> particles;
+    // the possible events, where the cumulative rate is the running sum of the reaction rates
+    std::vector<Event> events;
     double cellRate;
     double timestamp;
-    ReactionEvent nextEvent{};
+    // position of this cell in the event queue
+    std::size_t queuePosition;
 
-    GridCell(const cell_index_t i, const cell_index_t j, const cell_index_t k, const cell_index_t id,
-             const unsigned long nTypes)
-            : i(i), j(j), k(k), id(id), neighbors(27), particles({}), cellRate(0), typeCounts(nTypes), timestamp(0) {
-    }
-
-    void addNeighbor(GridCell const *const cell) {
-        neighbors.push_back(cell);
-    }
+    explicit GridCell(const cell_index_t id)
+            : id(id), particles({}), events({}), cellRate(0), timestamp(no_event), queuePosition(not_queued) {}
 };
 
+CPUNextSubvolumes::CPUNextSubvolumes(CPUKernel *const kernel, double timeStep)
+        : super(timeStep), kernel(kernel), cellSize(), cells({}), particleCells({}), consumed({}), occupiedCells({}),
+          eventQueue({}) {}
+
 void CPUNextSubvolumes::perform() {
-    eventQueue.clear();
+    const auto &ctx = kernel->getKernelContext();
+    auto &stateModel = kernel->getCPUKernelStateModel();
+    if (ctx.recordReactionsWithPositions()) {
+        stateModel.reactionRecords().clear();
+    }
+    if (ctx.recordReactionCounts()) {
+        readdy::model::observables::ReactionCounts::initializeCounts(stateModel.reactionCounts(), ctx);
+    }
     setUpGrid();
     assignParticles();
     setUpEventQueue();
     evaluateReactions();
 }
 
-CPUNextSubvolumes::CPUNextSubvolumes(const CPUKernel *const kernel, double timeStep)
-        : super(timeStep), kernel(kernel), cells({}), nCells({}), cellSize(), eventQueue({}) {}
-
 void CPUNextSubvolumes::setUpGrid() {
-    if (cells.empty()) {
-        const auto &simBoxSize = kernel->getKernelContext().getBoxSize();
-        const auto minCellWidth = getMaxReactionRadius();
-        const auto nTypes = kernel->getKernelContext().particle_types().n_types();
-        for (unsigned int i = 0; i < 3; ++i) {
-            nCells[i] = minCellWidth > 0 ? static_cast<unsigned int>(floor(simBoxSize[i] / minCellWidth)) : 1;
-            if (nCells[i] == 0) nCells[i] = 1;
-            cellSize[i] = simBoxSize[i] / nCells[i];
-        }
-        for (cell_index_t i = 0; i < nCells[0]; ++i) {
-            for (cell_index_t j = 0; j < nCells[1]; ++j) {
-                for (cell_index_t k = 0; k < nCells[2]; ++k) {
-                    cells.push_back({i, j, k, k + j * nCells[2] + i * nCells[2] * nCells[1], nTypes});
-                }
-            }
-        }
-        for (auto &cell : cells) {
-            setUpNeighbors(cell);
-        }
+    const auto &ctx = kernel->getKernelContext();
+    const auto &simBoxSize = ctx.getBoxSize();
+    const auto minCellWidth = getMaxReactionRadius();
+    if (!cells.empty() && gridBoxSize == simBoxSize && gridCellWidth == minCellWidth) {
+        return;
+    }
+    cells.clear();
+    occupiedCells.clear();
+    for (unsigned int i = 0; i < 3; ++i) {
+        nCells[i] = minCellWidth > 0 ? static_cast<cell_index_t>(std::floor(simBoxSize[i] / minCellWidth)) : 1;
+        if (nCells[i] == 0) nCells[i] = 1;
+        cellSize[i] = simBoxSize[i] / nCells[i];
+    }
+    const auto nCellsTotal = nCells[0] * nCells[1] * nCells[2];
+    cells.reserve(nCellsTotal);
+    for (cell_index_t id = 0; id < nCellsTotal; ++id) {
+        cells.emplace_back(id);
     }
+    gridBoxSize = simBoxSize;
+    gridCellWidth = minCellWidth;
 }
 
 void CPUNextSubvolumes::assignParticles() {
-    // todo this can be easily parallelized
-    const auto data = kernel->getCPUKernelStateModel().getParticleData();
-    std::for_each(cells.begin(), cells.end(), [](GridCell &cell) {
-        cell.particles.clear();
-        cell.typeCounts.clear();
-        cell.cellRate = 0;
-    });
-
+    const auto &data = *kernel->getCPUKernelStateModel().getParticleData();
+    for (const auto cellIdx : occupiedCells) {
+        cells[cellIdx].particles.clear();
+        cells[cellIdx].queuePosition = not_queued;
+    }
+    occupiedCells.clear();
+    particleCells.resize(data.size());
+    consumed.assign(data.size(), 0);
     std::size_t idx = 0;
-    for (auto& e : *data) {
-        if(!e.is_deactivated()) {
-            auto box = getCell(e.position());
-            if (box) {
-                box->particles[e.type].push_back(idx);
-                ++(box->typeCounts[e.type]);
+    for (const auto &e : data) {
+        if (!e.is_deactivated()) {
+            auto cell = getCell(e.position());
+            if (cell->particles.empty()) {
+                occupiedCells.push_back(cell->id);
             }
+            cell->particles.push_back(idx);
+            particleCells[idx] = cell->id;
         }
         ++idx;
     }
+}
 
+void CPUNextSubvolumes::setUpEventQueue() {
+    {
+        const auto &executor = kernel->executor();
+        const auto nThreads = kernel->getNThreads();
+        // only occupied cells can have events, as each pair belongs to the cell of one of its particles
+        auto worker = [this](std::size_t, std::size_t begin, std::size_t end) {
+            for (auto it = occupiedCells.begin() + begin; it != occupiedCells.begin() + end; ++it) {
+                setUpCell(cells[*it]);
+                scheduleCell(cells[*it], 0);
+            }
+        };
+        const auto grainSize = occupiedCells.size() / nThreads;
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nThreads);
+        for (std::size_t i = 0; i < nThreads - 1; ++i) {
+            executables.push_back(executor.pack(worker, i * grainSize, (i + 1) * grainSize));
+        }
+        executables.push_back(executor.pack(worker, (nThreads - 1) * grainSize, occupiedCells.size()));
+        executor.execute_and_wait(std::move(executables));
+    }
+    // within a time step the propensities can only decrease, hence cells without events never enter the queue
+    eventQueue.clear();
+    for (const auto cellIdx : occupiedCells) {
+        if (cells[cellIdx].cellRate > 0) {
+            eventQueue.push_back(cellIdx);
+        }
+    }
+    std::make_heap(eventQueue.begin(), eventQueue.end(), [this](cell_index_t c1, cell_index_t c2) {
+        return cells[c1].timestamp > cells[c2].timestamp;
+    });
+    for (std::size_t i = 0; i < eventQueue.size(); ++i) {
+        cells[eventQueue[i]].queuePosition = i;
+    }
 }
 
 void CPUNextSubvolumes::evaluateReactions() {
-    std::vector<GridCell *>::size_type n_cells_done = 0;
-    const auto& ctx = kernel->getKernelContext();
-    auto data = kernel->getCPUKernelStateModel().getParticleData();
-    auto neighbor_list = kernel->getCPUKernelStateModel().getNeighborList();
-
-    const auto comparator = [](const GridCell *c1, const GridCell *c2) {
-        return c1->cellRate < c2->cellRate;
-    };
-    const auto get_event_queue_end = [this, &n_cells_done] {
-        return eventQueue.end() - n_cells_done;
-    };
-
-    while (eventQueue.begin() != get_event_queue_end()) {
-        std::pop_heap(eventQueue.begin(), get_event_queue_end(), comparator);
-        auto currentCell = eventQueue.back();
-        bool performedSomething = false;
-        if (currentCell->timestamp < timeStep) {
-            const auto& particles = currentCell->particles;
-            const auto& event = currentCell->nextEvent;
-            if(event.isValid()) {
-                const auto findType1 = particles.find(event.type1);
-                if(findType1 != particles.end()) {
-                    const auto& particlesType1 = findType1->second;
-                    if (!particlesType1.empty()) {
-                        //const auto pidx_it = particlesType1.begin() +
-                        //        static_cast<std::size_t>(rnd::uniform_int(0L, particlesType1.size()));
-                        //const auto particle_idx = *pidx_it;
-                        // todo execute the reaction, and update cells and event queue (see slides)
-                        switch (event.order) {
-                            case 1: {/*
-                                // todo update neighbor list with this particle
-                                data_t::entries_update_t newParticles{};
-                                std::vector<data_t::index_t> decayedEntries {};
-
-                                auto reaction = ctx.getOrder1Reactions(event.type1)[event.reactionIndex];
-                                performReaction(*data, particle_idx, 0, newParticles, decayedEntries, reaction);
-                                performedSomething = true;
-                                --currentCell->typeCounts[event.type1];
-                                currentCell->particles[event.type1].erase(pidx_it);
-                                if (reaction->getNProducts() > 0) {
-                                    auto c1Out = getCell(p1->pos);
-                                    ++c1Out->typeCounts[p1->type];
-                                    c1Out->particles[p1->type].push_back(p1);
-                                    if (reaction->getNProducts() == 2) {
-                                        const auto& entry2 = newEntries.back();
-                                        auto c2Out = getCell(entry2.pos);
-                                        auto idx = data->addEntry(entry2);
-                                        neighbor_list->insert(*data, idx);
-                                        ++c2Out->typeCounts[entry2.type];
-                                        c2Out->particles[entry2.type].push_back(idx);
-                                    }
-                                } else {
-                                    data->removeEntry(p1);
-                                    neighbor_list->remove(p1);
-                                }
-                                break;
-                            */}
-                            case 2: {
-                                /*auto reaction = ctx.getOrder2Reactions(event.type1, event.type2)[event.reactionIndex];
-                                const auto findType2 = particles.find(event.type2);
-                                if(findType2 != particles.end()) {
-                                    const auto& particlesType2 = findType2->second;
-                                    const auto p2_it = rnd::random_element(particlesType2.begin(), particlesType2.end());
-                                    const auto p2_idx = *p2_it;
-                                    const auto p2 = (*data)[p2_idx];
+    const auto &ctx = kernel->getKernelContext();
+    const auto &fixPos = ctx.getFixPositionFun();
+    auto &stateModel = kernel->getCPUKernelStateModel();
+    auto &data = *stateModel.getParticleData();
+    auto &neighborList = *stateModel.getNeighborList();
 
-                                    reaction->perform(p1, p2, pOut1, pOut2);
-                                    performedSomething = true;
+    data_t::entries_update_t newParticles{};
+    std::vector<data_t::index_t> decayedEntries{};
+    std::vector<cell_index_t> affectedCells;
 
-                                    auto c1Out = getCell(pOut1.getPos());
-                                    ++c1Out->typeCounts[pOut1.getType()];
-                                    c1Out->particles[pOut1.getType()].push_back(p2_idx);
-                                    if (reaction->getNProducts() == 2) {
-                                        auto c2Out = getCell(pOut2.getPos());
-                                        data->addParticle(pOut2);
-                                        neighbor_list->insert(*data, data->size()-1);
-                                        ++c2Out->typeCounts[pOut2.getType()];
-                                        c2Out->particles[pOut2.getType()].push_back(data->size()-1);
-                                    }
+    while (!eventQueue.empty() && cells[eventQueue.front()].timestamp < timeStep) {
+        auto &currentCell = cells[eventQueue.front()];
+        const auto now = currentCell.timestamp;
 
-                                }*/
-                                break;
-                            }
-                            default: {
-                                log::error("encountered event with order > 2! (order was {})",
-                                                      event.order);
-                            }
-                        }
-                    }
-                } else {
-                    log::debug("did not find any particle of type {} in current box", event.type1);
-                }
-            } else {
-                log::error("The event was not set previously, should not happen! (?)");
-            }
-
-            if(performedSomething) {
-                // todo do something
+        // select the event
+        const auto &events = currentCell.events;
+        const auto x = rnd::uniform_real(0., events.back().cumulativeRate);
+        auto eventIt = std::lower_bound(events.begin(), events.end(), x, [](const Event &event, double value) {
+            return event.cumulativeRate < value;
+        });
+        if (eventIt == events.end()) --eventIt;
+        const auto event = *eventIt;
+
+        // perform it
+        record_t record;
+        record.reactionIndex = event.reactionIdx;
+        auto recordPtr = ctx.recordReactionsWithPositions() ? &record : nullptr;
+        if (event.nEducts == 1) {
+            auto reaction = ctx.reactions().order1_by_type(event.t1)[event.reactionIdx];
+            performReaction(data, ctx, event.idx1, event.idx1, newParticles, decayedEntries, reaction, recordPtr);
+            if (ctx.recordReactionCounts()) {
+                std::get<0>(stateModel.reactionCounts()).at(event.t1).at(event.reactionIdx)++;
             }
-
         } else {
-            ++n_cells_done;
+            auto reaction = ctx.reactions().order2_by_type(event.t1, event.t2)[event.reactionIdx];
+            performReaction(data, ctx, event.idx1, event.idx2, newParticles, decayedEntries, reaction, recordPtr);
+            if (ctx.recordReactionCounts()) {
+                std::get<1>(stateModel.reactionCounts()).at(std::tie(event.t1, event.t2)).at(event.reactionIdx)++;
+            }
+        }
+        if (recordPtr) {
+            fixPos(record.where);
+            stateModel.reactionRecords().push_back(std::move(record));
         }
 
-        std::push_heap(eventQueue.begin(), get_event_queue_end(), comparator);
-    }
-}
-
-double CPUNextSubvolumes::getMaxReactionRadius() const {
-    double maxReactionRadius = 0.0;
-    for (auto &&e : kernel->getKernelContext().reactions().order2_flat()) {
-        maxReactionRadius = std::max(maxReactionRadius, e->getEductDistance());
-    }
-    return maxReactionRadius;
-}
-
-void CPUNextSubvolumes::setUpNeighbors(CPUNextSubvolumes::GridCell &cell) {
-    for (int _i = -1; _i < 2; ++_i) {
-        for (int _j = -1; _j < 2; ++_j) {
-            for (int _k = -1; _k < 2; ++_k) {
-                // i am not my own neighbor
-                if (!(_i == 0 && _j == 0 && _k == 0)) {
-                    cell.addNeighbor(getCell(cell.i + _i, cell.j + _j, cell.k + _k));
-                }
+        // the educts are consumed, which affects their cells and the cells owning a pair with one of them
+        affectedCells.clear();
+        for (const auto educt : {event.idx1, event.idx2}) {
+            if (consumed[educt]) continue;
+            consumed[educt] = 1;
+            auto &cell = cells[particleCells[educt]];
+            auto it = std::find(cell.particles.begin(), cell.particles.end(), educt);
+            if (it != cell.particles.end()) {
+                *it = cell.particles.back();
+                cell.particles.pop_back();
+            }
+            affectedCells.push_back(cell.id);
+            for (const auto neighbor : neighborList.neighbors_of(educt)) {
+                if (neighbor < educt) affectedCells.push_back(particleCells[neighbor]);
             }
         }
-    }
-}
-
-CPUNextSubvolumes::GridCell *
-CPUNextSubvolumes::getCell(signed_cell_index_t i, signed_cell_index_t j, signed_cell_index_t k) {
-    const auto &periodic = kernel->getKernelContext().getPeriodicBoundary();
-    if (periodic[0]) i = static_cast<cell_index_t>(readdy::util::numeric::positive_modulo(i, nCells[0]));
-    else if (i < 0 || i >= nCells[0]) return nullptr;
-    if (periodic[1]) j = static_cast<cell_index_t>(readdy::util::numeric::positive_modulo(j, nCells[1]));
-    else if (j < 0 || j >= nCells[1]) return nullptr;
-    if (periodic[2]) k = static_cast<cell_index_t>(readdy::util::numeric::positive_modulo(k, nCells[2]));
-    else if (k < 0 || k >= nCells[2]) return nullptr;
-    return &*(cells.begin() + k + j * nCells[2] + i * nCells[2] * nCells[1]);
-}
-
-void CPUNextSubvolumes::setUpEventQueue() {
-    const auto &ctx = kernel->getKernelContext();
-    const auto dt = timeStep;
-    {
-        // todo: this can easily be parallelized
-        for (auto &cell : cells) {
+        std::sort(affectedCells.begin(), affectedCells.end());
+        affectedCells.erase(std::unique(affectedCells.begin(), affectedCells.end()), affectedCells.end());
+        for (const auto cellIdx : affectedCells) {
+            auto &cell = cells[cellIdx];
+            if (cell.queuePosition == not_queued) continue;
             setUpCell(cell);
-        }
-    }
-    {
-        // fill up event queue with viable cells
-        for (auto &cell : cells) {
-            if (cell.timestamp < dt) eventQueue.push_back(&cell);
+            scheduleCell(cell, now);
+            updateQueue(cell.queuePosition);
         }
     }
 
-    std::for_each(cells.begin(), cells.end(), [this](GridCell &cell) { eventQueue.push_back(&cell); });
-    const auto comparator = [](const GridCell *c1, const GridCell *c2) {
-        return c1->timestamp > c2->timestamp;
-    };
-    std::make_heap(eventQueue.begin(), eventQueue.end(), comparator);
+    neighborList.updateData(std::make_pair(std::move(newParticles), std::move(decayedEntries)));
 }
 
 void CPUNextSubvolumes::setUpCell(CPUNextSubvolumes::GridCell &cell) {
     const auto &ctx = kernel->getKernelContext();
-    std::vector<ReactionEvent> events;
-    // order 1 reactions
-    for (const auto& it : cell.particles) {
-        const auto pType = it.first;
-        for(auto i = 0; i < it.second.size(); ++i) {
-            std::size_t reactionIdx = 0;
-            for (const auto reactionOrder1 : ctx.reactions().order1_by_type(pType)) {
-                const auto rateUpdate = cell.typeCounts[pType] * reactionOrder1->getRate();
-                if (rateUpdate > 0) {
-                    cell.cellRate += rateUpdate;
-                    auto evt = ReactionEvent(1, reactionIdx, rateUpdate, pType, 0);
-                    evt.cumulativeRate = evt.reactionRate;
-                    if (!events.empty()) evt.cumulativeRate += events.back().cumulativeRate;
-                    events.push_back(std::move(evt));
+    const auto &data = *kernel->getCPUKernelStateModel().getParticleData();
+    const auto &neighborList = *kernel->getCPUKernelStateModel().getNeighborList();
+    const auto &d2 = ctx.getDistSquaredFun();
+    auto &events = cell.events;
+    events.clear();
+    double cumulativeRate = 0;
+    for (const auto idx : cell.particles) {
+        const auto &entry = data.entry_at(idx);
+        // order 1
+        {
+            const auto &reactions = ctx.reactions().order1_by_type(entry.type);
+            for (auto it = reactions.begin(); it != reactions.end(); ++it) {
+                const auto rate = (*it)->getRate();
+                if (rate > 0) {
+                    cumulativeRate += rate;
+                    events.push_back({1, (*it)->getNProducts(), idx, idx, rate, cumulativeRate,
+                                      static_cast<Event::reaction_index_type>(it - reactions.begin()), entry.type,
+                                      0});
                 }
-                ++reactionIdx;
             }
         }
-    }
-    // order 2 reactions
-    {
-        std::size_t reactionIdx = 0;
-        for (const auto reactionOrder2 : ctx.reactions().order2_flat()) {
-            for (int perm = 0; perm < 2; ++perm) {
-                const auto typeA = reactionOrder2->getEducts()[(0 + perm) % 2];
-                const auto typeB = reactionOrder2->getEducts()[(1 + perm) % 2];
-                const auto neighborSum = std::accumulate(
-                        cell.neighbors.begin(), cell.neighbors.end(), 0,
-                        [typeB](unsigned long acc, const GridCell *const neighborCell) {
-                            return acc + neighborCell->typeCounts[typeB];
-                        }
-                );
-                const auto rateUpdate = .5 * static_cast<double>(cell.typeCounts[typeA] * neighborSum);
-                if (rateUpdate > 0) {
-                    auto evt = ReactionEvent(1, reactionIdx, rateUpdate, typeA, typeB);
-                    cell.cellRate += rateUpdate;
-                    evt.cumulativeRate = evt.reactionRate;
-                    if (!events.empty()) evt.cumulativeRate += events.back().cumulativeRate;
-                    events.push_back(std::move(evt));
+        // order 2, the pair belongs to the cell of the particle with the smaller index
+        for (const auto idxNeighbor : neighborList.neighbors_of(idx)) {
+            if (idx > idxNeighbor || consumed[idxNeighbor]) continue;
+            const auto &neighbor = data.entry_at(idxNeighbor);
+            const auto &reactions = ctx.reactions().order2_by_type(entry.type, neighbor.type);
+            if (!reactions.empty()) {
+                const auto distSquared = d2(neighbor.position(), entry.position());
+                for (auto it = reactions.begin(); it != reactions.end(); ++it) {
+                    const auto rate = (*it)->getRate();
+                    if (rate > 0 && distSquared < (*it)->getEductDistanceSquared()) {
+                        cumulativeRate += rate;
+                        events.push_back({2, (*it)->getNProducts(), idx, idxNeighbor, rate, cumulativeRate,
+                                          static_cast<Event::reaction_index_type>(it - reactions.begin()),
+                                          entry.type, neighbor.type});
+                    }
                 }
             }
-            ++reactionIdx;
         }
     }
-    cell.timestamp = rnd::exponential(cell.cellRate);
-    // select next event
-    {
-        const auto x = rnd::uniform_real(0., events.back().cumulativeRate);
-        const auto eventIt = std::lower_bound(
-                events.begin(), events.end(), x, [](const ReactionEvent &elem1, double elem2) {
-                    return elem1.cumulativeRate < elem2;
-                }
-        );
-        if (eventIt != events.end()) {
-            cell.nextEvent = std::move(events[eventIt - events.begin()]);
-        } else {
-            log::error("next subvolumes: the next event was events.end()!");
-        }
+    cell.cellRate = cumulativeRate;
+}
+
+void CPUNextSubvolumes::scheduleCell(CPUNextSubvolumes::GridCell &cell, const double now) {
+    cell.timestamp = cell.cellRate > 0 ? now + rnd::exponential(cell.cellRate) : no_event;
+}
+
+void CPUNextSubvolumes::updateQueue(std::size_t pos) {
+    auto swap = [this](std::size_t pos1, std::size_t pos2) {
+        std::swap(eventQueue[pos1], eventQueue[pos2]);
+        cells[eventQueue[pos1]].queuePosition = pos1;
+        cells[eventQueue[pos2]].queuePosition = pos2;
+    };
+    auto timestamp = [this](std::size_t pos) { return cells[eventQueue[pos]].timestamp; };
+    // sift up
+    while (pos > 0 && timestamp(pos) < timestamp((pos - 1) / 2)) {
+        swap(pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+    // sift down
+    while (true) {
+        const auto left = 2 * pos + 1;
+        const auto right = left + 1;
+        auto smallest = pos;
+        if (left < eventQueue.size() && timestamp(left) < timestamp(smallest)) smallest = left;
+        if (right < eventQueue.size() && timestamp(right) < timestamp(smallest)) smallest = right;
+        if (smallest == pos) break;
+        swap(pos, smallest);
+        pos = smallest;
     }
 }
 
+double CPUNextSubvolumes::getMaxReactionRadius() const {
+    double maxReactionRadius = 0.0;
+    for (auto &&e : kernel->getKernelContext().reactions().order2_flat()) {
+        maxReactionRadius = std::max(maxReactionRadius, e->getEductDistance());
+    }
+    return maxReactionRadius;
+}
+
+const std::array<CPUNextSubvolumes::cell_index_t, 3> &CPUNextSubvolumes::getNCells() const {
+    return nCells;
+}
+
 CPUNextSubvolumes::GridCell *CPUNextSubvolumes::getCell(const readdy::model::Vec3 &particlePosition) {
-    const auto& simBoxSize = kernel->getKernelContext().getBoxSize();
-    const auto i = static_cast<cell_index_t>(floor((particlePosition[0] + .5*simBoxSize[0]) / cellSize[0]));
-    const auto j = static_cast<cell_index_t>(floor((particlePosition[1] + .5*simBoxSize[1]) / cellSize[1]));
-    const auto k = static_cast<cell_index_t>(floor((particlePosition[2] + .5*simBoxSize[2]) / cellSize[2]));
-    return getCell(i, j, k);
+    const auto &simBoxSize = kernel->getKernelContext().getBoxSize();
+    std::array<signed_cell_index_t, 3> ijk{};
+    for (unsigned int d = 0; d < 3; ++d) {
+        ijk[d] = static_cast<signed_cell_index_t>(std::floor((particlePosition[d] + .5 * simBoxSize[d]) / cellSize[d]));
+        // particles outside of a non-periodic box are attributed to the outermost cells
+        ijk[d] = std::min(std::max(ijk[d], 0), static_cast<signed_cell_index_t>(nCells[d]) - 1);
+    }
+    return &cells.at(ijk[2] + ijk[1] * nCells[2] + ijk[0] * nCells[2] * nCells[1]);
 }
 
 CPUNextSubvolumes::~CPUNextSubvolumes() = default;
 
-
 }
 }
 }
 }
-}
\ No newline at end of file
+}
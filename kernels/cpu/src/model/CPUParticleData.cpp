@@ -41,6 +41,20 @@ namespace kernel {
 namespace cpu {
 namespace model {
 
+namespace {
+/**
+ * moves each element of a column to the position given by the order, i.e., from i to order[i]
+ */
+template<typename Column>
+void reorder_column(const std::vector<std::size_t> &order, Column &column) {
+    Column reordered(column.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        reordered[order[i]] = std::move(column[i]);
+    }
+    column.swap(reordered);
+}
+}
+
 //
 // Entry Impl
 //
@@ -72,12 +86,17 @@ bool CPUParticleData::Entry::is_deactivated() const {
 //
 
 
-CPUParticleData::CPUParticleData(readdy::model::KernelContext*const context, const readdy::util::thread::Config &_config)
-        : blanks(std::vector<index_t>()), entries(), neighbors(), reorderSignal(std::make_unique<reorder_signal_t>()),
-          _config(_config), context(context) {}
+CPUParticleData::CPUParticleData(readdy::model::KernelContext *const context,
+                                 const readdy::util::thread::Config &_config, Layout layout)
+        : _layout(layout), blanks(std::vector<index_t>()), entries(), columns(), neighbors(),
+          reorderSignal(std::make_unique<reorder_signal_t>()), _config(_config), context(context) {}
+
+CPUParticleData::Layout CPUParticleData::layout() const {
+    return _layout;
+}
 
 std::size_t CPUParticleData::size() const {
-    return entries.size();
+    return _layout == Layout::aos ? entries.size() : columns.x.size();
 }
 
 bool CPUParticleData::empty() const {
@@ -87,6 +106,14 @@ bool CPUParticleData::empty() const {
 void CPUParticleData::clear() {
     blanks.clear();
     entries.clear();
+    columns.x.clear();
+    columns.y.clear();
+    columns.z.clear();
+    columns.force.clear();
+    columns.type.clear();
+    columns.deactivated.clear();
+    columns.id.clear();
+    columns.displacement.clear();
     neighbors.clear();
 }
 
@@ -99,21 +126,20 @@ void CPUParticleData::addParticles(const std::vector<CPUParticleData::particle_t
         if(!blanks.empty()) {
             const auto idx = blanks.back();
             blanks.pop_back();
-            entries.at(idx) = {p};
+            assign(idx, {p});
         } else {
-            entries.push_back({p});
-            neighbors.push_back({});
+            append({p});
+            neighbors.append_row();
         }
     }
 }
 
 void CPUParticleData::removeParticle(const CPUParticleData::particle_type &particle) {
-    auto it_entries = begin();
-    std::size_t idx = 0;
-    for(; it_entries != end(); ++it_entries, ++idx) {
-        if(!it_entries->is_deactivated() && it_entries->id == particle.getId()) {
+    for(index_t idx = 0; idx < size(); ++idx) {
+        const auto entry = entry_at(idx);
+        if(!entry.is_deactivated() && entry.id == particle.getId()) {
             blanks.push_back(idx);
-            it_entries->deactivated = true;
+            setDeactivated(idx, true);
             return;
         }
     }
@@ -121,10 +147,9 @@ void CPUParticleData::removeParticle(const CPUParticleData::particle_type &parti
 }
 
 void CPUParticleData::removeParticle(const CPUParticleData::index_t index) {
-    auto& p = *(entries.begin() + index);
-    if(!p.deactivated) {
+    if(!entry_at(index).is_deactivated()) {
         blanks.push_back(index);
-        p.deactivated = true;
+        setDeactivated(index, true);
         // neighbors.at(index).clear();
     } else {
         log::error("Tried to remove particle (index={}), that was already removed!", index);
@@ -136,35 +161,34 @@ CPUParticleData::index_t CPUParticleData::getNDeactivated() const {
 }
 
 readdy::model::Particle CPUParticleData::getParticle(const index_t index) const {
-    const auto& entry = *(entries.begin() + index);
-    if(entry.deactivated) {
+    const auto entry = entry_at(index);
+    if(entry.is_deactivated()) {
         log::error("Requested deactivated particle at index {}!", index);
     }
     return toParticle(entry);
 }
 
-readdy::model::Particle CPUParticleData::toParticle(const Entry &e) const {
-    return readdy::model::Particle(e.pos, e.type, e.id);
+readdy::model::Particle CPUParticleData::toParticle(const ConstEntryRef &e) const {
+    return readdy::model::Particle(e.position(), e.type, e.id);
 }
 
 CPUParticleData::index_t CPUParticleData::addEntry(CPUParticleData::Entry &&entry) {
     if(!blanks.empty()) {
         const auto idx = blanks.back();
         blanks.pop_back();
-        entries.at(idx) = std::move(entry);
-        neighbors.at(idx).clear();
+        assign(idx, std::move(entry));
+        neighbors.clear_row(idx);
         return idx;
     } else {
-        entries.push_back(std::move(entry));
-        neighbors.push_back({});
-        return entries.size()-1;
+        append(std::move(entry));
+        neighbors.append_row();
+        return size()-1;
     }
 }
 
 void CPUParticleData::removeEntry(index_t idx) {
-    auto &entry = entries.at(idx);
-    if(!entry.is_deactivated()) {
-        entry.deactivated = true;
+    if(!entry_at(idx).is_deactivated()) {
+        setDeactivated(idx, true);
         blanks.push_back(idx);
     } else {
         log::critical("Tried removing particle {} which was already deactivated!", idx);
@@ -181,8 +205,8 @@ std::vector<CPUParticleData::index_t> CPUParticleData::update(update_t &&update_
     auto it_del = removedEntries.begin();
     for(auto&& newEntry : newEntries) {
         if(it_del != removedEntries.end()) {
-            entries.at(*it_del) = std::move(newEntry);
-            neighbors.at(*it_del).clear();
+            assign(*it_del, std::move(newEntry));
+            neighbors.clear_row(*it_del);
             result.push_back(*it_del);
             ++it_del;
         } else {
@@ -197,15 +221,70 @@ std::vector<CPUParticleData::index_t> CPUParticleData::update(update_t &&update_
     return result;
 }
 
-const CPUParticleData::particle_type::pos_type &CPUParticleData::pos(CPUParticleData::index_t idx) const {
-    return entries.at(idx).pos;
+CPUParticleData::particle_type::pos_type CPUParticleData::pos(CPUParticleData::index_t idx) const {
+    if (_layout == Layout::aos) {
+        return entries.at(idx).pos;
+    }
+    return {columns.x.at(idx), columns.y[idx], columns.z[idx]};
 }
 
-void CPUParticleData::displace(CPUParticleData::Entry &entry, const readdy::model::Particle::pos_type &delta) {
-    entry.pos += delta;
-    context->getFixPositionFun()(entry.pos);
+void CPUParticleData::setPosition(index_t index, const particle_type::pos_type &position) {
+    if (_layout == Layout::aos) {
+        entries[index].pos = position;
+    } else {
+        columns.x[index] = position.x;
+        columns.y[index] = position.y;
+        columns.z[index] = position.z;
+    }
+}
+
+void CPUParticleData::setDeactivated(index_t index, bool deactivated) {
+    if (_layout == Layout::aos) {
+        entries[index].deactivated = deactivated;
+    } else {
+        columns.deactivated[index] = static_cast<char>(deactivated);
+    }
+}
+
+void CPUParticleData::assign(index_t index, Entry &&entry) {
+    if (index >= size()) {
+        throw std::out_of_range("tried to assign an entry to a particle index that is out of range");
+    }
+    if (_layout == Layout::aos) {
+        entries[index] = std::move(entry);
+    } else {
+        columns.x[index] = entry.pos.x;
+        columns.y[index] = entry.pos.y;
+        columns.z[index] = entry.pos.z;
+        columns.force[index] = entry.force;
+        columns.type[index] = entry.type;
+        columns.deactivated[index] = static_cast<char>(entry.deactivated);
+        columns.id[index] = entry.id;
+        columns.displacement[index] = entry.displacement;
+    }
+}
+
+void CPUParticleData::append(Entry &&entry) {
+    if (_layout == Layout::aos) {
+        entries.push_back(std::move(entry));
+    } else {
+        columns.x.push_back(entry.pos.x);
+        columns.y.push_back(entry.pos.y);
+        columns.z.push_back(entry.pos.z);
+        columns.force.push_back(entry.force);
+        columns.type.push_back(entry.type);
+        columns.deactivated.push_back(static_cast<char>(entry.deactivated));
+        columns.id.push_back(entry.id);
+        columns.displacement.push_back(entry.displacement);
+    }
+}
+
+void CPUParticleData::displace(CPUParticleData::index_t index, const readdy::model::Particle::pos_type &delta) {
+    auto position = pos(index) + delta;
+    context->getFixPositionFun()(position);
+    setPosition(index, position);
     if(_trackDisplacement) {
-        entry.displacement += std::sqrt(delta * delta);
+        entry_at(index).displacement += std::sqrt(delta * delta);
     }
 }
 
@@ -214,27 +293,47 @@ void CPUParticleData::blanks_moved_to_end() {
     std::iota(blanks.begin(), blanks.end(), size() - n_blanks - 1);
 }
 
-CPUParticleData::Entry &CPUParticleData::entry_at(CPUParticleData::index_t idx) {
-    return entries.at(idx);
+CPUParticleData::EntryRef CPUParticleData::entry_at(CPUParticleData::index_t idx) {
+    if (idx >= size()) {
+        throw std::out_of_range("requested a particle index that is out of range");
+    }
+    return {*this, idx};
 }
 
-const CPUParticleData::Entry &CPUParticleData::entry_at(CPUParticleData::index_t idx) const {
+CPUParticleData::ConstEntryRef CPUParticleData::entry_at(CPUParticleData::index_t idx) const {
     return centry_at(idx);
 }
 
-const CPUParticleData::Entry &CPUParticleData::centry_at(CPUParticleData::index_t idx) const {
-    return entries.at(idx);
+CPUParticleData::ConstEntryRef CPUParticleData::centry_at(CPUParticleData::index_t idx) const {
+    if (idx >= size()) {
+        throw std::out_of_range("requested a particle index that is out of range");
+    }
+    return {*this, idx};
 }
 
-CPUParticleData::neighbors_t &CPUParticleData::neighbors_at(CPUParticleData::index_t idx) {
-    return neighbors.at(idx);
+CPUParticleData::AoSView CPUParticleData::aos_view() {
+    if (_layout != Layout::aos) {
+        throw std::logic_error("the particle data is not stored as array of structures");
+    }
+    return AoSView(entries.data());
 }
 
-const CPUParticleData::neighbors_t &CPUParticleData::neighbors_at(CPUParticleData::index_t idx) const {
+CPUParticleData::SoAView CPUParticleData::soa_view() {
+    if (_layout != Layout::soa) {
+        throw std::logic_error("the particle data is not stored as structure of arrays");
+    }
+    return {columns.x.data(), columns.y.data(), columns.z.data(), columns.force.data(), columns.type.data(),
+            columns.deactivated.data(), columns.displacement.data()};
+}
+
+CPUParticleData::neighbors_t CPUParticleData::neighbors_at(CPUParticleData::index_t idx) const {
     return cneighbors_at(idx);
 }
 
-const CPUParticleData::neighbors_t &CPUParticleData::cneighbors_at(CPUParticleData::index_t idx) const {
+CPUParticleData::neighbors_t CPUParticleData::cneighbors_at(CPUParticleData::index_t idx) const {
+    if (idx >= neighbors.size()) {
+        throw std::out_of_range("requested neighbors of a particle index that is out of range");
+    }
     return neighbors.at(idx);
 }
 
@@ -243,29 +342,29 @@ CPUParticleData::~CPUParticleData() = default;
 
 
 CPUParticleData::iterator CPUParticleData::begin() {
-    return entries.begin();
+    return {this, 0};
 }
 
 CPUParticleData::iterator CPUParticleData::end() {
-    return entries.end();
+    return {this, size()};
 }
 
 CPUParticleData::const_iterator CPUParticleData::cbegin() const {
-    return entries.cbegin();
+    return {this, 0};
 }
 
 CPUParticleData::const_iterator CPUParticleData::cend() const {
-    return entries.cend();
+    return {this, size()};
 }
 
 
 CPUParticleData::const_iterator CPUParticleData::begin() const {
-    return entries.cbegin();
+    return cbegin();
 }
 
 
 CPUParticleData::const_iterator CPUParticleData::end() const {
-    return entries.cend();
+    return cend();
 }
 
 void CPUParticleData::blanks_moved_to_front() {
@@ -273,11 +372,11 @@ void CPUParticleData::blanks_moved_to_front() {
 }
 
 CPUParticleData::index_t CPUParticleData::getIndexForId(const particle_type::id_type id) const {
-    auto find_it = std::find_if(entries.begin(), entries.end(), [id](const Entry& e) {
+    auto find_it = std::find_if(begin(), end(), [id](const ConstEntryRef &e) {
         return !e.is_deactivated() && e.id == id;
     });
-    if(find_it != entries.end()) {
-        return static_cast<index_t>(std::distance(entries.begin(), find_it));
+    if(find_it != end()) {
+        return static_cast<index_t>(std::distance(begin(), find_it));
     }
     throw std::out_of_range("requested id was not to be found in particle data");
 }
@@ -290,19 +389,30 @@ CPUParticleData::addTopologyParticles(const std::vector<CPUParticleData::top_par
         if(!blanks.empty()) {
             const auto idx = blanks.back();
             blanks.pop_back();
-            entries.at(idx) = {p};
+            assign(idx, {p});
             indices.push_back(idx);
         } else {
-            entries.push_back({p});
-            neighbors.push_back({});
-            indices.push_back(entries.size()-1);
+            append({p});
+            neighbors.append_row();
+            indices.push_back(size()-1);
         }
     }
     return indices;
 }
 
 void CPUParticleData::reserve(std::size_t n) {
-    entries.reserve(n);
+    if (_layout == Layout::aos) {
+        entries.reserve(n);
+    } else {
+        columns.x.reserve(n);
+        columns.y.reserve(n);
+        columns.z.reserve(n);
+        columns.force.reserve(n);
+        columns.type.reserve(n);
+        columns.deactivated.reserve(n);
+        columns.id.reserve(n);
+        columns.displacement.reserve(n);
+    }
     neighbors.reserve(n);
 }
 
@@ -334,14 +444,14 @@ void CPUParticleData::hilbert_sort(const scalar grid_width) {
             std::vector<std::function<void(std::size_t)>> executables;
             executables.reserve(_config.nThreads());
             const auto& executor = *_config.executor();
-            auto data_it = begin();
+            const_iterator data_it = cbegin();
             auto hilberts_it = hilbert_indices.begin();
             for (std::size_t i = 0; i < _config.nThreads() - 1; ++i) {
                 executables.push_back(executor.pack(worker, data_it, data_it + grainSize, hilberts_it));
                 data_it += grainSize;
                 hilberts_it += grainSize;
             }
-            executables.push_back(executor.pack(worker, data_it, end(), hilberts_it));
+            executables.push_back(executor.pack(worker, data_it, cend(), hilberts_it));
             executor.execute_and_wait(std::move(executables));
         }
         {
@@ -357,7 +467,19 @@ void CPUParticleData::hilbert_sort(const scalar grid_width) {
             inverseIndices[indices[i]] = i;
         }
         reorderSignal->fire_signal(inverseIndices);
-        readdy::util::collections::reorder_destructive(inverseIndices.begin(), inverseIndices.end(), begin());
+        if (_layout == Layout::aos) {
+            readdy::util::collections::reorder_destructive(inverseIndices.begin(), inverseIndices.end(),
+                                                           entries.begin());
+        } else {
+            reorder_column(inverseIndices, columns.x);
+            reorder_column(inverseIndices, columns.y);
+            reorder_column(inverseIndices, columns.z);
+            reorder_column(inverseIndices, columns.force);
+            reorder_column(inverseIndices, columns.type);
+            reorder_column(inverseIndices, columns.deactivated);
+            reorder_column(inverseIndices, columns.id);
+            reorder_column(inverseIndices, columns.displacement);
+        }
     }
 }
 
@@ -385,4 +507,4 @@ const bool &CPUParticleData::trackDisplacement() const {
 }
 }
 }
-}
\ No newline at end of file
+}
@@ -0,0 +1,289 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * @file BondedInteractions.cpp
+ * @brief Implementation of the flattened table of bonded topology interactions
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <readdy/kernel/cpu/model/topologies/BondedInteractions.h>
+
+namespace readdy {
+namespace kernel {
+namespace cpu {
+namespace model {
+namespace top {
+
+namespace {
+
+using vec_t = readdy::model::Vec3;
+using box_t = std::array<double, 3>;
+
+/**
+ * the share of n table entries that is evaluated by one thread
+ */
+std::pair<std::size_t, std::size_t> slice(std::size_t n, std::size_t nThreads, std::size_t thread) {
+    return {n * thread / nThreads, n * (thread + 1) / nThreads};
+}
+
+template<bool PX, bool PY, bool PZ>
+void evaluateSlice(std::size_t, std::size_t thread, std::size_t nThreads, const BondedInteractions &table,
+                   const CPUParticleData &data, const box_t &box, std::vector<vec_t> &forces, std::size_t offset,
+                   double &energy) {
+    const auto pos = [&data](std::size_t idx) { return data.pos(idx); };
+    const auto d = [&box](const vec_t &lhs, const vec_t &rhs) {
+        return readdy::model::shortestDifference<PX, PY, PZ>(lhs, rhs, box[0], box[1], box[2]);
+    };
+    double e = 0;
+    {
+        const auto &bonds = table.bonds();
+        const auto range = slice(bonds.size(), nThreads, thread);
+        for (auto i = range.first; i < range.second; ++i) {
+            const auto &bond = bonds[i];
+            const auto &conf = bond.configuration;
+            const auto x_ij = d(pos(conf.idx1), pos(conf.idx2));
+            vec_t force{0, 0, 0};
+            bond.potential->calculateForce(force, x_ij, conf);
+            forces[bond.slots[0] - offset] += force;
+            forces[bond.slots[1] - offset] -= force;
+            e += bond.potential->calculateEnergy(x_ij, conf);
+        }
+    }
+    {
+        const auto &angles = table.angles();
+        const auto range = slice(angles.size(), nThreads, thread);
+        for (auto i = range.first; i < range.second; ++i) {
+            const auto &angle = angles[i];
+            const auto &conf = angle.configuration;
+            const auto x_ji = d(pos(conf.idx2), pos(conf.idx1));
+            const auto x_jk = d(pos(conf.idx2), pos(conf.idx3));
+            e += angle.potential->calculateEnergy(x_ji, x_jk, conf);
+            angle.potential->calculateForce(forces[angle.slots[0] - offset], forces[angle.slots[1] - offset],
+                                            forces[angle.slots[2] - offset], x_ji, x_jk, conf);
+        }
+    }
+    {
+        const auto &dihedrals = table.dihedrals();
+        const auto range = slice(dihedrals.size(), nThreads, thread);
+        for (auto i = range.first; i < range.second; ++i) {
+            const auto &dihedral = dihedrals[i];
+            const auto &conf = dihedral.configuration;
+            const auto x_ji = d(pos(conf.idx2), pos(conf.idx1));
+            const auto x_kj = d(pos(conf.idx3), pos(conf.idx2));
+            const auto x_kl = d(pos(conf.idx3), pos(conf.idx4));
+            e += dihedral.potential->calculateEnergy(x_ji, x_kj, x_kl, conf);
+            dihedral.potential->calculateForce(forces[dihedral.slots[0] - offset], forces[dihedral.slots[1] - offset],
+                                               forces[dihedral.slots[2] - offset], forces[dihedral.slots[3] - offset],
+                                               x_ji, x_kj, x_kl, conf);
+        }
+    }
+    energy = e;
+}
+
+using slice_fun = decltype(&evaluateSlice<true, true, true>);
+
+slice_fun selectSliceFun(const std::array<bool, 3> &pbc) {
+    static const slice_fun dispatch[8] = {
+            evaluateSlice<false, false, false>, evaluateSlice<false, false, true>,
+            evaluateSlice<false, true, false>, evaluateSlice<false, true, true>,
+            evaluateSlice<true, false, false>, evaluateSlice<true, false, true>,
+            evaluateSlice<true, true, false>, evaluateSlice<true, true, true>
+    };
+    return dispatch[4 * pbc[0] + 2 * pbc[1] + pbc[2]];
+}
+
+}
+
+bool BondedInteractions::update(const topologies_t &topologies, std::size_t nThreads) {
+    std::vector<std::size_t> currentSignature;
+    currentSignature.reserve(2 * topologies.size());
+    for (const auto &topology : topologies) {
+        if (!topology->isDeactivated()) {
+            currentSignature.push_back(reinterpret_cast<std::size_t>(topology.get()));
+            currentSignature.push_back(topology->version());
+        }
+    }
+    if (nThreads == _nThreads && currentSignature == _signature) {
+        return false;
+    }
+    _signature = std::move(currentSignature);
+    _nThreads = nThreads;
+
+    _bonds.clear();
+    _angles.clear();
+    _dihedrals.clear();
+    _slots.clear();
+    _others.clear();
+    for (const auto &topology : topologies) {
+        if (topology->isDeactivated()) continue;
+        const auto &particles = static_cast<const readdy::model::top::Topology &>(*topology).getParticles();
+        // the slots of this topology's particles follow upon the slots of the previous topologies
+        const auto base = _slots.size();
+        _slots.insert(_slots.end(), particles.begin(), particles.end());
+        for (const auto &potential : topology->getBondedPotentials()) {
+            if (const auto harmonic = dynamic_cast<const harmonic_bond *>(potential.get())) {
+                for (const auto &b : harmonic->getBonds()) {
+                    _bonds.push_back({harmonic, {particles.at(b.idx1), particles.at(b.idx2), b.forceConstant,
+                                                 b.length}, {{base + b.idx1, base + b.idx2}}});
+                }
+            } else {
+                _others.push_back(potential.get());
+            }
+        }
+        for (const auto &potential : topology->getAnglePotentials()) {
+            if (const auto harmonic = dynamic_cast<const harmonic_angle *>(potential.get())) {
+                for (const auto &a : harmonic->getAngles()) {
+                    _angles.push_back({harmonic, {particles.at(a.idx1), particles.at(a.idx2), particles.at(a.idx3),
+                                                  a.forceConstant, a.equilibriumAngle},
+                                       {{base + a.idx1, base + a.idx2, base + a.idx3}}});
+                }
+            } else {
+                _others.push_back(potential.get());
+            }
+        }
+        for (const auto &potential : topology->getTorsionPotentials()) {
+            if (const auto cosine = dynamic_cast<const cos_dihedral *>(potential.get())) {
+                for (const auto &dih : cosine->getDihedrals()) {
+                    _dihedrals.push_back({cosine, {particles.at(dih.idx1), particles.at(dih.idx2),
+                                                   particles.at(dih.idx3), particles.at(dih.idx4),
+                                                   dih.forceConstant, dih.multiplicity, dih.phi_0},
+                                          {{base + dih.idx1, base + dih.idx2, base + dih.idx3, base + dih.idx4}}});
+                }
+            } else {
+                _others.push_back(potential.get());
+            }
+        }
+    }
+
+    // determine the range of slots that each thread's share of the table touches
+    _buffers.resize(nThreads);
+    for (std::size_t thread = 0; thread < nThreads; ++thread) {
+        std::size_t lo = std::numeric_limits<std::size_t>::max(), hi = 0;
+        const auto touch = [&lo, &hi](std::size_t idx) {
+            lo = std::min(lo, idx);
+            hi = std::max(hi, idx + 1);
+        };
+        {
+            const auto range = slice(_bonds.size(), nThreads, thread);
+            for (auto i = range.first; i < range.second; ++i) {
+                for (const auto slot : _bonds[i].slots) touch(slot);
+            }
+        }
+        {
+            const auto range = slice(_angles.size(), nThreads, thread);
+            for (auto i = range.first; i < range.second; ++i) {
+                for (const auto slot : _angles[i].slots) touch(slot);
+            }
+        }
+        {
+            const auto range = slice(_dihedrals.size(), nThreads, thread);
+            for (auto i = range.first; i < range.second; ++i) {
+                for (const auto slot : _dihedrals[i].slots) touch(slot);
+            }
+        }
+        auto &buffer = _buffers[thread];
+        buffer.offset = lo < hi ? lo : 0;
+        buffer.forces.assign(lo < hi ? hi - lo : 0, {0, 0, 0});
+    }
+    return true;
+}
+
+double BondedInteractions::evaluate(CPUParticleData &data, const readdy::model::KernelContext &context,
+                                    const readdy::util::thread::Config &config,
+                                    const topology_action_factory *factory) {
+    double energy = 0;
+    if (!_bonds.empty() || !_angles.empty() || !_dihedrals.empty()) {
+        const auto &executor = *config.executor();
+        const auto sliceFun = selectSliceFun(context.getPeriodicBoundary());
+        std::vector<double> energies(_nThreads, 0);
+        {
+            std::vector<std::function<void(std::size_t)>> executables;
+            executables.reserve(_nThreads);
+            for (std::size_t thread = 0; thread < _nThreads; ++thread) {
+                auto &buffer = _buffers[thread];
+                executables.push_back(executor.pack(sliceFun, thread, _nThreads, std::cref(*this), std::cref(data),
+                                                    std::cref(context.getBoxSize()), std::ref(buffer.forces),
+                                                    buffer.offset, std::ref(energies[thread])));
+            }
+            executor.execute_and_wait(std::move(executables));
+        }
+        {
+            // add the buffered forces to the particles, resetting the buffers on the way. each slot belongs to a
+            // different particle, so that ranges of slots can be reduced concurrently
+            auto reduce = [this, &data](std::size_t, std::size_t begin, std::size_t end) {
+                for (auto &buffer : _buffers) {
+                    const auto from = std::max(begin, buffer.offset);
+                    const auto to = std::min(end, buffer.offset + buffer.forces.size());
+                    for (auto slot = from; slot < to; ++slot) {
+                        auto &f = buffer.forces[slot - buffer.offset];
+                        data.entry_at(_slots[slot]).force += f;
+                        f = {0, 0, 0};
+                    }
+                }
+            };
+            std::vector<std::function<void(std::size_t)>> executables;
+            executables.reserve(_nThreads);
+            const std::size_t grainSize = _slots.size() / _nThreads;
+            for (std::size_t i = 0; i < _nThreads - 1; ++i) {
+                executables.push_back(executor.pack(reduce, i * grainSize, (i + 1) * grainSize));
+            }
+            executables.push_back(executor.pack(reduce, (_nThreads - 1) * grainSize, _slots.size()));
+            executor.execute_and_wait(std::move(executables));
+        }
+        for (const auto e : energies) {
+            energy += e;
+        }
+    }
+    for (const auto potential : _others) {
+        energy += potential->createForceAndEnergyAction(factory)->perform();
+    }
+    return energy;
+}
+
+const std::vector<BondedInteractions::bond> &BondedInteractions::bonds() const {
+    return _bonds;
+}
+
+const std::vector<BondedInteractions::angle> &BondedInteractions::angles() const {
+    return _angles;
+}
+
+const std::vector<BondedInteractions::dihedral> &BondedInteractions::dihedrals() const {
+    return _dihedrals;
+}
+
+const std::vector<std::size_t> &BondedInteractions::slots() const {
+    return _slots;
+}
+
+}
+}
+}
+}
+}
@@ -29,20 +29,23 @@
  * @date 4/21/17
  */
 
+#include <algorithm>
 #include <cmath>
 #include <atomic>
+#include <numeric>
 
 #include <readdy/common/numeric.h>
 #include <readdy/kernel/cpu/nl/CellContainer.h>
 #include <readdy/kernel/cpu/nl/SubCell.h>
 #include <readdy/kernel/cpu/util/config.h>
-#include <readdy/common/thread/barrier.h>
 
 namespace readdy {
 namespace kernel {
 namespace cpu {
 namespace nl {
 
+constexpr CellContainer::cell_index CellContainer::no_leaf;
+
 CellContainer::sub_cells_t &CellContainer::sub_cells() {
     return _sub_cells;
 }
@@ -167,6 +170,7 @@ void CellContainer::subdivide(const scalar desired_cell_width) {
             }
         }
     }
+    index_leaves();
 }
 
 const model::CPUParticleData &CellContainer::data() const {
@@ -213,6 +217,7 @@ void CellContainer::refine_uniformly() {
     execute_for_each_sub_cell([](sub_cell &cell) {
         cell.refine_uniformly();
     });
+    index_leaves();
 }
 
 CellContainer::sub_cell *const CellContainer::leaf_cell_for_position(const CellContainer::vec3 &pos) {
@@ -253,7 +258,7 @@ const CellContainer *const CellContainer::super_cell() const {
     return _super_cell;
 }
 
-void CellContainer::insert_particle(const CellContainer::particle_index index, bool mark_dirty) const {
+void CellContainer::insert_particle(const CellContainer::particle_index index, bool mark_dirty) {
     const auto &entry = data().entry_at(index);
     if (!entry.is_deactivated()) {
         auto cell = leaf_cell_for_position(entry.position());
@@ -268,18 +273,142 @@ void CellContainer::insert_particle(const CellContainer::particle_index index, b
     }
 }
 
-void CellContainer::insert_particle(const CellContainer::particle_index index, bool mark_dirty) {
-    const auto &entry = data().entry_at(index);
-    if (!entry.is_deactivated()) {
-        auto cell = leaf_cell_for_position(entry.position());
-        if (cell != nullptr) {
-            cell->insert_particle(index);
-            if(mark_dirty) {
-                cell->super_cell()->set_dirty();
+std::size_t CellContainer::insert_particles(const std::function<bool(particle_index)> &filter) {
+    const auto nParticles = _data.size();
+    const auto nLeaves = _leaves.size();
+    const auto nThreads = config().nThreads();
+    const auto &executor = *config().executor();
+    _particle_leaves.resize(nParticles);
+
+    std::vector<std::atomic<std::size_t>> counts(nLeaves);
+    for (auto &count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    std::vector<std::size_t> nOutside(nThreads, 0);
+
+    auto run_chunked = [&](const std::size_t n, const std::function<void(std::size_t, std::size_t, std::size_t)> &f) {
+        const auto grainSize = n / nThreads;
+        auto worker = [&f](std::size_t, std::size_t chunk, std::size_t begin, std::size_t end) {
+            f(chunk, begin, end);
+        };
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nThreads);
+        for (std::size_t i = 0; i < nThreads - 1; ++i) {
+            executables.push_back(executor.pack(worker, i, i * grainSize, (i + 1) * grainSize));
+        }
+        executables.push_back(executor.pack(worker, nThreads - 1, (nThreads - 1) * grainSize, n));
+        executor.execute_and_wait(std::move(executables));
+    };
+
+    // determine the leaf of each particle and count the particles per leaf
+    run_chunked(nParticles, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            auto leaf = no_leaf;
+            const auto &entry = _data.entry_at(i);
+            if (!entry.is_deactivated() && (!filter || filter(i))) {
+                const auto cell = static_cast<const CellContainer *>(this)->leaf_cell_for_position(entry.position());
+                if (cell != nullptr) {
+                    leaf = cell->_first_leaf;
+                    counts[leaf].fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    ++nOutside[chunk];
+                }
             }
+            _particle_leaves[i] = leaf;
         }
-    } else {
-        log::critical("Tried inserting a deactivated particle ({}) into the neighbor list!", index);
+    });
+    // grow the leaves' lists, the counters become the positions at which the particles are written
+    run_chunked(nLeaves, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (auto l = begin; l < end; ++l) {
+            auto &particles = _leaves[l]->particles().data();
+            const auto offset = particles.size();
+            particles.resize(offset + counts[l].load(std::memory_order_relaxed));
+            counts[l].store(offset, std::memory_order_relaxed);
+        }
+    });
+    // scatter
+    run_chunked(nParticles, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            const auto leaf = _particle_leaves[i];
+            if (leaf != no_leaf) {
+                _leaves[leaf]->particles().data()[counts[leaf].fetch_add(1, std::memory_order_relaxed)] = i;
+            }
+        }
+    });
+    // the order in which the threads scattered into a leaf is arbitrary, restore the order by index
+    run_chunked(nLeaves, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (auto l = begin; l < end; ++l) {
+            auto &particles = _leaves[l]->particles().data();
+            std::sort(particles.begin(), particles.end());
+        }
+    });
+    return std::accumulate(nOutside.begin(), nOutside.end(), static_cast<std::size_t>(0));
+}
+
+void CellContainer::remove_particles(const std::vector<particle_index> &particles) {
+    std::vector<std::pair<cell_index, particle_index>> removals;
+    removals.reserve(particles.size());
+    for (const auto p : particles) {
+        const auto leaf = leaf_of_particle(p);
+        if (leaf != no_leaf) {
+            removals.emplace_back(leaf, p);
+            _particle_leaves[p] = no_leaf;
+        }
+    }
+    std::sort(removals.begin(), removals.end());
+    for (auto it = removals.begin(); it != removals.end();) {
+        const auto leaf = it->first;
+        const auto groupEnd = std::find_if(it, removals.end(), [leaf](const std::pair<cell_index, particle_index> &r) {
+            return r.first != leaf;
+        });
+        auto &leafParticles = _leaves[leaf]->particles().data();
+        leafParticles.erase(std::remove_if(leafParticles.begin(), leafParticles.end(), [&](particle_index p) {
+            return std::binary_search(it, groupEnd, std::make_pair(leaf, p));
+        }), leafParticles.end());
+        _leaves[leaf]->super_cell()->set_dirty();
+        it = groupEnd;
+    }
+}
+
+const std::vector<CellContainer::sub_cell *> &CellContainer::leaves() const {
+    return _leaves;
+}
+
+const CellContainer::cell_index &CellContainer::first_leaf() const {
+    return _first_leaf;
+}
+
+const CellContainer::cell_index &CellContainer::n_leaves() const {
+    return _n_leaves;
+}
+
+CellContainer::cell_index CellContainer::leaf_of_particle(particle_index index) const {
+    return index < _particle_leaves.size() ? _particle_leaves[index] : no_leaf;
+}
+
+void CellContainer::set_leaf_of_particle(particle_index index, cell_index leaf) {
+    if (index >= _particle_leaves.size()) {
+        _particle_leaves.resize(index + 1, no_leaf);
+    }
+    _particle_leaves[index] = leaf;
+}
+
+void CellContainer::index_leaves() {
+    _leaves.clear();
+    collect_leaves(_leaves);
+    _first_leaf = 0;
+    _n_leaves = _leaves.size();
+}
+
+void CellContainer::collect_leaves(std::vector<sub_cell *> &leaves) {
+    for (auto &cell : _sub_cells) {
+        cell._first_leaf = leaves.size();
+        if (cell.is_leaf()) {
+            leaves.push_back(&cell);
+        } else {
+            cell.collect_leaves(leaves);
+        }
+        cell._n_leaves = leaves.size() - cell._first_leaf;
     }
 }
 
@@ -288,6 +417,7 @@ void CellContainer::clear() {
     execute_for_each_sub_cell([](sub_cell &cell) {
         cell.clear();
     });
+    std::fill(_particle_leaves.begin(), _particle_leaves.end(), no_leaf);
 }
 
 bool CellContainer::update_sub_cell_displacements_and_mark_dirty(const scalar cutoff, const scalar skin) {
@@ -328,54 +458,86 @@ bool CellContainer::update_sub_cell_displacements_and_mark_dirty(const scalar cu
 }
 
 void CellContainer::update_dirty_cells() {
-    using barrier_t = util::thread::barrier;
-    // todo go through macro cells, see if dirty => the current particles might be in the neighboring cells
-
-    // 1. reset displacement of DIRTY cells
-    // 3. reassign these particles to cells, rebuild verlet list (in NL?) for particles in DIRTY and NEIGHBORS
-
-    auto worker = [this](std::size_t, const CellContainer& container,
-                         const barrier_t& barrier,
-                         sub_cells_t::iterator begin, sub_cells_t::iterator end) {
-        std::vector<std::vector<particle_index>> dirty_cell_particles;
-        {
-            for (auto it = begin; it != end; ++it) {
-                if (it->is_dirty()) {
-                    it->reset_particles_displacements();
-                    dirty_cell_particles.emplace_back(it->collect_contained_particles());
-                    it->clear();
-                }
-            }
-        }
-        barrier.wait();
-        {
-            for (const auto &dirty_cell : dirty_cell_particles) {
-                for (const auto p_idx : dirty_cell) {
-                    auto &entry = _data.entry_at(p_idx);
-                    // entry.displacement = 0;
-                    auto cell = container.leaf_cell_for_position(entry.position());
-                    if (cell != nullptr) {
-                        cell->insert_particle(p_idx);
+    // the leaves of dirty cells are compacted in place, the particles that left their leaf are collected in move
+    // lists. these are grouped by target leaf, so that each leaf is appended to by one thread only.
+    using particle_move = std::pair<cell_index, particle_index>;
+    const auto nThreads = config().nThreads();
+    std::vector<std::vector<particle_move>> moves(nThreads);
+
+    auto collect_worker = [this](std::size_t, sub_cells_t::iterator begin, sub_cells_t::iterator end,
+                                 std::vector<particle_move> &threadMoves) {
+        const auto &container = static_cast<const CellContainer &>(*this);
+        for (auto it = begin; it != end; ++it) {
+            if (it->is_dirty()) {
+                it->reset_particles_displacements();
+                for (auto l = it->_first_leaf; l < it->_first_leaf + it->_n_leaves; ++l) {
+                    auto &particles = _leaves[l]->particles().data();
+                    std::size_t nKept = 0;
+                    for (std::size_t i = 0; i < particles.size(); ++i) {
+                        const auto p_idx = particles[i];
+                        const auto cell = container.leaf_cell_for_position(_data.entry_at(p_idx).position());
+                        if (cell == _leaves[l]) {
+                            particles[nKept++] = p_idx;
+                        } else if (cell != nullptr) {
+                            threadMoves.emplace_back(cell->_first_leaf, p_idx);
+                        } else {
+                            _particle_leaves[p_idx] = no_leaf;
+                        }
                     }
+                    particles.resize(nKept);
                 }
             }
         }
     };
+    auto insert_worker = [this](std::size_t, const std::vector<particle_move> &allMoves, std::size_t begin,
+                                std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            _leaves[allMoves[i].first]->particles().add(allMoves[i].second);
+            _particle_leaves[allMoves[i].second] = allMoves[i].first;
+        }
+    };
 
-    barrier_t barrier{_config.nThreads()};
-    const auto grainSize = sub_cells().size() / config().nThreads();
-
-    std::vector<std::function<void(std::size_t)>> executables;
-    executables.reserve(config().nThreads());
+    const auto grainSize = sub_cells().size() / nThreads;
     const auto& executor = *config().executor();
-
-    auto it = sub_cells().begin();
-    for (auto i = 0; i < config().nThreads() - 1; ++i) {
-        executables.push_back(executor.pack(worker, std::cref(*this), std::cref(barrier), it, it + grainSize));
-        it += grainSize;
+    {
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nThreads);
+        auto it = sub_cells().begin();
+        for (auto i = 0; i < nThreads - 1; ++i) {
+            executables.push_back(executor.pack(collect_worker, it, it + grainSize, std::ref(moves[i])));
+            it += grainSize;
+        }
+        executables.push_back(executor.pack(collect_worker, it, sub_cells().end(), std::ref(moves.back())));
+        executor.execute_and_wait(std::move(executables));
+    }
+    std::vector<particle_move> allMoves;
+    {
+        std::size_t nMoves = 0;
+        for (const auto &threadMoves : moves) nMoves += threadMoves.size();
+        allMoves.reserve(nMoves);
+        for (const auto &threadMoves : moves) {
+            allMoves.insert(allMoves.end(), threadMoves.begin(), threadMoves.end());
+        }
+        std::sort(allMoves.begin(), allMoves.end());
+    }
+    if (!allMoves.empty()) {
+        // split into chunks whose borders do not cut through the moves into one leaf
+        std::vector<std::size_t> borders(nThreads + 1, allMoves.size());
+        borders.front() = 0;
+        for (std::size_t i = 1; i < nThreads; ++i) {
+            auto border = std::max(borders[i - 1], i * allMoves.size() / nThreads);
+            while (border > 0 && border < allMoves.size() && allMoves[border].first == allMoves[border - 1].first) {
+                ++border;
+            }
+            borders[i] = border;
+        }
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nThreads);
+        for (std::size_t i = 0; i < nThreads; ++i) {
+            executables.push_back(executor.pack(insert_worker, std::cref(allMoves), borders[i], borders[i + 1]));
+        }
+        executor.execute_and_wait(std::move(executables));
     }
-    executables.push_back(executor.pack(worker, std::cref(*this), std::cref(barrier), it, sub_cells().end()));
-    executor.execute_and_wait(std::move(executables));
 }
 
 const std::size_t CellContainer::n_dirty_macro_cells() const {
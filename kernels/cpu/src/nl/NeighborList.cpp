@@ -30,6 +30,11 @@
  * @copyright GNU Lesser General Public License v3.0
  */
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+
 #include <readdy/kernel/cpu/nl/NeighborList.h>
 #include <readdy/kernel/cpu/util/config.h>
 
@@ -38,6 +43,46 @@ namespace kernel {
 namespace cpu {
 namespace nl {
 
+using CompactNeighborList = model::CompactNeighborList;
+
+namespace {
+/**
+ * the capacity that is reserved for a row holding n neighbors, leaving some headroom so that the row can usually be
+ * refilled in place when only a few cells were updated
+ */
+CompactNeighborList::offset_type row_capacity(CompactNeighborList::count_type n) {
+    return n + n / 8 + 1;
+}
+
+/**
+ * invokes f for each particle in the cell and its neighboring cells that is closer to the given particle than the
+ * candidate cutoff of their type pair, pairs of types without candidate cutoff are never considered
+ */
+template<typename F>
+void for_each_candidate(const CellContainer::sub_cell &cell, const CellContainer::particle_index particle_index,
+                        const model::CPUParticleData &data, const readdy::model::KernelContext::dist_squared_fun &d2,
+                        const std::vector<scalar> &pairCutoffsSquared, const std::size_t nTypes, F &&f) {
+    const auto &entry = data.entry_at(particle_index);
+    if (entry.type >= nTypes) return;
+    const auto cutoffsSquared = pairCutoffsSquared.data() + entry.type * nTypes;
+    const auto &pos = entry.position();
+    for (const auto p_i : cell.particles().data()) {
+        const auto &other = data.entry_at(p_i);
+        if (p_i != particle_index && other.type < nTypes && d2(pos, other.position()) < cutoffsSquared[other.type]) {
+            f(p_i);
+        }
+    }
+    for (const auto &neighbor_cell : cell.neighbors()) {
+        for (const auto p_j : neighbor_cell->particles().data()) {
+            const auto &other = data.entry_at(p_j);
+            if (other.type < nTypes && d2(pos, other.position()) < cutoffsSquared[other.type]) {
+                f(p_j);
+            }
+        }
+    }
+}
+}
+
 NeighborList::NeighborList(model::CPUParticleData &data, const readdy::model::KernelContext &context,
                            const readdy::util::thread::Config &config, bool adaptive,
                            skin_size_t skin, bool hilbert_sort)
@@ -50,8 +95,14 @@ const CellContainer &NeighborList::cell_container() const {
 }
 
 void NeighborList::set_up() {
+    ++_stats.n_updates;
     _max_cutoff = calculate_max_cutoff();
-    _max_cutoff_skin_squared = (_max_cutoff + _skin) * (_max_cutoff + _skin);
+    update_candidate_cutoffs();
+    _candidate_cutoffs_skin_squared.resize(_candidate_cutoffs.size());
+    std::transform(_candidate_cutoffs.begin(), _candidate_cutoffs.end(), _candidate_cutoffs_skin_squared.begin(),
+                   [this](const scalar cutoff) {
+                       return cutoff > 0 ? (cutoff + _skin) * (cutoff + _skin) : static_cast<scalar>(0);
+                   });
     if (_max_cutoff > 0) {
         _cell_container.update_root_size();
         _cell_container.subdivide(_max_cutoff + _skin);
@@ -62,38 +113,144 @@ void NeighborList::set_up() {
         }
         fill_container();
         fill_verlet_list();
+        _n_updates_since_sort = 0;
+        _locality_after_sort = locality();
+        ++_stats.n_rebuilds;
     }
     _is_set_up = true;
 }
 
 scalar NeighborList::calculate_max_cutoff() {
-    scalar max_cutoff = 0;
+    const auto types = _context.particle_types().types_flat();
+    _n_types = types.empty() ? 0 : static_cast<std::size_t>(*std::max_element(types.begin(), types.end())) + 1;
+    _pair_cutoffs.assign(_n_types * _n_types, 0);
+    auto update_pair = [this](const readdy::util::particle_type_pair &pair, const scalar cutoff) {
+        const auto t1 = std::get<0>(pair);
+        const auto t2 = std::get<1>(pair);
+        if (t1 < _n_types && t2 < _n_types) {
+            auto &c12 = _pair_cutoffs[t1 * _n_types + t2];
+            auto &c21 = _pair_cutoffs[t2 * _n_types + t1];
+            c12 = std::max(c12, cutoff);
+            c21 = std::max(c21, cutoff);
+        }
+    };
     for (const auto &entry : _context.potentials().potentials_order2()) {
         for (const auto &potential : entry.second) {
-            max_cutoff = max_cutoff < potential->getCutoffRadius() ? potential->getCutoffRadius() : max_cutoff;
+            update_pair(entry.first, potential->getCutoffRadius());
         }
     }
     for (const auto &entry : _context.reactions().order2()) {
         for (const auto &reaction : entry.second) {
-            max_cutoff = max_cutoff < reaction->getEductDistance() ? reaction->getEductDistance() : max_cutoff;
+            update_pair(entry.first, reaction->getEductDistance());
         }
     }
+    scalar max_cutoff = 0;
+    for (const auto cutoff : _pair_cutoffs) {
+        max_cutoff = std::max(max_cutoff, cutoff);
+    }
     return max_cutoff;
 }
 
+void NeighborList::update_candidate_cutoffs() {
+    const auto n = _n_types;
+    // reachable[a * n + b] is true if particles of type a can become particles of type b, possibly in several steps
+    std::vector<char> reachable(n * n, false);
+    for (std::size_t t = 0; t < n; ++t) {
+        reachable[t * n + t] = true;
+    }
+    auto add_conversion = [n, &reachable](const particle_type_type from, const particle_type_type to) {
+        if (from < n && to < n) {
+            reachable[from * n + to] = true;
+        }
+    };
+    // conversions and fissions keep the educt's entry for their first product
+    for (const auto reaction : _context.reactions().order1_flat()) {
+        if (reaction->getNProducts() > 0) {
+            add_conversion(reaction->getEducts()[0], reaction->getProducts()[0]);
+        }
+    }
+    // enzymatic reactions convert their first educt in place, fusions create a new entry
+    for (const auto reaction : _context.reactions().order2_flat()) {
+        if (reaction->getNProducts() == 2) {
+            add_conversion(reaction->getEducts()[0], reaction->getProducts()[0]);
+        }
+    }
+    for (const auto &compartment : _context.getCompartments()) {
+        for (const auto &conversion : compartment->getConversions()) {
+            add_conversion(conversion.first, conversion.second);
+        }
+    }
+    const auto &types = _context.particle_types();
+    for (const auto t : types.types_flat()) {
+        if (t < n && types.info_of(t).flavor == readdy::model::Particle::FLAVOR_TOPOLOGY) {
+            std::fill(reachable.begin() + t * n, reachable.begin() + (t + 1) * n, true);
+        }
+    }
+    for (std::size_t k = 0; k < n; ++k) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!reachable[i * n + k]) continue;
+            for (std::size_t j = 0; j < n; ++j) {
+                if (reachable[k * n + j]) reachable[i * n + j] = true;
+            }
+        }
+    }
+    // maximize over the types of the first particle, then over the types of the second particle
+    std::vector<scalar> partial(n * n, 0);
+    for (std::size_t a = 0; a < n; ++a) {
+        for (std::size_t a2 = 0; a2 < n; ++a2) {
+            if (!reachable[a * n + a2]) continue;
+            for (std::size_t b = 0; b < n; ++b) {
+                partial[a * n + b] = std::max(partial[a * n + b], _pair_cutoffs[a2 * n + b]);
+            }
+        }
+    }
+    _candidate_cutoffs.assign(n * n, 0);
+    for (std::size_t b = 0; b < n; ++b) {
+        for (std::size_t b2 = 0; b2 < n; ++b2) {
+            if (!reachable[b * n + b2]) continue;
+            for (std::size_t a = 0; a < n; ++a) {
+                _candidate_cutoffs[a * n + b] = std::max(_candidate_cutoffs[a * n + b], partial[a * n + b2]);
+            }
+        }
+    }
+}
+
+scalar NeighborList::candidate_cutoff(const particle_type_type type1, const particle_type_type type2) const {
+    if (type1 < _n_types && type2 < _n_types) {
+        return _candidate_cutoffs[type1 * _n_types + type2];
+    }
+    return 0;
+}
+
+const NeighborList::statistics &NeighborList::stats() const {
+    return _stats;
+}
+
+scalar NeighborList::pair_cutoff(const particle_type_type type1, const particle_type_type type2) const {
+    if (type1 < _n_types && type2 < _n_types) {
+        return _pair_cutoffs[type1 * _n_types + type2];
+    }
+    return 0;
+}
+
 void NeighborList::update() {
     if(!_is_set_up) {
         set_up();
     } else {
+        ++_stats.n_updates;
         if (_max_cutoff > 0) {
             bool too_far = _adaptive ? !_cell_container.update_sub_cell_displacements_and_mark_dirty(_max_cutoff, _skin)
                                      : false;
             bool too_many = _adaptive ? _cell_container.n_dirty_macro_cells() >=
                                         .9 * _cell_container.n_sub_cells_total() : false;
+            ++_n_updates_since_sort;
+            const bool resort = _hilbert_sort && resort_due();
             log::trace("updating {}% ({} of {})",
                        100. * _cell_container.n_dirty_macro_cells() / _cell_container.n_sub_cells_total(),
                        _cell_container.n_dirty_macro_cells(), _cell_container.n_sub_cells_total());
-            if (_adaptive && !too_far && !too_many) {
+            if (_adaptive && !too_far && !too_many && !resort) {
+                ++_stats.n_adaptive_updates;
+                _stats.n_dirty_cells += _cell_container.n_dirty_macro_cells();
                 _cell_container.update_dirty_cells();
                 handle_dirty_cells();
             } else {
@@ -109,9 +266,15 @@ void NeighborList::update() {
                             "More than 90% of the cells were marked dirty, thus re-create the whole neighbor list rather"
                                     " than update it adaptively");
                 }
-                clear_cells();
-                fill_container();
-                fill_verlet_list();
+                ++_stats.n_rebuilds;
+                if (_hilbert_sort && (resort || too_far || too_many)) {
+                    // the whole list is rebuilt anyways, so restoring the memory locality comes at little extra cost
+                    sort_by_hilbert_curve();
+                } else {
+                    clear_cells();
+                    fill_container();
+                    fill_verlet_list();
+                }
             }
         }
     }
@@ -127,39 +290,7 @@ const readdy::util::thread::Config &NeighborList::config() const {
 
 void NeighborList::fill_container() {
     if (_max_cutoff > 0) {
-
-        const auto grainSize = _data.size() / _config.nThreads();
-        const auto data_begin = _data.cbegin();
-        auto worker = [=](std::size_t, model::CPUParticleData::const_iterator begin,
-                          model::CPUParticleData::const_iterator end, const CellContainer &container) {
-            CellContainer::particle_index i = (CellContainer::particle_index) std::distance(data_begin, begin);
-            for (auto it = begin; it != end; ++it, ++i) {
-                if (!it->is_deactivated()) {
-                    container.insert_particle(i);
-                }
-            }
-        };
-
-        auto& executor = *config().executor();
-
-        std::vector<std::function<void(std::size_t)>> executables;
-        executables.reserve(config().nThreads());
-
-        auto it = _data.cbegin();
-        for (auto i = 0; i < _config.nThreads() - 1; ++i) {
-            executables.push_back(executor.pack(worker, it, it + grainSize, std::cref(_cell_container)));
-            it += grainSize;
-        }
-        executables.push_back(executor.pack(worker, it, _data.end(), std::cref(_cell_container)));
-
-        executor.execute_and_wait(std::move(executables));
-        // threads.emplace_back(worker, it, _data.end(), std::cref(_cell_container));
-        /*std::size_t i = 0;
-        for(auto it = _data.begin(); it != _data.end(); ++it, ++i) {
-            if(!it->is_deactivated()) {
-                _cell_container.insert_particle(i);
-            }
-        }*/
+        _cell_container.insert_particles();
     }
 }
 
@@ -170,45 +301,118 @@ void NeighborList::clear_cells() {
 void NeighborList::clear() {
     if (_max_cutoff > 0) {
         clear_cells();
-        for (auto &neighbors : _data.neighbors) {
-            neighbors.clear();
-        }
+        auto &counts = _data.neighbors.counts;
+        std::fill(counts.begin(), counts.end(), 0);
     }
 }
 
 void NeighborList::fill_verlet_list() {
-    const auto &d2 = _context.getDistSquaredFun();
     if (_max_cutoff > 0) {
+        if (_data.size() > std::numeric_limits<data_t::Neighbor>::max()) {
+            throw std::runtime_error("the number of particles exceeds the range of the neighbor list's indices");
+        }
+        auto &neighbors = _data.neighbors;
+        neighbors.resize_rows(_data.size());
+        // particles that are not contained in any cell do not have neighbors
+        std::fill(neighbors.counts.begin(), neighbors.counts.end(), 0);
+        _cell_container.execute_for_each_leaf([this](const CellContainer::sub_cell &cell) {
+            count_cell_neighbors(cell);
+        });
+        update_offsets();
         _cell_container.execute_for_each_leaf([this](const CellContainer::sub_cell &cell) {
             fill_cell_verlet_list(cell, true);
         });
     }
 }
 
-void NeighborList::fill_cell_verlet_list(const CellContainer::sub_cell &cell, const bool reset_displacement) {
+void NeighborList::count_cell_neighbors(const CellContainer::sub_cell &cell) {
     const auto &d2 = _context.getDistSquaredFun();
+    auto &counts = _data.neighbors.counts;
     for (const auto particle_index : cell.particles().data()) {
-        auto &neighbors = _data.neighbors_at(particle_index);
-        auto &entry = _data.entry_at(particle_index);
-        if (reset_displacement) entry.displacement = 0;
-        neighbors.clear();
-        for (const auto p_i : cell.particles().data()) {
-            if (p_i != particle_index) {
-                const auto distSquared = d2(entry.position(), _data.pos(p_i));
-                if (distSquared < _max_cutoff_skin_squared) {
-                    neighbors.push_back(p_i);
-                }
+        CompactNeighborList::count_type n = 0;
+        for_each_candidate(cell, particle_index, _data, d2, _candidate_cutoffs_skin_squared, _n_types,
+                           [&n](std::size_t) { ++n; });
+        counts[particle_index] = n;
+    }
+}
+
+void NeighborList::update_offsets() {
+    auto &neighbors = _data.neighbors;
+    const auto nRows = neighbors.size();
+    const auto nThreads = _config.nThreads();
+    const auto grainSize = nRows / nThreads;
+    std::vector<CompactNeighborList::offset_type> chunkSums(nThreads, 0);
+
+    const auto &executor = *_config.executor();
+    // first sum up the capacities of each chunk of rows, then write the offsets of each chunk starting from the
+    // exclusive prefix sum over the chunks
+    {
+        auto worker = [&neighbors, &chunkSums](std::size_t, std::size_t chunk, std::size_t begin, std::size_t end) {
+            CompactNeighborList::offset_type sum = 0;
+            for (auto row = begin; row < end; ++row) {
+                sum += row_capacity(neighbors.counts[row]);
             }
+            chunkSums[chunk] = sum;
+        };
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nThreads);
+        for (std::size_t i = 0; i < nThreads - 1; ++i) {
+            executables.push_back(executor.pack(worker, i, i * grainSize, (i + 1) * grainSize));
         }
-        for (const auto &neighbor_cell : cell.neighbors()) {
-            for (const auto p_j : neighbor_cell->particles().data()) {
-                const auto distSquared = d2(entry.position(), _data.pos(p_j));
-                if (distSquared < _max_cutoff_skin_squared) {
-                    neighbors.push_back(p_j);
-                }
+        executables.push_back(executor.pack(worker, nThreads - 1, (nThreads - 1) * grainSize, nRows));
+        executor.execute_and_wait(std::move(executables));
+    }
+    {
+        CompactNeighborList::offset_type running = 0;
+        for (auto &chunkSum : chunkSums) {
+            const auto sum = chunkSum;
+            chunkSum = running;
+            running += sum;
+        }
+    }
+    {
+        auto worker = [&neighbors, &chunkSums](std::size_t, std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto offset = chunkSums[chunk];
+            for (auto row = begin; row < end; ++row) {
+                offset += row_capacity(neighbors.counts[row]);
+                neighbors.offsets[row + 1] = offset;
             }
+        };
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nThreads);
+        for (std::size_t i = 0; i < nThreads - 1; ++i) {
+            executables.push_back(executor.pack(worker, i, i * grainSize, (i + 1) * grainSize));
+        }
+        executables.push_back(executor.pack(worker, nThreads - 1, (nThreads - 1) * grainSize, nRows));
+        executor.execute_and_wait(std::move(executables));
+    }
+    neighbors.offsets.front() = 0;
+    neighbors.indices.resize(neighbors.n_entries());
+}
+
+bool NeighborList::fill_cell_verlet_list(const CellContainer::sub_cell &cell, const bool reset_displacement) {
+    const auto &d2 = _context.getDistSquaredFun();
+    auto &neighbors = _data.neighbors;
+    bool fits = true;
+    for (const auto particle_index : cell.particles().data()) {
+        if (reset_displacement) _data.entry_at(particle_index).displacement = 0;
+        const auto capacity = neighbors.capacity(particle_index);
+        auto row = neighbors.indices.data() + neighbors.offsets[particle_index];
+        CompactNeighborList::offset_type n = 0;
+        for_each_candidate(cell, particle_index, _data, d2, _candidate_cutoffs_skin_squared, _n_types,
+                           [&](std::size_t p) {
+            if (n < capacity) {
+                row[n] = static_cast<data_t::Neighbor>(p);
+            }
+            ++n;
+        });
+        if (n > capacity) {
+            fits = false;
+            n = capacity;
         }
+        neighbors.counts[particle_index] = static_cast<CompactNeighborList::count_type>(n);
     }
+    return fits;
 }
 
 bool &NeighborList::adaptive() {
@@ -228,6 +432,7 @@ const bool &NeighborList::performs_hilbert_sort() const {
 }
 
 void NeighborList::sort_by_hilbert_curve() {
+    ++_stats.n_hilbert_sorts;
     clear();
     if (_hilbert_sort) {
         _data.hilbert_sort(_max_cutoff + _skin);
@@ -236,26 +441,91 @@ void NeighborList::sort_by_hilbert_curve() {
     }
     fill_container();
     fill_verlet_list();
+    _n_updates_since_sort = 0;
+    _locality_after_sort = locality();
+}
+
+bool NeighborList::resort_due() const {
+    if (_hilbert_sort_interval > 0 && _n_updates_since_sort >= _hilbert_sort_interval) {
+        return true;
+    }
+    if (_hilbert_sort_locality_factor > 1 && _locality_after_sort > 0
+        && _n_updates_since_sort % locality_check_interval == 0) {
+        const auto current = locality();
+        log::trace("locality of the particle data is {} (after the last sort: {})", current, _locality_after_sort);
+        return current > _hilbert_sort_locality_factor * _locality_after_sort;
+    }
+    return false;
+}
+
+scalar NeighborList::locality() const {
+    const auto &neighbors = _data.neighbors;
+    const auto nRows = neighbors.size();
+    const auto nThreads = _config.nThreads();
+    const auto grainSize = nRows / nThreads;
+    std::vector<scalar> distances(nThreads, 0);
+    std::vector<std::size_t> counts(nThreads, 0);
+    auto worker = [&neighbors, &distances, &counts](std::size_t, std::size_t chunk, std::size_t begin,
+                                                    std::size_t end) {
+        scalar distance = 0;
+        std::size_t count = 0;
+        for (auto row = begin; row < end; ++row) {
+            for (const std::size_t neighbor : neighbors.at(row)) {
+                distance += neighbor > row ? neighbor - row : row - neighbor;
+            }
+            count += neighbors.at(row).size();
+        }
+        distances[chunk] = distance;
+        counts[chunk] = count;
+    };
+    const auto &executor = *_config.executor();
+    std::vector<std::function<void(std::size_t)>> executables;
+    executables.reserve(nThreads);
+    for (std::size_t i = 0; i < nThreads - 1; ++i) {
+        executables.push_back(executor.pack(worker, i, i * grainSize, (i + 1) * grainSize));
+    }
+    executables.push_back(executor.pack(worker, nThreads - 1, (nThreads - 1) * grainSize, nRows));
+    executor.execute_and_wait(std::move(executables));
+
+    const auto nNeighbors = std::accumulate(counts.begin(), counts.end(), static_cast<std::size_t>(0));
+    if (nNeighbors == 0) return 0;
+    return std::accumulate(distances.begin(), distances.end(), static_cast<scalar>(0)) / nNeighbors;
+}
+
+std::size_t &NeighborList::hilbert_sort_interval() {
+    return _hilbert_sort_interval;
+}
+
+const std::size_t &NeighborList::hilbert_sort_interval() const {
+    return _hilbert_sort_interval;
+}
+
+scalar &NeighborList::hilbert_sort_locality_factor() {
+    return _hilbert_sort_locality_factor;
+}
+
+const scalar &NeighborList::hilbert_sort_locality_factor() const {
+    return _hilbert_sort_locality_factor;
 }
 
 void NeighborList::displace(data_t::iterator iter, const readdy::model::Vec3 &vec) {
-    _data.displace(*iter, vec);
+    _data.displace((*iter).index(), vec);
 }
 
-void NeighborList::displace(model::CPUParticleData::Entry &entry, const readdy::model::Vec3 &delta) {
-    _data.displace(entry, delta);
+void NeighborList::displace(const model::CPUParticleData::EntryRef &entry, const readdy::model::Vec3 &delta) {
+    _data.displace(entry.index(), delta);
 }
 
 void NeighborList::displace(model::CPUParticleData::index_t entry, const readdy::model::Vec3 &delta) {
-    _data.displace(_data.entry_at(entry), delta);
+    _data.displace(entry, delta);
 }
 
-NeighborList::iterator NeighborList::begin() {
-    return _data.neighbors.begin();
+NeighborList::const_iterator NeighborList::begin() const {
+    return _data.neighbors.cbegin();
 }
 
-NeighborList::iterator NeighborList::end() {
-    return _data.neighbors.end();
+NeighborList::const_iterator NeighborList::end() const {
+    return _data.neighbors.cend();
 }
 
 NeighborList::const_iterator NeighborList::cbegin() const {
@@ -267,32 +537,11 @@ NeighborList::const_iterator NeighborList::cend() const {
 }
 
 void NeighborList::updateData(data_t::update_t &&update) {
-    const auto& decayed_particles = std::get<1>(update);
-    for(const auto p_idx : decayed_particles) {
-        const auto sub_cell = _cell_container.leaf_cell_for_position(_data.pos(p_idx));
-        if (sub_cell) {
-            const auto& particles = sub_cell->particles();
-            if(particles.erase_if_found(p_idx)) {
-                sub_cell->super_cell()->set_dirty();
-            } else {
-                bool found = false;
-                for(const auto neighbor : sub_cell->neighbors()) {
-                    if(!found) {
-                        const auto& neighbor_particles = neighbor->particles();
-                        if(neighbor_particles.erase_if_found(p_idx)) {
-                            neighbor->super_cell()->set_dirty();
-                            found = true;
-                        }
-                    } else {
-                        break;
-                    }
-                }
-                if(!found) {
-                    log::critical("something went very very wrong");
-                }
-            }
-        }
+    if (std::get<0>(update).empty() && std::get<1>(update).empty()) {
+        // no particles appeared or disappeared, the neighbor list is still valid
+        return;
     }
+    _cell_container.remove_particles(std::get<1>(update));
 
     auto new_entries = _data.update(std::move(update));
 
@@ -304,24 +553,30 @@ void NeighborList::updateData(data_t::update_t &&update) {
 }
 
 void NeighborList::handle_dirty_cells() {
-    _cell_container.execute_for_each_sub_cell([this](const CellContainer::sub_cell &cell) {
+    _data.neighbors.resize_rows(_data.size());
+    std::atomic<bool> fits{true};
+    _cell_container.execute_for_each_sub_cell([this, &fits](const CellContainer::sub_cell &cell) {
         if (cell.is_dirty() || cell.neighbor_dirty() ) { // or neighbor? ||
             for (const auto &sub_cell : cell.sub_cells()) {
                 // no need to reset displacement as this is already happening in the dirty marking process
-                fill_cell_verlet_list(sub_cell, false);
+                if (!fill_cell_verlet_list(sub_cell, false)) {
+                    fits = false;
+                }
             }
         }
     });
     _cell_container.unset_dirty();
+    if (!fits.load()) {
+        // some rows grew beyond their capacity, lay out all rows anew
+        fill_verlet_list();
+    }
 }
 
-const static NeighborList::neighbors_t no_neighbors{};
-
-const NeighborList::neighbors_t &NeighborList::neighbors_of(const data_t::index_t entry) const {
+NeighborList::neighbors_t NeighborList::neighbors_of(const data_t::index_t entry) const {
     if (_max_cutoff > 0) {
         return _data.neighbors_at(entry);
     }
-    return no_neighbors;
+    return {nullptr, nullptr};
 }
 
 NeighborList::skin_size_t &NeighborList::skin() {
@@ -141,13 +141,9 @@ void SubCell::setup_uniform_neighbors(const std::uint8_t radius) {
     }
 }
 
-void SubCell::insert_particle(const CellContainer::particle_index index, bool mark_dirty) const {
-    _particles_list.add(index);
-    if(mark_dirty) set_dirty();
-}
-
 void SubCell::insert_particle(const CellContainer::particle_index index, bool mark_dirty) {
     _particles_list.add(index);
+    root()->set_leaf_of_particle(index, _first_leaf);
     if(mark_dirty) set_dirty();
 }
 
@@ -165,6 +161,10 @@ const ParticlesList &SubCell::particles() const {
     return _particles_list;
 }
 
+ParticlesList &SubCell::particles() {
+    return _particles_list;
+}
+
 ParticlesList::particle_indices SubCell::collect_contained_particles() const {
     if (!is_leaf()) {
         ParticlesList::particle_indices result;
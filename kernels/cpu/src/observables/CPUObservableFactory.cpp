@@ -68,8 +68,7 @@ CPUObservableFactory::createPositions(unsigned int stride, std::vector<std::stri
 readdy::model::observables::RadialDistribution *
 CPUObservableFactory::createRadialDistribution(unsigned int stride, std::vector<double> binBorders, std::vector<std::string> typeCountFrom,
                                                std::vector<std::string> typeCountTo, double particleToDensity) const {
-    return new readdy::kernel::scpu::observables::SCPURadialDistribution<CPUKernel>(kernel, stride, binBorders, typeCountFrom, typeCountTo,
-                                                                                               particleToDensity);
+    return new CPURadialDistribution(kernel, stride, binBorders, typeCountFrom, typeCountTo, particleToDensity);
 }
 
 readdy::model::observables::Particles *CPUObservableFactory::createParticles(unsigned int stride) const {
@@ -29,12 +29,18 @@
  * @date 27.10.16
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <future>
+#include <numeric>
 
 #include <readdy/common/thread/scoped_async.h>
 
 #include <readdy/kernel/cpu/observables/CPUObservables.h>
 #include <readdy/kernel/cpu/CPUKernel.h>
+#include <readdy/kernel/cpu/nl/CellContainer.h>
+#include <readdy/kernel/cpu/nl/SubCell.h>
 #include <readdy/kernel/cpu/util/config.h>
 
 namespace readdy {
@@ -73,7 +79,7 @@ CPUHistogramAlongAxis::CPUHistogramAlongAxis(CPUKernel *const kernel, unsigned i
 }
 
 void CPUHistogramAlongAxis::evaluate() {
-    using Iter = readdy::kernel::cpu::model::CPUParticleData::entries_t::const_iterator;
+    using Iter = readdy::kernel::cpu::model::CPUParticleData::const_iterator;
 
     std::fill(result.begin(), result.end(), 0);
 
@@ -138,6 +144,189 @@ void CPUHistogramAlongAxis::evaluate() {
 }
 
 
+CPURadialDistribution::CPURadialDistribution(CPUKernel *const kernel, unsigned int stride,
+                                             const std::vector<double> &binBorders,
+                                             const std::vector<std::string> &typeCountFrom,
+                                             const std::vector<std::string> &typeCountTo, double particleToDensity)
+        : readdy::model::observables::RadialDistribution(kernel, stride, binBorders, typeCountFrom, typeCountTo,
+                                                         particleToDensity), kernel(kernel) {
+    auto makeMask = [](const std::vector<unsigned int> &types) {
+        std::vector<char> mask;
+        for (const auto type : types) {
+            if (type >= mask.size()) mask.resize(type + 1, 0);
+            mask[type] = 1;
+        }
+        return mask;
+    };
+    fromMask = makeMask(this->typeCountFrom);
+    toMask = makeMask(this->typeCountTo);
+    if (this->binBorders.size() > 1) {
+        const auto &borders = this->binBorders;
+        binWidth = (borders.back() - borders.front()) / (borders.size() - 1);
+        uniformBins = binWidth > 0;
+        for (std::size_t i = 0; uniformBins && i + 1 < borders.size(); ++i) {
+            uniformBins = std::abs(borders[i + 1] - borders[i] - binWidth) <= 1e-10 * binWidth;
+        }
+    }
+}
+
+CPURadialDistribution::~CPURadialDistribution() = default;
+
+std::ptrdiff_t CPURadialDistribution::binIndex(const double dist) const {
+    if (dist < binBorders.front() || dist >= binBorders.back()) {
+        return -1;
+    }
+    if (uniformBins) {
+        const auto nBins = static_cast<std::ptrdiff_t>(counts.size());
+        auto idx = std::min(static_cast<std::ptrdiff_t>((dist - binBorders.front()) / binWidth), nBins - 1);
+        // the borders are equidistant only up to rounding errors
+        if (dist < binBorders[idx]) {
+            --idx;
+        } else if (dist >= binBorders[idx + 1]) {
+            ++idx;
+        }
+        return idx;
+    }
+    return std::upper_bound(binBorders.begin(), binBorders.end(), dist) - binBorders.begin() - 1;
+}
+
+void CPURadialDistribution::evaluate() {
+    if (binBorders.size() < 2) {
+        return;
+    }
+    using histogram_t = std::vector<double>;
+    std::fill(counts.begin(), counts.end(), 0);
+
+    auto &data = *kernel->getCPUKernelStateModel().getParticleData();
+    const auto &context = kernel->getKernelContext();
+    const auto &config = kernel->threadConfig();
+    const auto &executor = kernel->executor();
+    const auto nThreads = config.nThreads();
+    const auto &d2 = context.getDistSquaredFun();
+    const auto &fromMask = this->fromMask;
+    const auto &toMask = this->toMask;
+    auto isFrom = [&fromMask](particle_type_type type) { return type < fromMask.size() && fromMask[type]; };
+    auto isTo = [&toMask](particle_type_type type) { return type < toMask.size() && toMask[type]; };
+
+    const bool useCells = binBorders.back() > 0;
+    if (useCells) {
+        if (!cells || cellsBoxSize != context.getBoxSize() || cellsPeriodicity != context.getPeriodicBoundary()) {
+            cells = std::make_unique<nl::CellContainer>(data, context, config);
+            cells->update_root_size();
+            cells->subdivide(binBorders.back());
+            cells->refine_uniformly();
+            cells->setup_uniform_neighbors();
+            cellsBoxSize = context.getBoxSize();
+            cellsPeriodicity = context.getPeriodicBoundary();
+        } else {
+            cells->clear();
+        }
+    }
+
+    // sort the particles of interest into the cells and count the "from" particles
+    bool allInCells = true;
+    if (useCells) {
+        allInCells = cells->insert_particles([&](std::size_t i) {
+            const auto type = data.entry_at(i).type;
+            return isFrom(type) || isTo(type);
+        }) == 0;
+    }
+    std::vector<std::size_t> nFrom(nThreads, 0);
+    {
+        auto worker = [&](std::size_t, std::size_t chunk, std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                const auto &entry = data.entry_at(i);
+                if (!entry.is_deactivated() && isFrom(entry.type)) {
+                    ++nFrom[chunk];
+                }
+            }
+        };
+        const auto grainSize = data.size() / nThreads;
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nThreads);
+        for (std::size_t i = 0; i < nThreads - 1; ++i) {
+            executables.push_back(executor.pack(worker, i, i * grainSize, (i + 1) * grainSize));
+        }
+        executables.push_back(executor.pack(worker, nThreads - 1, (nThreads - 1) * grainSize, data.size()));
+        executor.execute_and_wait(std::move(executables));
+    }
+
+    std::vector<histogram_t> histograms(nThreads, histogram_t(counts.size(), 0));
+    auto binPair = [&](histogram_t &histogram, const model::CPUParticleData::ConstEntryRef &from,
+                       const model::CPUParticleData::ConstEntryRef &to) {
+        const auto bin = binIndex(std::sqrt(d2(from.position(), to.position())));
+        if (bin >= 0) {
+            ++histogram[bin];
+        }
+    };
+    if (useCells && allInCells) {
+        // only pairs within the same or neighboring cells can be closer than the largest bin border
+        const auto &superCells = cells->sub_cells();
+        auto worker = [&](std::size_t, std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto &histogram = histograms[chunk];
+            std::vector<const nl::SubCell *> candidateCells;
+            for (auto c = begin; c < end; ++c) {
+                for (const auto &cell : superCells[c].sub_cells()) {
+                    // in small, periodic boxes a cell can appear more than once among the neighbors
+                    candidateCells.assign(cell.neighbors().begin(), cell.neighbors().end());
+                    candidateCells.push_back(&cell);
+                    std::sort(candidateCells.begin(), candidateCells.end());
+                    candidateCells.erase(std::unique(candidateCells.begin(), candidateCells.end()),
+                                         candidateCells.end());
+                    for (const auto pFrom : cell.particles().data()) {
+                        const auto &from = data.entry_at(pFrom);
+                        if (!isFrom(from.type)) continue;
+                        for (const auto other : candidateCells) {
+                            for (const auto pTo : other->particles().data()) {
+                                const auto &to = data.entry_at(pTo);
+                                if (pTo != pFrom && isTo(to.type)) {
+                                    binPair(histogram, from, to);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        };
+        const auto grainSize = superCells.size() / nThreads;
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nThreads);
+        for (std::size_t i = 0; i < nThreads - 1; ++i) {
+            executables.push_back(executor.pack(worker, i, i * grainSize, (i + 1) * grainSize));
+        }
+        executables.push_back(executor.pack(worker, nThreads - 1, (nThreads - 1) * grainSize, superCells.size()));
+        executor.execute_and_wait(std::move(executables));
+    } else if (useCells) {
+        // some particles are outside of the box, fall back to looking at all pairs
+        auto worker = [&](std::size_t, std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto &histogram = histograms[chunk];
+            for (auto i = begin; i < end; ++i) {
+                const auto &from = data.entry_at(i);
+                if (from.is_deactivated() || !isFrom(from.type)) continue;
+                for (std::size_t j = 0; j < data.size(); ++j) {
+                    const auto &to = data.entry_at(j);
+                    if (i != j && !to.is_deactivated() && isTo(to.type)) {
+                        binPair(histogram, from, to);
+                    }
+                }
+            }
+        };
+        const auto grainSize = data.size() / nThreads;
+        std::vector<std::function<void(std::size_t)>> executables;
+        executables.reserve(nThreads);
+        for (std::size_t i = 0; i < nThreads - 1; ++i) {
+            executables.push_back(executor.pack(worker, i, i * grainSize, (i + 1) * grainSize));
+        }
+        executables.push_back(executor.pack(worker, nThreads - 1, (nThreads - 1) * grainSize, data.size()));
+        executor.execute_and_wait(std::move(executables));
+    }
+
+    for (const auto &histogram : histograms) {
+        std::transform(counts.begin(), counts.end(), histogram.begin(), counts.begin(), std::plus<double>());
+    }
+    normalizeCounts(std::accumulate(nFrom.begin(), nFrom.end(), static_cast<std::size_t>(0)));
+}
+
 CPUNParticles::CPUNParticles(CPUKernel *const kernel, unsigned int stride, std::vector<std::string> typesToCount)
         : readdy::model::observables::NParticles(kernel, stride, typesToCount),
           kernel(kernel) {}
@@ -33,6 +33,8 @@
 #include <readdy/plugin/KernelProvider.h>
 #include <readdy/model/actions/Actions.h>
 #include <readdy/model/RandomProvider.h>
+#include <readdy/model/potentials/PotentialsOrder2.h>
+#include <readdy/kernel/cpu/CPUKernel.h>
 
 namespace {
 
@@ -76,4 +78,114 @@ TEST(CPUTestKernel, TestKernelLoad) {
 
     connection.disconnect();
 }
-}
\ No newline at end of file
+
+TEST(CPUTestKernel, ForcesAgreeWithBruteForce) {
+    using vec_t = readdy::model::Vec3;
+    auto kernel = readdy::plugin::KernelProvider::getInstance().create("CPU");
+    auto &ctx = kernel->getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    ctx.setPeriodicBoundary(true, true, false);
+    ctx.particle_types().add("A", 1., .5);
+    ctx.particle_types().add("B", 1., .7);
+    kernel->registerPotential<readdy::model::potentials::HarmonicRepulsion>("A", "A", 10.);
+    kernel->registerPotential<readdy::model::potentials::HarmonicRepulsion>("A", "B", 5.);
+    kernel->registerPotential<readdy::model::potentials::WeakInteractionPiecewiseHarmonic>(
+            "B", "B", 10., readdy::model::potentials::WeakInteractionPiecewiseHarmonic::Configuration(1., 2., 1.5));
+    kernel->registerPotential<readdy::model::potentials::Cube>("A", 1., vec_t{-5, -5, -5}, vec_t{10, 10, 10}, true);
+
+    readdy::model::rnd::seed(7);
+    std::vector<readdy::model::Particle> particles;
+    for (int i = 0; i < 1000; ++i) {
+        const vec_t pos{readdy::model::rnd::uniform_real(-5., 5.), readdy::model::rnd::uniform_real(-5., 5.),
+                        readdy::model::rnd::uniform_real(-4.9, 4.9)};
+        particles.emplace_back(pos, ctx.particle_types().id_of(i % 2 == 0 ? "A" : "B"));
+    }
+    kernel->getKernelStateModel().addParticles(particles);
+    ctx.configure();
+    kernel->createAction<readdy::model::actions::UpdateNeighborList>()->perform();
+    kernel->createAction<readdy::model::actions::CalculateForces>()->perform();
+
+    const auto &data = *dynamic_cast<readdy::kernel::cpu::CPUKernel *>(kernel.get())
+            ->getCPUKernelStateModel().getParticleData();
+    const auto &d = ctx.getShortestDifferenceFun();
+    std::vector<vec_t> forces(data.size(), {0, 0, 0});
+    double energy = 0;
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        const auto &entry_i = data.entry_at(i);
+        for (const auto potential : ctx.potentials().potentials_of(entry_i.type)) {
+            potential->calculateForceAndEnergy(forces[i], energy, entry_i.position());
+        }
+        for (std::size_t j = i + 1; j < data.size(); ++j) {
+            const auto &entry_j = data.entry_at(j);
+            const auto x_ij = d(entry_i.position(), entry_j.position());
+            for (const auto potential : ctx.potentials().potentials_of(entry_i.type, entry_j.type)) {
+                if (x_ij * x_ij < potential->getCutoffRadiusSquared()) {
+                    vec_t f{0, 0, 0};
+                    potential->calculateForceAndEnergy(f, energy, x_ij);
+                    forces[i] += f;
+                    forces[j] -= f;
+                }
+            }
+        }
+    }
+    EXPECT_NEAR(kernel->getKernelStateModel().getEnergy(), energy, 1e-8 * std::max(1., std::abs(energy)));
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        for (auto dim = 0; dim < 3; ++dim) {
+            EXPECT_NEAR(data.entry_at(i).force[dim], forces[i][dim], 1e-8 * std::max(1., std::abs(forces[i][dim])));
+        }
+    }
+}
+
+TEST(CPUTestKernel, StructureOfArraysLayoutAgreesWithArrayOfStructures) {
+    using vec_t = readdy::model::Vec3;
+    using layout_t = readdy::kernel::cpu::model::CPUParticleData::Layout;
+    auto simulate = [](layout_t layout) {
+        auto kernel = std::make_unique<readdy::kernel::cpu::CPUKernel>(layout);
+        kernel->setNThreads(1);
+        auto &ctx = kernel->getKernelContext();
+        ctx.setBoxSize(8, 8, 8);
+        ctx.setPeriodicBoundary(true, true, false);
+        ctx.particle_types().add("A", 1., .5);
+        ctx.particle_types().add("B", .5, .7);
+        kernel->registerPotential<readdy::model::potentials::HarmonicRepulsion>("A", "A", 10.);
+        kernel->registerPotential<readdy::model::potentials::HarmonicRepulsion>("A", "B", 5.);
+        kernel->registerPotential<readdy::model::potentials::Cube>("B", 1., vec_t{-4, -4, -4}, vec_t{8, 8, 8}, true);
+        kernel->registerReaction<readdy::model::reactions::Fusion>("A+A->B", "A", "A", "B", .5, .6);
+        kernel->registerReaction<readdy::model::reactions::Fission>("B->A+A", "B", "A", "A", .1, .6);
+
+        readdy::model::rnd::seed(11);
+        std::vector<readdy::model::Particle> particles;
+        for (int i = 0; i < 300; ++i) {
+            const vec_t pos{readdy::model::rnd::uniform_real(-4., 4.), readdy::model::rnd::uniform_real(-4., 4.),
+                            readdy::model::rnd::uniform_real(-3.9, 3.9)};
+            particles.emplace_back(pos, ctx.particle_types().id_of(i % 3 == 0 ? "B" : "A"));
+        }
+        kernel->getKernelStateModel().addParticles(particles);
+        ctx.configure();
+
+        auto &&integrator = kernel->createAction<readdy::model::actions::EulerBDIntegrator>(.01);
+        auto &&neighborList = kernel->createAction<readdy::model::actions::UpdateNeighborList>();
+        auto &&forces = kernel->createAction<readdy::model::actions::CalculateForces>();
+        auto &&reactions = kernel->createAction<readdy::model::actions::reactions::UncontrolledApproximation>(.01);
+        neighborList->perform();
+        forces->perform();
+        for (int t = 0; t < 50; ++t) {
+            integrator->perform();
+            neighborList->perform();
+            reactions->perform();
+            neighborList->perform();
+            forces->perform();
+        }
+        return std::make_pair(kernel->getKernelStateModel().getParticles(), kernel->getKernelStateModel().getEnergy());
+    };
+
+    const auto aos = simulate(layout_t::aos);
+    const auto soa = simulate(layout_t::soa);
+    EXPECT_EQ(aos.second, soa.second);
+    ASSERT_EQ(aos.first.size(), soa.first.size());
+    for (std::size_t i = 0; i < aos.first.size(); ++i) {
+        EXPECT_EQ(aos.first[i].getType(), soa.first[i].getType());
+        EXPECT_EQ(aos.first[i].getPos(), soa.first[i].getPos());
+    }
+}
+}
@@ -33,6 +33,8 @@
  */
 
 #include <cmath>
+#include <set>
+#include <unordered_map>
 
 #include <gtest/gtest.h>
 #include <readdy/api/SimulationScheme.h>
@@ -91,7 +93,7 @@ auto isIdPairInList = [](nl_t *pairs, data_t &data, std::size_t id1, std::size_t
 
 auto getNumberPairs = [](nl_t &pairs) {
     using val_t = decltype(*pairs.begin());
-    return std::accumulate(pairs.begin(), pairs.end(), 0, [](int acc, val_t &x) {
+    return std::accumulate(pairs.begin(), pairs.end(), 0, [](int acc, const val_t &x) {
         return acc + x.size();
     });
 };
@@ -429,6 +431,74 @@ TEST(TestAdaptiveNeighborList, SetUpNeighborList) {
     }
 }
 
+TEST(TestAdaptiveNeighborList, CellListConsistency) {
+    using namespace readdy;
+    auto kernel = std::make_unique<kernel::cpu::CPUKernel>();
+    auto &context = kernel->getKernelContext();
+    context.setBoxSize(20, 20, 20);
+    context.setPeriodicBoundary(true, true, true);
+    context.particle_types().add("A", 1., 1.);
+    kernel->registerReaction<readdy::model::reactions::Fusion>("test", "A", "A", "A", .1, 1.);
+    context.configure(false);
+    kernel->setNThreads(4);
+    auto &data = *kernel->getCPUKernelStateModel().getParticleData();
+    for (int i = 0; i < 3000; ++i) {
+        data.addParticle({model::rnd::uniform_real(-10., 10.), model::rnd::uniform_real(-10., 10.),
+                          model::rnd::uniform_real(-10., 10.), context.particle_types().id_of("A")});
+    }
+    kernel::cpu::nl::NeighborList neighbor_list{data, context, kernel->threadConfig(), true, .3, false};
+    neighbor_list.set_up();
+    const auto &cells = neighbor_list.cell_container();
+
+    // every active particle is contained in exactly the leaf that is recorded for it
+    auto check = [&](bool sorted) {
+        std::vector<int> occurrences(data.size(), 0);
+        for (std::size_t l = 0; l < cells.leaves().size(); ++l) {
+            const auto &particles = cells.leaves()[l]->particles().data();
+            if (sorted) {
+                EXPECT_TRUE(std::is_sorted(particles.begin(), particles.end()));
+            }
+            for (const auto p : particles) {
+                ++occurrences.at(p);
+                EXPECT_EQ(cells.leaf_of_particle(p), l);
+            }
+        }
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            EXPECT_EQ(occurrences[i], data.entry_at(i).is_deactivated() ? 0 : 1) << "particle " << i;
+        }
+    };
+    // after a complete rebuild, the leaves are sorted by particle index
+    check(true);
+    {
+        std::size_t nParticles = 0;
+        for (const auto leaf : cells.leaves()) {
+            EXPECT_EQ(leaf->n_leaves(), 1);
+            nParticles += leaf->particles().data().size();
+        }
+        EXPECT_EQ(nParticles, data.size());
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            EXPECT_EQ(cells.leaves()[cells.leaf_of_particle(i)], cells.leaf_cell_for_position(data.pos(i)));
+        }
+    }
+
+    // few particles move, so that only some cells are dirty and the particles are moved between the leaves
+    for (int t = 0; t < 10; ++t) {
+        for (std::size_t i = t; i < data.size(); i += 50) {
+            neighbor_list.displace(i, {model::rnd::normal3<>(0, .2)});
+        }
+        neighbor_list.update();
+        EXPECT_LT(cells.n_dirty_macro_cells(), cells.n_sub_cells_total());
+        check(false);
+    }
+
+    readdy::kernel::cpu::model::CPUParticleData::update_t update;
+    for (std::size_t i = 0; i < data.size(); i += 7) {
+        std::get<1>(update).push_back(i);
+    }
+    neighbor_list.updateData(std::move(update));
+    check(false);
+}
+
 TEST(TestAdaptiveNeighborList, HilbertSort) {
     using namespace readdy;
 
@@ -540,6 +610,58 @@ TEST(TestAdaptiveNeighborList, VerletList) {
     }
 }
 
+TEST(TestAdaptiveNeighborList, RowsOutgrowingTheirCapacity) {
+    using namespace readdy;
+
+    std::unique_ptr<kernel::cpu::CPUKernel> kernel = std::make_unique<kernel::cpu::CPUKernel>();
+    auto &context = kernel->getKernelContext();
+    context.setBoxSize(10, 10, 10);
+    context.setPeriodicBoundary(true, true, true);
+    context.particle_types().add("A", 1.0, 1.0);
+    const auto cutoff = 1.;
+    for (int i = 0; i < 100; ++i) {
+        kernel->addParticle("A", {model::rnd::uniform_real(-5., 5.),
+                                  model::rnd::uniform_real(-5., 5.),
+                                  model::rnd::uniform_real(-5., 5.)});
+    }
+    kernel->registerReaction<readdy::model::reactions::Fusion>("test", "A", "A", "A", .1, cutoff);
+    context.configure(false);
+    const auto &d2 = context.getDistSquaredFun();
+    const auto typeA = context.particle_types().id_of("A");
+    auto &data = *kernel->getCPUKernelStateModel().getParticleData();
+    kernel::cpu::nl::NeighborList neighbor_list{data, context, kernel->threadConfig(), true, .1};
+    neighbor_list.set_up();
+
+    // crowd the vicinity of the first particle, its row and the rows of the new particles have to be relocated
+    data_t::update_t update;
+    for (int i = 0; i < 30; ++i) {
+        model::Vec3 pos = data.pos(0) + model::Vec3(model::rnd::uniform_real(-.5, .5),
+                                                    model::rnd::uniform_real(-.5, .5),
+                                                    model::rnd::uniform_real(-.5, .5));
+        context.getFixPositionFun()(pos);
+        std::get<0>(update).emplace_back(model::Particle(pos, typeA));
+    }
+    neighbor_list.updateData(std::move(update));
+    ASSERT_EQ(data.size(), 130);
+    EXPECT_GE(neighbor_list.neighbors_of(0).size(), 30);
+
+    std::size_t i = 0;
+    for (const auto &entry_i : data) {
+        std::size_t j = 0;
+        for (const auto &entry_j : data) {
+            if (!entry_i.is_deactivated() && !entry_j.is_deactivated() && i != j) {
+                if (d2(entry_i.position(), entry_j.position()) < cutoff * cutoff) {
+                    const auto &neighbors = neighbor_list.neighbors_of(i);
+                    ASSERT_TRUE(std::find(neighbors.begin(), neighbors.end(), j) != neighbors.end())
+                                                << i << " and " << j << " should be neighbors";
+                }
+            }
+            ++j;
+        }
+        ++i;
+    }
+}
+
 TEST(TestAdaptiveNeighborList, AdaptiveUpdating) {
     using namespace readdy;
     
@@ -557,7 +679,8 @@ TEST(TestAdaptiveNeighborList, AdaptiveUpdating) {
                                   model::rnd::uniform_real(-14., 14.),
                                   model::rnd::uniform_real(-14., 14.)});
     }
-    kernel->registerReaction<readdy::model::reactions::Fusion>("test", "V", "V", "V", cutoff, cutoff);
+    // only pairs of types that interact are stored in the neighbor list
+    kernel->registerReaction<readdy::model::reactions::Fusion>("test", "A", "A", "A", cutoff, cutoff);
     context.configure(false);
     const auto &d2 = context.getDistSquaredFun();
     auto &data = *kernel->getCPUKernelStateModel().getParticleData();
@@ -615,6 +738,157 @@ TEST(TestAdaptiveNeighborList, AdaptiveUpdating) {
 }
 
 
+TEST(TestAdaptiveNeighborList, HilbertResorting) {
+    using namespace readdy;
+
+    std::unique_ptr<kernel::cpu::CPUKernel> kernel = std::make_unique<kernel::cpu::CPUKernel>();
+    auto &context = kernel->getKernelContext();
+    context.setBoxSize(10, 10, 10);
+    context.setPeriodicBoundary(true, true, true);
+    context.particle_types().add("A", .01, 1.0);
+    const auto cutoff = 1.;
+    for (int i = 0; i < 200; ++i) {
+        kernel->addParticle("A", {model::rnd::uniform_real(-5., 5.),
+                                  model::rnd::uniform_real(-5., 5.),
+                                  model::rnd::uniform_real(-5., 5.)});
+    }
+    kernel->registerReaction<readdy::model::reactions::Fusion>("test", "A", "A", "A", .1, cutoff);
+    context.configure(false);
+    const auto &d2 = context.getDistSquaredFun();
+    auto &data = *kernel->getCPUKernelStateModel().getParticleData();
+    kernel::cpu::nl::NeighborList neighbor_list{data, context, kernel->threadConfig(), true, .1};
+    neighbor_list.hilbert_sort_interval() = 3;
+    neighbor_list.set_up();
+
+    std::size_t nReorders = 0;
+    auto connection = data.registerReorderEventListener([&nReorders](const std::vector<std::size_t> &) {
+        ++nReorders;
+    });
+
+    auto integrator = kernel->createAction<readdy::model::actions::EulerBDIntegrator>(.01);
+    for (int t = 0; t < 10; ++t) {
+        integrator->perform();
+        std::unordered_map<model::Particle::id_type, model::Vec3> positions;
+        for (const auto &entry : data) {
+            positions[entry.id] = entry.position();
+        }
+        neighbor_list.update();
+        for (const auto &p : positions) {
+            EXPECT_EQ(data.pos(data.getIndexForId(p.first)), p.second);
+        }
+        std::size_t i = 0;
+        for (const auto &entry_i : data) {
+            std::size_t j = 0;
+            for (const auto &entry_j : data) {
+                if (i != j && d2(entry_i.position(), entry_j.position()) < cutoff * cutoff) {
+                    const auto &neighbors = neighbor_list.neighbors_of(i);
+                    ASSERT_TRUE(std::find(neighbors.begin(), neighbors.end(), j) != neighbors.end())
+                                                << i << " and " << j << " should be neighbors";
+                }
+                ++j;
+            }
+            ++i;
+        }
+    }
+    // re-sorted after updates 3, 6 and 9, possibly more often if the whole list had to be rebuilt anyways
+    EXPECT_GE(nReorders, 3);
+}
+
+TEST(TestAdaptiveNeighborList, PairCutoffs) {
+    auto kernel = std::make_unique<readdy::kernel::cpu::CPUKernel>();
+    auto &ctx = kernel->getKernelContext();
+    ctx.particle_types().add("A", 1., 1.);
+    ctx.particle_types().add("B", 1., 1.);
+    ctx.particle_types().add("C", 1., 1.);
+    ctx.setBoxSize(20, 20, 20);
+    ctx.setPeriodicBoundary(true, true, true);
+    // A interacts with A on a short range, the rare species B reacts with B on a long range, C is inert
+    ctx.potentials().add(std::make_unique<readdy::testing::NOOPPotentialOrder2>("A", "A", 1., 0., 0.));
+    kernel->registerReaction<readdy::model::reactions::Fusion>("B+B->B", "B", "B", "B", .1, 4.);
+    ctx.configure();
+    const auto typeA = ctx.particle_types().id_of("A");
+    const auto typeB = ctx.particle_types().id_of("B");
+    const auto typeC = ctx.particle_types().id_of("C");
+
+    std::vector<m::Particle> particles;
+    for (std::size_t i = 0; i < 600; ++i) {
+        const auto type = i % 3 == 0 ? typeA : (i % 3 == 1 ? typeB : typeC);
+        particles.emplace_back(readdy::model::rnd::uniform_real(-10., 10.),
+                               readdy::model::rnd::uniform_real(-10., 10.),
+                               readdy::model::rnd::uniform_real(-10., 10.), type);
+    }
+    data_t data {&ctx, kernel->threadConfig()};
+    data.addParticles(particles);
+    const readdy::scalar skin = .2;
+    nl_t list(data, ctx, kernel->threadConfig(), true, skin);
+    list.set_up();
+
+    EXPECT_DOUBLE_EQ(list.pair_cutoff(typeA, typeA), 1.);
+    EXPECT_DOUBLE_EQ(list.pair_cutoff(typeB, typeB), 4.);
+    EXPECT_DOUBLE_EQ(list.pair_cutoff(typeA, typeB), 0.);
+    EXPECT_DOUBLE_EQ(list.pair_cutoff(typeC, typeC), 0.);
+
+    const auto d2 = ctx.getDistSquaredFun();
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        const auto neighbors = list.neighbors_of(i);
+        for (std::size_t j = 0; j < data.size(); ++j) {
+            if (i == j) continue;
+            const auto &entry_i = data.entry_at(i);
+            const auto &entry_j = data.entry_at(j);
+            const auto cutoff = list.pair_cutoff(entry_i.type, entry_j.type);
+            const auto inList = std::find(neighbors.begin(), neighbors.end(), j) != neighbors.end();
+            const auto distSquared = d2(entry_i.position(), entry_j.position());
+            if (cutoff == 0) {
+                EXPECT_FALSE(inList) << "types " << entry_i.type << " and " << entry_j.type << " do not interact";
+            } else {
+                EXPECT_EQ(inList, distSquared < (cutoff + skin) * (cutoff + skin)) << "particles " << i << ", " << j;
+            }
+        }
+    }
+}
+
+TEST(TestAdaptiveNeighborList, ConversionEnablesPairReaction) {
+    using conversion_t = readdy::model::reactions::Conversion;
+    using fusion_t = readdy::model::reactions::Fusion;
+    auto kernel = std::make_unique<readdy::kernel::cpu::CPUKernel>();
+    auto &ctx = kernel->getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    ctx.setPeriodicBoundary(true, true, true);
+    ctx.particle_types().add("A", 0., 1.);
+    ctx.particle_types().add("B", 0., 1.);
+    ctx.particle_types().add("C", 0., 1.);
+    ctx.particle_types().add("D", 0., 1.);
+    // A and C neither interact nor react, but A turns into B, which fuses with C
+    kernel->registerReaction<conversion_t>("A->B", "A", "B", 1e3);
+    kernel->registerReaction<fusion_t>("B+C->D", "B", "C", "D", 1e3, 1.);
+    kernel->addParticle("A", {0, 0, 0});
+    kernel->addParticle("C", {.5, 0, 0});
+    ctx.configure();
+    const auto typeB = ctx.particle_types().id_of("B");
+    const auto typeC = ctx.particle_types().id_of("C");
+    const auto typeD = ctx.particle_types().id_of("D");
+
+    using update_nl_t = readdy::model::actions::UpdateNeighborList;
+    auto &&neighborList = kernel->createAction<update_nl_t>(update_nl_t::Operation::create, .5);
+    auto &&reactions = kernel->createAction<readdy::model::actions::reactions::UncontrolledApproximation>(1);
+    neighborList->perform();
+    reactions->perform();
+    {
+        const auto particles = kernel->getKernelStateModel().getParticles();
+        ASSERT_EQ(particles.size(), 2);
+        std::multiset<readdy::particle_type_type> types{particles[0].getType(), particles[1].getType()};
+        EXPECT_EQ(types, (std::multiset<readdy::particle_type_type>{typeB, typeC}));
+    }
+    // the types changed in place, the adaptive update does not rebuild any cell
+    neighborList->perform();
+    reactions->perform();
+    {
+        const auto particles = kernel->getKernelStateModel().getParticles();
+        ASSERT_EQ(particles.size(), 1);
+        EXPECT_EQ(particles[0].getType(), typeD);
+    }
+}
+
 TEST(TestAdaptiveNeighborList, DiffusionAndReaction) {
     using namespace readdy;
     std::unique_ptr<kernel::cpu::CPUKernel> kernel = std::make_unique<kernel::cpu::CPUKernel>();
@@ -663,8 +937,11 @@ TEST(TestAdaptiveNeighborList, Diffusion) {
     context.particle_types().add("A", 0.05, 1.0);
     context.particle_types().add("F", 0.0, 1.0);
     context.particle_types().add("V", 0.0, 1.0);
-    // just to have a cutoff
+    // just to have a cutoff, only pairs of types that interact are stored in the neighbor list
     kernel->registerReaction<readdy::model::reactions::Fusion>("test", "V", "V", "V", .1, 2.0);
+    context.potentials().add(std::make_unique<readdy::testing::NOOPPotentialOrder2>("A", "A", 2.0, 0., 0.));
+    context.potentials().add(std::make_unique<readdy::testing::NOOPPotentialOrder2>("A", "F", 2.0, 0., 0.));
+    context.potentials().add(std::make_unique<readdy::testing::NOOPPotentialOrder2>("F", "F", 2.0, 0., 0.));
     context.setPeriodicBoundary(true, true, true);
     context.setBoxSize(100, 10, 10);
 
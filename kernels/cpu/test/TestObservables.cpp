@@ -0,0 +1,82 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * @file TestObservables.cpp
+ * @brief Tests for the observables of the CPU kernel that have a specialized implementation
+ * @author clonker
+ * @date 18.10.17
+ */
+
+#include <gtest/gtest.h>
+#include <readdy/kernel/cpu/CPUKernel.h>
+#include <readdy/kernel/cpu/observables/CPUObservables.h>
+#include <readdy/kernel/singlecpu/observables/SCPUObservables.h>
+
+namespace {
+
+namespace cpu = readdy::kernel::cpu;
+
+void compareRadialDistributions(cpu::CPUKernel *kernel, const std::vector<double> &binBorders) {
+    cpu::observables::CPURadialDistribution rdf(kernel, 1, binBorders, {"A"}, {"A", "B"}, 1.5);
+    readdy::kernel::scpu::observables::SCPURadialDistribution<cpu::CPUKernel> reference(kernel, 1, binBorders, {"A"},
+                                                                                       {"A", "B"}, 1.5);
+    rdf.evaluate();
+    reference.evaluate();
+    const auto &result = rdf.getResult();
+    const auto &expected = reference.getResult();
+    ASSERT_EQ(std::get<0>(result), std::get<0>(expected));
+    ASSERT_EQ(std::get<1>(result).size(), std::get<1>(expected).size());
+    for (std::size_t i = 0; i < std::get<1>(result).size(); ++i) {
+        EXPECT_DOUBLE_EQ(std::get<1>(result)[i], std::get<1>(expected)[i]) << "bin " << i;
+    }
+}
+
+TEST(TestObservables, RadialDistributionAgreesWithAllPairs) {
+    for (const auto &pbc : std::vector<std::array<bool, 3>>{{{true, true, true}}, {{true, false, true}}}) {
+        auto kernel = std::make_unique<cpu::CPUKernel>();
+        auto &context = kernel->getKernelContext();
+        context.setBoxSize(12, 8, 10);
+        context.setPeriodicBoundary(pbc[0], pbc[1], pbc[2]);
+        context.particle_types().add("A", 1., 1.);
+        context.particle_types().add("B", 1., 1.);
+        context.particle_types().add("C", 1., 1.);
+        for (const auto &type : {"A", "B", "C"}) {
+            for (int i = 0; i < 300; ++i) {
+                kernel->addParticle(type, {readdy::model::rnd::uniform_real(-6., 6.),
+                                           readdy::model::rnd::uniform_real(-4., 4.),
+                                           readdy::model::rnd::uniform_real(-5., 5.)});
+            }
+        }
+        context.configure(false);
+
+        std::vector<double> uniform;
+        for (int i = 0; i <= 20; ++i) uniform.push_back(.1 * i);
+        compareRadialDistributions(kernel.get(), uniform);
+        compareRadialDistributions(kernel.get(), {.5, .7, 1., 1.8, 2.5, 3.2});
+        // larger than half the box
+        compareRadialDistributions(kernel.get(), {0., 2., 4., 7.});
+    }
+}
+
+}
@@ -31,6 +31,7 @@
 
 #include <readdy/common/logging.h>
 #include <readdy/kernel/cpu/model/CPUParticleData.h>
+#include <readdy/model/RandomProvider.h>
 #include "gtest/gtest.h"
 
 namespace {
@@ -39,4 +40,74 @@ namespace {
         readdy::kernel::cpu::model::CPUParticleData::Entry entry {p};
         EXPECT_EQ(72, sizeof(entry)) << "an entry should have exactly 72 bytes";
     }
-}
\ No newline at end of file
+
+    TEST(TestParticleData, StructureOfArraysColumnsAreAligned) {
+        using data_t = readdy::kernel::cpu::model::CPUParticleData;
+        readdy::model::KernelContext ctx;
+        readdy::util::thread::Config config;
+        data_t data {&ctx, config, data_t::Layout::soa};
+        EXPECT_EQ(data_t::Layout::soa, data.layout());
+        EXPECT_THROW(data.aos_view(), std::logic_error);
+        for (int i = 0; i < 17; ++i) {
+            data.addParticle({static_cast<double>(i), 0, 0, 0});
+        }
+        const auto view = data.soa_view();
+        for (const void *column : {static_cast<const void *>(view.x), static_cast<const void *>(view.y),
+                                   static_cast<const void *>(view.z), static_cast<const void *>(view.forces),
+                                   static_cast<const void *>(view.types),
+                                   static_cast<const void *>(view.deactivated)}) {
+            EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(column) % 64);
+        }
+        EXPECT_EQ(5., view.x[5]);
+        EXPECT_THROW(data.entry_at(17), std::out_of_range);
+    }
+
+    TEST(TestParticleData, StructureOfArraysAgreesWithArrayOfStructures) {
+        using data_t = readdy::kernel::cpu::model::CPUParticleData;
+        readdy::model::KernelContext ctx;
+        ctx.setBoxSize(10, 10, 10);
+        ctx.particle_types().add("A", 1., 1.);
+        ctx.particle_types().add("B", 1., 1.);
+        ctx.configure();
+        readdy::util::thread::Config config;
+        data_t aos {&ctx, config, data_t::Layout::aos};
+        data_t soa {&ctx, config, data_t::Layout::soa};
+
+        std::vector<readdy::model::Particle> particles;
+        for (int i = 0; i < 100; ++i) {
+            const readdy::model::Vec3 pos{readdy::model::rnd::uniform_real(-5., 5.), readdy::model::rnd::uniform_real(-5., 5.),
+                                          readdy::model::rnd::uniform_real(-5., 5.)};
+            particles.emplace_back(pos, i % 2);
+        }
+        const std::vector<readdy::model::Particle> newParticles{{1, 2, 3, 1}, {-1, -2, -3, 0}};
+        for (auto data : {&aos, &soa}) {
+            data->addParticles(particles);
+            data->removeParticle(particles[3]);
+            data->removeParticle(10);
+            data->removeParticle(42);
+            data_t::entries_update_t newEntries;
+            newEntries.emplace_back(newParticles[0]);
+            newEntries.emplace_back(newParticles[1]);
+            data->update(std::make_pair(std::move(newEntries), std::vector<data_t::index_t>{7, 8}));
+            data->displace(5, {.5, .5, .5});
+            data->entry_at(6).force = {1, 2, 3};
+            data->hilbert_sort(1.);
+        }
+
+        ASSERT_EQ(aos.size(), soa.size());
+        EXPECT_EQ(aos.getNDeactivated(), soa.getNDeactivated());
+        for (data_t::index_t i = 0; i < aos.size(); ++i) {
+            const auto a = aos.centry_at(i);
+            const auto b = soa.centry_at(i);
+            ASSERT_EQ(a.is_deactivated(), b.is_deactivated());
+            if (!a.is_deactivated()) {
+                EXPECT_EQ(a.position(), b.position());
+                EXPECT_EQ(a.type, b.type);
+                EXPECT_EQ(a.id, b.id);
+                EXPECT_EQ(a.force, b.force);
+                EXPECT_EQ(a.displacement, b.displacement);
+                EXPECT_EQ(i, soa.getIndexForId(b.id));
+            }
+        }
+    }
+}
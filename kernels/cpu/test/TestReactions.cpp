@@ -297,6 +297,8 @@ TEST(CPUTestReactions, TestGillespieParallel) {
         );
         neighborList->perform();
         reactions->perform();
+        // the particles at the boundary of the boxes are handled serially
+        EXPECT_GT(kernel->performance().counters().at("reactions.conflicts"), 0);
         EXPECT_EQ(1.0, reactions->getMaxReactionRadius());
         EXPECT_EQ(15.0, reactions->getBoxWidth());
         EXPECT_EQ(2, reactions->getLongestAxis());
@@ -368,3 +370,247 @@ TEST(TestNextSubvolumes, ReactionRadii) {
     kernel->getKernelContext().configure();
     EXPECT_EQ(7.0, nextSubvolumes->getMaxReactionRadius()) << "max(5.0, 6.0, 7.0) = 7.0";
 }
+
+TEST(TestNextSubvolumes, PairsWithinReactionRadius) {
+    using fusion_t = readdy::model::reactions::Fusion;
+    auto kernel = std::make_unique<readdy::kernel::cpu::CPUKernel>();
+    auto &ctx = kernel->getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    ctx.setPeriodicBoundary(true, true, false);
+    ctx.particle_types().add("A", .1, 1.);
+    ctx.particle_types().add("B", .1, 1.);
+    ctx.particle_types().add("C", .1, 1.);
+    kernel->registerReaction<fusion_t>("A+B->C", "A", "B", "C", 1e3, 1.);
+    const auto typeA = ctx.particle_types().id_of("A");
+    const auto typeB = ctx.particle_types().id_of("B");
+    const auto typeC = ctx.particle_types().id_of("C");
+    // a pair across the periodic boundary, a pair in neighboring cells, and a pair that is too far apart
+    kernel->getKernelStateModel().addParticle({-4.8, 0, 0, typeA});
+    kernel->getKernelStateModel().addParticle({4.8, 0, 0, typeB});
+    kernel->getKernelStateModel().addParticle({0, 2.6, 0, typeA});
+    kernel->getKernelStateModel().addParticle({0, 3.3, 0, typeB});
+    kernel->getKernelStateModel().addParticle({0, 0, -4.9, typeA});
+    kernel->getKernelStateModel().addParticle({0, 0, 4.9, typeB});
+    ctx.configure();
+
+    auto &&neighborList = kernel->createAction<readdy::model::actions::UpdateNeighborList>();
+    auto &&reactions = readdy::util::static_unique_ptr_cast<readdy::kernel::cpu::actions::reactions::CPUNextSubvolumes>(
+            kernel->createAction<readdy::model::actions::reactions::NextSubvolumes>(1)
+    );
+    neighborList->perform();
+    reactions->perform();
+    EXPECT_EQ(10, reactions->getNCells()[0]);
+    const auto particles = kernel->getKernelStateModel().getParticles();
+    EXPECT_EQ(4, particles.size());
+    EXPECT_EQ(2, std::count_if(particles.begin(), particles.end(), [=](const readdy::model::Particle &p) {
+        return p.getType() == typeC;
+    }));
+    EXPECT_EQ(1, std::count_if(particles.begin(), particles.end(), [=](const readdy::model::Particle &p) {
+        return p.getType() == typeA && p.getPos() == readdy::model::Vec3(0, 0, -4.9);
+    })) << "the particles at the non-periodic boundary are too far apart to react";
+}
+
+TEST(TestNextSubvolumes, ConsumesEachParticleOnce) {
+    using fusion_t = readdy::model::reactions::Fusion;
+    using decay_t = readdy::model::reactions::Decay;
+    auto kernel = std::make_unique<readdy::kernel::cpu::CPUKernel>();
+    auto &ctx = kernel->getKernelContext();
+    ctx.setBoxSize(20, 20, 20);
+    ctx.setPeriodicBoundary(true, true, true);
+    ctx.particle_types().add("A", .01, 1.);
+    ctx.particle_types().add("B", .01, 1.);
+    ctx.particle_types().add("C", .01, 1.);
+    kernel->registerReaction<fusion_t>("A+B->C", "A", "B", "C", 5., 1.5);
+    kernel->registerReaction<decay_t>("C decay", "C", 1e3);
+    ctx.recordReactionCounts() = true;
+
+    const std::size_t n = 1000;
+    for (std::size_t i = 0; i < 2 * n; ++i) {
+        kernel->addParticle(i < n ? "A" : "B", {readdy::model::rnd::uniform_real(-10., 10.),
+                                                readdy::model::rnd::uniform_real(-10., 10.),
+                                                readdy::model::rnd::uniform_real(-10., 10.)});
+    }
+    ctx.configure();
+
+    const auto typeA = ctx.particle_types().id_of("A");
+    const auto typeB = ctx.particle_types().id_of("B");
+    const auto typeC = ctx.particle_types().id_of("C");
+    auto &&integrator = kernel->createAction<readdy::model::actions::EulerBDIntegrator>(1);
+    auto &&neighborList = kernel->createAction<readdy::model::actions::UpdateNeighborList>();
+    auto &&reactions = kernel->createAction<readdy::model::actions::reactions::NextSubvolumes>(1);
+    neighborList->perform();
+    std::size_t nFusions = 0, nDecays = 0;
+    for (int t = 0; t < 5; ++t) {
+        integrator->perform();
+        neighborList->perform();
+        reactions->perform();
+        const auto &counts = kernel->getCPUKernelStateModel().reactionCounts();
+        nFusions += std::get<1>(counts).at(std::tie(typeA, typeB)).at(0);
+        nDecays += std::get<0>(counts).at(typeC).at(0);
+
+        std::size_t nParticlesA = 0, nParticlesB = 0, nParticlesC = 0;
+        for (const auto &p : kernel->getKernelStateModel().getParticles()) {
+            if (p.getType() == typeA) ++nParticlesA;
+            if (p.getType() == typeB) ++nParticlesB;
+            if (p.getType() == typeC) ++nParticlesC;
+        }
+        EXPECT_EQ(n, nParticlesA + nFusions);
+        EXPECT_EQ(n, nParticlesB + nFusions);
+        // products only react in the next step, and then they decay for sure
+        EXPECT_EQ(nFusions, nParticlesC + nDecays);
+        EXPECT_EQ(nParticlesC, std::get<1>(counts).at(std::tie(typeA, typeB)).at(0));
+    }
+    EXPECT_GT(nFusions, 0);
+}
+
+TEST(CPUTestReactions, UncontrolledApproximationConsumesEachParticleOnce) {
+    using fusion_t = readdy::model::reactions::Fusion;
+    auto kernel = std::make_unique<readdy::kernel::cpu::CPUKernel>();
+    auto &ctx = kernel->getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    ctx.setPeriodicBoundary(true, true, true);
+    ctx.particle_types().add("A", .1, 1.);
+    ctx.particle_types().add("B", .1, 1.);
+    ctx.particle_types().add("C", .1, 1.);
+    // the rate is so large that every candidate event is accepted, hence many events compete for the same educts
+    kernel->registerReaction<fusion_t>("A+B->C", "A", "B", "C", 1e3, 1.5);
+    ctx.recordReactionCounts() = true;
+    ctx.recordReactionsWithPositions() = true;
+
+    const std::size_t nA = 2000, nB = 1500;
+    for (std::size_t i = 0; i < nA + nB; ++i) {
+        kernel->addParticle(i < nA ? "A" : "B", {readdy::model::rnd::uniform_real(-5., 5.),
+                                                 readdy::model::rnd::uniform_real(-5., 5.),
+                                                 readdy::model::rnd::uniform_real(-5., 5.)});
+    }
+    ctx.configure();
+
+    const auto typeA = ctx.particle_types().id_of("A");
+    const auto typeB = ctx.particle_types().id_of("B");
+    const auto typeC = ctx.particle_types().id_of("C");
+    fix_n_threads n_threads{kernel.get(), 4};
+    auto &&neighborList = kernel->createAction<readdy::model::actions::UpdateNeighborList>();
+    auto &&reactions = kernel->createAction<readdy::model::actions::reactions::UncontrolledApproximation>(1);
+    neighborList->perform();
+    std::size_t nReactions = 0;
+    for (int t = 0; t < 3; ++t) {
+        reactions->perform();
+        neighborList->perform();
+        const auto &counts = std::get<1>(kernel->getCPUKernelStateModel().reactionCounts());
+        const auto nStep = counts.at(std::tie(typeA, typeB)).at(0);
+        EXPECT_EQ(nStep, kernel->getCPUKernelStateModel().reactionRecords().size());
+        nReactions += nStep;
+
+        std::size_t nParticlesA = 0, nParticlesB = 0, nParticlesC = 0;
+        for (const auto &p : kernel->getKernelStateModel().getParticles()) {
+            if (p.getType() == typeA) ++nParticlesA;
+            if (p.getType() == typeB) ++nParticlesB;
+            if (p.getType() == typeC) ++nParticlesC;
+        }
+        EXPECT_EQ(nA, nParticlesA + nParticlesC);
+        EXPECT_EQ(nB, nParticlesB + nParticlesC);
+        EXPECT_EQ(nReactions, nParticlesC);
+    }
+    EXPECT_GT(nReactions, 0);
+    // the discarded events are counted
+    EXPECT_GT(kernel->performance().counters().at("reactions.conflicts"), 0);
+}
+
+TEST(CPUTestReactions, ReactionTable) {
+    using fusion_t = readdy::model::reactions::Fusion;
+    using decay_t = readdy::model::reactions::Decay;
+    auto kernel = std::make_unique<readdy::kernel::cpu::CPUKernel>();
+    auto &ctx = kernel->getKernelContext();
+    ctx.particle_types().add("A", .1, 1.);
+    ctx.particle_types().add("B", .1, 1.);
+    ctx.particle_types().add("C", .1, 1.);
+    kernel->registerReaction<fusion_t>("A+B->C", "A", "B", "C", .5, 1.5);
+    kernel->registerReaction<fusion_t>("A+B->C wide", "A", "B", "C", .1, 2.);
+    kernel->registerReaction<fusion_t>("A+A->C off", "A", "A", "C", 0, 3.);
+    kernel->registerReaction<decay_t>("C->", "C", 2.);
+    ctx.configure();
+
+    const auto typeA = ctx.particle_types().id_of("A");
+    const auto typeB = ctx.particle_types().id_of("B");
+    const auto typeC = ctx.particle_types().id_of("C");
+    const reac::ReactionTable table{ctx, .1, true};
+    EXPECT_TRUE(table.reactive(typeA, typeB));
+    EXPECT_TRUE(table.reactive(typeB, typeA));
+    EXPECT_FALSE(table.reactive(typeA, typeA));
+    EXPECT_FALSE(table.reactive(typeB, typeC));
+    EXPECT_DOUBLE_EQ(table.maxEductDistanceSquared(typeA, typeB), 4.);
+    EXPECT_EQ(table.order2(typeA, typeB).size(), 2);
+    EXPECT_EQ(table.order1(typeC).size(), 1);
+    EXPECT_TRUE(table.order1(typeA).empty());
+    EXPECT_DOUBLE_EQ(table.probability(table.order1Id(typeC, 0)), .2);
+    EXPECT_DOUBLE_EQ(table.probability(table.order2Id(typeA, typeB, 1)), .01);
+}
+
+TEST(CPUTestReactions, UncontrolledApproximationDecayFraction) {
+    using decay_t = readdy::model::reactions::Decay;
+    auto kernel = std::make_unique<readdy::kernel::cpu::CPUKernel>();
+    auto &ctx = kernel->getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    ctx.particle_types().add("A", .1, 1.);
+    kernel->registerReaction<decay_t>("A->", "A", 2.);
+
+    const std::size_t n = 20000;
+    for (std::size_t i = 0; i < n; ++i) {
+        kernel->addParticle("A", {readdy::model::rnd::uniform_real(-5., 5.),
+                                  readdy::model::rnd::uniform_real(-5., 5.),
+                                  readdy::model::rnd::uniform_real(-5., 5.)});
+    }
+    ctx.configure();
+
+    fix_n_threads n_threads{kernel.get(), 4};
+    auto &&neighborList = kernel->createAction<readdy::model::actions::UpdateNeighborList>();
+    // each particle decays with probability rate * dt = .2, i.e., about 4000 +- 57 decays are expected
+    auto &&reactions = kernel->createAction<readdy::model::actions::reactions::UncontrolledApproximation>(.1);
+    neighborList->perform();
+    reactions->perform();
+    const auto nDecayed = n - kernel->getKernelStateModel().getParticles().size();
+    EXPECT_GT(nDecayed, 3700);
+    EXPECT_LT(nDecayed, 4300);
+}
+
+TEST(CPUTestReactions, UncontrolledApproximationFollowsTimeStepAndConfiguration) {
+    using decay_t = readdy::model::reactions::Decay;
+    auto kernel = std::make_unique<readdy::kernel::cpu::CPUKernel>();
+    auto &ctx = kernel->getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    ctx.particle_types().add("A", .1, 1.);
+    ctx.particle_types().add("B", .1, 1.);
+    kernel->registerReaction<decay_t>("A->", "A", 10.);
+
+    const std::size_t n = 1000;
+    for (std::size_t i = 0; i < n; ++i) {
+        kernel->addParticle(i % 2 == 0 ? "A" : "B", {readdy::model::rnd::uniform_real(-5., 5.),
+                                                     readdy::model::rnd::uniform_real(-5., 5.),
+                                                     readdy::model::rnd::uniform_real(-5., 5.)});
+    }
+    ctx.configure();
+
+    auto &&neighborList = kernel->createAction<readdy::model::actions::UpdateNeighborList>();
+    auto &&reactions = kernel->createAction<readdy::model::actions::reactions::UncontrolledApproximation>(.001);
+    const auto nParticles = [&kernel] { return kernel->getKernelStateModel().getParticles().size(); };
+    neighborList->perform();
+    // each A decays with probability .01
+    reactions->perform();
+    EXPECT_GT(nParticles(), n - 50);
+
+    // with the larger time step, each A decays for sure
+    reactions->setTimeStep(1);
+    neighborList->perform();
+    reactions->perform();
+    EXPECT_EQ(nParticles(), n / 2);
+
+    // the decay of B is only known to the reactions after the context was configured again
+    kernel->registerReaction<decay_t>("B->", "B", 10.);
+    neighborList->perform();
+    reactions->perform();
+    EXPECT_EQ(nParticles(), n / 2);
+    ctx.configure();
+    neighborList->perform();
+    reactions->perform();
+    EXPECT_EQ(nParticles(), 0);
+}
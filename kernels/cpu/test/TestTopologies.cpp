@@ -0,0 +1,282 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * @file TestTopologies.cpp
+ * @brief Tests for the CPU kernel's evaluation of topology potentials
+ * @author clonker
+ * @date 18.10.17
+ */
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include <readdy/kernel/cpu/CPUKernel.h>
+#include <readdy/kernel/cpu/model/topologies/BondedInteractions.h>
+#include <readdy/kernel/cpu/actions/CPUEvaluateTopologyReactions.h>
+#include <readdy/kernel/cpu/util/fenwick_tree.h>
+#include <readdy/testing/Utils.h>
+
+namespace {
+
+namespace cpu = readdy::kernel::cpu;
+using harmonic_bond = readdy::model::top::pot::HarmonicBondPotential;
+using harmonic_angle = readdy::model::top::pot::HarmonicAnglePotential;
+using cos_dihedral = readdy::model::top::pot::CosineDihedralPotential;
+using topology_reaction = readdy::model::top::reactions::TopologyReaction;
+
+/**
+ * adds a linear polymer of n particles with bonds, angles and dihedrals along its backbone, it crosses the periodic
+ * boundary in x direction
+ */
+readdy::model::top::GraphTopology *addPolymer(cpu::CPUKernel &kernel, std::size_t n, double y) {
+    const auto type = kernel.getKernelContext().particle_types().id_of("T");
+    std::vector<readdy::model::TopologyParticle> particles;
+    for (std::size_t i = 0; i < n; ++i) {
+        auto x = -4. + .9 * i;
+        x -= 10. * std::floor((x + 5.) / 10.);
+        particles.emplace_back(x, y + .3 * std::sin(1. * i), .4 * std::cos(1.7 * i), type);
+    }
+    auto top = kernel.getKernelStateModel().addTopology(particles);
+    harmonic_bond::bonds_t bonds;
+    harmonic_angle::angles_t angles;
+    cos_dihedral::dihedrals_t dihedrals;
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        bonds.emplace_back(i, i + 1, 10., 1.);
+    }
+    for (std::size_t i = 0; i + 2 < n; ++i) {
+        angles.emplace_back(i, i + 1, i + 2, 2., 2.5);
+    }
+    for (std::size_t i = 0; i + 3 < n; ++i) {
+        dihedrals.emplace_back(i, i + 1, i + 2, i + 3, 1., 3, .5);
+    }
+    top->addBondedPotential<harmonic_bond>(bonds);
+    top->addAnglePotential<harmonic_angle>(angles);
+    top->addTorsionPotential<cos_dihedral>(dihedrals);
+    return top;
+}
+
+TEST(CPUTestTopologies, BondedInteractionsMatchActions) {
+    for (std::size_t nThreads : {1, 3, 4}) {
+        cpu::CPUKernel kernel;
+        kernel.setNThreads(nThreads);
+        auto &ctx = kernel.getKernelContext();
+        ctx.setBoxSize(10, 10, 10);
+        ctx.setPeriodicBoundary(true, true, true);
+        ctx.particle_types().add("T", 1., 1., readdy::model::Particle::FLAVOR_TOPOLOGY);
+        addPolymer(kernel, 30, -2.);
+        addPolymer(kernel, 17, 2.);
+        ctx.configure();
+
+        auto &stateModel = kernel.getCPUKernelStateModel();
+        stateModel.calculateForces();
+        auto &data = *stateModel.getParticleData();
+        std::vector<readdy::model::Vec3> forces;
+        for (const auto &entry : data) {
+            forces.push_back(entry.force);
+        }
+        const auto energy = stateModel.getEnergy();
+
+        // evaluate the potentials one by one through their actions
+        for (auto entry : data) {
+            entry.force = {0, 0, 0};
+        }
+        double expectedEnergy = 0;
+        const auto factory = kernel.getTopologyActionFactory();
+        for (const auto &top : stateModel.topologies()) {
+            for (const auto &pot : top->getBondedPotentials()) {
+                expectedEnergy += pot->createForceAndEnergyAction(factory)->perform();
+            }
+            for (const auto &pot : top->getAnglePotentials()) {
+                expectedEnergy += pot->createForceAndEnergyAction(factory)->perform();
+            }
+            for (const auto &pot : top->getTorsionPotentials()) {
+                expectedEnergy += pot->createForceAndEnergyAction(factory)->perform();
+            }
+        }
+        EXPECT_NEAR(energy, expectedEnergy, 1e-10);
+        std::size_t i = 0;
+        for (const auto &entry : data) {
+            EXPECT_VEC3_NEAR(forces.at(i), entry.force, 1e-10);
+            ++i;
+        }
+    }
+}
+
+TEST(CPUTestTopologies, BondedInteractionsRebuildOnChange) {
+    cpu::CPUKernel kernel;
+    auto &ctx = kernel.getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    ctx.particle_types().add("T", 1., 1., readdy::model::Particle::FLAVOR_TOPOLOGY);
+    auto top1 = addPolymer(kernel, 10, -2.);
+    addPolymer(kernel, 5, 2.);
+    const auto &topologies = kernel.getCPUKernelStateModel().topologies();
+
+    cpu::model::top::BondedInteractions table;
+    EXPECT_TRUE(table.update(topologies, 2));
+    EXPECT_EQ(table.bonds().size(), 9 + 4);
+    EXPECT_EQ(table.angles().size(), 8 + 3);
+    EXPECT_EQ(table.dihedrals().size(), 7 + 2);
+    EXPECT_FALSE(table.update(topologies, 2));
+    // the indices of the second polymer are resolved to indices into the particle data
+    EXPECT_EQ(table.bonds().back().configuration.idx1, 13);
+    EXPECT_EQ(table.bonds().back().configuration.idx2, 14);
+    EXPECT_EQ(table.slots().size(), 10 + 5);
+
+    EXPECT_TRUE(table.update(topologies, 3));
+    EXPECT_FALSE(table.update(topologies, 3));
+
+    {
+        harmonic_bond::bonds_t bonds;
+        bonds.emplace_back(0, 9, 1., 1.);
+        top1->addBondedPotential<harmonic_bond>(bonds);
+    }
+    EXPECT_TRUE(table.update(topologies, 3));
+    EXPECT_EQ(table.bonds().size(), 9 + 1 + 4);
+    EXPECT_FALSE(table.update(topologies, 3));
+
+    top1->deactivate();
+    EXPECT_TRUE(table.update(topologies, 3));
+    EXPECT_EQ(table.bonds().size(), 4);
+    EXPECT_EQ(table.angles().size(), 3);
+    EXPECT_EQ(table.dihedrals().size(), 2);
+    // only the particles of the remaining polymer are given slots
+    EXPECT_EQ(table.slots().size(), 5);
+    EXPECT_EQ(table.slots().front(), 10);
+    EXPECT_EQ(table.bonds().back().configuration.idx2, 14);
+    EXPECT_EQ(table.bonds().back().slots[0], 3);
+    EXPECT_EQ(table.bonds().back().slots[1], 4);
+}
+
+
+TEST(CPUTestTopologies, FenwickTree) {
+    cpu::util::fenwick_tree<double> tree;
+    tree.resize(7);
+    const std::vector<double> weights{.5, 0, 2, 1, 0, 0, 3};
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        tree.set(i, weights[i]);
+    }
+    EXPECT_DOUBLE_EQ(tree.total(), 6.5);
+    double prefix = 0;
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        EXPECT_DOUBLE_EQ(tree.prefix_sum(i), prefix);
+        if (weights[i] > 0) {
+            EXPECT_EQ(tree.find(prefix), i);
+            EXPECT_EQ(tree.find(prefix + .99 * weights[i]), i);
+        }
+        prefix += weights[i];
+    }
+    EXPECT_EQ(tree.find(6.5), 6);
+
+    tree.set(6, 0);
+    tree.set(4, 1.5);
+    EXPECT_DOUBLE_EQ(tree.total(), 5);
+    EXPECT_EQ(tree.find(4.), 4);
+    tree.resize(9);
+    EXPECT_DOUBLE_EQ(tree.total(), 5);
+    EXPECT_EQ(tree[4], 1.5);
+    tree.set(8, 1);
+    EXPECT_EQ(tree.find(5.5), 8);
+    tree.reset();
+    EXPECT_DOUBLE_EQ(tree.total(), 0);
+}
+
+TEST(CPUTestTopologies, TopologyReactionRatesAreUpdatedIncrementally) {
+    cpu::CPUKernel kernel;
+    auto &ctx = kernel.getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    ctx.particle_types().add("T", 1., 1., readdy::model::Particle::FLAVOR_TOPOLOGY);
+    const auto type = ctx.particle_types().id_of("T");
+
+    double rate = 1.;
+    const auto noop = [](readdy::model::top::GraphTopology &top) {
+        return readdy::model::top::reactions::Recipe{top};
+    };
+    const auto rateFunction = [&rate](const readdy::model::top::GraphTopology &) { return rate; };
+    std::vector<readdy::model::top::GraphTopology *> tops;
+    for (std::size_t i = 0; i < 3; ++i) {
+        auto top = kernel.getKernelStateModel().addTopology({{0., 0., 0., type}});
+        top->addReaction(topology_reaction{noop, rateFunction});
+        top->updateReactionRates();
+        tops.push_back(top);
+    }
+
+    cpu::actions::top::CPUEvaluateTopologyReactions action{&kernel, 1.};
+    action.updateRates();
+    EXPECT_EQ(action.stride(), 1);
+    EXPECT_DOUBLE_EQ(action.rates().total(), 3.);
+
+    // only topologies whose rates were updated are looked at again
+    rate = 2.;
+    tops[1]->updateReactionRates();
+    action.updateRates();
+    EXPECT_DOUBLE_EQ(action.rates().total(), 4.);
+    EXPECT_DOUBLE_EQ(action.rates()[1], 2.);
+
+    // a topology with more reactions changes the layout
+    {
+        auto top = kernel.getKernelStateModel().addTopology({{0., 0., 0., type}});
+        top->addReaction(topology_reaction{noop, rateFunction});
+        top->addReaction(topology_reaction{noop, 5.});
+        top->updateReactionRates();
+    }
+    action.updateRates();
+    EXPECT_EQ(action.stride(), 2);
+    EXPECT_EQ(action.rates().size(), 8);
+    EXPECT_DOUBLE_EQ(action.rates().total(), 1. + 2. + 1. + 2. + 5.);
+    EXPECT_DOUBLE_EQ(action.rates()[7], 5.);
+
+    // deactivated topologies do not contribute
+    auto &topologies = kernel.getCPUKernelStateModel().topologies();
+    topologies.erase(topologies.begin() + 3);
+    action.updateRates();
+    EXPECT_DOUBLE_EQ(action.rates().total(), 4.);
+}
+
+TEST(CPUTestTopologies, TopologyReactionAcceptanceProbability) {
+    cpu::CPUKernel kernel;
+    auto &ctx = kernel.getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    ctx.particle_types().add("T", 1., 1., readdy::model::Particle::FLAVOR_TOPOLOGY);
+    const auto type = ctx.particle_types().id_of("T");
+
+    std::size_t nPerformed = 0;
+    const auto count = [&nPerformed](readdy::model::top::GraphTopology &top) {
+        ++nPerformed;
+        return readdy::model::top::reactions::Recipe{top};
+    };
+    auto top = kernel.getKernelStateModel().addTopology({{0., 0., 0., type}});
+    top->addReaction(topology_reaction{count, 5.});
+    top->updateReactionRates();
+
+    // an event is performed with probability rate * timeStep = .5 and not 1 - exp(-rate * timeStep) ~ .39
+    cpu::actions::top::CPUEvaluateTopologyReactions action{&kernel, .1};
+    const std::size_t nSteps = 5000;
+    for (std::size_t i = 0; i < nSteps; ++i) {
+        action.perform();
+    }
+    EXPECT_NEAR(static_cast<double>(nPerformed) / nSteps, .5, .04);
+    EXPECT_DOUBLE_EQ(action.rates().total(), 5.);
+}
+
+}
@@ -55,6 +55,8 @@ public:
 
     virtual const std::vector<readdy::model::Particle> getParticles() const override;
 
+    virtual std::size_t getNParticles() const override;
+
     virtual void updateNeighborList() override;
 
     virtual void calculateForces() override;
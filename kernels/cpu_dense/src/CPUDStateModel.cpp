@@ -179,6 +179,10 @@ const std::vector<readdy::model::Particle> CPUDStateModel::getParticles() const
     return result;
 }
 
+std::size_t CPUDStateModel::getNParticles() const {
+    return pimpl->cdata().size();
+}
+
 void CPUDStateModel::updateNeighborList() {
     pimpl->neighborList->create();
 }
@@ -111,6 +111,11 @@ const std::vector<readdy::model::Particle> SCPUStateModel::getParticles() const
     return result;
 }
 
+std::size_t SCPUStateModel::getNParticles() const {
+    const auto &data = *pimpl->particleData;
+    return data.size() - data.n_deactivated();
+}
+
 void SCPUStateModel::updateNeighborList() {
     pimpl->neighborList->create(*pimpl->particleData);
 }
@@ -42,6 +42,16 @@ double Simulation::getKBT() const {
 void Simulation::setKBT(double kBT) {
     ensureKernelSelected();
     pimpl->kernel->getKernelContext().setKBT(kBT);
+}
+
+void Simulation::setSeed(std::uint64_t seed) {
+    ensureKernelSelected();
+    pimpl->kernel->getKernelContext().setSeed(seed);
+}
+
+std::uint64_t Simulation::getSeed() const {
+    ensureKernelSelected();
+    return pimpl->kernel->getKernelContext().getSeed();
 
 }
 
@@ -79,6 +89,16 @@ void Simulation::run(const time_step_type steps, const double timeStep) {
     runScheme().configure(timeStep)->run(steps);
 }
 
+readdy::util::Performance &Simulation::performance() {
+    ensureKernelSelected();
+    return pimpl->kernel->performance();
+}
+
+const readdy::util::Performance &Simulation::performance() const {
+    ensureKernelSelected();
+    return pimpl->kernel->performance();
+}
+
 void Simulation::setKernel(const std::string &kernel) {
     if (isKernelSelected()) {
         log::debug("replacing kernel \"{}\" with \"{}\"", pimpl->kernel->getName(), kernel);
@@ -363,6 +383,16 @@ void Simulation::registerPotentialOrder1(readdy::model::potentials::PotentialOrd
     getSelectedKernel()->getKernelContext().potentials().add_external(ptr);
 }
 
+void Simulation::setAutoTabulatePotentials(bool autoTabulate) {
+    ensureKernelSelected();
+    pimpl->kernel->getKernelContext().potentials().setAutoTabulate(autoTabulate);
+}
+
+bool Simulation::getAutoTabulatePotentials() const {
+    ensureKernelSelected();
+    return pimpl->kernel->getKernelContext().potentials().autoTabulate();
+}
+
 void Simulation::registerPotentialOrder2(readdy::model::potentials::PotentialOrder2 *ptr) {
     ensureKernelSelected();
     getSelectedKernel()->getKernelContext().potentials().add_external(ptr);
@@ -81,6 +81,7 @@ void Config::update() {
 
     switch (_mode) {
         case ThreadMode::pool: {
+            wsPool.reset(nullptr);
             if (pool) {
                 pool->resize(m_nThreads);
             } else {
@@ -94,6 +95,7 @@ void Config::update() {
                 pool->stop(true);
                 pool.reset(nullptr);
             }
+            wsPool.reset(nullptr);
             _executor = std::unique_ptr<executor_base>(new thread_executor(nullptr));
             break;
         }
@@ -102,14 +104,32 @@ void Config::update() {
                 pool->stop(true);
                 pool.reset(nullptr);
             }
+            wsPool.reset(nullptr);
             _executor = std::unique_ptr<executor_base>(new async_executor(nullptr));
             break;
         }
+        case ThreadMode::work_stealing: {
+            if(pool) {
+                pool->stop(true);
+                pool.reset(nullptr);
+            }
+            // the calling thread takes part in the execution, more threads than cores would only oversubscribe as
+            // the load balancing is taken care of by work stealing
+            const auto nCores = std::max(std::thread::hardware_concurrency(), 1u);
+            const auto poolSize = std::min(m_nThreads, nCores);
+            if (!wsPool || wsPool->size() != poolSize) {
+                wsPool.reset(nullptr);
+                wsPool = std::make_unique<work_stealing_pool>(poolSize);
+            }
+            _executor = std::unique_ptr<executor_base>(new work_stealing_executor(wsPool.get()));
+            break;
+        }
         case ThreadMode::inactive: {
             if(pool) {
                 pool->stop(true);
                 pool.reset(nullptr);
             }
+            wsPool.reset(nullptr);
             _executor.reset(nullptr);
             break;
         }
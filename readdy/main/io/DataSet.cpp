@@ -35,6 +35,11 @@
 
 namespace readdy {
 namespace io {
+
+std::recursive_mutex &dataSetMutex() {
+    static std::recursive_mutex mutex;
+    return mutex;
+}
 namespace blosc_compression {
 
 void initialize() {
@@ -39,6 +39,13 @@ namespace compartments {
 
 short Compartment::counter = 0;
 
+void Compartment::areContained(const double *x, const double *y, const double *z, const std::size_t n,
+                               std::uint8_t *contained) const {
+    for (std::size_t i = 0; i < n; ++i) {
+        contained[i] = static_cast<std::uint8_t>(isContained({x[i], y[i], z[i]}));
+    }
+}
+
 Sphere::Sphere(const std::unordered_map<particleType_t, particleType_t> &conversions, const std::string &uniqueName, const Vec3 &origin,
                const double radius, const bool largerOrLess)
         : Compartment(conversions, getCompartmentTypeName<Sphere>(), uniqueName), radius(radius), radiusSquared(radius * radius),
@@ -54,6 +61,24 @@ const bool Sphere::isContained(const Vec3 &position) const {
     }
 }
 
+void Sphere::areContained(const double *x, const double *y, const double *z, const std::size_t n,
+                          std::uint8_t *contained) const {
+    const auto ox = origin[0], oy = origin[1], oz = origin[2];
+    const auto r2 = radiusSquared;
+    // branch free loops over the batch, selected once by the orientation
+    if (largerOrLess) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto dx = x[i] - ox, dy = y[i] - oy, dz = z[i] - oz;
+            contained[i] = static_cast<std::uint8_t>(dx * dx + dy * dy + dz * dz > r2);
+        }
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto dx = x[i] - ox, dy = y[i] - oy, dz = z[i] - oz;
+            contained[i] = static_cast<std::uint8_t>(dx * dx + dy * dy + dz * dz < r2);
+        }
+    }
+}
+
 Plane::Plane(const std::unordered_map<particleType_t, particleType_t> &conversions, const std::string &uniqueName, const Vec3 &normalCoefficients,
              const double distance, const bool largerOrLess)
         : Compartment(conversions, getCompartmentTypeName<Plane>(), uniqueName), normalCoefficients(normalCoefficients), distanceFromOrigin(distance),
@@ -74,6 +99,21 @@ const bool Plane::isContained(const Vec3 &position) const {
     }
 }
 
+void Plane::areContained(const double *x, const double *y, const double *z, const std::size_t n,
+                         std::uint8_t *contained) const {
+    const auto nx = normalCoefficients[0], ny = normalCoefficients[1], nz = normalCoefficients[2];
+    const auto d = distanceFromOrigin;
+    if (largerOrLess) {
+        for (std::size_t i = 0; i < n; ++i) {
+            contained[i] = static_cast<std::uint8_t>(x[i] * nx + y[i] * ny + z[i] * nz - d > 0);
+        }
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            contained[i] = static_cast<std::uint8_t>(x[i] * nx + y[i] * ny + z[i] * nz - d < 0);
+        }
+    }
+}
+
 }
 }
 }
\ No newline at end of file
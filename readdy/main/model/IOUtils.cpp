@@ -113,6 +113,40 @@ void writeSimulationSetup(io::Group &group, const KernelContext &context) {
     writeReactionInformation(group, context);
 }
 
+void writePerformance(io::Group &group, const readdy::util::Performance &performance) {
+    {
+        std::vector<std::string> names;
+        std::vector<double> seconds;
+        std::vector<long> calls, particles;
+        for (const auto &entry : performance.timings()) {
+            names.push_back(entry.first);
+            seconds.push_back(entry.second.seconds);
+            calls.push_back(static_cast<long>(entry.second.calls));
+            particles.push_back(static_cast<long>(entry.second.particles));
+        }
+        if (!names.empty()) {
+            auto subgroup = group.createGroup("./timings");
+            subgroup.write("names", names);
+            subgroup.write("seconds", seconds);
+            subgroup.write("calls", calls);
+            subgroup.write("particles", particles);
+        }
+    }
+    {
+        std::vector<std::string> names;
+        std::vector<long> values;
+        for (const auto &entry : performance.counters()) {
+            names.push_back(entry.first);
+            values.push_back(static_cast<long>(entry.second));
+        }
+        if (!names.empty()) {
+            auto subgroup = group.createGroup("./counters");
+            subgroup.write("names", names);
+            subgroup.write("values", values);
+        }
+    }
+}
+
 }
 }
 }
\ No newline at end of file
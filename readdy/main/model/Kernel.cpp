@@ -47,7 +47,14 @@ struct Kernel::Impl {
      * todo
      */
     std::unique_ptr<observables::ObservableFactory> observableFactory;
-
+    /**
+     * writer thread for observables, drained on finalize
+     */
+    std::unique_ptr<observables::util::AsyncWriter> asyncWriter;
+    /**
+     * timings and counters
+     */
+    readdy::util::Performance performance;
 };
 
 const std::string &Kernel::getName() const {
@@ -58,6 +65,7 @@ Kernel::Kernel(const std::string &name) : pimpl(std::make_unique<Kernel::Impl>()
     pimpl->name = name;
     pimpl->observableFactory = std::make_unique<observables::ObservableFactory>(this);
     pimpl->signal = std::make_unique<observables::signal_type>();
+    pimpl->asyncWriter = std::make_unique<observables::util::AsyncWriter>();
 }
 
 Kernel::~Kernel() {
@@ -236,6 +244,19 @@ void Kernel::initialize() {
 }
 
 void Kernel::finalize() {
+    pimpl->asyncWriter->wait();
+}
+
+observables::util::AsyncWriter &Kernel::asyncWriter() {
+    return *pimpl->asyncWriter;
+}
+
+readdy::util::Performance &Kernel::performance() {
+    return pimpl->performance;
+}
+
+const readdy::util::Performance &Kernel::performance() const {
+    return pimpl->performance;
 }
 
 Kernel &Kernel::operator=(Kernel &&rhs) = default;
@@ -32,6 +32,7 @@
 #include <readdy/model/KernelContext.h>
 #include <readdy/common/Utils.h>
 #include <readdy/model/_internal/Util.h>
+#include <readdy/model/RandomProvider.h>
 
 namespace readdy {
 namespace model {
@@ -41,6 +42,10 @@ using particle_t = readdy::model::Particle;
 struct KernelContext::Impl {
 
     double kBT = 1;
+    std::uint64_t seed = 0;
+    bool seedSet = false;
+    bool seedPending = false;
+    std::size_t nConfigurations = 0;
     std::array<double, 3> box_size{{1, 1, 1}};
     std::array<bool, 3> periodic_boundary{{true, true, true}};
 
@@ -182,6 +187,16 @@ void KernelContext::setKBT(double kBT) {
     (*pimpl).kBT = kBT;
 }
 
+void KernelContext::setSeed(std::uint64_t seed) {
+    pimpl->seed = seed;
+    pimpl->seedSet = true;
+    pimpl->seedPending = true;
+}
+
+std::uint64_t KernelContext::getSeed() const {
+    return pimpl->seedSet ? pimpl->seed : rnd::get_seed();
+}
+
 void KernelContext::setBoxSize(double dx, double dy, double dz) {
     (*pimpl).box_size = {dx, dy, dz};
     pimpl->updateDistAndFixPositionFun();
@@ -220,6 +235,12 @@ const KernelContext::shortest_dist_fun &KernelContext::getShortestDifferenceFun(
 void KernelContext::configure(bool debugOutput) {
     potentialRegistry_.configure();
     reactionRegistry_.configure();
+    ++pimpl->nConfigurations;
+
+    if (pimpl->seedPending) {
+        rnd::seed(pimpl->seed);
+        pimpl->seedPending = false;
+    }
 
     /**
      * Info output
@@ -239,6 +260,10 @@ void KernelContext::configure(bool debugOutput) {
 
 }
 
+std::size_t KernelContext::nConfigurations() const {
+    return pimpl->nConfigurations;
+}
+
 std::tuple<readdy::model::Vec3, readdy::model::Vec3> KernelContext::getBoxBoundingVertices() const {
     const auto &boxSize = getBoxSize();
     readdy::model::Vec3 lowerLeft{-0.5 * boxSize[0], -0.5 * boxSize[1], -0.5 * boxSize[2]};
@@ -0,0 +1,78 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * Holds the process-wide seed state of the random provider.
+ *
+ * @file RandomProvider.cpp
+ * @brief Implementation of the seeding functions of the random provider
+ * @author clonker
+ * @date 18.10.17
+ */
+
+#include <atomic>
+#include <chrono>
+
+#include <readdy/model/RandomProvider.h>
+
+namespace readdy {
+namespace model {
+namespace rnd {
+
+namespace {
+std::uint64_t initialSeed() {
+    std::random_device device;
+    const auto entropy = (static_cast<std::uint64_t>(device()) << 32) | device();
+    const auto time = static_cast<std::uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    return entropy ^ time;
+}
+
+std::atomic<std::uint64_t> currentSeed{initialSeed()};
+// starts at one so that thread local generators, which start at generation zero, get seeded on first use
+std::atomic<std::uint64_t> generation{1};
+std::atomic<std::uint64_t> stream{0};
+}
+
+void seed(std::uint64_t seed) {
+    currentSeed.store(seed);
+    stream.store(0);
+    generation.fetch_add(1);
+}
+
+std::uint64_t get_seed() {
+    return currentSeed.load();
+}
+
+namespace detail {
+std::uint64_t seed_generation() {
+    return generation.load(std::memory_order_acquire);
+}
+
+std::uint64_t next_stream() {
+    return stream.fetch_add(1);
+}
+}
+
+}
+}
+}
@@ -44,5 +44,16 @@ std::vector<Particle> KernelStateModel::getParticlesForTopology(const top::Graph
     return result;
 }
 
+std::size_t KernelStateModel::getNParticles() const {
+    return getParticles().size();
+}
+
+void KernelStateModel::toTrajectoryFrame(std::vector<observables::TrajectoryEntry> &frame) const {
+    frame.clear();
+    for (const auto &p : getParticles()) {
+        frame.emplace_back(p);
+    }
+}
+
 }
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * @file AsyncWriter.cpp
+ * @brief Implementation of the AsyncWriter
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#include <algorithm>
+
+#include <readdy/model/observables/io/AsyncWriter.h>
+
+namespace readdy {
+namespace model {
+namespace observables {
+namespace util {
+
+AsyncWriter::AsyncWriter(std::size_t capacity) : capacity(std::max(capacity, static_cast<std::size_t>(1))) {}
+
+AsyncWriter::~AsyncWriter() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    taskAvailable.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void AsyncWriter::enqueue(task_t task) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!thread.joinable()) {
+            thread = std::thread([this] { work(); });
+        }
+        taskDone.wait(lock, [this] { return tasks.size() < capacity; });
+        tasks.push_back(std::move(task));
+    }
+    taskAvailable.notify_one();
+}
+
+void AsyncWriter::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    taskDone.wait(lock, [this] { return tasks.empty() && !busy; });
+    if (firstException) {
+        auto e = firstException;
+        firstException = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+void AsyncWriter::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        taskAvailable.wait(lock, [this] { return !tasks.empty() || stopped; });
+        if (tasks.empty()) {
+            // stopped and nothing left to do
+            return;
+        }
+        auto task = std::move(tasks.front());
+        tasks.pop_front();
+        busy = true;
+        lock.unlock();
+        taskDone.notify_all();
+        try {
+            task();
+        } catch (...) {
+            std::unique_lock<std::mutex> exceptionLock(mutex);
+            if (!firstException) firstException = std::current_exception();
+        }
+        lock.lock();
+        busy = false;
+        taskDone.notify_all();
+    }
+}
+
+}
+}
+}
+}
@@ -91,6 +91,7 @@ void CenterOfMass::initializeDataSet(io::File &file, const std::string &dataSetN
                 group.createDataSet("data", fs, dims, util::Vec3MemoryType(), util::Vec3FileType()));
         log::debug("created data set with path {}", std::string(util::OBSERVABLES_GROUP_PATH) + "/" + dataSetName);
         pimpl->ds = std::move(dataSet);
+        pimpl->ds->setBuffered(true);
         pimpl->timeSeries = std::make_unique<util::TimeSeriesWriter>(group, flushStride);
     }
 }
@@ -77,6 +77,7 @@ void HistogramAlongAxis::initializeDataSet(io::File &file, const std::string &da
         auto group = file.createGroup(path);
         auto dataSet = std::make_unique<io::DataSet>(group.createDataSet<double>("data", fs, dims));
         pimpl->dataSet = std::move(dataSet);
+        pimpl->dataSet->setBuffered(true);
         pimpl->time = std::make_unique<util::TimeSeriesWriter>(group, flushStride);
     }
 }
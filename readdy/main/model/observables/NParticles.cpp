@@ -69,6 +69,7 @@ void NParticles::initializeDataSet(io::File &file, const std::string &dataSetNam
         std::vector<readdy::io::h5::dims_t> dims = {readdy::io::h5::UNLIMITED_DIMS, size};
         auto group = file.createGroup(std::string(util::OBSERVABLES_GROUP_PATH) + "/" + dataSetName);
         pimpl->ds = std::make_unique<io::DataSet>(group.createDataSet<std::size_t>("data", fs, dims));
+        pimpl->ds->setBuffered(true);
         pimpl->time = std::make_unique<util::TimeSeriesWriter>(group, flushStride);
     }
 }
@@ -74,7 +74,7 @@ void RadialDistribution::evaluate() {
                         if (isInCollection(pTo, typeCountTo) && pFrom.getId() != pTo.getId()) {
                             const auto dist = sqrt(distSquared(pFrom.getPos(), pTo.getPos()));
                             auto upperBound = std::upper_bound(binBorders.begin(), binBorders.end(), dist);
-                            if (upperBound != binBorders.end()) {
+                            if (upperBound != binBorders.begin() && upperBound != binBorders.end()) {
                                 const auto binBordersIdx = upperBound - binBorders.begin();
                                 counts[binBordersIdx - 1]++;
                             }
@@ -84,23 +84,25 @@ void RadialDistribution::evaluate() {
             }
         }
 
-        auto &radialDistribution = std::get<1>(result);
-        {
-            const auto &binCenters = std::get<0>(result);
-            auto &&it_centers = binCenters.begin();
-            auto &&it_distribution = radialDistribution.begin();
-            for (auto &&it_counts = counts.begin(); it_counts != counts.end(); ++it_counts) {
-                const auto idx = it_centers - binCenters.begin();
-                const auto lowerRadius = binBorders[idx];
-                const auto upperRadius = binBorders[idx + 1];
-                *it_distribution =
-                        (*it_counts) /
-                        (4 / 3 * readdy::util::numeric::pi() * (std::pow(upperRadius, 3) - std::pow(lowerRadius, 3)) *
-                         nFromParticles * particleToDensity);
-                ++it_distribution;
-                ++it_centers;
-            }
-        }
+        normalizeCounts(static_cast<std::size_t>(nFromParticles));
+    }
+}
+
+void RadialDistribution::normalizeCounts(std::size_t nFromParticles) {
+    auto &radialDistribution = std::get<1>(result);
+    const auto &binCenters = std::get<0>(result);
+    auto &&it_centers = binCenters.begin();
+    auto &&it_distribution = radialDistribution.begin();
+    for (auto &&it_counts = counts.begin(); it_counts != counts.end(); ++it_counts) {
+        const auto idx = it_centers - binCenters.begin();
+        const auto lowerRadius = binBorders[idx];
+        const auto upperRadius = binBorders[idx + 1];
+        *it_distribution =
+                (*it_counts) /
+                (4 / 3 * readdy::util::numeric::pi() * (std::pow(upperRadius, 3) - std::pow(lowerRadius, 3)) *
+                 nFromParticles * particleToDensity);
+        ++it_distribution;
+        ++it_centers;
     }
 }
 
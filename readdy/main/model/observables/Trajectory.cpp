@@ -29,6 +29,14 @@
  * @copyright GNU Lesser General Public License v3.0
  */
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <iterator>
+#include <mutex>
+
 #include <readdy/model/observables/io/Trajectory.h>
 #include <readdy/io/File.h>
 #include <readdy/model/observables/io/TimeSeriesWriter.h>
@@ -42,11 +50,116 @@ namespace readdy {
 namespace model {
 namespace observables {
 
+namespace {
+/**
+ * Double buffer of recorded frames. The simulation thread stages copies of its results, the writer thread takes
+ * all staged frames at once and writes them with a single call per data set. The buffers of written frames are
+ * recycled, so that staging a frame amounts to a copy into already allocated memory.
+ */
+class StagedFrames {
+public:
+    using frame_t = std::vector<TrajectoryEntry>;
+    using frames_t = std::vector<frame_t>;
+    using times_t = std::vector<time_step_type>;
+
+    /**
+     * maximal number of staged frames, the simulation thread blocks if the writer falls further behind
+     */
+    static constexpr std::size_t max_staged_frames = 8;
+
+    /**
+     * stages a copy of a frame
+     * @param frame the frame
+     * @param t the frame's time step
+     * @return true if the frames need to be drained by a new writer task
+     */
+    bool stage(const frame_t &frame, time_step_type t) {
+        frame_t copy;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            written.wait(lock, [this] { return staged.size() < max_staged_frames; });
+            if (!pool.empty()) {
+                copy = std::move(pool.back());
+                pool.pop_back();
+            }
+        }
+        copy.assign(frame.begin(), frame.end());
+        std::unique_lock<std::mutex> lock(mutex);
+        staged.push_back(std::move(copy));
+        stagedTimes.push_back(t);
+        if (!drainScheduled) {
+            drainScheduled = true;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * hands all staged frames to a write function, to be called from the writer thread
+     * @param write the write function, taking the frames and their time steps
+     */
+    template<typename F>
+    void drain(F &&write) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::swap(staged, writing);
+            std::swap(stagedTimes, writingTimes);
+            drainScheduled = false;
+            writeInProgress = true;
+        }
+        written.notify_all();
+        try {
+            write(writing, writingTimes);
+        } catch (...) {
+            release();
+            throw;
+        }
+        release();
+    }
+
+    /**
+     * blocks until all staged frames have been written
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        written.wait(lock, [this] { return !drainScheduled && !writeInProgress; });
+    }
+
+private:
+    void release() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::move(writing.begin(), writing.end(), std::back_inserter(pool));
+            writing.clear();
+            writingTimes.clear();
+            writeInProgress = false;
+        }
+        written.notify_all();
+    }
+
+    frames_t staged;
+    frames_t writing;
+    frames_t pool;
+    times_t stagedTimes;
+    times_t writingTimes;
+    bool drainScheduled{false};
+    bool writeInProgress{false};
+    std::mutex mutex;
+    std::condition_variable written;
+};
+}
+
 const std::string Trajectory::TRAJECTORY_GROUP_PATH = "/readdy/trajectory";
 
 struct Trajectory::Impl {
     std::unique_ptr<io::VLENDataSet> dataSet;
     std::unique_ptr<util::TimeSeriesWriter> time;
+    StagedFrames frames;
+
+    void write(StagedFrames::frames_t &frames, const StagedFrames::times_t &times) {
+        dataSet->append({frames.size()}, frames.data());
+        time->append(times);
+    }
 };
 
 
@@ -55,20 +168,23 @@ Trajectory::Trajectory(readdy::model::Kernel *const kernel, unsigned int stride)
 }
 
 void Trajectory::evaluate() {
-    result.clear();
-    const auto &currentInput = kernel->getKernelStateModel().getParticles();
-    std::for_each(currentInput.begin(), currentInput.end(), [this](const Particle &p) {
-        result.push_back(TrajectoryEntry{p});
-    });
+    kernel->getKernelStateModel().toTrajectoryFrame(result);
 }
 
 void Trajectory::flush() {
+    pimpl->frames.wait();
     if (pimpl->dataSet) pimpl->dataSet->flush();
     if (pimpl->time) pimpl->time->flush();
 
 }
 
-Trajectory::~Trajectory() = default;
+Trajectory::~Trajectory() {
+    pimpl->frames.wait();
+    // the writer thread might still be busy with other data sets
+    std::lock_guard<std::recursive_mutex> lock(io::dataSetMutex());
+    pimpl->dataSet.reset();
+    pimpl->time.reset();
+}
 
 void Trajectory::initializeDataSet(io::File &file, const std::string &dataSetName, unsigned int flushStride) {
     if (!pimpl->dataSet) {
@@ -84,8 +200,14 @@ void Trajectory::initializeDataSet(io::File &file, const std::string &dataSetNam
 }
 
 void Trajectory::append() {
-    pimpl->dataSet->append({1}, &result);
-    pimpl->time->append(t_current);
+    if (pimpl->frames.stage(result, t_current)) {
+        auto impl = pimpl.get();
+        kernel->asyncWriter().enqueue([impl] {
+            impl->frames.drain([impl](StagedFrames::frames_t &frames, const StagedFrames::times_t &times) {
+                impl->write(frames, times);
+            });
+        });
+    }
 }
 
 struct FlatTrajectory::Impl {
@@ -93,11 +215,29 @@ struct FlatTrajectory::Impl {
     std::unique_ptr<readdy::io::DataSet> limits;
     std::unique_ptr<util::TimeSeriesWriter> time;
     std::size_t current_limits[2]{0, 0};
+    StagedFrames frames;
+    // buffers of the writer thread, holding the concatenated records and limits of a batch of frames
+    std::vector<TrajectoryEntry> records;
+    std::vector<std::size_t> batchLimits;
+
+    void write(StagedFrames::frames_t &frames, const StagedFrames::times_t &times) {
+        records.clear();
+        batchLimits.clear();
+        for (const auto &frame : frames) {
+            current_limits[0] = current_limits[1];
+            current_limits[1] += frame.size();
+            batchLimits.push_back(current_limits[0]);
+            batchLimits.push_back(current_limits[1]);
+            records.insert(records.end(), frame.begin(), frame.end());
+        }
+        dataSet->append({records.size()}, records.data());
+        time->append(times);
+        limits->append({frames.size(), 2}, batchLimits.data());
+    }
 };
 
 FlatTrajectory::FlatTrajectory(Kernel *const kernel, unsigned int stride) : Observable(kernel, stride),
                                                                             pimpl(std::make_unique<Impl>()) {}
-
 void FlatTrajectory::initializeDataSet(io::File &file, const std::string &dataSetName, unsigned int flushStride) {
     if (!pimpl->dataSet) {
         auto group = file.createGroup(
@@ -122,30 +262,216 @@ void FlatTrajectory::initializeDataSet(io::File &file, const std::string &dataSe
 }
 
 void FlatTrajectory::evaluate() {
-    result.clear();
-    const auto &currentInput = kernel->getKernelStateModel().getParticles();
-    std::for_each(currentInput.begin(), currentInput.end(), [this](const Particle &p) {
-        result.push_back(TrajectoryEntry{p});
-    });
+    kernel->getKernelStateModel().toTrajectoryFrame(result);
 }
 
 void FlatTrajectory::flush() {
+    pimpl->frames.wait();
     if (pimpl->dataSet) pimpl->dataSet->flush();
     if (pimpl->time) pimpl->time->flush();
     if (pimpl->limits) pimpl->limits->flush();
 }
 
 void FlatTrajectory::append() {
-    pimpl->current_limits[0] = pimpl->current_limits[1];
-    pimpl->current_limits[1] += result.size();
-    pimpl->dataSet->append({result.size()}, result.data());
-    pimpl->time->append(t_current);
-    pimpl->limits->append({1, 2}, pimpl->current_limits);
+    if (pimpl->frames.stage(result, t_current)) {
+        auto impl = pimpl.get();
+        kernel->asyncWriter().enqueue([impl] {
+            impl->frames.drain([impl](StagedFrames::frames_t &frames, const StagedFrames::times_t &times) {
+                impl->write(frames, times);
+            });
+        });
+    }
 }
 
 FlatTrajectory::FlatTrajectory(FlatTrajectory &&) = default;
 
-FlatTrajectory::~FlatTrajectory() = default;
+FlatTrajectory::~FlatTrajectory() {
+    if (pimpl) {
+        pimpl->frames.wait();
+        std::lock_guard<std::recursive_mutex> lock(io::dataSetMutex());
+        pimpl->dataSet.reset();
+        pimpl->limits.reset();
+        pimpl->time.reset();
+    }
+}
+struct ColumnarTrajectory::Impl {
+    using id_t = readdy::model::Particle::id_type;
+    using type_t = readdy::model::Particle::type_type;
+
+    static constexpr id_t padding_id = std::numeric_limits<id_t>::max();
+    static constexpr type_t padding_type = std::numeric_limits<type_t>::max();
+
+    std::size_t maxParticles;
+    bool singlePrecision;
+    double precision;
+    unsigned int flushStride{0};
+    std::unique_ptr<io::Group> group;
+    std::unique_ptr<io::DataSet> positions;
+    std::unique_ptr<io::DataSet> ids;
+    std::unique_ptr<io::DataSet> types;
+    std::unique_ptr<io::DataSet> nParticles;
+    std::unique_ptr<util::TimeSeriesWriter> time;
+    StagedFrames frames;
+    // column buffers of the writer thread
+    std::vector<double> positionsF64;
+    std::vector<float> positionsF32;
+    std::vector<int> positionsQuantized;
+    std::vector<id_t> idsBuffer;
+    std::vector<type_t> typesBuffer;
+    std::vector<std::size_t> nParticlesBuffer;
+
+    Impl(std::size_t maxParticles, bool singlePrecision, double precision)
+            : maxParticles(maxParticles), singlePrecision(singlePrecision), precision(precision) {}
+
+    /**
+     * creates the data sets, called once the number of particles per frame is known
+     * @param boxSize the box size, the quantized positions inside of the box must fit into 32 bit integers
+     */
+    void createDataSets(const std::array<double, 3> &boxSize) {
+        if (precision > 0) {
+            const auto halfExtent = .5 * *std::max_element(boxSize.begin(), boxSize.end());
+            if (halfExtent / precision >= static_cast<double>(std::numeric_limits<int>::max())) {
+                throw std::invalid_argument("the precision (" + std::to_string(precision) + ") is too fine to store "
+                        "positions of up to " + std::to_string(halfExtent) + " in magnitude as 32 bit integers");
+            }
+        }
+        const io::h5::dims_t n = maxParticles;
+        const io::h5::dims_t chunkParticles = std::max(std::min(maxParticles, particles_per_chunk),
+                                                       static_cast<std::size_t>(1));
+        const std::vector<io::h5::dims_t> chunk3 = {flushStride, chunkParticles, 3};
+        const std::vector<io::h5::dims_t> maxDims3 = {io::h5::UNLIMITED_DIMS, n, 3};
+        if (precision > 0) {
+            positions = std::make_unique<io::DataSet>(group->createDataSet<int>("positions", chunk3, maxDims3));
+            group->write("position_precision", std::vector<double>{precision});
+        } else if (singlePrecision) {
+            positions = std::make_unique<io::DataSet>(group->createDataSet<float>("positions", chunk3, maxDims3));
+        } else {
+            positions = std::make_unique<io::DataSet>(group->createDataSet<double>("positions", chunk3, maxDims3));
+        }
+        const std::vector<io::h5::dims_t> chunk2 = {flushStride, chunkParticles};
+        const std::vector<io::h5::dims_t> maxDims2 = {io::h5::UNLIMITED_DIMS, n};
+        ids = std::make_unique<io::DataSet>(group->createDataSet<id_t>("ids", chunk2, maxDims2));
+        types = std::make_unique<io::DataSet>(group->createDataSet<type_t>("types", chunk2, maxDims2));
+        nParticles = std::make_unique<io::DataSet>(group->createDataSet<std::size_t>(
+                "n_particles", {flushStride}, {io::h5::UNLIMITED_DIMS}));
+    }
+
+    template<typename T, typename Convert>
+    void writePositions(std::vector<T> &buffer, const StagedFrames::frames_t &frames, Convert &&convert) {
+        buffer.assign(frames.size() * maxParticles * 3, 0);
+        auto out = buffer.begin();
+        for (const auto &frame : frames) {
+            for (const auto &entry : frame) {
+                *out++ = convert(entry.pos.x);
+                *out++ = convert(entry.pos.y);
+                *out++ = convert(entry.pos.z);
+            }
+            out += 3 * (maxParticles - frame.size());
+        }
+        positions->append({frames.size(), maxParticles, 3}, buffer.data());
+    }
+
+    void write(StagedFrames::frames_t &frames, const StagedFrames::times_t &times) {
+        const auto nFrames = frames.size();
+        if (precision > 0) {
+            const auto inverse = 1. / precision;
+            writePositions(positionsQuantized, frames, [inverse](double x) {
+                return static_cast<int>(std::lround(x * inverse));
+            });
+        } else if (singlePrecision) {
+            writePositions(positionsF32, frames, [](double x) { return static_cast<float>(x); });
+        } else {
+            writePositions(positionsF64, frames, [](double x) { return x; });
+        }
+        idsBuffer.assign(nFrames * maxParticles, padding_id);
+        typesBuffer.assign(nFrames * maxParticles, padding_type);
+        nParticlesBuffer.resize(nFrames);
+        for (std::size_t f = 0; f < nFrames; ++f) {
+            const auto &frame = frames[f];
+            for (std::size_t i = 0; i < frame.size(); ++i) {
+                idsBuffer[f * maxParticles + i] = frame[i].id;
+                typesBuffer[f * maxParticles + i] = frame[i].typeId;
+            }
+            nParticlesBuffer[f] = frame.size();
+        }
+        ids->append({nFrames, maxParticles}, idsBuffer.data());
+        types->append({nFrames, maxParticles}, typesBuffer.data());
+        nParticles->append({nFrames}, nParticlesBuffer.data());
+        time->append(times);
+    }
+};
+
+constexpr std::size_t ColumnarTrajectory::particles_per_chunk;
+constexpr ColumnarTrajectory::Impl::id_t ColumnarTrajectory::Impl::padding_id;
+constexpr ColumnarTrajectory::Impl::type_t ColumnarTrajectory::Impl::padding_type;
+
+ColumnarTrajectory::ColumnarTrajectory(Kernel *const kernel, unsigned int stride, std::size_t maxParticles,
+                                       bool singlePrecision, double precision)
+        : super(kernel, stride), pimpl(std::make_unique<Impl>(maxParticles, singlePrecision, precision)) {}
+
+void ColumnarTrajectory::evaluate() {
+    kernel->getKernelStateModel().toTrajectoryFrame(result);
+}
+
+void ColumnarTrajectory::initializeDataSet(io::File &file, const std::string &dataSetName, unsigned int flushStride) {
+    if (!pimpl->group) {
+        pimpl->flushStride = std::max(flushStride, 1u);
+        pimpl->group = std::make_unique<io::Group>(file.createGroup(
+                std::string(Trajectory::TRAJECTORY_GROUP_PATH + (dataSetName.length() > 0 ? "/" + dataSetName : ""))));
+        pimpl->time = std::make_unique<util::TimeSeriesWriter>(*pimpl->group, pimpl->flushStride);
+        if (pimpl->maxParticles > 0) {
+            pimpl->createDataSets(kernel->getKernelContext().getBoxSize());
+        }
+    }
+}
+
+void ColumnarTrajectory::append() {
+    if (!pimpl->positions) {
+        // the bound is given by the first frame
+        if (result.empty()) {
+            throw std::runtime_error("the first frame of the columnar trajectory is empty, the bound on the number of "
+                                     "particles has to be given explicitly");
+        }
+        pimpl->maxParticles = result.size();
+        std::lock_guard<std::recursive_mutex> lock(io::dataSetMutex());
+        pimpl->createDataSets(kernel->getKernelContext().getBoxSize());
+    }
+    if (result.size() > pimpl->maxParticles) {
+        throw std::runtime_error("the number of particles (" + std::to_string(result.size()) + ") exceeds the bound ("
+                                 + std::to_string(pimpl->maxParticles) + ") of the columnar trajectory");
+    }
+    if (pimpl->frames.stage(result, t_current)) {
+        auto impl = pimpl.get();
+        kernel->asyncWriter().enqueue([impl] {
+            impl->frames.drain([impl](StagedFrames::frames_t &frames, const StagedFrames::times_t &times) {
+                impl->write(frames, times);
+            });
+        });
+    }
+}
+
+void ColumnarTrajectory::flush() {
+    pimpl->frames.wait();
+    if (pimpl->positions) {
+        pimpl->positions->flush();
+        pimpl->ids->flush();
+        pimpl->types->flush();
+        pimpl->nParticles->flush();
+    }
+    if (pimpl->time) pimpl->time->flush();
+}
+
+ColumnarTrajectory::~ColumnarTrajectory() {
+    pimpl->frames.wait();
+    std::lock_guard<std::recursive_mutex> lock(io::dataSetMutex());
+    pimpl->positions.reset();
+    pimpl->ids.reset();
+    pimpl->types.reset();
+    pimpl->nParticles.reset();
+    pimpl->time.reset();
+    pimpl->group.reset();
+}
+
 }
 }
 }
\ No newline at end of file
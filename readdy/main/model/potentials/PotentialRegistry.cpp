@@ -20,8 +20,11 @@
  ********************************************************************/
 
 
+#include <algorithm>
+#include <typeinfo>
 #include <readdy/model/potentials/PotentialRegistry.h>
 #include <readdy/common/Utils.h>
+#include <readdy/model/potentials/PotentialsOrder2.h>
 
 /**
  * << detailed description >>
@@ -150,6 +153,118 @@ void PotentialRegistry::configure() {
         ptr->configureForTypes(&typeRegistry, std::get<0>(type), std::get<1>(type));
         (potentialO2Registry)[type].push_back(ptr);
     });
+    if (autoTabulateEnabled) {
+        tabulatePotentials();
+    } else {
+        tabulatedPotentials.clear();
+    }
+    compilePairPotentialTable();
+}
+
+void PotentialRegistry::setAutoTabulate(bool enabled, std::size_t nSamples) {
+    autoTabulateEnabled = enabled;
+    nTabulationSamples = nSamples;
+}
+
+bool PotentialRegistry::autoTabulate() const {
+    return autoTabulateEnabled;
+}
+
+void PotentialRegistry::tabulatePotentials() {
+    decltype(tabulatedPotentials) tabulated;
+    for (auto &entry : potentialO2Registry) {
+        for (auto &potential : entry.second) {
+            const auto &type = typeid(*potential);
+            if (type == typeid(HarmonicRepulsion) || type == typeid(WeakInteractionPiecewiseHarmonic)
+                || type == typeid(TabulatedPotentialOrder2)) {
+                continue;
+            }
+            std::unique_ptr<TabulatedPotentialOrder2> table;
+            auto it = tabulatedPotentials.find(potential->getId());
+            if (it != tabulatedPotentials.end() && it->second->getTabulatedPotential() == potential
+                && it->second->nSamples == nTabulationSamples) {
+                table = std::move(it->second);
+            } else {
+                table = std::make_unique<TabulatedPotentialOrder2>(potential->particleType1, potential->particleType2,
+                                                                   potential, nTabulationSamples);
+            }
+            table->configureForTypes(&typeRegistry, std::get<0>(entry.first), std::get<1>(entry.first));
+            const auto id = potential->getId();
+            potential = table.get();
+            tabulated[id] = std::move(table);
+        }
+    }
+    tabulatedPotentials = std::move(tabulated);
+}
+
+const PairPotentialTable &PotentialRegistry::pair_potential_table() const {
+    return pairPotentialTable;
+}
+
+void PotentialRegistry::compilePairPotentialTable() {
+    auto &table = pairPotentialTable;
+    std::size_t nTypes = 0;
+    for (const auto type : typeRegistry.types_flat()) {
+        nTypes = std::max(nTypes, static_cast<std::size_t>(type) + 1);
+    }
+    table._nTypes = nTypes;
+    table._entries.clear();
+    table._offsets.assign(nTypes * nTypes + 1, 0);
+    table._uniform = true;
+    table._uniformKind = PairPotentialKind::GENERIC;
+
+    auto compile = [](const PotentialOrder2 *potential) {
+        PairPotentialEntry entry{PairPotentialKind::GENERIC, potential->getCutoffRadiusSquared(), {{0, 0, 0, 0, 0}},
+                                 potential};
+        const auto &type = typeid(*potential);
+        if (type == typeid(HarmonicRepulsion)) {
+            auto p = static_cast<const HarmonicRepulsion *>(potential);
+            entry.kind = PairPotentialKind::HARMONIC_REPULSION;
+            entry.params = {{p->forceConstant, p->sumOfParticleRadii, 0, 0, 0}};
+        } else if (type == typeid(WeakInteractionPiecewiseHarmonic)) {
+            auto p = static_cast<const WeakInteractionPiecewiseHarmonic *>(potential);
+            entry.kind = PairPotentialKind::WEAK_INTERACTION_PIECEWISE_HARMONIC;
+            entry.params = {{p->forceConstant, p->conf.desiredParticleDistance, p->conf.depthAtDesiredDistance,
+                             p->conf.noInteractionDistance, 0}};
+        } else if (type == typeid(LennardJones)) {
+            auto p = static_cast<const LennardJones *>(potential);
+            entry.kind = PairPotentialKind::LENNARD_JONES;
+            entry.params = {{p->k, p->m, p->n, p->sigma, p->shift ? p->energy(p->cutoffDistance) : 0}};
+        } else if (type == typeid(TabulatedPotentialOrder2)) {
+            entry.kind = PairPotentialKind::TABULATED;
+        } else if (type == typeid(ScreenedElectrostatics)) {
+            auto p = static_cast<const ScreenedElectrostatics *>(potential);
+            entry.kind = PairPotentialKind::SCREENED_ELECTROSTATICS;
+            entry.params = {{p->electrostaticStrength, p->inverseScreeningDepth, p->repulsionStrength,
+                             p->repulsionDistance, p->exponent}};
+        }
+        return entry;
+    };
+
+    bool first = true;
+    for (std::size_t t1 = 0; t1 < nTypes; ++t1) {
+        for (std::size_t t2 = 0; t2 < nTypes; ++t2) {
+            auto it = potentialO2Registry.find(std::make_tuple(static_cast<particle_type_type>(t1),
+                                                               static_cast<particle_type_type>(t2)));
+            if (it != potentialO2Registry.end()) {
+                if (it->second.size() > 1) table._uniform = false;
+                for (const auto potential : it->second) {
+                    table._entries.push_back(compile(potential));
+                    const auto kind = table._entries.back().kind;
+                    if (first) {
+                        table._uniformKind = kind;
+                        first = false;
+                    } else if (kind != table._uniformKind) {
+                        table._uniform = false;
+                    }
+                }
+            }
+            table._offsets[t1 * nTypes + t2 + 1] = table._entries.size();
+        }
+    }
+    if (table._entries.empty()) {
+        table._uniform = false;
+    }
 }
 
 void PotentialRegistry::debug_output() const {
@@ -0,0 +1,126 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          * 
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+/**
+ * @file TabulatedPotentialOrder2.cpp
+ * @brief Implementation of the tabulated order 2 potential
+ * @author clonker
+ * @date 18.10.17
+ * @copyright GNU Lesser General Public License v3.0
+ */
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include <readdy/model/potentials/TabulatedPotentialOrder2.h>
+
+namespace readdy {
+namespace model {
+namespace potentials {
+
+constexpr std::size_t TabulatedPotentialOrder2::default_n_samples;
+
+TabulatedPotentialOrder2::TabulatedPotentialOrder2(const std::string &particleType1, const std::string &particleType2,
+                                                   const PotentialOrder2 *potential, std::size_t nSamples)
+        : super(particleType1, particleType2), potential(potential), nSamples(nSamples) {
+    if (potential == nullptr) {
+        throw std::invalid_argument("the tabulated potential must not be null!");
+    }
+    if (nSamples < 2) {
+        throw std::invalid_argument("a tabulated potential needs at least two samples, got " +
+                                    std::to_string(nSamples) + "!");
+    }
+}
+
+void TabulatedPotentialOrder2::configureForTypes(const ParticleTypeRegistry *const, particle_type_type,
+                                                 particle_type_type) {
+    cutoffSquared = potential->getCutoffRadiusSquared();
+    table.assign(nSamples + 2, {0, 0});
+    if (cutoffSquared <= 0) {
+        sMin = 0;
+        inverseSpacing = 0;
+        return;
+    }
+    // the samples are placed at k * spacing for k = 1, ..., nSamples, so that the last one sits on the cutoff and the
+    // singularity at r = 0 that many potentials have is avoided
+    const auto spacing = cutoffSquared / nSamples;
+    sMin = spacing;
+    inverseSpacing = 1. / spacing;
+    for (std::size_t k = 0; k < nSamples; ++k) {
+        const auto r = std::sqrt(sMin + k * spacing);
+        Vec3 force{0, 0, 0};
+        double energy = 0;
+        potential->calculateForceAndEnergy(force, energy, {r, 0, 0});
+        table[k + 1] = {energy, force[0] / r};
+    }
+    // ghost samples by linear extrapolation
+    table[0] = {2 * table[1].energy - table[2].energy, 2 * table[1].forceFactor - table[2].forceFactor};
+    table[nSamples + 1] = {2 * table[nSamples].energy - table[nSamples - 1].energy,
+                           2 * table[nSamples].forceFactor - table[nSamples - 1].forceFactor};
+}
+
+std::string TabulatedPotentialOrder2::describe() const {
+    std::ostringstream ss;
+    ss << "TabulatedPotentialOrder2[nSamples: " << nSamples << ", potential: " << potential->describe() << "]";
+    return ss.str();
+}
+
+double TabulatedPotentialOrder2::getMaximalForce(double kbt) const noexcept {
+    return potential->getMaximalForce(kbt);
+}
+
+double TabulatedPotentialOrder2::calculateEnergy(const Vec3 &x_ij) const {
+    Vec3 force{0, 0, 0};
+    double energy = 0;
+    calculateForceAndEnergy(force, energy, x_ij);
+    return energy;
+}
+
+void TabulatedPotentialOrder2::calculateForce(Vec3 &force, const Vec3 &x_ij) const {
+    double energy = 0;
+    force = {0, 0, 0};
+    calculateForceAndEnergy(force, energy, x_ij);
+}
+
+void TabulatedPotentialOrder2::calculateForceAndEnergy(Vec3 &force, double &energy, const Vec3 &x_ij) const {
+    const auto distSquared = x_ij * x_ij;
+    if (distSquared < cutoffSquared) {
+        evaluate(x_ij, distSquared, force, energy);
+    }
+}
+
+double TabulatedPotentialOrder2::getCutoffRadius() const {
+    return potential->getCutoffRadius();
+}
+
+double TabulatedPotentialOrder2::getCutoffRadiusSquared() const {
+    return potential->getCutoffRadiusSquared();
+}
+
+const PotentialOrder2 *TabulatedPotentialOrder2::getTabulatedPotential() const {
+    return potential;
+}
+
+}
+}
+}
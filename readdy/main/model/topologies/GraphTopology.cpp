@@ -80,86 +80,235 @@ void GraphTopology::configure() {
     bondedPotentials.clear();
     anglePotentials.clear();
     torsionPotentials.clear();
-
-    std::unordered_map<api::BondType, std::vector<pot::BondConfiguration>, readdy::util::hash::EnumClassHash> bonds;
-    std::unordered_map<api::AngleType, std::vector<pot::AngleConfiguration>, readdy::util::hash::EnumClassHash> angles;
-    std::unordered_map<api::TorsionType, std::vector<pot::DihedralConfiguration>, readdy::util::hash::EnumClassHash> dihedrals;
+    _bondPotentials.clear();
+    _anglePotentials.clear();
+    _torsionPotentials.clear();
+    _bonds.reset(getNParticles());
+    _angles.reset(getNParticles());
+    _dihedrals.reset(getNParticles());
+    _changedVertices.clear();
+    _configured = false;
+    touch();
 
     graph_.findNTuples([&](const graph_t::edge &tuple) {
-        auto v1 = std::get<0>(tuple);
-        auto v2 = std::get<1>(tuple);
-        auto it = config.pairPotentials.find(
-                std::tie(v1->particleType(), v2->particleType()));
-        if (it != config.pairPotentials.end()) {
-            for (const auto &cfg : it->second) {
-                bonds[cfg.type].emplace_back(v1->particleIndex, v2->particleIndex,
-                                             cfg.forceConstant, cfg.length);
-            }
-        } else {
-            std::ostringstream ss;
+        insertBond(std::get<0>(tuple).data(), std::get<1>(tuple).data());
+    }, [&](const graph_t::path_len_2 &triple) {
+        insertAngle(std::get<0>(triple).data(), std::get<1>(triple).data(), std::get<2>(triple).data());
+    }, [&](const graph_t::path_len_3 &quadruple) {
+        insertDihedral(std::get<0>(quadruple).data(), std::get<1>(quadruple).data(), std::get<2>(quadruple).data(),
+                       std::get<3>(quadruple).data());
+    });
+    _configured = true;
+}
 
-            ss << "The edge " << v1->particleIndex;
-            if (!v1->label().empty()) {
-                ss << " (" << v1->label() << ")";
+void GraphTopology::updateBondedPotentials() {
+    if (!_configured) {
+        configure();
+        return;
+    }
+    // if anything goes wrong on the way, the next update starts from scratch
+    _configured = false;
+    touch();
+
+    using vertex_ptr = graph::Vertex::vertex_ptr;
+    std::sort(_changedVertices.begin(), _changedVertices.end(), [](const vertex_ptr &v1, const vertex_ptr &v2) {
+        return v1->particleIndex < v2->particleIndex;
+    });
+    _changedVertices.erase(std::unique(_changedVertices.begin(), _changedVertices.end()), _changedVertices.end());
+
+    {
+        // remove the tuples containing a changed vertex, as they were before the change
+        const auto bondsOf = [this](api::BondType type) -> pot::BondedPotential::bonds_t & {
+            return bonds(type);
+        };
+        const auto anglesOf = [this](api::AngleType type) -> pot::HarmonicAnglePotential::angles_t & {
+            return angles(type);
+        };
+        const auto dihedralsOf = [this](api::TorsionType type) -> pot::CosineDihedralPotential::dihedrals_t & {
+            return dihedrals(type);
+        };
+        const auto bondKey = [](const pot::BondConfiguration &bond) {
+            return decltype(_bonds)::key_type{{bond.idx1, bond.idx2}};
+        };
+        // angle configurations hold the center first
+        const auto angleKey = [](const pot::AngleConfiguration &angle) {
+            return decltype(_angles)::key_type{{angle.idx2, angle.idx1, angle.idx3}};
+        };
+        const auto dihedralKey = [](const pot::DihedralConfiguration &dihedral) {
+            return decltype(_dihedrals)::key_type{{dihedral.idx1, dihedral.idx2, dihedral.idx3, dihedral.idx4}};
+        };
+        for (const auto &vertex : _changedVertices) {
+            const auto idx = vertex->particleIndex;
+            const std::vector<decltype(_bonds)::key_type> incidentBonds(_bonds.incident(idx).begin(),
+                                                                        _bonds.incident(idx).end());
+            for (const auto &key : incidentBonds) {
+                _bonds.erase(key, bondsOf, bondKey);
             }
-            ss << " -- " << v2->particleIndex;
-            if (!v2->label().empty()) {
-                ss << " (" << v2->label() << ")";
+            const std::vector<decltype(_angles)::key_type> incidentAngles(_angles.incident(idx).begin(),
+                                                                          _angles.incident(idx).end());
+            for (const auto &key : incidentAngles) {
+                _angles.erase(key, anglesOf, angleKey);
             }
-            ss << " has no bond configured! (See KernelContext.configureTopologyBondPotential())";
-
-            throw std::invalid_argument(ss.str());
-        }
-    }, [&](const graph_t::path_len_2 &triple) {
-        const auto &v1 = std::get<0>(triple);
-        const auto &v2 = std::get<1>(triple);
-        const auto &v3 = std::get<2>(triple);
-        auto it = config.anglePotentials.find(std::tie(v1->particleType(), v2->particleType(), v3->particleType()));
-        if (it != config.anglePotentials.end()) {
-            for (const auto &cfg : it->second) {
-                angles[cfg.type].emplace_back(v2->particleIndex, v1->particleIndex, v3->particleIndex,
-                                              cfg.forceConstant, cfg.equilibriumAngle);
+            const std::vector<decltype(_dihedrals)::key_type> incidentDihedrals(_dihedrals.incident(idx).begin(),
+                                                                                _dihedrals.incident(idx).end());
+            for (const auto &key : incidentDihedrals) {
+                _dihedrals.erase(key, dihedralsOf, dihedralKey);
             }
         }
-    }, [&](const graph_t::path_len_3 &quadruple) {
-        const auto &v1 = std::get<0>(quadruple);
-        const auto &v2 = std::get<1>(quadruple);
-        const auto &v3 = std::get<2>(quadruple);
-        const auto &v4 = std::get<3>(quadruple);
-        auto it = config.torsionPotentials.find(
-                std::tie(v1->particleType(), v2->particleType(), v3->particleType(), v4->particleType()));
-        if (it != config.torsionPotentials.end()) {
-            for (const auto &cfg : it->second) {
-                dihedrals[cfg.type].emplace_back(v1->particleIndex, v2->particleIndex, v3->particleIndex,
-                                                 v4->particleIndex, cfg.forceConstant, cfg.multiplicity,
-                                                 cfg.phi_0);
+    }
+    {
+        // enumerate the tuples containing a changed vertex, the same rules as in Graph::findNTuples apply
+        const auto adjacent = [](const vertex_ptr &v1, const vertex_ptr &v2) {
+            const auto &neighbors = v1->neighbors();
+            return std::find(neighbors.begin(), neighbors.end(), v2) != neighbors.end();
+        };
+        for (const auto &w : _changedVertices) {
+            for (const auto &u : w->neighbors()) {
+                insertBond(w, u);
+                // w at the end of the path
+                for (const auto &v : u->neighbors()) {
+                    if (v == w) continue;
+                    insertAngle(w, u, v);
+                    if (adjacent(w, v)) continue;
+                    for (const auto &y : v->neighbors()) {
+                        if (y != u && !adjacent(y, u)) {
+                            insertDihedral(w, u, v, y);
+                        }
+                    }
+                }
+                // w inside the path
+                for (const auto &v : w->neighbors()) {
+                    if (v == u) continue;
+                    insertAngle(u, w, v);
+                    if (adjacent(u, v)) continue;
+                    for (const auto &y : v->neighbors()) {
+                        if (y != w && !adjacent(y, w)) {
+                            insertDihedral(u, w, v, y);
+                        }
+                    }
+                }
             }
         }
-    });
-    for (const auto &bond : bonds) {
-        switch (bond.first) {
+    }
+    _changedVertices.clear();
+    _configured = true;
+}
+
+void GraphTopology::markChanged(graph::Vertex::vertex_ptr vertex) {
+    _changedVertices.push_back(vertex);
+}
+
+void GraphTopology::insertBond(graph::Vertex::vertex_ptr v1, graph::Vertex::vertex_ptr v2) {
+    if (v1->particleIndex > v2->particleIndex) {
+        std::swap(v1, v2);
+    }
+    const decltype(_bonds)::key_type key{{v1->particleIndex, v2->particleIndex}};
+    if (_bonds.contains(key)) return;
+    auto it = config.pairPotentials.find(std::tie(v1->particleType(), v2->particleType()));
+    if (it != config.pairPotentials.end()) {
+        for (const auto &cfg : it->second) {
+            auto &configurations = bonds(cfg.type);
+            _bonds.insert(key, cfg.type, configurations.size());
+            configurations.emplace_back(key[0], key[1], cfg.forceConstant, cfg.length);
+        }
+    } else {
+        std::ostringstream ss;
+
+        ss << "The edge " << v1->particleIndex;
+        if (!v1->label().empty()) {
+            ss << " (" << v1->label() << ")";
+        }
+        ss << " -- " << v2->particleIndex;
+        if (!v2->label().empty()) {
+            ss << " (" << v2->label() << ")";
+        }
+        ss << " has no bond configured! (See KernelContext.configureTopologyBondPotential())";
+
+        throw std::invalid_argument(ss.str());
+    }
+}
+
+void GraphTopology::insertAngle(graph::Vertex::vertex_ptr v1, graph::Vertex::vertex_ptr center,
+                                graph::Vertex::vertex_ptr v2) {
+    if (v1->particleIndex > v2->particleIndex) {
+        std::swap(v1, v2);
+    }
+    const decltype(_angles)::key_type key{{v1->particleIndex, center->particleIndex, v2->particleIndex}};
+    if (_angles.contains(key)) return;
+    auto it = config.anglePotentials.find(std::tie(v1->particleType(), center->particleType(), v2->particleType()));
+    if (it != config.anglePotentials.end()) {
+        for (const auto &cfg : it->second) {
+            auto &configurations = angles(cfg.type);
+            _angles.insert(key, cfg.type, configurations.size());
+            configurations.emplace_back(key[1], key[0], key[2], cfg.forceConstant, cfg.equilibriumAngle);
+        }
+    }
+}
+
+void GraphTopology::insertDihedral(graph::Vertex::vertex_ptr v1, graph::Vertex::vertex_ptr v2,
+                                   graph::Vertex::vertex_ptr v3, graph::Vertex::vertex_ptr v4) {
+    if (v2->particleIndex > v3->particleIndex) {
+        std::swap(v1, v4);
+        std::swap(v2, v3);
+    }
+    const decltype(_dihedrals)::key_type key{{v1->particleIndex, v2->particleIndex, v3->particleIndex,
+                                              v4->particleIndex}};
+    if (_dihedrals.contains(key)) return;
+    auto it = config.torsionPotentials.find(
+            std::tie(v1->particleType(), v2->particleType(), v3->particleType(), v4->particleType()));
+    if (it != config.torsionPotentials.end()) {
+        for (const auto &cfg : it->second) {
+            auto &configurations = dihedrals(cfg.type);
+            _dihedrals.insert(key, cfg.type, configurations.size());
+            configurations.emplace_back(key[0], key[1], key[2], key[3], cfg.forceConstant, cfg.multiplicity,
+                                        cfg.phi_0);
+        }
+    }
+}
+
+pot::BondedPotential::bonds_t &GraphTopology::bonds(api::BondType type) {
+    auto it = _bondPotentials.find(type);
+    if (it == _bondPotentials.end()) {
+        switch (type) {
             case api::BondType::HARMONIC: {
-                addBondedPotential(std::make_unique<harmonic_bond>(this, bond.second));
+                auto potential = std::make_unique<harmonic_bond>(this, pot::BondedPotential::bonds_t{});
+                it = _bondPotentials.emplace(type, potential.get()).first;
+                addBondedPotential(std::move(potential));
                 break;
             };
         }
     }
-    for (const auto &angle : angles) {
-        switch (angle.first) {
+    return it->second->bonds;
+}
+
+pot::HarmonicAnglePotential::angles_t &GraphTopology::angles(api::AngleType type) {
+    auto it = _anglePotentials.find(type);
+    if (it == _anglePotentials.end()) {
+        switch (type) {
             case api::AngleType::HARMONIC: {
-                addAnglePotential(std::make_unique<harmonic_angle>(this, angle.second));
+                auto potential = std::make_unique<harmonic_angle>(this, pot::HarmonicAnglePotential::angles_t{});
+                it = _anglePotentials.emplace(type, potential.get()).first;
+                addAnglePotential(std::move(potential));
                 break;
             };
         }
     }
-    for (const auto &dih : dihedrals) {
-        switch (dih.first) {
+    return it->second->angles;
+}
+
+pot::CosineDihedralPotential::dihedrals_t &GraphTopology::dihedrals(api::TorsionType type) {
+    auto it = _torsionPotentials.find(type);
+    if (it == _torsionPotentials.end()) {
+        switch (type) {
             case api::TorsionType::COS_DIHEDRAL: {
-                addTorsionPotential(std::make_unique<cos_dihedral>(this, dih.second));
+                auto potential = std::make_unique<cos_dihedral>(this, pot::CosineDihedralPotential::dihedrals_t{});
+                it = _torsionPotentials.emplace(type, potential.get()).first;
+                addTorsionPotential(std::move(potential));
                 break;
             };
         }
     }
+    return it->second->dihedrals;
 }
 
 void GraphTopology::validate() {
@@ -176,16 +325,7 @@ void GraphTopology::updateReactionRates() {
         std::get<1>(reaction) = rate;
         _cumulativeRate += rate;
     }
-    {
-        std::stringstream ss;
-        for(const auto& r : reactions_) {
-            ss << std::get<1>(r) << " + ";
-        }
-        const void * address = static_cast<const void*>(this);
-        std::stringstream ss2;
-        ss2 << address;
-        std::string name = ss2.str();
-    }
+    touch();
 }
 
 void GraphTopology::addReaction(const reactions::TopologyReaction &reaction) {
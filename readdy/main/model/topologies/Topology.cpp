@@ -30,15 +30,25 @@
  * @copyright GNU Lesser General Public License v3.0
  */
 
+#include <atomic>
+
 #include <readdy/model/topologies/Topology.h>
 
 namespace readdy {
 namespace model {
 namespace top {
+
+namespace {
+std::size_t nextVersion() {
+    static std::atomic<std::size_t> version{0};
+    return ++version;
+}
+}
+
 readdy::model::top::Topology::~Topology() = default;
 
-Topology::Topology(Topology::particles_t &&p) : particles(std::move(p)) { }
-Topology::Topology(const Topology::particles_t &p) : particles(p) { }
+Topology::Topology(Topology::particles_t &&p) : _version(nextVersion()), particles(std::move(p)) { }
+Topology::Topology(const Topology::particles_t &p) : _version(nextVersion()), particles(p) { }
 
 Topology::particles_t::size_type Topology::getNParticles() const {
     return particles.size();
@@ -49,6 +59,7 @@ const Topology::particles_t &Topology::getParticles() const {
 }
 
 Topology::particles_t &Topology::getParticles() {
+    touch();
     return particles;
 }
 
@@ -69,6 +80,7 @@ void Topology::addAnglePotential(std::unique_ptr<pot::AnglePotential> &&pot) {
         throw std::invalid_argument("the topology associated with the argument did not correspond to the actual one");
     }
     anglePotentials.push_back(std::move(pot));
+    touch();
 }
 
 void Topology::addTorsionPotential(std::unique_ptr<pot::TorsionPotential> &&pot) {
@@ -76,6 +88,7 @@ void Topology::addTorsionPotential(std::unique_ptr<pot::TorsionPotential> &&pot)
         throw std::invalid_argument("the topology associated with the argument did not correspond to the actual one");
     }
     torsionPotentials.push_back(std::move(pot));
+    touch();
 }
 
 void Topology::addBondedPotential(std::unique_ptr<pot::BondedPotential> &&pot) {
@@ -83,12 +96,22 @@ void Topology::addBondedPotential(std::unique_ptr<pot::BondedPotential> &&pot) {
         throw std::invalid_argument("the topology associated with the argument did not correspond to the actual one");
     }
     bondedPotentials.push_back(std::move(pot));
+    touch();
 }
 
 void Topology::permuteIndices(const std::vector<std::size_t> &permutation) {
     std::transform(particles.begin(), particles.end(), particles.begin(), [&permutation](std::size_t index) {
         return permutation[index];
     });
+    touch();
+}
+
+std::size_t Topology::version() const {
+    return _version;
+}
+
+void Topology::touch() {
+    _version = nextVersion();
 }
 
 }
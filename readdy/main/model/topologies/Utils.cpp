@@ -43,29 +43,28 @@ std::string to_gexf(graph::Graph& graph) {
     ss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
     ss << "<gexf xmlns=\"http://www.gexf.net/1.2draft\" version=\"1.2\">";
     ss << "<graph mode=\"static\" defaultedgetype=\"undirected\">";
+    const auto &adjacency = graph.adjacency();
     {
         ss << "<nodes>";
-        std::size_t id = 0;
-        for (auto &v : graph.vertices()) {
+        for (const auto &v : graph.vertices()) {
             ss << "<node id=\"" << v.particleIndex << "\" label=\"" << v.label() << "\" />";
-            v.visited = false;
-            ++id;
         }
         ss << "</nodes>";
     }
     {
         ss << "<edges>";
         std::size_t id = 0;
-        for(auto& v : graph.vertices()) {
-            for(const auto& neighbor : v.neighbors()) {
-                if(!neighbor->visited) {
+        for (std::size_t v = 0; v < adjacency.vertices.size(); ++v) {
+            for (auto k = adjacency.offsets[v]; k < adjacency.offsets[v + 1]; ++k) {
+                // each edge is written from the side of the vertex that comes first
+                const auto neighbor = adjacency.neighbors[k];
+                if (neighbor > v) {
                     ss << "<edge id=\"" << id << "\" "
-                            "source=\"" << v.particleIndex << "\" "
-                            "target=\"" << neighbor->particleIndex << "\" />";
+                            "source=\"" << adjacency.vertices[v]->particleIndex << "\" "
+                            "target=\"" << adjacency.vertices[neighbor]->particleIndex << "\" />";
                     ++id;
                 }
             }
-            v.visited = true;
         }
         ss << "</edges>";
     }
@@ -51,6 +51,7 @@ void Graph::addEdge(const std::string &v1, const std::string &v2) {
     }
     findIt1->second->addNeighbor(findIt2->second.data());
     findIt2->second->addNeighbor(findIt1->second.data());
+    _adjacencyValid = false;
 }
 
 const Graph::vertex_list &Graph::vertices() const {
@@ -63,6 +64,7 @@ void Graph::removeVertex(vertex_ref vertex) {
         _vertex_label_mapping.erase(_vertex_label_mapping.find(vertex->label()));
     }
     _vertices.erase(vertex.data());
+    _adjacencyValid = false;
 }
 
 void Graph::removeParticle(std::size_t particleIndex) {
@@ -73,6 +75,7 @@ void Graph::removeParticle(std::size_t particleIndex) {
             _vertex_label_mapping.erase(_vertex_label_mapping.find(v->label()));
         }
         _vertices.erase(v);
+        _adjacencyValid = false;
     } else {
         throw std::invalid_argument(
                 "the vertex corresponding to the particle with topology index " + std::to_string(particleIndex) +
@@ -98,6 +101,7 @@ void Graph::removeEdge(vertex_ref v1, vertex_ref v2) {
     assert(v1 != v2);
     v1->removeNeighbor(v2.data());
     v2->removeNeighbor(v1.data());
+    _adjacencyValid = false;
 }
 
 void Graph::removeEdge(const std::string &v1, const std::string &v2) {
@@ -156,6 +160,7 @@ void Graph::addVertex(std::size_t particleIndex, particle_type_type particleType
     } else {
         _vertices.emplace_back(particleIndex, particleType);
     }
+    _adjacencyValid = false;
 }
 
 auto Graph::vertexItForParticleIndex(std::size_t particleIndex) -> decltype(_vertices.begin()) {
@@ -174,6 +179,7 @@ void Graph::addEdgeBetweenParticles(std::size_t particleIndex1, std::size_t part
     if (it1 != _vertices.end() && it2 != _vertices.end()) {
         it1->addNeighbor(it2);
         it2->addNeighbor(it1);
+        _adjacencyValid = false;
     } else {
         throw std::invalid_argument("the particles indices did not exist...");
     }
@@ -182,6 +188,7 @@ void Graph::addEdgeBetweenParticles(std::size_t particleIndex1, std::size_t part
 void Graph::addEdge(vertex_ref v1, vertex_ref v2) {
     v1->addNeighbor(v2.data());
     v2->addNeighbor(v1.data());
+    _adjacencyValid = false;
 }
 
 Graph::vertex_list &Graph::vertices() {
@@ -200,20 +207,48 @@ Graph::vertex_ref Graph::lastVertex() {
     return --vertices().end();
 }
 
+const Graph::Adjacency &Graph::adjacency() {
+    if (_adjacencyValid) {
+        return _adjacency;
+    }
+    auto &result = _adjacency;
+    result.vertices.clear();
+    result.offsets.clear();
+    result.neighbors.clear();
+    result.vertices.reserve(_vertices.size());
+    for (auto it = _vertices.begin(); it != _vertices.end(); ++it) {
+        it->_handle = result.vertices.size();
+        result.vertices.push_back(it);
+    }
+    result.offsets.reserve(_vertices.size() + 1);
+    result.offsets.push_back(0);
+    for (const auto &v : _vertices) {
+        for (const auto &neighbor : v.neighbors()) {
+            result.neighbors.push_back(neighbor->_handle);
+        }
+        result.offsets.push_back(result.neighbors.size());
+    }
+    _adjacencyValid = true;
+    return result;
+}
+
 bool Graph::isConnected() {
-    std::for_each(_vertices.begin(), _vertices.end(), [](Vertex &v) { v.visited = false; });
-    std::vector<vertex_ref> unvisited;
-    unvisited.push_back(_vertices.begin());
+    if (_vertices.empty()) {
+        return true;
+    }
+    const auto &adj = adjacency();
+    std::vector<bool> visited(adj.vertices.size(), false);
+    std::vector<std::size_t> unvisited{0};
     std::size_t n_visited = 0;
-    while(!unvisited.empty()) {
-        auto vertex = unvisited.back();
+    while (!unvisited.empty()) {
+        const auto vertex = unvisited.back();
         unvisited.pop_back();
-        if(!vertex->visited) {
-            vertex->visited = true;
+        if (!visited[vertex]) {
+            visited[vertex] = true;
             ++n_visited;
-            for (auto neighbor : vertex->neighbors()) {
-                if (!neighbor->visited) {
-                    unvisited.push_back(neighbor);
+            for (auto k = adj.offsets[vertex]; k < adj.offsets[vertex + 1]; ++k) {
+                if (!visited[adj.neighbors[k]]) {
+                    unvisited.push_back(adj.neighbors[k]);
                 }
             }
         }
@@ -224,54 +259,60 @@ bool Graph::isConnected() {
 void Graph::findNTuples(const edge_callback &tuple_callback,
                         const path_len_2_callback &triple_callback,
                         const path_len_3_callback &quadruple_callback) {
-    for (auto &v : _vertices) {
-        v.visited = false;
-    }
-
-    for (auto it = _vertices.begin(); it != _vertices.end(); ++it) {
-        it->visited = true;
-        auto v_type = it->particleType();
-        auto v_idx = it->particleIndex;
-        auto &neighbors = it->neighbors();
-        for (auto it_neigh : neighbors) {
-            auto vv_type = it_neigh->particleType();
-            auto vv_idx = it_neigh->particleIndex;
-            if (!it_neigh->visited) {
-                log::debug("got type tuple ({}, {}) for particles {}, {}", v_type, vv_type, v_idx, vv_idx);
-                // got edge (v, vv), now look for N(v)\{vv} and N(vv)\(N(v) + v)
-                tuple_callback(std::tie(it, it_neigh));
-                for (auto quad_it_1 : neighbors) {
-                    // N(v)\{vv}
-                    if (it_neigh != quad_it_1) {
-                        auto vvv_type = quad_it_1->particleType();
-                        auto vvv_idx = quad_it_1->particleIndex;
+    const auto &adj = adjacency();
+    const auto &vertices = adj.vertices;
+    // visited: the vertex' edges were reported, adjacent: the vertex is a neighbor of the current vertex,
+    // adjacentToOther: the vertex is a neighbor of the other end of the current edge
+    std::vector<bool> visited(vertices.size(), false);
+    std::vector<bool> adjacent(vertices.size(), false);
+    std::vector<bool> adjacentToOther(vertices.size(), false);
+
+    for (std::size_t v = 0; v < vertices.size(); ++v) {
+        visited[v] = true;
+        const auto begin = adj.offsets[v];
+        const auto end = adj.offsets[v + 1];
+        for (auto k = begin; k < end; ++k) {
+            adjacent[adj.neighbors[k]] = true;
+        }
+        for (auto k = begin; k < end; ++k) {
+            const auto vv = adj.neighbors[k];
+            if (!visited[vv]) {
+                // got edge (v, vv), now look for N(v)\(N(vv) + vv) and N(vv)\(N(v) + v)
+                tuple_callback(std::make_tuple(vertex_ref(vertices[v]), vertex_ref(vertices[vv])));
+                for (auto k2 = adj.offsets[vv]; k2 < adj.offsets[vv + 1]; ++k2) {
+                    adjacentToOther[adj.neighbors[k2]] = true;
+                }
+                for (auto k1 = begin; k1 < end; ++k1) {
+                    const auto vvv = adj.neighbors[k1];
+                    if (vvv != vv && !adjacentToOther[vvv]) {
                         // got one end of the quadruple
-                        for (auto quad_it_2 : it_neigh->neighbors()) {
+                        for (auto k2 = adj.offsets[vv]; k2 < adj.offsets[vv + 1]; ++k2) {
                             // if this other neighbor is no neighbor of v and not v itself,
                             // we got the other end of the quadruple
-                            auto no_circle =
-                                    std::find(neighbors.begin(), neighbors.end(), quad_it_2) == neighbors.end();
-                            if (quad_it_2 != it && no_circle) {
-                                auto vvvv_type = quad_it_2->particleType();
-                                auto vvvv_idx = quad_it_2->particleIndex;
-                                log::debug("got type quadruple ({}, {}, {}, {}) for particles {}, {}, {}, {}", vvv_type, v_type,
-                                           vv_type, vvvv_type, vvv_idx, v_idx, vv_idx, vvvv_idx);
-                                quadruple_callback(std::tie(quad_it_1, it, it_neigh, quad_it_2));
+                            const auto vvvv = adj.neighbors[k2];
+                            if (vvvv != v && !adjacent[vvvv]) {
+                                quadruple_callback(std::make_tuple(vertex_ref(vertices[vvv]), vertex_ref(vertices[v]),
+                                                                   vertex_ref(vertices[vv]),
+                                                                   vertex_ref(vertices[vvvv])));
                             }
                         }
                     }
                 }
+                for (auto k2 = adj.offsets[vv]; k2 < adj.offsets[vv + 1]; ++k2) {
+                    adjacentToOther[adj.neighbors[k2]] = false;
+                }
             }
-            for (auto it_neigh2 : neighbors) {
-                if (it_neigh2 != it_neigh && it_neigh->particleIndex < it_neigh2->particleIndex) {
-                    auto vvv_type = it_neigh2->particleType();
-                    auto vvv_idx = it_neigh2->particleIndex;
-                    log::debug("got type triple ({}, {}, {}) for particles {}, {}, {}", vv_type, v_type, vvv_type,
-                               vv_idx, v_idx, vvv_idx);
-                    triple_callback(std::tie(it_neigh, it, it_neigh2));
+            for (auto k1 = begin; k1 < end; ++k1) {
+                const auto vvv = adj.neighbors[k1];
+                if (vvv != vv && vertices[vv]->particleIndex < vertices[vvv]->particleIndex) {
+                    triple_callback(std::make_tuple(vertex_ref(vertices[vv]), vertex_ref(vertices[v]),
+                                                    vertex_ref(vertices[vvv])));
                 }
             }
         }
+        for (auto k = begin; k < end; ++k) {
+            adjacent[adj.neighbors[k]] = false;
+        }
     }
 }
 
@@ -329,67 +370,55 @@ Graph::vertex_ref Graph::namedVertexPtr(const Graph::label &name) {
 }
 
 std::vector<Graph> Graph::connectedComponentsDestructive() {
-    std::vector<vertex_list> subVertexLists;
-    std::vector<vertex_label_mapping> subVertexLabelMappings;
-
+    const auto &adj = adjacency();
+    const auto &vertices = adj.vertices;
+
+    // component membership in depth first order
+    std::vector<bool> visited(vertices.size(), false);
+    std::vector<std::size_t> order;
+    std::vector<std::size_t> componentOffsets;
+    order.reserve(vertices.size());
     {
-        std::vector<std::vector<vertex_cref>> components;
-
-        std::for_each(_vertices.begin(), _vertices.end(), [](Vertex &v) { v.visited = false; });
-
-        for(auto it = _vertices.begin(); it != _vertices.end(); ++it) {
-            if(!it->visited) {
+        std::vector<std::size_t> unvisitedInComponent;
+        for (std::size_t root = 0; root < vertices.size(); ++root) {
+            if (!visited[root]) {
                 // got a new component
-                components.emplace_back();
-                subVertexLists.emplace_back();
-                subVertexLabelMappings.emplace_back();
-
-                auto& component = components.back();
-                auto& mapping = subVertexLabelMappings.back();
-
-                std::vector<vertex_ref> unvisitedInComponent;
-                unvisitedInComponent.emplace_back(it);
+                componentOffsets.push_back(order.size());
+                unvisitedInComponent.push_back(root);
                 while (!unvisitedInComponent.empty()) {
-                    auto& vertex = unvisitedInComponent.back();
+                    const auto vertex = unvisitedInComponent.back();
                     unvisitedInComponent.pop_back();
-                    if (!vertex->visited) {
-                        vertex->visited = true;
-                        {
-                            component.emplace_back(vertex);
-                            if (!vertex->_label.empty()) mapping[vertex->_label] = vertex;
-                        }
-                        for (auto neighbor : vertex->neighbors()) {
-                            if (!neighbor->visited) {
-                                unvisitedInComponent.push_back(neighbor);
+                    if (!visited[vertex]) {
+                        visited[vertex] = true;
+                        order.push_back(vertex);
+                        for (auto k = adj.offsets[vertex]; k < adj.offsets[vertex + 1]; ++k) {
+                            if (!visited[adj.neighbors[k]]) {
+                                unvisitedInComponent.push_back(adj.neighbors[k]);
                             }
                         }
                     }
                 }
             }
         }
-
-        {
-            // transfer vertices
-            auto it_components = components.begin();
-            auto it_subLists = subVertexLists.begin();
-            for(; it_components != components.end(); ++it_components, ++it_subLists) {
-                for(const auto& vertex_ref : *it_components) {
-                    it_subLists->splice(it_subLists->end(), _vertices, vertex_ref.data());
-                }
-            }
-        }
+        componentOffsets.push_back(order.size());
     }
 
+    // transfer the vertices, splicing keeps the neighbor iterators valid
     std::vector<Graph> subGraphs;
-    subGraphs.reserve(subVertexLists.size());
-    {
-        auto it_mappings = subVertexLabelMappings.begin();
-        auto it_subLists = subVertexLists.begin();
-        for(; it_mappings != subVertexLabelMappings.end(); ++it_mappings, ++it_subLists) {
-            subGraphs.emplace_back(std::move(*it_subLists), std::move(*it_mappings));
+    subGraphs.reserve(componentOffsets.size() - 1);
+    for (std::size_t component = 0; component + 1 < componentOffsets.size(); ++component) {
+        vertex_list subVertexList;
+        vertex_label_mapping subVertexLabelMapping;
+        for (auto i = componentOffsets[component]; i < componentOffsets[component + 1]; ++i) {
+            const auto &vertex = vertices[order[i]];
+            if (!vertex->_label.empty()) subVertexLabelMapping[vertex->_label] = vertex;
+            subVertexList.splice(subVertexList.end(), _vertices, vertex);
         }
+        subGraphs.emplace_back(std::move(subVertexList), std::move(subVertexLabelMapping));
     }
-    return std::move(subGraphs);
+    _vertex_label_mapping.clear();
+    _adjacencyValid = false;
+    return subGraphs;
 }
 
 Graph::Graph(vertex_list vertexList, vertex_label_mapping vertexLabelMapping)
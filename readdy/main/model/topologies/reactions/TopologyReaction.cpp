@@ -155,7 +155,7 @@ std::vector<GraphTopology> TopologyReaction::execute(GraphTopology &topology, co
                     }
                 } else {
                     // if valid, update force field
-                    topology.configure();
+                    topology.updateBondedPotentials();
                     // and update reaction rates
                     topology.updateReactionRates();
                 }
@@ -166,7 +166,7 @@ std::vector<GraphTopology> TopologyReaction::execute(GraphTopology &topology, co
                     return std::move(subTopologies);
                 } else {
                     // if valid, update force field
-                    topology.configure();
+                    topology.updateBondedPotentials();
                     // and update reaction rates
                     topology.updateReactionRates();
                 }
@@ -43,10 +43,15 @@ TopologyReactionAction::TopologyReactionAction(GraphTopology *const topology) :
 
 ChangeParticleType::ChangeParticleType(GraphTopology *const topology, const vertex &v,
                                        const particle_type_type &type_to)
-        : TopologyReactionAction(topology), _vertex(v), type_to(type_to), previous_type(type_to){}
+        : TopologyReactionAction(topology), _vertex(v), type_to(type_to), previous_type(type_to){
+    topology->markChanged(_vertex.data());
+}
 
 AddEdge::AddEdge(GraphTopology *const topology, const edge &edge)
-        : TopologyReactionAction(topology), label_edge_(edge) {}
+        : TopologyReactionAction(topology), label_edge_(edge) {
+    topology->markChanged(std::get<0>(label_edge_).data());
+    topology->markChanged(std::get<1>(label_edge_).data());
+}
 
 void AddEdge::execute() {
     topology->graph().addEdge(label_edge_);
@@ -57,7 +62,10 @@ void AddEdge::undo() {
 }
 
 RemoveEdge::RemoveEdge(GraphTopology *const topology, const edge& edge)
-        : TopologyReactionAction(topology), label_edge_(edge) {}
+        : TopologyReactionAction(topology), label_edge_(edge) {
+    topology->markChanged(std::get<0>(label_edge_).data());
+    topology->markChanged(std::get<1>(label_edge_).data());
+}
 
 void RemoveEdge::execute() {
     topology->graph().removeEdge(label_edge_);
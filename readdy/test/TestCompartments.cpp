@@ -109,6 +109,80 @@ TEST_P(TestCompartments, TwoCompartments) {
     }
 }
 
+TEST_P(TestCompartments, ChainedConversionsManyParticles) {
+    // A is converted to B inside the sphere and B to C in the upper half space, hence As in the intersection become Cs.
+    // E particles are not converted by any compartment.
+    auto &ctx = kernel->getKernelContext();
+    ctx.setBoxSize(10, 10, 10);
+    for (const auto &t : {"A", "B", "C", "E"}) {
+        ctx.particle_types().add(t, 1., 1.);
+    }
+    std::unordered_map<std::string, std::string> conversionsSphere = {{"A", "B"}};
+    std::unordered_map<std::string, std::string> conversionsPlane = {{"B", "C"}};
+    kernel->registerCompartment<m::compartments::Sphere>(conversionsSphere, "sphere", m::Vec3(0, 0, 0), 2., false);
+    kernel->registerCompartment<m::compartments::Plane>(conversionsPlane, "plane", m::Vec3(0, 0, 1), 0, true);
+
+    const std::size_t n = 2000;
+    for (std::size_t i = 0; i < n; ++i) {
+        kernel->addParticle("A", m::Vec3(m::rnd::uniform_real(-4.9, 4.9), m::rnd::uniform_real(-4.9, 4.9),
+                                         m::rnd::uniform_real(-4.9, 4.9)));
+        kernel->addParticle("E", m::Vec3(0, 0, 1));
+    }
+
+    kernel->createAction<m::actions::EvaluateCompartments>()->perform();
+
+    std::size_t nA = 0, nB = 0, nC = 0, nE = 0;
+    const auto idA = ctx.particle_types().id_of("A");
+    const auto idB = ctx.particle_types().id_of("B");
+    const auto idC = ctx.particle_types().id_of("C");
+    for (const auto &p : kernel->getKernelStateModel().getParticles()) {
+        const auto &pos = p.getPos();
+        const bool inSphere = pos * pos < 4.;
+        const bool upper = pos[2] > 0;
+        if (p.getType() == ctx.particle_types().id_of("E")) {
+            ++nE;
+        } else if (p.getType() == idA) {
+            ++nA;
+            EXPECT_FALSE(inSphere);
+        } else if (p.getType() == idB) {
+            ++nB;
+            EXPECT_TRUE(inSphere && !upper);
+        } else if (p.getType() == idC) {
+            ++nC;
+            EXPECT_TRUE(inSphere && upper);
+        }
+    }
+    EXPECT_EQ(nE, n);
+    EXPECT_EQ(nA + nB + nC, n);
+    EXPECT_GT(nB, 0);
+    EXPECT_GT(nC, 0);
+}
+
+TEST(TestCompartmentsBatch, AreContainedAgreesWithIsContained) {
+    std::unordered_map<m::compartments::Compartment::particleType_t, m::compartments::Compartment::particleType_t> conv;
+    const m::compartments::Sphere sphereIn(conv, "in", m::Vec3(1, 0, -1), 2., false);
+    const m::compartments::Sphere sphereOut(conv, "out", m::Vec3(1, 0, -1), 2., true);
+    const m::compartments::Plane planeAbove(conv, "above", m::Vec3(0, 1, 0), .5, true);
+    const m::compartments::Plane planeBelow(conv, "below", m::Vec3(0, 1, 0), .5, false);
+    const std::size_t n = 300;
+    std::vector<double> x(n), y(n), z(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = m::rnd::uniform_real(-4., 4.);
+        y[i] = m::rnd::uniform_real(-4., 4.);
+        z[i] = m::rnd::uniform_real(-4., 4.);
+    }
+    std::vector<std::uint8_t> contained(n);
+    for (const m::compartments::Compartment *c : {static_cast<const m::compartments::Compartment *>(&sphereIn),
+                                                  static_cast<const m::compartments::Compartment *>(&sphereOut),
+                                                  static_cast<const m::compartments::Compartment *>(&planeAbove),
+                                                  static_cast<const m::compartments::Compartment *>(&planeBelow)}) {
+        c->areContained(x.data(), y.data(), z.data(), n, contained.data());
+        for (std::size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(contained[i] != 0, c->isContained({x[i], y[i], z[i]})) << "for " << c->getUniqueName();
+        }
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(TestCompartments, TestCompartments, ::testing::ValuesIn(readdy::testing::getKernelsToTest()));
 
 }
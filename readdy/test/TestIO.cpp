@@ -30,6 +30,9 @@
  * @copyright GNU Lesser General Public License v3.0
  */
 
+#include <readdy/io/File.h>
+#include <readdy/model/observables/io/AsyncWriter.h>
+#include <readdy/model/observables/io/Trajectory.h>
 #include <readdy/model/observables/io/TrajectoryEntry.h>
 #include <readdy/model/observables/io/Types.h>
 #include <fstream>
@@ -198,10 +201,313 @@ TEST(TestIO, ReadTrajectory) {
         readdy::log::warn("foo: {}", info.name);
         readdy::log::warn("foo: {}", info.diffusion_constant);
         readdy::log::warn("foo: {}", info.type_id);
-    }*/
-    readdy::log::console()->set_level(spdlog::level::debug);
+    }
+    readdy::log::console()->set_level(spdlog::level::debug);*/
+
+
+}
+
+TEST(TestIO, FlatTrajectoryIsWrittenAsynchronously) {
+    const std::string fname = "test_io_flat_trajectory.h5";
+    const std::size_t nParticles = 50;
+    const unsigned int nSteps = 40;
+    {
+        readdy::io::File file(fname, readdy::io::File::Action::CREATE, readdy::io::File::Flag::OVERWRITE);
+        readdy::Simulation simulation;
+        simulation.setKernel("SingleCPU");
+        simulation.setBoxSize(10, 10, 10);
+        simulation.registerParticleType("A", 1., .1);
+        for (std::size_t i = 0; i < nParticles; ++i) {
+            simulation.addParticle("A", 0, 0, 0);
+        }
+        auto handle = simulation.registerObservable<readdy::model::observables::FlatTrajectory>(1);
+        handle.enableWriteToFile(file, "", 3);
+        simulation.run(nSteps, .01);
+        // the frames must be written out by the time the run returned
+        file.flush();
+    }
+    readdy::io::File file(fname, readdy::io::File::Action::OPEN, readdy::io::File::Flag::READ_ONLY);
+    auto traj = file.getRootGroup().subgroup("readdy/trajectory");
+    std::vector<readdy::time_step_type> time;
+    traj.read("time", time);
+    std::vector<std::size_t> limits;
+    traj.read("limits", limits, readdy::io::STDDataSetType<std::size_t>(), readdy::io::NativeDataSetType<std::size_t>());
+    std::vector<readdy::model::observables::TrajectoryEntry> records;
+    traj.read("records", records, readdy::model::observables::util::TrajectoryEntryMemoryType(),
+              readdy::model::observables::util::TrajectoryEntryFileType());
+    ASSERT_EQ(time.size(), nSteps + 1);
+    ASSERT_EQ(limits.size(), 2 * (nSteps + 1));
+    ASSERT_EQ(records.size(), nParticles * (nSteps + 1));
+    for (std::size_t frame = 0; frame <= nSteps; ++frame) {
+        EXPECT_EQ(time[frame], frame);
+        EXPECT_EQ(limits[2 * frame], frame * nParticles);
+        EXPECT_EQ(limits[2 * frame + 1], (frame + 1) * nParticles);
+    }
+}
+
+TEST(TestIO, AsyncWriter) {
+    std::vector<int> executed;
+    {
+        readdy::model::observables::util::AsyncWriter writer{2};
+        for (int i = 0; i < 100; ++i) {
+            writer.enqueue([&executed, i] { executed.push_back(i); });
+        }
+        writer.wait();
+        ASSERT_EQ(executed.size(), 100);
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(executed[i], i);
+        }
+        writer.enqueue([] { throw std::runtime_error("write failed"); });
+        writer.enqueue([&executed] { executed.push_back(100); });
+        EXPECT_THROW(writer.wait(), std::runtime_error);
+        EXPECT_EQ(executed.size(), 101);
+        // tasks enqueued before destruction are still executed
+        writer.enqueue([&executed] { executed.push_back(101); });
+    }
+    EXPECT_EQ(executed.size(), 102);
+}
 
+TEST(TestIO, BufferedDataSetAppends) {
+    const std::string fname = "test_io_buffered_appends.h5";
+    const std::size_t nColumns = 3;
+    std::vector<double> expected;
+    {
+        readdy::io::File f(fname, readdy::io::File::Action::CREATE, readdy::io::File::Flag::OVERWRITE);
+        auto group = f.createGroup("/buffered");
+        auto dataSet = group.createDataSet<double>("data", {4, nColumns},
+                                                   {readdy::io::h5::UNLIMITED_DIMS, nColumns});
+        dataSet.setBuffered(true);
+        // single rows, which are gathered into chunks of four rows
+        for (std::size_t row = 0; row < 10; ++row) {
+            std::vector<double> data(nColumns);
+            for (std::size_t col = 0; col < nColumns; ++col) data[col] = row * nColumns + col;
+            dataSet.append({1, nColumns}, data.data());
+            expected.insert(expected.end(), data.begin(), data.end());
+        }
+        // a block of several rows
+        {
+            std::vector<double> data(2 * nColumns);
+            for (std::size_t i = 0; i < data.size(); ++i) data[i] = -1. * i;
+            dataSet.append({2, nColumns}, data.data());
+            expected.insert(expected.end(), data.begin(), data.end());
+        }
+        dataSet.flush();
+        std::vector<double> more(nColumns, 42.);
+        dataSet.append({1, nColumns}, more.data());
+        expected.insert(expected.end(), more.begin(), more.end());
+        // the last row is written when the data set is destroyed
+    }
+    readdy::io::File f(fname, readdy::io::File::Action::OPEN, readdy::io::File::Flag::READ_ONLY);
+    auto group = f.getRootGroup().subgroup("buffered");
+    std::vector<double> data;
+    group.read("data", data);
+    ASSERT_EQ(data.size(), expected.size());
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        EXPECT_EQ(data[i], expected[i]);
+    }
+}
 
+TEST(TestIO, DataSetCopiesAppendDifferentShapes) {
+    const std::string fname = "test_io_data_set_copies.h5";
+    const std::size_t nColumns = 2;
+    std::vector<double> expected;
+    {
+        readdy::io::File f(fname, readdy::io::File::Action::CREATE, readdy::io::File::Flag::OVERWRITE);
+        auto group = f.createGroup("/copies");
+        auto dataSet = group.createDataSet<double>("data", {4, nColumns}, {readdy::io::h5::UNLIMITED_DIMS, nColumns});
+        auto copy = dataSet;
+        // the copies share their append state, hence also the memory space whose extent it tracks
+        const std::vector<readdy::io::h5::dims_t> nRows{1, 2, 2, 1, 3};
+        for (std::size_t i = 0; i < nRows.size(); ++i) {
+            std::vector<double> data(nRows[i] * nColumns);
+            for (std::size_t j = 0; j < data.size(); ++j) data[j] = expected.size() + j;
+            (i % 2 == 0 ? dataSet : copy).append({nRows[i], nColumns}, data.data());
+            expected.insert(expected.end(), data.begin(), data.end());
+        }
+    }
+    readdy::io::File f(fname, readdy::io::File::Action::OPEN, readdy::io::File::Flag::READ_ONLY);
+    auto group = f.getRootGroup().subgroup("copies");
+    std::vector<double> data;
+    group.read("data", data);
+    EXPECT_EQ(data, expected);
 }
 
-}
\ No newline at end of file
+TEST(TestIO, ColumnarTrajectory) {
+    const std::string fname = "test_io_columnar_trajectory.h5";
+    const std::size_t nParticles = 30;
+    const std::size_t bound = 40;
+    const unsigned int nSteps = 12;
+    const double precision = 1e-3;
+    std::vector<std::vector<readdy::model::Vec3>> expectedPositions;
+    {
+        readdy::io::File file(fname, readdy::io::File::Action::CREATE, readdy::io::File::Flag::OVERWRITE);
+        readdy::Simulation simulation;
+        simulation.setKernel("SingleCPU");
+        simulation.setBoxSize(10, 10, 10);
+        simulation.registerParticleType("A", .1, .1);
+        for (std::size_t i = 0; i < nParticles; ++i) {
+            simulation.addParticle("A", -4. + .25 * i, 0, 1);
+        }
+        auto handle = simulation.registerObservable<readdy::model::observables::ColumnarTrajectory>(
+                1, bound, false, precision);
+        handle.enableWriteToFile(file, "columnar", 5);
+        simulation.registerObservable<readdy::model::observables::Positions>(
+                [&expectedPositions](const readdy::model::observables::Positions::result_t &result) {
+                    expectedPositions.push_back(result);
+                }, 1);
+        simulation.run(nSteps, .01);
+    }
+    readdy::io::File file(fname, readdy::io::File::Action::OPEN, readdy::io::File::Flag::READ_ONLY);
+    auto traj = file.getRootGroup().subgroup("readdy/trajectory/columnar");
+    std::vector<int> positions;
+    traj.read("positions", positions);
+    std::vector<readdy::particle_type_type> types;
+    traj.read("types", types);
+    std::vector<std::size_t> counts;
+    traj.read("n_particles", counts);
+    std::vector<readdy::time_step_type> time;
+    traj.read("time", time);
+    ASSERT_EQ(expectedPositions.size(), nSteps + 1);
+    ASSERT_EQ(time.size(), nSteps + 1);
+    ASSERT_EQ(counts.size(), nSteps + 1);
+    ASSERT_EQ(types.size(), (nSteps + 1) * bound);
+    ASSERT_EQ(positions.size(), (nSteps + 1) * bound * 3);
+    for (std::size_t frame = 0; frame <= nSteps; ++frame) {
+        EXPECT_EQ(counts[frame], nParticles);
+        for (std::size_t i = 0; i < bound; ++i) {
+            const auto offset = 3 * (frame * bound + i);
+            if (i < nParticles) {
+                for (unsigned int d = 0; d < 3; ++d) {
+                    EXPECT_NEAR(positions[offset + d] * precision, expectedPositions[frame][i][d], precision);
+                }
+            } else {
+                EXPECT_EQ(types[frame * bound + i], std::numeric_limits<readdy::particle_type_type>::max());
+            }
+        }
+    }
+}
+
+TEST(TestIO, ColumnarTrajectoryPrecisionOutOfRange) {
+    readdy::io::File file("test_io_columnar_trajectory_precision.h5", readdy::io::File::Action::CREATE,
+                          readdy::io::File::Flag::OVERWRITE);
+    readdy::Simulation simulation;
+    simulation.setKernel("SingleCPU");
+    simulation.setBoxSize(10, 10, 10);
+    simulation.registerParticleType("A", .1, .1);
+    // 5 / 1e-9 does not fit into a 32 bit integer
+    auto handle = simulation.registerObservable<readdy::model::observables::ColumnarTrajectory>(1, 10, false, 1e-9);
+    EXPECT_THROW(handle.enableWriteToFile(file, "columnar", 5), std::invalid_argument);
+}
+
+TEST(TestIO, ColumnarTrajectoryWithEmptyFirstFrame) {
+    const std::string fname = "test_io_columnar_trajectory_empty.h5";
+    {
+        readdy::io::File file(fname, readdy::io::File::Action::CREATE, readdy::io::File::Flag::OVERWRITE);
+        readdy::Simulation simulation;
+        simulation.setKernel("SingleCPU");
+        simulation.setBoxSize(10, 10, 10);
+        simulation.registerParticleType("A", .1, .1);
+        {
+            // the bound cannot be taken from an empty frame
+            auto handle = simulation.registerObservable<readdy::model::observables::ColumnarTrajectory>(1);
+            handle.enableWriteToFile(file, "unbounded", 5);
+            EXPECT_THROW(simulation.run(2, .01), std::runtime_error);
+            simulation.deregisterObservable(handle);
+        }
+        auto handle = simulation.registerObservable<readdy::model::observables::ColumnarTrajectory>(1, 4);
+        handle.enableWriteToFile(file, "bounded", 5);
+        simulation.run(2, .01);
+    }
+    readdy::io::File file(fname, readdy::io::File::Action::OPEN, readdy::io::File::Flag::READ_ONLY);
+    auto traj = file.getRootGroup().subgroup("readdy/trajectory/bounded");
+    std::vector<std::size_t> counts;
+    traj.read("n_particles", counts);
+    EXPECT_EQ(counts, (std::vector<std::size_t>{0, 0, 0}));
+    std::vector<readdy::particle_type_type> types;
+    traj.read("types", types);
+    EXPECT_EQ(types.size(), 3 * 4);
+}
+
+TEST(TestIO, PerformanceIsWrittenPerRun) {
+    const std::string fname = "test_io_performance.h5";
+    {
+        readdy::io::File file(fname, readdy::io::File::Action::CREATE, readdy::io::File::Flag::OVERWRITE);
+        readdy::Simulation simulation;
+        simulation.setKernel("SingleCPU");
+        simulation.setBoxSize(10, 10, 10);
+        simulation.registerParticleType("A", 1., .1);
+        simulation.addParticle("A", 0, 0, 0);
+        auto scheme = simulation.runScheme().writePerformanceToFile(file).configure(.01);
+        scheme->run(3);
+        scheme->run(4);
+        // another scheme appends its runs to the ones that are already in the file
+        simulation.runScheme().writePerformanceToFile(file).configureAndRun(5, .01);
+        EXPECT_EQ(simulation.performance().timings().at("integrator").calls, 3 + 4 + 5);
+    }
+    readdy::io::File file(fname, readdy::io::File::Action::OPEN, readdy::io::File::Flag::READ_ONLY);
+    auto performance = file.getRootGroup().subgroup("readdy/performance");
+    EXPECT_EQ(performance.subgroups().size(), 3);
+    const std::vector<long> nSteps{3, 4, 5};
+    for (std::size_t run = 0; run < nSteps.size(); ++run) {
+        auto timings = performance.subgroup("run_" + std::to_string(run) + "/timings");
+        std::vector<long> calls;
+        timings.read("calls", calls);
+        std::vector<double> seconds;
+        timings.read("seconds", seconds);
+        ASSERT_EQ(calls.size(), seconds.size());
+        // the timings are sorted by name: forces, integrator, neighbor_list, observables, reactions, ...
+        EXPECT_EQ(calls.at(1), nSteps[run]);
+        for (const auto s : seconds) {
+            EXPECT_GE(s, 0);
+        }
+    }
+}
+
+TEST(TestIO, BufferedObservablesAreWrittenOnFlushAndDestruction) {
+    const std::string fname = "test_io_buffered_observables.h5";
+    const unsigned int nSteps = 12;
+    {
+        readdy::io::File file(fname, readdy::io::File::Action::CREATE, readdy::io::File::Flag::OVERWRITE);
+        readdy::Simulation simulation;
+        simulation.setKernel("SingleCPU");
+        simulation.setBoxSize(10, 10, 10);
+        simulation.registerParticleType("A", .1, .1);
+        simulation.addParticle("A", 0, 0, 0);
+        simulation.addParticle("A", 1, 1, 1);
+        // the chunk size of 5 does not divide the number of frames, so that the last frames stay pending
+        auto nParticles = simulation.registerObservable<readdy::model::observables::NParticles>(1);
+        nParticles.enableWriteToFile(file, "n_particles", 5);
+        auto centerOfMass = simulation.registerObservable<readdy::model::observables::CenterOfMass>(
+                1, std::vector<std::string>{"A"});
+        centerOfMass.enableWriteToFile(file, "center_of_mass", 5);
+        simulation.run(nSteps, .01);
+
+        auto group = file.getRootGroup().subgroup("readdy/observables/n_particles");
+        std::vector<std::size_t> counts;
+        group.read("data", counts);
+        // only full chunks have been written so far
+        EXPECT_EQ(counts.size(), 10);
+        nParticles.flush();
+        group.read("data", counts);
+        EXPECT_EQ(counts, std::vector<std::size_t>(nSteps + 1, 2));
+        std::vector<readdy::time_step_type> time;
+        group.read("time", time);
+        ASSERT_EQ(time.size(), nSteps + 1);
+        for (std::size_t t = 0; t < time.size(); ++t) {
+            EXPECT_EQ(time[t], t);
+        }
+    }
+    // the center of mass was not flushed, its pending frames are written when the observable is destroyed
+    readdy::io::File file(fname, readdy::io::File::Action::OPEN, readdy::io::File::Flag::READ_ONLY);
+    auto group = file.getRootGroup().subgroup("readdy/observables/center_of_mass");
+    std::vector<readdy::model::Vec3> centers;
+    group.read("data", centers, readdy::model::observables::util::Vec3MemoryType(),
+               readdy::model::observables::util::Vec3FileType());
+    EXPECT_EQ(centers.size(), nSteps + 1);
+    std::vector<readdy::time_step_type> time;
+    group.read("time", time);
+    EXPECT_EQ(time.size(), nSteps + 1);
+    EXPECT_EQ(time.back(), nSteps);
+}
+
+}
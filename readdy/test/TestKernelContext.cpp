@@ -33,6 +33,8 @@
 #include <readdy/common/Utils.h>
 #include <readdy/common/make_unique.h>
 #include <readdy/model/Kernel.h>
+#include <readdy/model/potentials/PotentialsOrder2.h>
+#include <readdy/model/RandomProvider.h>
 #include <readdy/plugin/KernelProvider.h>
 #include <readdy/testing/KernelTest.h>
 #include <readdy/testing/Utils.h>
@@ -57,6 +59,26 @@ TEST_F(TestKernelContext, SetGetKBT) {
     EXPECT_EQ(42, ctx.getKBT());
 }
 
+TEST_F(TestKernelContext, SeedIsPerContext) {
+    m::KernelContext ctx1, ctx2;
+    ctx2.setSeed(17);
+    ctx1.setSeed(42);
+    EXPECT_EQ(42, ctx1.getSeed());
+    EXPECT_EQ(17, ctx2.getSeed());
+
+    // the seed is handed to the random provider upon configuration
+    ctx1.configure();
+    EXPECT_EQ(42, m::rnd::get_seed());
+    const auto first = m::rnd::uniform_real();
+    ctx1.setSeed(42);
+    ctx1.configure();
+    EXPECT_EQ(first, m::rnd::uniform_real());
+    // configuring again without setting a new seed does not rewind the generators
+    ctx1.configure();
+    EXPECT_NE(first, m::rnd::uniform_real());
+    EXPECT_EQ(17, ctx2.getSeed());
+}
+
 TEST_F(TestKernelContext, PeriodicBoundary) {
     m::KernelContext ctx;
     ctx.setPeriodicBoundary(true, false, true);
@@ -87,6 +109,95 @@ TEST_F(TestKernelContext, PotentialOrder2Map) {
     EXPECT_EQ(vector.size(), 2);
 }
 
+TEST_F(TestKernelContext, PairPotentialTable) {
+    namespace rmp = readdy::model::potentials;
+    m::KernelContext ctx;
+    ctx.particle_types().add("a", 1., .5);
+    ctx.particle_types().add("b", 1., 1.);
+    ctx.particle_types().add("c", 1., 1.);
+    ctx.potentials().add(std::make_unique<rmp::HarmonicRepulsion>("a", "b", 10.));
+    ctx.potentials().add(std::make_unique<rmp::ScreenedElectrostatics>("b", "a", -1., 1., 2., 1., 6, 3.));
+    ctx.potentials().add(std::make_unique<rmp::WeakInteractionPiecewiseHarmonic>(
+            "a", "a", 5., rmp::WeakInteractionPiecewiseHarmonic::Configuration(1., 2., 3.)));
+    ctx.potentials().add(std::make_unique<rmp::LennardJones>("b", "b", 12, 6, 2.5, true, 1., 1.));
+    ctx.potentials().add(std::make_unique<readdy::testing::NOOPPotentialOrder2>("b", "c", 2., 1., 3.));
+    ctx.configure();
+
+    const auto &table = ctx.potentials().pair_potential_table();
+    rmp::PairPotentialKind kind;
+    EXPECT_FALSE(table.uniform(kind));
+    const auto &types = ctx.particle_types();
+    for (const auto &t1 : {"a", "b", "c"}) {
+        for (const auto &t2 : {"a", "b", "c"}) {
+            const auto &potentials = ctx.potentials().potentials_of(t1, t2);
+            const auto begin = table.begin(types.id_of(t1), types.id_of(t2));
+            const auto end = table.end(types.id_of(t1), types.id_of(t2));
+            ASSERT_EQ(static_cast<std::size_t>(end - begin), potentials.size());
+            for (std::size_t i = 0; i < potentials.size(); ++i) {
+                const auto &entry = begin[i];
+                EXPECT_EQ(entry.cutoffSquared, potentials[i]->getCutoffRadiusSquared());
+                for (const auto &x_ij : {m::Vec3(.1, .2, .3), m::Vec3(-.7, .4, .1), m::Vec3(1.1, .5, -.3)}) {
+                    if (x_ij * x_ij >= entry.cutoffSquared) continue;
+                    m::Vec3 expectedForce{0, 0, 0}, force{0, 0, 0};
+                    double expectedEnergy = 0, energy = 0;
+                    potentials[i]->calculateForceAndEnergy(expectedForce, expectedEnergy, x_ij);
+                    rmp::pair_kernels::forceAndEnergy(entry, x_ij, x_ij * x_ij, force, energy);
+                    EXPECT_NEAR(energy, expectedEnergy, 1e-10);
+                    for (auto d = 0; d < 3; ++d) {
+                        EXPECT_NEAR(force[d], expectedForce[d], 1e-10);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TestKernelContext, AutoTabulatePotentials) {
+    namespace rmp = readdy::model::potentials;
+    m::KernelContext ctx;
+    ctx.particle_types().add("a", 1., .5);
+    ctx.particle_types().add("b", 1., 1.);
+    ctx.potentials().add(std::make_unique<rmp::HarmonicRepulsion>("a", "b", 10.));
+    ctx.potentials().add(std::make_unique<rmp::LennardJones>("a", "a", 12, 6, 2.5, true, 1., 1.));
+    ctx.potentials().add(std::make_unique<rmp::ScreenedElectrostatics>("b", "b", -1., 1., 2., 1., 6, 3.));
+    ctx.configure();
+    const auto exactLJ = ctx.potentials().potentials_of("a", "a").at(0);
+    const auto exactSE = ctx.potentials().potentials_of("b", "b").at(0);
+
+    ctx.potentials().setAutoTabulate(true);
+    ctx.configure();
+    EXPECT_EQ(typeid(*ctx.potentials().potentials_of("a", "b").at(0)), typeid(rmp::HarmonicRepulsion));
+    for (const auto &pair : {std::make_pair(exactLJ, ctx.potentials().potentials_of("a", "a").at(0)),
+                             std::make_pair(exactSE, ctx.potentials().potentials_of("b", "b").at(0))}) {
+        auto tabulated = dynamic_cast<const rmp::TabulatedPotentialOrder2 *>(pair.second);
+        ASSERT_NE(tabulated, nullptr);
+        EXPECT_EQ(tabulated->getTabulatedPotential(), pair.first);
+        EXPECT_EQ(tabulated->getCutoffRadius(), pair.first->getCutoffRadius());
+        for (double r = .9; r < pair.first->getCutoffRadius(); r += .0123) {
+            const m::Vec3 x_ij{.6 * r, -.8 * r, 0};
+            m::Vec3 expectedForce{0, 0, 0}, force{0, 0, 0};
+            double expectedEnergy = 0, energy = 0;
+            pair.first->calculateForceAndEnergy(expectedForce, expectedEnergy, x_ij);
+            tabulated->calculateForceAndEnergy(force, energy, x_ij);
+            EXPECT_NEAR(energy, expectedEnergy, 1e-4 * std::max(1., std::abs(expectedEnergy)));
+            for (auto d = 0; d < 3; ++d) {
+                EXPECT_NEAR(force[d], expectedForce[d], 1e-3 * std::max(1., std::abs(expectedForce[d])));
+            }
+        }
+    }
+    const auto &table = ctx.potentials().pair_potential_table();
+    const auto idA = ctx.particle_types().id_of("a");
+    EXPECT_EQ(table.begin(idA, idA)->kind, rmp::PairPotentialKind::TABULATED);
+
+    // the tables are kept when reconfiguring and dropped when disabling the tabulation
+    const auto tabulatedLJ = ctx.potentials().potentials_of("a", "a").at(0);
+    ctx.configure();
+    EXPECT_EQ(ctx.potentials().potentials_of("a", "a").at(0), tabulatedLJ);
+    ctx.potentials().setAutoTabulate(false);
+    ctx.configure();
+    EXPECT_EQ(ctx.potentials().potentials_of("a", "a").at(0), exactLJ);
+}
+
 TEST_P(TestKernelContextWithKernels, PotentialOrder1Map) {
     using vec_t = readdy::model::Vec3;
     auto kernel = readdy::plugin::KernelProvider::getInstance().create("SingleCPU");
@@ -648,6 +648,25 @@ void scaleNumbersAndSkin_tmp(const std::string kernelName, bool reducedNumbers)
     }
 }*/
 
+TEST(TestPerformance, ReactionSchedulersCPU) {
+    // a dilute, reaction limited system, in which the next subvolume method only needs to reevaluate the
+    // neighborhood of each event
+    const std::map<std::string, double> factors{{NUMBERS_FACTOR,    1.},
+                                                {BOXLENGTHS_FACTOR, 2.}};
+    ReactiveUniformHomogeneous uncontrolledApproximation("CPU", factors);
+    uncontrolledApproximation.perform<readdy::model::actions::reactions::UncontrolledApproximation>(20);
+    ReactiveUniformHomogeneous gillespie("CPU", factors);
+    gillespie.perform<readdy::model::actions::reactions::Gillespie>(20);
+    ReactiveUniformHomogeneous nextSubvolumes("CPU", factors);
+    nextSubvolumes.perform<readdy::model::actions::reactions::NextSubvolumes>(20);
+    std::cout << "Average time for handling reactions (uncontrolled approximation): "
+              << uncontrolledApproximation.getTimeReactions() << std::endl;
+    std::cout << "Average time for handling reactions (gillespie):                  "
+              << gillespie.getTimeReactions() << std::endl;
+    std::cout << "Average time for handling reactions (next subvolumes):            "
+              << nextSubvolumes.getTimeReactions() << std::endl;
+}
+
 TEST(TestPerformance, ReactiveCPU) {
     //scaleNumbersAndSkin<CollisiveUniformHomogeneous, readdy::model::actions::reactions::Gillespie>("SingleCPU", true);
     //scaleNumbersAndSkin<CollisiveUniformHomogeneous, readdy::model::actions::reactions::GillespieParallel>("CPU_Dense", false);
@@ -0,0 +1,116 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+
+/**
+ * @file TestRandomProvider.cpp
+ * @brief Tests for the counter-based generator, seeding and the bulk functions of the random provider
+ * @author clonker
+ * @date 18.10.17
+ */
+
+#include <numeric>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <readdy/model/RandomProvider.h>
+
+namespace rnd = readdy::model::rnd;
+
+namespace {
+
+std::pair<double, double> meanAndVariance(const std::vector<double> &values) {
+    const auto n = static_cast<double>(values.size());
+    const auto mean = std::accumulate(values.begin(), values.end(), 0.) / n;
+    double var = 0;
+    for (const auto v : values) var += (v - mean) * (v - mean);
+    return std::make_pair(mean, var / (n - 1));
+}
+
+TEST(TestRandomProvider, PhiloxKnownAnswer) {
+    // known answer test from the Random123 distribution
+    rnd::philox4x32::counter_type ctr{{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+    rnd::philox4x32::key_type key{{0xa4093822, 0x299f31d0}};
+    rnd::philox4x32::counter_type expected{{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+    EXPECT_EQ(rnd::philox4x32::bijection(ctr, key), expected);
+}
+
+TEST(TestRandomProvider, PhiloxDiscard) {
+    rnd::philox4x32 g1{42, 7}, g2{42, 7};
+    for (int i = 0; i < 13; ++i) g1();
+    g2.discard(13);
+    EXPECT_EQ(g1, g2);
+    EXPECT_EQ(g1(), g2());
+}
+
+TEST(TestRandomProvider, SeedingIsReproducible) {
+    rnd::seed(1234);
+    std::vector<double> first(100);
+    rnd::fill_normal(first.data(), first.data() + first.size());
+    const auto scalar = rnd::uniform_real();
+
+    rnd::seed(1234);
+    std::vector<double> second(100);
+    rnd::fill_normal(second.data(), second.data() + second.size());
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(scalar, rnd::uniform_real());
+    EXPECT_EQ(rnd::get_seed(), 1234);
+
+    rnd::seed(4321);
+    rnd::fill_normal(second.data(), second.data() + second.size());
+    EXPECT_NE(first, second);
+}
+
+TEST(TestRandomProvider, ThreadsUseDifferentStreams) {
+    rnd::seed(5);
+    double a = rnd::uniform_real(), b = 0;
+    std::thread t([&b] { b = rnd::uniform_real(); });
+    t.join();
+    EXPECT_NE(a, b);
+}
+
+TEST(TestRandomProvider, BulkMoments) {
+    rnd::seed(99);
+    std::vector<double> values(200001);
+    {
+        rnd::fill_uniform(values.data(), values.data() + values.size(), -1., 3.);
+        const auto mv = meanAndVariance(values);
+        EXPECT_NEAR(mv.first, 1., 1e-2);
+        EXPECT_NEAR(mv.second, 16. / 12., 1e-2);
+        EXPECT_GE(*std::min_element(values.begin(), values.end()), -1.);
+        EXPECT_LT(*std::max_element(values.begin(), values.end()), 3.);
+    }
+    {
+        rnd::fill_normal(values.data(), values.data() + values.size());
+        const auto mv = meanAndVariance(values);
+        EXPECT_NEAR(mv.first, 0., 1e-2);
+        EXPECT_NEAR(mv.second, 1., 1e-2);
+    }
+    {
+        rnd::fill_exponential(values.data(), values.data() + values.size(), 2.);
+        const auto mv = meanAndVariance(values);
+        EXPECT_NEAR(mv.first, .5, 1e-2);
+        EXPECT_NEAR(mv.second, .25, 1e-2);
+    }
+}
+
+}
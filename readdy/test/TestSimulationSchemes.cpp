@@ -138,6 +138,31 @@ TEST_P(TestSchemes, SkinSizeSanity) {
     scheme->run(10);
 }
 
+TEST_P(TestSchemes, PerformanceRecord) {
+    simulation.registerParticleType("A", 1., 1.);
+    simulation.setBoxSize(10., 10., 10.);
+    simulation.setPeriodicBoundary({true, true, true});
+    simulation.registerHarmonicRepulsionPotential("A", "A", 1.);
+    simulation.addParticle("A", 0., 0., 0.);
+    simulation.addParticle("A", 1., 0., 0.);
+    simulation.runScheme().configureAndRun(5, .01);
+
+    const auto &timings = simulation.performance().timings();
+    EXPECT_EQ(timings.at("integrator").calls, 5);
+    EXPECT_EQ(timings.at("integrator").particles, 2 * 5);
+    EXPECT_EQ(timings.at("forces").calls, 6);
+    EXPECT_EQ(timings.at("observables").calls, 6);
+    EXPECT_GE(timings.at("forces").seconds, 0);
+    if (simulation.getSelectedKernelType() == "CPU") {
+        EXPECT_GT(simulation.performance().counters().at("neighbor_list.updates"), 0);
+    }
+
+    simulation.performance().clear();
+    EXPECT_EQ(timings.at("integrator").calls, 0);
+    EXPECT_EQ(timings.at("integrator").particles, 0);
+    EXPECT_EQ(timings.at("forces").seconds, 0);
+}
+
 INSTANTIATE_TEST_CASE_P(TestSchemesCore, TestSchemes, ::testing::ValuesIn(readdy::testing::getKernelsToTest()));
 
 }
\ No newline at end of file
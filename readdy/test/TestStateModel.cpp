@@ -208,6 +208,38 @@ TEST_P(TestStateModel, CalculateForcesNoForces) {
     }
 }
 
+TEST_P(TestStateModel, TrajectoryFrameMatchesParticles) {
+    m::KernelContext &ctx = kernel->getKernelContext();
+    auto &stateModel = kernel->getKernelStateModel();
+    ctx.particle_types().add("A", 1.0, 1.0);
+    ctx.particle_types().add("B", 1.0, 1.0);
+    ctx.setBoxSize(10., 10., 10.);
+    ctx.configure();
+    const auto typeIdA = ctx.particle_types().id_of("A");
+    const auto typeIdB = ctx.particle_types().id_of("B");
+    std::vector<m::Particle> particles;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        particles.emplace_back(m::rnd::uniform_real(-5., 5.), m::rnd::uniform_real(-5., 5.),
+                               m::rnd::uniform_real(-5., 5.), i % 3 == 0 ? typeIdA : typeIdB);
+    }
+    stateModel.addParticles(particles);
+    // leave some gaps in the particle storage
+    for (std::size_t i = 0; i < particles.size(); i += 7) {
+        stateModel.removeParticle(particles[i]);
+    }
+    // the frame must be overwritten, not appended to
+    std::vector<m::observables::TrajectoryEntry> frame(5);
+    stateModel.toTrajectoryFrame(frame);
+    const auto expected = stateModel.getParticles();
+    ASSERT_EQ(frame.size(), expected.size());
+    for (std::size_t i = 0; i < frame.size(); ++i) {
+        EXPECT_EQ(frame[i].id, expected[i].getId());
+        EXPECT_EQ(frame[i].typeId, expected[i].getType());
+        EXPECT_EQ(frame[i].flavor, expected[i].getFlavor());
+        EXPECT_VEC3_EQ(frame[i].pos, expected[i].getPos());
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(TestStateModel, TestStateModel,
                         ::testing::ValuesIn(readdy::testing::getKernelsToTest()));
 }
\ No newline at end of file
@@ -20,7 +20,9 @@
  ********************************************************************/
 
 
+#include <algorithm>
 #include <array>
+#include <set>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -298,6 +300,123 @@ TEST(TestTopologyGraphs, TestFindNTuplesInTriangle) {
     ASSERT_THAT(triples, AnyOf(Contains(std::tie(c, a, b)), Contains(std::tie(b, a, c))));
 }
 
+TEST(TestTopologyGraphs, TestFindNTuplesInTriangleWithPendant) {
+    // the triangle a, b, c with the pendant vertex d at a and the pendant vertex e at d: the paths of length 3 that
+    // span a triangle edge, e.g. (b, c, a, d), are no dihedrals, no matter in which order the vertices were added
+    std::array<std::string, 5> labels{{"a", "b", "c", "d", "e"}};
+    using quadruple = std::array<std::string, 4>;
+    const std::set<quadruple> expected{{{"b", "a", "d", "e"}}, {{"c", "a", "d", "e"}}};
+    do {
+        readdy::model::top::graph::Graph graph;
+        for (std::size_t i = 0; i < labels.size(); ++i) {
+            graph.addVertex(i, 0, labels[i]);
+        }
+        graph.addEdge("a", "b");
+        graph.addEdge("b", "c");
+        graph.addEdge("c", "a");
+        graph.addEdge("a", "d");
+
+        EXPECT_TRUE(std::get<2>(graph.findNTuples()).empty());
+
+        graph.addEdge("d", "e");
+        const auto nTuples = graph.findNTuples();
+        std::set<quadruple> dihedrals;
+        for (const auto &path : std::get<2>(nTuples)) {
+            quadruple dihedral{{std::get<0>(path)->label(), std::get<1>(path)->label(), std::get<2>(path)->label(),
+                                std::get<3>(path)->label()}};
+            if (dihedral.back() < dihedral.front()) {
+                std::reverse(dihedral.begin(), dihedral.end());
+            }
+            EXPECT_TRUE(dihedrals.insert(dihedral).second);
+        }
+        EXPECT_EQ(dihedrals, expected);
+    } while (std::next_permutation(labels.begin(), labels.end()));
+}
+
+TEST(TestTopologyGraphs, Adjacency) {
+    readdy::model::top::graph::Graph graph;
+    graph.addVertex(0, 0, "a");
+    graph.addVertex(1, 0, "b");
+    graph.addVertex(2, 0, "c");
+    graph.addVertex(3, 0, "d");
+    graph.addEdge("a", "b");
+    graph.addEdge("a", "c");
+    graph.addEdge("c", "d");
+
+    {
+        const auto &adjacency = graph.adjacency();
+        ASSERT_EQ(adjacency.vertices.size(), 4);
+        EXPECT_EQ(adjacency.vertices[0], graph.namedVertexPtr("a").data());
+        EXPECT_EQ(adjacency.vertices[3], graph.namedVertexPtr("d").data());
+        EXPECT_EQ(adjacency.offsets, (std::vector<std::size_t>{0, 2, 3, 5, 6}));
+        EXPECT_EQ(adjacency.neighbors, (std::vector<std::size_t>{1, 2, 0, 0, 3, 2}));
+    }
+    // the cached adjacency follows changes of the graph
+    graph.removeEdge("a", "c");
+    {
+        const auto &adjacency = graph.adjacency();
+        EXPECT_EQ(adjacency.offsets, (std::vector<std::size_t>{0, 1, 2, 3, 4}));
+        EXPECT_EQ(adjacency.neighbors, (std::vector<std::size_t>{1, 0, 3, 2}));
+    }
+    graph.addVertex(4, 0, "e");
+    graph.addEdge("e", "a");
+    {
+        const auto &adjacency = graph.adjacency();
+        ASSERT_EQ(adjacency.vertices.size(), 5);
+        EXPECT_EQ(adjacency.offsets, (std::vector<std::size_t>{0, 2, 3, 4, 5, 6}));
+        EXPECT_EQ(adjacency.neighbors, (std::vector<std::size_t>{1, 4, 0, 3, 2, 0}));
+    }
+    graph.removeVertex("b");
+    {
+        const auto &adjacency = graph.adjacency();
+        ASSERT_EQ(adjacency.vertices.size(), 4);
+        EXPECT_EQ(adjacency.offsets, (std::vector<std::size_t>{0, 1, 2, 3, 4}));
+        EXPECT_EQ(adjacency.neighbors, (std::vector<std::size_t>{3, 2, 1, 0}));
+    }
+}
+
+TEST(TestTopologyGraphs, LongChain) {
+    const std::size_t n = 20000;
+    readdy::model::top::graph::Graph graph;
+    for (std::size_t i = 0; i < n; ++i) {
+        graph.addVertex(i, 0);
+    }
+    {
+        auto it = graph.vertices().begin();
+        auto it2 = ++graph.vertices().begin();
+        for (; it2 != graph.vertices().end(); ++it, ++it2) {
+            graph.addEdge(it, it2);
+        }
+    }
+    EXPECT_TRUE(graph.isConnected());
+    {
+        auto n_tuples = graph.findNTuples();
+        EXPECT_EQ(std::get<0>(n_tuples).size(), n - 1);
+        EXPECT_EQ(std::get<1>(n_tuples).size(), n - 2);
+        EXPECT_EQ(std::get<2>(n_tuples).size(), n - 3);
+    }
+
+    auto middle = graph.vertices().begin();
+    std::advance(middle, n / 2);
+    auto next = std::next(middle);
+    graph.removeEdge(middle, next);
+    EXPECT_FALSE(graph.isConnected());
+
+    auto subGraphs = graph.connectedComponentsDestructive();
+    ASSERT_EQ(subGraphs.size(), 2);
+    EXPECT_EQ(subGraphs[0].vertices().size(), n / 2 + 1);
+    EXPECT_EQ(subGraphs[1].vertices().size(), n - n / 2 - 1);
+    for (auto &subGraph : subGraphs) {
+        EXPECT_TRUE(subGraph.isConnected());
+        for (const auto &vertex : subGraph.vertices()) {
+            for (const auto &neighbor : vertex.neighbors()) {
+                EXPECT_EQ(std::abs(static_cast<long>(neighbor->particleIndex) -
+                                   static_cast<long>(vertex.particleIndex)), 1);
+            }
+        }
+    }
+}
+
 TEST_P(TestTopologyGraphs, BondedPotential) {
     auto &ctx = kernel->getKernelContext();
     ctx.particle_types().add("Topology A", 1.0, 1.0, particle_t::FLAVOR_TOPOLOGY);
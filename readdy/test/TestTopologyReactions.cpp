@@ -30,6 +30,8 @@
  * @copyright GNU Lesser General Public License v3.0
  */
 
+#include <random>
+
 #include <gtest/gtest.h>
 #include <readdy/model/topologies/GraphTopology.h>
 #include <readdy/testing/KernelTest.h>
@@ -513,6 +515,123 @@ TEST_P(TestTopologyReactions, SplitUpChainDecay) {
     EXPECT_EQ(kernel->getKernelStateModel().getTopologies().size(), 0);
 }
 
+TEST_P(TestTopologyReactions, IncrementalBondedPotentials) {
+    // after each reaction the incrementally updated bonds, angles and dihedrals must agree with a full configuration
+    using namespace readdy;
+    if (!kernel->supportsTopologies()) {
+        log::debug("kernel {} does not support topologies, thus skipping the test", kernel->getName());
+        return;
+    }
+    auto &ctx = kernel->getKernelContext();
+    ctx.configureTopologyAnglePotential("Topology A", "Topology A", "Topology A", {1., 2.});
+    ctx.configureTopologyAnglePotential("Topology A", "Topology A", "Topology B", {3., 2.});
+    ctx.configureTopologyAnglePotential("Topology A", "Topology B", "Topology A", {4., 2.});
+    ctx.configureTopologyTorsionPotential("Topology A", "Topology A", "Topology A", "Topology A", {1., 1., 1.});
+    ctx.configureTopologyTorsionPotential("Topology A", "Topology A", "Topology B", "Topology B", {2., 1., 1.});
+    ctx.configureTopologyTorsionPotential("Topology B", "Topology A", "Topology A", "Topology B", {3., 1., 1.});
+    const auto typeA = ctx.particle_types().id_of("Topology A");
+    const auto typeB = ctx.particle_types().id_of("Topology B");
+
+    const std::size_t n = 12;
+    std::vector<topology_particle_t> particles;
+    for (std::size_t i = 0; i < n; ++i) {
+        particles.emplace_back(0., 0., 0., i % 3 == 0 ? typeB : typeA);
+    }
+    auto topology = kernel->getKernelStateModel().addTopology(particles);
+    auto vertex = [&](std::size_t i) {
+        return std::next(topology->graph().vertices().begin(), i);
+    };
+    for (std::size_t i = 0; i < n - 1; ++i) {
+        topology->graph().addEdge(vertex(i), vertex(i + 1));
+    }
+    topology->graph().addEdge(vertex(0), vertex(5));
+    topology->graph().addEdge(vertex(2), vertex(4));
+    topology->configure();
+
+    using tuples = std::vector<std::vector<double>>;
+    auto collect = [](const model::top::GraphTopology &top) {
+        tuples bonds, angles, dihedrals;
+        for (const auto &potential : top.getBondedPotentials()) {
+            for (const auto &b : potential->getBonds()) {
+                bonds.push_back({static_cast<double>(b.idx1), static_cast<double>(b.idx2), b.forceConstant, b.length});
+            }
+        }
+        for (const auto &potential : top.getAnglePotentials()) {
+            const auto harmonic = dynamic_cast<const model::top::pot::HarmonicAnglePotential *>(potential.get());
+            for (const auto &a : harmonic->getAngles()) {
+                angles.push_back({static_cast<double>(a.idx1), static_cast<double>(a.idx2),
+                                  static_cast<double>(a.idx3), a.forceConstant});
+            }
+        }
+        for (const auto &potential : top.getTorsionPotentials()) {
+            const auto cosine = dynamic_cast<const model::top::pot::CosineDihedralPotential *>(potential.get());
+            for (const auto &d : cosine->getDihedrals()) {
+                dihedrals.push_back({static_cast<double>(d.idx1), static_cast<double>(d.idx2),
+                                     static_cast<double>(d.idx3), static_cast<double>(d.idx4), d.forceConstant});
+            }
+        }
+        std::sort(bonds.begin(), bonds.end());
+        std::sort(angles.begin(), angles.end());
+        std::sort(dihedrals.begin(), dihedrals.end());
+        return std::make_tuple(bonds, angles, dihedrals);
+    };
+
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<std::size_t> randomVertex(0, n - 1);
+    auto reactionFunction = [&](model::top::GraphTopology &top) {
+        model::top::reactions::Recipe recipe(top);
+        auto &graph = top.graph();
+        const auto i = randomVertex(generator);
+        auto j = randomVertex(generator);
+        while (j == i) j = randomVertex(generator);
+        auto v1 = std::next(graph.vertices().begin(), i);
+        auto v2 = std::next(graph.vertices().begin(), j);
+        switch (generator() % 3) {
+            case 0: {
+                const auto &neighbors = v1->neighbors();
+                if (std::find(neighbors.begin(), neighbors.end(), v2) == neighbors.end()) recipe.addEdge(v1, v2);
+                break;
+            }
+            case 1: {
+                if (!v1->neighbors().empty()) recipe.removeEdge(v1, v1->neighbors().front());
+                break;
+            }
+            default: {
+                recipe.changeParticleType(v1, v1->particleType() == typeA ? typeB : typeA);
+            }
+        }
+        return recipe;
+    };
+    model::top::reactions::TopologyReaction reaction{reactionFunction, 1};
+    reaction.expect_connected_after_reaction();
+    reaction.roll_back_if_invalid();
+
+    for (int step = 0; step < 300; ++step) {
+        reaction.execute(*topology, kernel.get());
+        // configure a copy of the graph from scratch
+        std::vector<particle_type_type> types;
+        for (const auto &v : topology->graph().vertices()) {
+            types.push_back(v.particleType());
+        }
+        model::top::GraphTopology reference(topology->getParticles(), types, ctx.topology_potentials());
+        for (const auto &v : topology->graph().vertices()) {
+            for (const auto &neighbor : v.neighbors()) {
+                if (v.particleIndex < neighbor->particleIndex) {
+                    reference.graph().addEdge(std::next(reference.graph().vertices().begin(), v.particleIndex),
+                                              std::next(reference.graph().vertices().begin(),
+                                                        neighbor->particleIndex));
+                }
+            }
+        }
+        reference.configure();
+        const auto incremental = collect(*topology);
+        const auto full = collect(reference);
+        ASSERT_EQ(std::get<0>(incremental), std::get<0>(full)) << "bonds differ in step " << step;
+        ASSERT_EQ(std::get<1>(incremental), std::get<1>(full)) << "angles differ in step " << step;
+        ASSERT_EQ(std::get<2>(incremental), std::get<2>(full)) << "dihedrals differ in step " << step;
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(TestTopologyReactionsKernelTests, TestTopologyReactions,
                         ::testing::ValuesIn(readdy::testing::getKernelsToTest()));
 
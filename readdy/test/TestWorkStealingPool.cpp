@@ -0,0 +1,109 @@
+/********************************************************************
+ * Copyright © 2016 Computational Molecular Biology Group,          *
+ *                  Freie Universität Berlin (GER)                  *
+ *                                                                  *
+ * This file is part of ReaDDy.                                     *
+ *                                                                  *
+ * ReaDDy is free software: you can redistribute it and/or modify   *
+ * it under the terms of the GNU Lesser General Public License as   *
+ * published by the Free Software Foundation, either version 3 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU Lesser General Public License for more details.              *
+ *                                                                  *
+ * You should have received a copy of the GNU Lesser General        *
+ * Public License along with this program. If not, see              *
+ * <http://www.gnu.org/licenses/>.                                  *
+ ********************************************************************/
+
+
+/**
+ * @file TestWorkStealingPool.cpp
+ * @brief Tests for the work stealing thread pool and its executor
+ * @author clonker
+ * @date 17.10.17
+ */
+
+#include <gtest/gtest.h>
+#include <readdy/common/thread/Config.h>
+#include <readdy/common/thread/work_stealing_pool.h>
+
+namespace thd = readdy::util::thread;
+
+namespace {
+
+TEST(TestWorkStealingPool, EachTaskIsExecutedOnce) {
+    thd::work_stealing_pool pool{4, false};
+    for (std::size_t nTasks : {1, 3, 4, 17, 100}) {
+        std::vector<std::atomic<int>> counts(nTasks);
+        for (auto &c : counts) c = 0;
+        std::vector<thd::work_stealing_pool::task_t> tasks;
+        for (std::size_t i = 0; i < nTasks; ++i) {
+            tasks.emplace_back([&counts, i](std::size_t idx) {
+                EXPECT_EQ(i, idx);
+                ++counts.at(idx);
+            });
+        }
+        pool.run(tasks);
+        for (const auto &c : counts) {
+            EXPECT_EQ(c.load(), 1);
+        }
+    }
+}
+
+TEST(TestWorkStealingPool, ManyConsecutiveBatches) {
+    thd::work_stealing_pool pool{3, false};
+    std::atomic<std::size_t> sum{0};
+    for (int batch = 0; batch < 1000; ++batch) {
+        std::vector<thd::work_stealing_pool::task_t> tasks(5, [&sum](std::size_t idx) { sum += idx; });
+        pool.run(tasks);
+    }
+    EXPECT_EQ(sum.load(), 1000 * (0 + 1 + 2 + 3 + 4));
+}
+
+TEST(TestWorkStealingPool, ExceptionIsRethrown) {
+    thd::work_stealing_pool pool{2, false};
+    std::atomic<int> executed{0};
+    std::vector<thd::work_stealing_pool::task_t> tasks;
+    for (int i = 0; i < 8; ++i) {
+        tasks.emplace_back([&executed, i](std::size_t) {
+            ++executed;
+            if (i == 3) throw std::runtime_error("task failed");
+        });
+    }
+    EXPECT_THROW(pool.run(tasks), std::runtime_error);
+    EXPECT_EQ(executed.load(), 8);
+    // the pool stays usable
+    std::vector<thd::work_stealing_pool::task_t> more(4, [&executed](std::size_t) { ++executed; });
+    pool.run(more);
+    EXPECT_EQ(executed.load(), 12);
+}
+
+TEST(TestWorkStealingPool, PinnedWithoutSpinning) {
+    thd::work_stealing_pool pool{3, true, 0};
+    std::atomic<std::size_t> sum{0};
+    for (int batch = 0; batch < 100; ++batch) {
+        std::vector<thd::work_stealing_pool::task_t> tasks(5, [&sum](std::size_t idx) { sum += idx; });
+        pool.run(tasks);
+    }
+    EXPECT_EQ(sum.load(), 100 * (0 + 1 + 2 + 3 + 4));
+}
+
+TEST(TestWorkStealingPool, ConfigExecutor) {
+    thd::Config config;
+    config.setNThreads(8);
+    config.setMode(thd::ThreadMode::work_stealing);
+    const auto &executor = *config.executor();
+    std::atomic<std::size_t> count{0};
+    std::vector<std::function<void(std::size_t)>> executables;
+    for (std::size_t i = 0; i < config.nThreads(); ++i) {
+        executables.push_back(executor.pack([&count](std::size_t, std::size_t n) { count += n; }, 2));
+    }
+    executor.execute_and_wait(std::move(executables));
+    EXPECT_EQ(count.load(), 16);
+}
+
+}
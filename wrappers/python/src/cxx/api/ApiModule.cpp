@@ -82,6 +82,8 @@ void exportApi(py::module &api) {
     py::class_ <sim> simulation(api, "Simulation");
     simulation.def(py::init<>())
             .def_property("kbt", &sim::getKBT, &sim::setKBT)
+            .def_property("seed", &sim::getSeed, &sim::setSeed)
+            .def_property("auto_tabulate_potentials", &sim::getAutoTabulatePotentials, &sim::setAutoTabulatePotentials)
             .def_property("periodic_boundary", &sim::getPeriodicBoundary, &sim::setPeriodicBoundary)
             .def_property("box_size", &sim::getBoxSize, &setBoxSize)
             .def("set_expected_max_n_particles", &sim::setExpectedMaxNParticles, "n"_a)
@@ -170,9 +172,22 @@ void exportApi(py::module &api) {
             .def("run", [](sim &self, const readdy::time_step_type steps, const double timeStep) {
                 py::gil_scoped_release release;
                 self.run(steps, timeStep);
-            }, "n_steps"_a, "time_step"_a);
+            }, "n_steps"_a, "time_step"_a)
+            .def_property_readonly("performance", [](sim &self) -> readdy::util::Performance & {
+                return self.performance();
+            }, rvp::reference_internal);
     exportObservables(api, simulation);
 
+    py::class_<readdy::util::Timing>(api, "Timing")
+            .def_readonly("seconds", &readdy::util::Timing::seconds)
+            .def_readonly("calls", &readdy::util::Timing::calls)
+            .def_readonly("particles", &readdy::util::Timing::particles);
+
+    py::class_<readdy::util::Performance>(api, "Performance")
+            .def("timings", &readdy::util::Performance::timings)
+            .def("counters", &readdy::util::Performance::counters)
+            .def("clear", &readdy::util::Performance::clear);
+
     py::class_<kp, std::unique_ptr<kp, readdy::util::nodelete>>(api, "KernelProvider")
             .def_static("get", &kp::getInstance, rvp::reference)
             .def("load_from_dir", &kp::loadKernelsFromDirectory, "directory"_a);
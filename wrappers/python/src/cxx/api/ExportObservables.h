@@ -175,6 +175,12 @@ inline obs_handle_t registerObservable_FlatTrajectory(sim& self, unsigned int st
     return self.registerObservable<readdy::model::observables::FlatTrajectory>(stride);
 }
 
+inline obs_handle_t registerObservable_ColumnarTrajectory(sim& self, unsigned int stride, std::size_t maxParticles,
+                                                         bool singlePrecision, double precision) {
+    return self.registerObservable<readdy::model::observables::ColumnarTrajectory>(stride, maxParticles,
+                                                                                   singlePrecision, precision);
+}
+
 template <typename type_, typename... options>
 void exportObservables(py::module &apiModule, py::class_<type_, options...> &simulation) {
     using namespace pybind11::literals;
@@ -219,6 +225,8 @@ void exportObservables(py::module &apiModule, py::class_<type_, options...> &sim
                  "stride"_a, "callback"_a = py::none())
             .def("register_observable_trajectory", &registerObservable_Trajectory, "stride"_a)
             .def("register_observable_flat_trajectory", &registerObservable_FlatTrajectory, "stride"_a)
+            .def("register_observable_columnar_trajectory", &registerObservable_ColumnarTrajectory, "stride"_a,
+                 "max_particles"_a = 0, "single_precision"_a = false, "precision"_a = 0.)
             .def("deregister_observable", [](sim &self, const obs_handle_t &handle) {
                 self.deregisterObservable(handle.getId());
             }, "handle"_a);
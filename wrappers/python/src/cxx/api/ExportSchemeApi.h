@@ -65,6 +65,8 @@ void exportSchemeApi(pybind11::module &module, std::string schemeName) {
                  },
                  py::return_value_policy::reference_internal, "reaction_scheduler_name"_a)
             .def("write_config_to_file", &conf::writeConfigToFile, py::return_value_policy::reference_internal, "file"_a)
+            .def("write_performance_to_file", &conf::writePerformanceToFile, py::return_value_policy::reference_internal,
+                 "file"_a)
             .def("evaluate_topology_reactions", &conf::evaluateTopologyReactions, py::return_value_policy::reference_internal)
             .def("evaluate_observables", &conf::evaluateObservables, py::return_value_policy::reference_internal,
                  "do_evaluate"_a = true)
@@ -106,6 +108,8 @@ void exportSchemeApi<readdy::api::AdvancedScheme>(pybind11::module &module, std:
                  py::return_value_policy::reference_internal, "reaction_scheduler_name"_a)
             .def("evaluate_observables", &conf::evaluateObservables, py::return_value_policy::reference_internal, "do_evaluate"_a = true)
             .def("with_skin_size", &conf::withSkinSize, py::return_value_policy::reference_internal, "skin_size"_a = -1)
+            .def("write_performance_to_file", &conf::writePerformanceToFile, py::return_value_policy::reference_internal,
+                 "file"_a)
             .def("configure", &conf::configure, "time_step"_a)
             .def("configure_and_run", [](conf& self, const readdy::time_step_type steps, double dt) {
                 py::gil_scoped_release release;